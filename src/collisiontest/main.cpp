@@ -0,0 +1,324 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+#include "engine/collisionmodel.h"
+
+#define COLLISIONTEST_EPSILON			0.0001f
+#define COLLISIONTEST_BENCH_TRACES		100000
+
+//---------------------------------------------------------------------//
+
+// Synthetic level: BSP tree with one node on plane x = 0, front leaf 0 and back leaf 1.
+// Brushes (index in BSP):
+//   0 - axial box [ 64, 128 ] x [ -32, 32 ] x [ -32, 32 ], leaf 0
+//   1 - axial box [ -128, -64 ] x [ -32, 32 ] x [ -32, 32 ] with bevel on edge x = -128, z = 32, leaf 1
+//   2 - axial box [ -16, 16 ] x [ 64, 96 ] x [ -16, 16 ], crosses node plane, both leafs
+//   3 - non solid box [ -16, 16 ] x [ -96, -64 ] x [ -16, 16 ], both leafs
+struct SyntheticLevel
+{
+	std::vector< le::BSPCompactNode >		nodes;
+	std::vector< le::BSPLeaf >				leafs;
+	std::vector< int >						leafBrushes;
+	std::vector< le::BSPBrush >				brushes;
+	std::vector< le::BSPBrushSide >			brushSides;
+	std::vector< le::BSPPlane >				planes;
+	std::vector< le::BSPTexture >			textures;
+};
+
+static le::UInt32_t			countChecks = 0;
+static le::UInt32_t			countFailed = 0;
+
+// ------------------------------------------------------------------------------------ //
+// Add brush side
+// ------------------------------------------------------------------------------------ //
+static void AddSide( SyntheticLevel& Level, const le::Vector3D_t& Normal, float Distance )
+{
+	Level.planes.push_back( { Normal, Distance } );
+	Level.brushSides.push_back( { ( int ) Level.planes.size() - 1, Level.brushes.back().textureID } );
+	++Level.brushes.back().numOfBrushSides;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Add axial box brush
+// ------------------------------------------------------------------------------------ //
+static void AddBoxBrush( SyntheticLevel& Level, const le::Vector3D_t& Min, const le::Vector3D_t& Max, int TextureID )
+{
+	Level.brushes.push_back( { ( int ) Level.brushSides.size(), 0, TextureID } );
+
+	for ( le::UInt32_t axis = 0; axis < 3; ++axis )
+	{
+		le::Vector3D_t		normal( 0.f );
+		normal[ axis ] = 1.f;
+
+		AddSide( Level, normal, Max[ axis ] );
+		AddSide( Level, -normal, -Min[ axis ] );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Add leaf with brushes
+// ------------------------------------------------------------------------------------ //
+static void AddLeaf( SyntheticLevel& Level, const std::vector< int >& Brushes )
+{
+	le::BSPLeaf			leaf = {};
+	leaf.leafBrush = Level.leafBrushes.size();
+	leaf.numOfLeafBrushes = Brushes.size();
+
+	Level.leafBrushes.insert( Level.leafBrushes.end(), Brushes.begin(), Brushes.end() );
+	Level.leafs.push_back( leaf );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Build synthetic level
+// ------------------------------------------------------------------------------------ //
+static void BuildLevel( SyntheticLevel& Level )
+{
+	le::BSPTexture		solid = {};
+	le::BSPTexture		water = {};
+	solid.type = le::BC_SOLID;
+	Level.textures.push_back( solid );
+	Level.textures.push_back( water );
+
+	AddBoxBrush( Level, le::Vector3D_t( 64.f, -32.f, -32.f ), le::Vector3D_t( 128.f, 32.f, 32.f ), 0 );
+
+	// Bevel passes through ( -112, 0, 32 ) and ( -128, 0, 16 )
+	AddBoxBrush( Level, le::Vector3D_t( -128.f, -32.f, -32.f ), le::Vector3D_t( -64.f, 32.f, 32.f ), 0 );
+	AddSide( Level, glm::normalize( le::Vector3D_t( -1.f, 0.f, 1.f ) ), 144.f / sqrtf( 2.f ) );
+
+	AddBoxBrush( Level, le::Vector3D_t( -16.f, 64.f, -16.f ), le::Vector3D_t( 16.f, 96.f, 16.f ), 0 );
+	AddBoxBrush( Level, le::Vector3D_t( -16.f, -96.f, -16.f ), le::Vector3D_t( 16.f, -64.f, 16.f ), 1 );
+
+	AddLeaf( Level, { 0, 2, 3 } );
+	AddLeaf( Level, { 1, 2, 3 } );
+
+	le::BSPCompactNode		node = {};
+	node.normal = le::Vector3D_t( 1.f, 0.f, 0.f );
+	node.distance = 0.f;
+	node.children[ 0 ] = -1;
+	node.children[ 1 ] = -2;
+	node.axis = 0;
+	Level.nodes.push_back( node );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Make request of trace
+// ------------------------------------------------------------------------------------ //
+static le::TraceRequest MakeRequest( le::TRACE_TYPE Type, const le::Vector3D_t& Start, const le::Vector3D_t& End, float Size = 0.f )
+{
+	le::TraceRequest		request;
+	request.type = Type;
+	request.start = Start;
+	request.end = End;
+	request.min = le::Vector3D_t( -Size );
+	request.max = le::Vector3D_t( Size );
+	request.radius = Size;
+	return request;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Check result of trace
+// ------------------------------------------------------------------------------------ //
+static void CheckTrace( le::CollisionModel& CollisionModel, const char* Name, const le::TraceRequest& Request,
+						float Fraction, const le::Vector3D_t& Normal, int Brush, bool IsStartSolid, bool IsAllSolid = false )
+{
+	le::TraceResult			result;
+	CollisionModel.Trace( Request, result );
+	++countChecks;
+
+	if ( fabsf( result.fraction - Fraction ) > COLLISIONTEST_EPSILON || glm::length( result.normal - Normal ) > COLLISIONTEST_EPSILON ||
+		 result.brush != Brush || result.isStartSolid != IsStartSolid || result.isAllSolid != IsAllSolid )
+	{
+		++countFailed;
+		printf( "FAILED %s: fraction %f (expected %f), normal ( %f, %f, %f ) (expected ( %f, %f, %f )), brush %i (expected %i), start solid %i (expected %i), all solid %i (expected %i)\n",
+				Name, result.fraction, Fraction, result.normal.x, result.normal.y, result.normal.z, Normal.x, Normal.y, Normal.z,
+				result.brush, Brush, result.isStartSolid, IsStartSolid, result.isAllSolid, IsAllSolid );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Fill requests with random traces around brushes
+// ------------------------------------------------------------------------------------ //
+static void MakeRandomRequests( std::vector< le::TraceRequest >& Requests, le::UInt32_t Count )
+{
+	srand( 1 );
+	Requests.resize( Count );
+
+	for ( le::UInt32_t index = 0; index < Count; ++index )
+	{
+		le::Vector3D_t		start( rand() % 512 - 256, rand() % 512 - 256, rand() % 512 - 256 );
+		le::Vector3D_t		end( rand() % 512 - 256, rand() % 512 - 256, rand() % 512 - 256 );
+		Requests[ index ] = MakeRequest( ( le::TRACE_TYPE ) ( index % 3 ), start, end, ( float ) ( rand() % 16 ) );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Run checks of traces
+// ------------------------------------------------------------------------------------ //
+static void RunTests( le::CollisionModel& CollisionModel )
+{
+	const float				epsilon = COLLISIONMODEL_SURFACE_EPSILON;
+	const le::Vector3D_t	noNormal( 0.f );
+	const le::Vector3D_t	bevelNormal = glm::normalize( le::Vector3D_t( -1.f, 0.f, 1.f ) );
+
+	CheckTrace( CollisionModel, "ray hits axial side", MakeRequest( le::TRT_RAY, le::Vector3D_t( 0.f ), le::Vector3D_t( 256.f, 0.f, 0.f ) ),
+				( 64.f - epsilon ) / 256.f, le::Vector3D_t( -1.f, 0.f, 0.f ), 0, false );
+
+	CheckTrace( CollisionModel, "ray hits brush behind node", MakeRequest( le::TRT_RAY, le::Vector3D_t( 0.f ), le::Vector3D_t( -256.f, 0.f, 0.f ) ),
+				( 64.f - epsilon ) / 256.f, le::Vector3D_t( 1.f, 0.f, 0.f ), 1, false );
+
+	// At x = -124 bevel is at z = 20, below top side z = 32
+	CheckTrace( CollisionModel, "ray hits bevel", MakeRequest( le::TRT_RAY, le::Vector3D_t( -124.f, 0.f, 100.f ), le::Vector3D_t( -124.f, 0.f, 0.f ) ),
+				( 80.f - epsilon * sqrtf( 2.f ) ) / 100.f, bevelNormal, 1, false );
+
+	CheckTrace( CollisionModel, "ray hits top side next to bevel", MakeRequest( le::TRT_RAY, le::Vector3D_t( -96.f, 0.f, 100.f ), le::Vector3D_t( -96.f, 0.f, 0.f ) ),
+				( 68.f - epsilon ) / 100.f, le::Vector3D_t( 0.f, 0.f, 1.f ), 1, false );
+
+	CheckTrace( CollisionModel, "ray hits brush in both leafs", MakeRequest( le::TRT_RAY, le::Vector3D_t( 0.f ), le::Vector3D_t( 0.f, 256.f, 0.f ) ),
+				( 64.f - epsilon ) / 256.f, le::Vector3D_t( 0.f, -1.f, 0.f ), 2, false );
+
+	CheckTrace( CollisionModel, "ray passes non solid brush", MakeRequest( le::TRT_RAY, le::Vector3D_t( 0.f ), le::Vector3D_t( 0.f, -256.f, 0.f ) ),
+				1.f, noNormal, -1, false );
+
+	CheckTrace( CollisionModel, "ray misses", MakeRequest( le::TRT_RAY, le::Vector3D_t( 0.f, 0.f, 200.f ), le::Vector3D_t( 256.f, 0.f, 200.f ) ),
+				1.f, noNormal, -1, false );
+
+	CheckTrace( CollisionModel, "ray starts in brush", MakeRequest( le::TRT_RAY, le::Vector3D_t( 96.f, 0.f, 0.f ), le::Vector3D_t( 200.f, 0.f, 0.f ) ),
+				1.f, noNormal, 0, true );
+
+	CheckTrace( CollisionModel, "ray stays in brush", MakeRequest( le::TRT_RAY, le::Vector3D_t( 80.f, 0.f, 0.f ), le::Vector3D_t( 100.f, 0.f, 0.f ) ),
+				0.f, noNormal, 0, true, true );
+
+	CheckTrace( CollisionModel, "box hits axial side", MakeRequest( le::TRT_BOX, le::Vector3D_t( 0.f ), le::Vector3D_t( 256.f, 0.f, 0.f ), 8.f ),
+				( 56.f - epsilon ) / 256.f, le::Vector3D_t( -1.f, 0.f, 0.f ), 0, false );
+
+	CheckTrace( CollisionModel, "sphere hits axial side", MakeRequest( le::TRT_SPHERE, le::Vector3D_t( 0.f ), le::Vector3D_t( 256.f, 0.f, 0.f ), 8.f ),
+				( 56.f - epsilon ) / 256.f, le::Vector3D_t( -1.f, 0.f, 0.f ), 0, false );
+
+	// Box corner touches bevel first: side is pushed out by ( |nx| + |nz| ) * 8 = 8 * sqrt( 2 )
+	CheckTrace( CollisionModel, "box hits bevel", MakeRequest( le::TRT_BOX, le::Vector3D_t( -124.f, 0.f, 100.f ), le::Vector3D_t( -124.f, 0.f, 0.f ), 8.f ),
+				( 80.f - 8.f * 2.f - epsilon * sqrtf( 2.f ) ) / 100.f, bevelNormal, 1, false );
+
+	CheckTrace( CollisionModel, "box starts overlapping brush", MakeRequest( le::TRT_BOX, le::Vector3D_t( 60.f, 0.f, 0.f ), le::Vector3D_t( 0.f ), 8.f ),
+				1.f, noNormal, 0, true );
+
+	// Batch split across threads must give same results as single traces
+	std::vector< le::TraceRequest >		requests;
+	std::vector< le::TraceResult >		results( 4096 );
+	MakeRandomRequests( requests, results.size() );
+	CollisionModel.TraceBatch( requests.data(), results.data(), results.size() );
+
+	for ( le::UInt32_t index = 0, count = requests.size(); index < count; ++index )
+	{
+		le::TraceResult			result;
+		CollisionModel.Trace( requests[ index ], result );
+		++countChecks;
+
+		if ( result.fraction != results[ index ].fraction || result.brush != results[ index ].brush || result.normal != results[ index ].normal ||
+			 result.isStartSolid != results[ index ].isStartSolid || result.isAllSolid != results[ index ].isAllSolid )
+		{
+			++countFailed;
+			printf( "FAILED batch trace %i differs from single trace\n", index );
+		}
+	}
+
+	// Single traces from several threads at once must not share check counters
+	std::vector< le::TraceResult >		threadResults( results.size() );
+	std::vector< std::thread >			threads;
+	for ( le::UInt32_t indexThread = 0; indexThread < 4; ++indexThread )
+		threads.push_back( std::thread( [ & ]( le::UInt32_t IndexThread )
+		{
+			for ( le::UInt32_t index = IndexThread, count = requests.size(); index < count; index += 4 )
+				CollisionModel.Trace( requests[ index ], threadResults[ index ] );
+		}, indexThread ) );
+
+	for ( le::UInt32_t index = 0, count = threads.size(); index < count; ++index )
+		threads[ index ].join();
+
+	for ( le::UInt32_t index = 0, count = requests.size(); index < count; ++index )
+	{
+		++countChecks;
+		if ( threadResults[ index ].fraction != results[ index ].fraction || threadResults[ index ].brush != results[ index ].brush ||
+			 threadResults[ index ].normal != results[ index ].normal )
+		{
+			++countFailed;
+			printf( "FAILED trace %i from thread differs from batch trace\n", index );
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Measure speed of traces
+// ------------------------------------------------------------------------------------ //
+static void RunBenchmark( le::CollisionModel& CollisionModel, le::UInt32_t CountTraces )
+{
+	std::vector< le::TraceRequest >		requests;
+	std::vector< le::TraceResult >		results( CountTraces );
+	MakeRandomRequests( requests, CountTraces );
+
+	auto		startTime = std::chrono::steady_clock::now();
+	for ( le::UInt32_t index = 0; index < CountTraces; ++index )
+		CollisionModel.Trace( requests[ index ], results[ index ] );
+
+	double		singleTime = std::chrono::duration< double >( std::chrono::steady_clock::now() - startTime ).count();
+
+	startTime = std::chrono::steady_clock::now();
+	CollisionModel.TraceBatch( requests.data(), results.data(), CountTraces );
+
+	double		batchTime = std::chrono::duration< double >( std::chrono::steady_clock::now() - startTime ).count();
+
+	printf( "Benchmark: %i traces, single %.3f ms (%.0f traces/s), batch %.3f ms (%.0f traces/s)\n",
+			CountTraces, singleTime * 1000.0, CountTraces / singleTime, batchTime * 1000.0, CountTraces / batchTime );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Entry point
+// ------------------------------------------------------------------------------------ //
+int main( int CountArguments, char** Arguments )
+{
+	bool				isBenchmark = false;
+	le::UInt32_t		countTraces = COLLISIONTEST_BENCH_TRACES;
+
+	for ( int index = 1; index < CountArguments; ++index )
+		if ( !strcmp( Arguments[ index ], "-bench" ) )
+		{
+			isBenchmark = true;
+			if ( index + 1 < CountArguments )		countTraces = atoi( Arguments[ ++index ] );
+		}
+		else
+		{
+			printf( "Usage: collisiontest [-bench [count]]\n" );
+			printf( "  -bench      measure speed of random traces against synthetic brushes\n" );
+			return 1;
+		}
+
+	SyntheticLevel			level;
+	le::CollisionModel		collisionModel;
+
+	BuildLevel( level );
+	collisionModel.Build( level.nodes, level.leafs, level.leafBrushes, level.brushes, level.brushSides, level.planes, level.textures );
+
+	if ( isBenchmark )
+	{
+		RunBenchmark( collisionModel, countTraces > 0 ? countTraces : COLLISIONTEST_BENCH_TRACES );
+		return 0;
+	}
+
+	RunTests( collisionModel );
+	printf( "%i of %i checks passed\n", countChecks - countFailed, countChecks );
+	return countFailed > 0 ? 1 : 0;
+}
@@ -15,6 +15,10 @@
 
 //---------------------------------------------------------------------//
 
+#define BSP_NODE_NOT_AXIAL		3
+
+//---------------------------------------------------------------------//
+
 namespace le
 {
 	//---------------------------------------------------------------------//
@@ -43,6 +47,23 @@ namespace le
 
 	//---------------------------------------------------------------------//
 
+	enum BSP_CONTENTS
+	{
+		BC_SOLID = 0x1,
+		BC_AREAPORTAL = 0x8000,
+		BC_TRANSLUCENT = 0x20000000
+	};
+
+	//---------------------------------------------------------------------//
+
+	enum BSP_SURFACE_FLAGS
+	{
+		BSF_SKY = 0x4,
+		BSF_NODRAW = 0x80
+	};
+
+	//---------------------------------------------------------------------//
+
 	enum BSP_TYPE_PLANE
 	{
 		BTP_POLYGON_FACE = 1,	
@@ -82,6 +103,28 @@ namespace le
 
 	//---------------------------------------------------------------------//
 
+	struct BSPPackedVertex
+	{
+		Vector3D_t		position;
+		UInt16_t		textureCoord[ 2 ];
+		UInt16_t		lightmapCoord[ 2 ];
+		UInt32_t		normal;
+		Byte_t			color[ 4 ];
+	};
+
+	//---------------------------------------------------------------------//
+
+	struct BSPPackedVertexFloatUV
+	{
+		Vector3D_t		position;
+		Vector2D_t		textureCoord;
+		UInt16_t		lightmapCoord[ 2 ];
+		UInt32_t		normal;
+		Byte_t			color[ 4 ];
+	};
+
+	//---------------------------------------------------------------------//
+
 	struct BSPModel
 	{
 		Vector3D_t		min;					
@@ -163,6 +206,19 @@ namespace le
 
 	//---------------------------------------------------------------------//
 
+	// Node of BSP tree repacked at load: plane is inlined, nodes are in depth-first order
+	// (front child follows parent), two nodes fit in cache line
+	struct BSPCompactNode
+	{
+		Vector3D_t		normal;
+		float			distance;
+		int				children[ 2 ];		// Front and back, leaf is stored as -( leaf + 1 )
+		int				axis;				// 0-2 for axial plane, BSP_NODE_NOT_AXIAL otherwise
+		int				padding;
+	};
+
+	//---------------------------------------------------------------------//
+
 	struct BSPVisData
 	{
 		BSPVisData();
@@ -201,6 +257,15 @@ namespace le
 	};
 
 	//---------------------------------------------------------------------//
+
+	struct BSPLightVolume
+	{
+		Byte_t		ambient[ 3 ];
+		Byte_t		directional[ 3 ];
+		Byte_t		direction[ 2 ];		// Longitude and latitude, 1/256 of turn
+	};
+
+	//---------------------------------------------------------------------//
 }
 
 //---------------------------------------------------------------------//
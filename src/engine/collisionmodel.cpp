@@ -0,0 +1,465 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+
+#include "collisionmodel.h"
+
+// Count of traces taken by worker thread at once
+#define COLLISIONMODEL_BATCH_CHUNK		64
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::CollisionModel::CollisionModel()
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Build collision data
+// ------------------------------------------------------------------------------------ //
+void le::CollisionModel::Build( const std::vector< BSPCompactNode >& Nodes, const std::vector< BSPLeaf >& Leafs, const std::vector< int >& LeafBrushes,
+								const std::vector< BSPBrush >& Brushes, const std::vector< BSPBrushSide >& BrushSides, const std::vector< BSPPlane >& Planes,
+								const std::vector< BSPTexture >& Textures )
+{
+	Clear();
+	nodes = Nodes;
+
+	// Only solid brushes take part in traces, others are remapped to -1
+	std::vector< int >		remap( Brushes.size(), -1 );
+
+	for ( UInt32_t index = 0, count = Brushes.size(); index < count; ++index )
+	{
+		const BSPBrush&		bspBrush = Brushes[ index ];
+		if ( bspBrush.textureID < 0 || bspBrush.textureID >= ( int ) Textures.size() || !( Textures[ bspBrush.textureID ].type & BC_SOLID ) ||
+			 bspBrush.numOfBrushSides <= 0 )
+			continue;
+
+		Brush			brush;
+		brush.min = Vector3D_t( -FLT_MAX );
+		brush.max = Vector3D_t( FLT_MAX );
+		brush.firstSide = sideDistances.size();
+		brush.countSides = bspBrush.numOfBrushSides;
+		brush.bspIndex = index;
+
+		for ( int indexSide = 0; indexSide < bspBrush.numOfBrushSides; ++indexSide )
+		{
+			const BSPPlane&		plane = Planes[ BrushSides[ bspBrush.brushSide + indexSide ].plane ];
+
+			sideNormalsX.push_back( plane.normal.x );
+			sideNormalsY.push_back( plane.normal.y );
+			sideNormalsZ.push_back( plane.normal.z );
+			sideDistances.push_back( plane.distance );
+
+			// Axial sides give bounds of brush
+			for ( UInt32_t axis = 0; axis < 3; ++axis )
+				if ( plane.normal[ axis ] == 1.f )
+					brush.max[ axis ] = plane.distance;
+				else if ( plane.normal[ axis ] == -1.f )
+					brush.min[ axis ] = -plane.distance;
+		}
+
+		remap[ index ] = brushes.size();
+		brushes.push_back( brush );
+	}
+
+	leafFirstBrush.reserve( Leafs.size() + 1 );
+	for ( UInt32_t index = 0, count = Leafs.size(); index < count; ++index )
+	{
+		const BSPLeaf&		leaf = Leafs[ index ];
+		leafFirstBrush.push_back( leafBrushes.size() );
+
+		for ( int indexBrush = 0; indexBrush < leaf.numOfLeafBrushes; ++indexBrush )
+		{
+			int			brush = remap[ LeafBrushes[ leaf.leafBrush + indexBrush ] ];
+			if ( brush >= 0 )		leafBrushes.push_back( brush );
+		}
+	}
+
+	leafFirstBrush.push_back( leafBrushes.size() );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Clear collision data
+// ------------------------------------------------------------------------------------ //
+void le::CollisionModel::Clear()
+{
+	nodes.clear();
+	brushes.clear();
+	sideNormalsX.clear();
+	sideNormalsY.clear();
+	sideNormalsZ.clear();
+	sideDistances.clear();
+	leafFirstBrush.clear();
+	leafBrushes.clear();
+
+	// Contexts are sized by count of brushes, new ones will be made for next level
+	std::lock_guard< std::mutex >		lockGuard( mutexContexts );
+	freeContexts.clear();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Trace from calling thread
+// ------------------------------------------------------------------------------------ //
+void le::CollisionModel::Trace( const TraceRequest& Request, TraceResult& Result )
+{
+	TraceContext*		context = AcquireContext();
+	Trace( *context, Request, Result );
+	ReleaseContext( context );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Trace many requests
+// ------------------------------------------------------------------------------------ //
+void le::CollisionModel::TraceBatch( const TraceRequest* Requests, TraceResult* Results, UInt32_t Count )
+{
+	UInt32_t		countThreads = Count < COLLISIONMODEL_MIN_PARALLEL_TRACES ? 1 :
+		glm::clamp( std::thread::hardware_concurrency(), 1u, ( Count + COLLISIONMODEL_BATCH_CHUNK - 1 ) / COLLISIONMODEL_BATCH_CHUNK );
+
+	if ( countThreads == 1 )
+	{
+		TraceContext*		context = AcquireContext();
+		for ( UInt32_t index = 0; index < Count; ++index )
+			Trace( *context, Requests[ index ], Results[ index ] );
+
+		ReleaseContext( context );
+		return;
+	}
+
+	// Each thread owns context with its own check counters
+	std::vector< TraceContext* >	contexts( countThreads );
+	for ( UInt32_t index = 0; index < countThreads; ++index )
+		contexts[ index ] = AcquireContext();
+
+	std::atomic< UInt32_t >			nextTrace( 0 );
+	std::vector< std::thread >		threads;
+
+	auto							worker = [ & ]( UInt32_t IndexThread )
+	{
+		TraceContext&		context = *contexts[ IndexThread ];
+		for ( UInt32_t start = nextTrace.fetch_add( COLLISIONMODEL_BATCH_CHUNK ); start < Count; start = nextTrace.fetch_add( COLLISIONMODEL_BATCH_CHUNK ) )
+			for ( UInt32_t index = start, end = glm::min( start + COLLISIONMODEL_BATCH_CHUNK, Count ); index < end; ++index )
+				Trace( context, Requests[ index ], Results[ index ] );
+	};
+
+	// Calling thread works too
+	for ( UInt32_t indexThread = 1; indexThread < countThreads; ++indexThread )
+		threads.push_back( std::thread( worker, indexThread ) );
+
+	worker( 0 );
+
+	for ( UInt32_t index = 0, count = threads.size(); index < count; ++index )
+		threads[ index ].join();
+
+	for ( UInt32_t index = 0; index < countThreads; ++index )
+		ReleaseContext( contexts[ index ] );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Trace one request
+// ------------------------------------------------------------------------------------ //
+void le::CollisionModel::Trace( TraceContext& Context, const TraceRequest& Request, TraceResult& Result ) const
+{
+	Result.isStartSolid = false;
+	Result.isAllSolid = false;
+	Result.fraction = 1.f;
+	Result.normal = Vector3D_t( 0.f );
+	Result.brush = -1;
+
+	if ( nodes.empty() )
+	{
+		Result.endPosition = Request.end;
+		return;
+	}
+
+	// Box is traced by its center with symmetric extents, sides of brushes are pushed out by extents
+	TraceWork		work;
+	Vector3D_t		offset( 0.f );
+
+	work.context = &Context;
+	work.result = &Result;
+	work.extents = Vector3D_t( 0.f );
+	work.radius = 0.f;
+
+	switch ( Request.type )
+	{
+	case TRT_BOX:
+		offset = ( Request.min + Request.max ) * 0.5f;
+		work.extents = ( Request.max - Request.min ) * 0.5f;
+		break;
+
+	case TRT_SPHERE:
+		work.radius = Request.radius;
+		break;
+
+	default: break;
+	}
+
+	work.start = Request.start + offset;
+	work.end = Request.end + offset;
+	work.sweptMin = glm::min( work.start, work.end ) - work.extents - work.radius;
+	work.sweptMax = glm::max( work.start, work.end ) + work.extents + work.radius;
+
+	// New check count for this trace, on overflow all counters are reset
+	if ( ++Context.checkCount == 0 )
+	{
+		std::fill( Context.brushCheckCounts.begin(), Context.brushCheckCounts.end(), 0 );
+		Context.checkCount = 1;
+	}
+
+	TraceThroughTree( work, 0, 0.f, 1.f, work.start, work.end );
+
+	if ( Result.fraction == 1.f )
+		Result.endPosition = Request.end;
+	else
+		Result.endPosition = Request.start + ( Request.end - Request.start ) * Result.fraction;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Trace through BSP tree, segment is split by planes of nodes
+// ------------------------------------------------------------------------------------ //
+void le::CollisionModel::TraceThroughTree( TraceWork& Work, int Node, float StartFraction, float EndFraction, const Vector3D_t& Start, const Vector3D_t& End ) const
+{
+	// Already hit something nearer
+	if ( Work.result->fraction <= StartFraction )		return;
+
+	if ( Node < 0 )
+	{
+		TraceThroughLeaf( Work, -Node - 1 );
+		return;
+	}
+
+	const BSPCompactNode&		node = nodes[ Node ];
+	float						startDistance;
+	float						endDistance;
+	float						offset;
+
+	if ( node.axis != BSP_NODE_NOT_AXIAL )
+	{
+		startDistance = node.normal[ node.axis ] * Start[ node.axis ] - node.distance;
+		endDistance = node.normal[ node.axis ] * End[ node.axis ] - node.distance;
+		offset = Work.extents[ node.axis ] + Work.radius;
+	}
+	else
+	{
+		startDistance = glm::dot( node.normal, Start ) - node.distance;
+		endDistance = glm::dot( node.normal, End ) - node.distance;
+		offset = glm::dot( glm::abs( node.normal ), Work.extents ) + Work.radius;
+	}
+
+	// Whole segment with its volume is on one side of plane
+	if ( startDistance >= offset + 1.f && endDistance >= offset + 1.f )
+	{
+		TraceThroughTree( Work, node.children[ 0 ], StartFraction, EndFraction, Start, End );
+		return;
+	}
+
+	if ( startDistance < -offset - 1.f && endDistance < -offset - 1.f )
+	{
+		TraceThroughTree( Work, node.children[ 1 ], StartFraction, EndFraction, Start, End );
+		return;
+	}
+
+	// Split segment, both parts overlap by volume of trace
+	int				side;
+	float			fraction;
+	float			fraction2;
+
+	if ( startDistance < endDistance )
+	{
+		float		inverseDistance = 1.f / ( startDistance - endDistance );
+		side = 1;
+		fraction2 = ( startDistance + offset + COLLISIONMODEL_SURFACE_EPSILON ) * inverseDistance;
+		fraction = ( startDistance - offset + COLLISIONMODEL_SURFACE_EPSILON ) * inverseDistance;
+	}
+	else if ( startDistance > endDistance )
+	{
+		float		inverseDistance = 1.f / ( startDistance - endDistance );
+		side = 0;
+		fraction2 = ( startDistance - offset - COLLISIONMODEL_SURFACE_EPSILON ) * inverseDistance;
+		fraction = ( startDistance + offset + COLLISIONMODEL_SURFACE_EPSILON ) * inverseDistance;
+	}
+	else
+	{
+		side = 0;
+		fraction = 1.f;
+		fraction2 = 0.f;
+	}
+
+	fraction = glm::clamp( fraction, 0.f, 1.f );
+	fraction2 = glm::clamp( fraction2, 0.f, 1.f );
+
+	TraceThroughTree( Work, node.children[ side ], StartFraction, StartFraction + ( EndFraction - StartFraction ) * fraction,
+					  Start, Start + ( End - Start ) * fraction );
+
+	TraceThroughTree( Work, node.children[ side ^ 1 ], StartFraction + ( EndFraction - StartFraction ) * fraction2, EndFraction,
+					  Start + ( End - Start ) * fraction2, End );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Trace against brushes of leaf
+// ------------------------------------------------------------------------------------ //
+void le::CollisionModel::TraceThroughLeaf( TraceWork& Work, int Leaf ) const
+{
+	TraceContext&		context = *Work.context;
+
+	for ( UInt32_t index = leafFirstBrush[ Leaf ], count = leafFirstBrush[ Leaf + 1 ]; index < count; ++index )
+	{
+		UInt32_t		brushIndex = leafBrushes[ index ];
+		if ( context.brushCheckCounts[ brushIndex ] == context.checkCount )		continue;
+		context.brushCheckCounts[ brushIndex ] = context.checkCount;
+
+		const Brush&	brush = brushes[ brushIndex ];
+		if ( brush.min.x > Work.sweptMax.x || brush.min.y > Work.sweptMax.y || brush.min.z > Work.sweptMax.z ||
+			 brush.max.x < Work.sweptMin.x || brush.max.y < Work.sweptMin.y || brush.max.z < Work.sweptMin.z )
+			continue;
+
+		TraceThroughBrush( Work, brushIndex );
+		if ( Work.result->isAllSolid )		return;
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Clip trace by convex brush
+// ------------------------------------------------------------------------------------ //
+void le::CollisionModel::TraceThroughBrush( TraceWork& Work, UInt32_t Brush ) const
+{
+	const CollisionModel::Brush&	brush = brushes[ Brush ];
+	TraceContext&					context = *Work.context;
+	float*							startDistances = context.startDistances.data();
+	float*							endDistances = context.endDistances.data();
+	const float*					normalsX = &sideNormalsX[ brush.firstSide ];
+	const float*					normalsY = &sideNormalsY[ brush.firstSide ];
+	const float*					normalsZ = &sideNormalsZ[ brush.firstSide ];
+	const float*					distances = &sideDistances[ brush.firstSide ];
+
+	// Distances to all sides pushed out by volume of trace. Loop has no branches, so compiler vectorizes it
+	for ( UInt32_t index = 0; index < brush.countSides; ++index )
+	{
+		float		distance = distances[ index ] + fabsf( normalsX[ index ] ) * Work.extents.x + fabsf( normalsY[ index ] ) * Work.extents.y +
+							   fabsf( normalsZ[ index ] ) * Work.extents.z + Work.radius;
+
+		startDistances[ index ] = normalsX[ index ] * Work.start.x + normalsY[ index ] * Work.start.y + normalsZ[ index ] * Work.start.z - distance;
+		endDistances[ index ] = normalsX[ index ] * Work.end.x + normalsY[ index ] * Work.end.y + normalsZ[ index ] * Work.end.z - distance;
+	}
+
+	bool			isGetOut = false;
+	bool			isStartOut = false;
+	float			enterFraction = -1.f;
+	float			leaveFraction = 1.f;
+	int				clipSide = -1;
+
+	for ( UInt32_t index = 0; index < brush.countSides; ++index )
+	{
+		float		startDistance = startDistances[ index ];
+		float		endDistance = endDistances[ index ];
+
+		if ( endDistance > 0.f )		isGetOut = true;
+		if ( startDistance > 0.f )		isStartOut = true;
+
+		// Completely in front of side, no contact with brush
+		if ( startDistance > 0.f && ( endDistance >= COLLISIONMODEL_SURFACE_EPSILON || endDistance >= startDistance ) )
+			return;
+
+		// Completely behind side
+		if ( startDistance <= 0.f && endDistance <= 0.f )
+			continue;
+
+		if ( startDistance > endDistance )
+		{
+			// Enter brush
+			float		fraction = glm::max( ( startDistance - COLLISIONMODEL_SURFACE_EPSILON ) / ( startDistance - endDistance ), 0.f );
+			if ( fraction > enterFraction )
+			{
+				enterFraction = fraction;
+				clipSide = index;
+			}
+		}
+		else
+		{
+			// Leave brush
+			float		fraction = glm::min( ( startDistance + COLLISIONMODEL_SURFACE_EPSILON ) / ( startDistance - endDistance ), 1.f );
+			if ( fraction < leaveFraction )
+				leaveFraction = fraction;
+		}
+	}
+
+	TraceResult&		result = *Work.result;
+
+	if ( !isStartOut )
+	{
+		result.isStartSolid = true;
+		result.brush = brush.bspIndex;
+
+		if ( !isGetOut )
+		{
+			result.isAllSolid = true;
+			result.fraction = 0.f;
+		}
+
+		return;
+	}
+
+	if ( enterFraction < leaveFraction && enterFraction > -1.f && enterFraction < result.fraction && clipSide >= 0 )
+	{
+		UInt32_t		side = brush.firstSide + clipSide;
+
+		result.fraction = glm::max( enterFraction, 0.f );
+		result.normal = Vector3D_t( sideNormalsX[ side ], sideNormalsY[ side ], sideNormalsZ[ side ] );
+		result.brush = brush.bspIndex;
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Prepare context for current collision data
+// ------------------------------------------------------------------------------------ //
+void le::CollisionModel::InitializeContext( TraceContext& Context ) const
+{
+	UInt32_t		maxSides = 0;
+	for ( UInt32_t index = 0, count = brushes.size(); index < count; ++index )
+		maxSides = glm::max( maxSides, brushes[ index ].countSides );
+
+	Context.checkCount = 0;
+	Context.brushCheckCounts.assign( brushes.size(), 0 );
+	Context.startDistances.resize( maxSides );
+	Context.endDistances.resize( maxSides );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Take free context or make new one
+// ------------------------------------------------------------------------------------ //
+le::CollisionModel::TraceContext* le::CollisionModel::AcquireContext()
+{
+	{
+		std::lock_guard< std::mutex >		lockGuard( mutexContexts );
+		if ( !freeContexts.empty() )
+		{
+			TraceContext*		context = freeContexts.back().release();
+			freeContexts.pop_back();
+			return context;
+		}
+	}
+
+	TraceContext*		context = new TraceContext();
+	InitializeContext( *context );
+	return context;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Return context to free list
+// ------------------------------------------------------------------------------------ //
+void le::CollisionModel::ReleaseContext( TraceContext* Context )
+{
+	std::lock_guard< std::mutex >		lockGuard( mutexContexts );
+	freeContexts.push_back( std::unique_ptr< TraceContext >( Context ) );
+}
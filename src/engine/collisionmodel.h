@@ -0,0 +1,131 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef COLLISIONMODEL_H
+#define COLLISIONMODEL_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "common/types.h"
+#include "engine/trace.h"
+#include "bsp.h"
+
+//---------------------------------------------------------------------//
+
+// Distance kept between trace end position and brush side
+#define COLLISIONMODEL_SURFACE_EPSILON		0.125f
+
+// Minimum count of traces in batch before it is split across threads
+#define COLLISIONMODEL_MIN_PARALLEL_TRACES	256
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	class CollisionModel
+	{
+	public:
+		CollisionModel();
+
+		// Build collision data from solid brushes of level, all planes must be in engine axes.
+		// Build and Clear must not run concurrently with traces
+		void					Build( const std::vector< BSPCompactNode >& Nodes, const std::vector< BSPLeaf >& Leafs, const std::vector< int >& LeafBrushes,
+									   const std::vector< BSPBrush >& Brushes, const std::vector< BSPBrushSide >& BrushSides, const std::vector< BSPPlane >& Planes,
+									   const std::vector< BSPTexture >& Textures );
+		void					Clear();
+
+		// Trace from calling thread, safe to call from several threads at once
+		void					Trace( const TraceRequest& Request, TraceResult& Result );
+
+		// Trace many requests, large batches are split across worker threads
+		void					TraceBatch( const TraceRequest* Requests, TraceResult* Results, UInt32_t Count );
+
+		inline UInt32_t			GetCountBrushes() const
+		{
+			return brushes.size();
+		}
+
+	private:
+
+		//---------------------------------------------------------------------//
+
+		struct Brush
+		{
+			Vector3D_t		min;
+			Vector3D_t		max;
+			UInt32_t		firstSide;
+			UInt32_t		countSides;
+			int				bspIndex;
+		};
+
+		//---------------------------------------------------------------------//
+
+		// Per thread state. Check counters mark brushes already tested by current trace,
+		// so brushes shared by several leafs are clipped only once
+		struct TraceContext
+		{
+			UInt32_t					checkCount;
+			std::vector< UInt32_t >		brushCheckCounts;
+			std::vector< float >		startDistances;
+			std::vector< float >		endDistances;
+		};
+
+		//---------------------------------------------------------------------//
+
+		struct TraceWork
+		{
+			TraceContext*		context;
+			TraceResult*		result;
+			Vector3D_t			start;
+			Vector3D_t			end;
+			Vector3D_t			extents;
+			float				radius;
+			Vector3D_t			sweptMin;
+			Vector3D_t			sweptMax;
+		};
+
+		//---------------------------------------------------------------------//
+
+		void					Trace( TraceContext& Context, const TraceRequest& Request, TraceResult& Result ) const;
+		void					TraceThroughTree( TraceWork& Work, int Node, float StartFraction, float EndFraction, const Vector3D_t& Start, const Vector3D_t& End ) const;
+		void					TraceThroughLeaf( TraceWork& Work, int Leaf ) const;
+		void					TraceThroughBrush( TraceWork& Work, UInt32_t Brush ) const;
+		void					InitializeContext( TraceContext& Context ) const;
+		TraceContext*			AcquireContext();
+		void					ReleaseContext( TraceContext* Context );
+
+		std::vector< BSPCompactNode >		nodes;
+		std::vector< Brush >				brushes;
+
+		// Brush side planes in structure of arrays, so distances to all sides of brush are computed in one pass
+		std::vector< float >				sideNormalsX;
+		std::vector< float >				sideNormalsY;
+		std::vector< float >				sideNormalsZ;
+		std::vector< float >				sideDistances;
+
+		// Solid brushes of each leaf, leaf N owns range [ leafFirstBrush[ N ], leafFirstBrush[ N + 1 ] )
+		std::vector< UInt32_t >				leafFirstBrush;
+		std::vector< UInt32_t >				leafBrushes;
+
+		// Contexts not used by any trace now, each trace takes one for its duration
+		std::mutex										mutexContexts;
+		std::vector< std::unique_ptr< TraceContext > >	freeContexts;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !COLLISIONMODEL_H
@@ -9,8 +9,9 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <stdarg.h>
+#include <stdlib.h>
+#include <chrono>
 #include <string>
-#include <sstream>
 #include <vector>
 
 #include "engine/lifeengine.h"
@@ -21,6 +22,9 @@
 #include "global.h"
 
 le::ConCmd*     con_help = nullptr;
+le::ConVar*		con_loglevel = nullptr;
+le::ConVar*		con_ratelimit = nullptr;
+le::ConCmd*		con_benchmark = nullptr;
 
 namespace le
 {
@@ -46,6 +50,36 @@ namespace le
 		    g_consoleSystem->PrintInfo( "%s : %s", conCmd->GetName(), conCmd->GetHelpText() );
         }
 	}
+
+	// ------------------------------------------------------------------------------------ //
+	// Консольная комманда замера скорости выполнения команды
+	// ------------------------------------------------------------------------------------ //
+	void CMD_Benchmark( le::UInt32_t CountArguments, const char** Arguments )
+	{
+		if ( CountArguments < 2 || !Arguments )
+		{
+			g_consoleSystem->PrintInfo( "Using command \"con_benchmark\": con_benchmark <count> <command>" );
+			return;
+		}
+
+		UInt32_t				count = atoi( Arguments[ 0 ] );
+		PreparedCommand			preparedCommand;
+		g_consoleSystem->Prepare( Arguments[ 1 ], preparedCommand );
+		if ( count == 0 )		return;
+
+		auto			startTime = std::chrono::steady_clock::now();
+		for ( UInt32_t index = 0; index < count; ++index )
+			g_consoleSystem->Exec( Arguments[ 1 ] );
+
+		auto			middleTime = std::chrono::steady_clock::now();
+		for ( UInt32_t index = 0; index < count; ++index )
+			g_consoleSystem->Exec( preparedCommand );
+
+		auto			endTime = std::chrono::steady_clock::now();
+		double			timeExec = std::chrono::duration< double, std::micro >( middleTime - startTime ).count() / count;
+		double			timePrepared = std::chrono::duration< double, std::micro >( endTime - middleTime ).count() / count;
+		g_consoleSystem->PrintInfo( "Exec: %.3f us per call, prepared: %.3f us per call", timeExec, timePrepared );
+	}
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -53,11 +87,32 @@ namespace le
 // ------------------------------------------------------------------------------------ //
 void le::ConsoleSystem::Initialize()
 {
-	fileLog = fopen( "engine.log", "w" );
+	logger.Open( "engine.log" );
 
 	con_help = new ConCmd();
 	con_help->Initialize( "help", "Show help variables and comands", CMD_Help );
 	RegisterCommand( con_help );
+
+	// Фильтр сообщений по уровню и ограничение частоты сообщений одного места вызова
+	con_loglevel = new ConVar();
+	con_loglevel->Initialize( "con_loglevel", "0", CVT_INT, "Min level of log messages: 0 - info, 1 - warnings, 2 - errors", true, 0, true, 2,
+							  []( le::IConVar* Var )
+							  {
+								  g_consoleSystem->GetLogger().SetMinLevel( ( le::LOG_LEVEL ) Var->GetValueInt() );
+							  } );
+	RegisterVar( con_loglevel );
+
+	con_ratelimit = new ConVar();
+	con_ratelimit->Initialize( "con_ratelimit", "0", CVT_INT, "Max count of log messages per second from one place of code, 0 - without limit", true, 0, false, 0,
+							   []( le::IConVar* Var )
+							   {
+								   g_consoleSystem->GetLogger().SetRateLimit( Var->GetValueInt() );
+							   } );
+	RegisterVar( con_ratelimit );
+
+	con_benchmark = new ConCmd();
+	con_benchmark->Initialize( "con_benchmark", "Measure time of command by text and prepared command", CMD_Benchmark );
+	RegisterCommand( con_benchmark );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -69,6 +124,7 @@ void le::ConsoleSystem::RegisterVar( IConVar* ConVar )
 	
 	if ( vars.find( ConVar->GetName() ) != vars.end() ) return;
 	vars[ ConVar->GetName() ] = ConVar;
+	++generation;
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -80,6 +136,7 @@ void le::ConsoleSystem::RegisterCommand( IConCmd* ConCmd )
 
 	if ( commands.find( ConCmd->GetName() ) != commands.end() ) return;
 	commands[ ConCmd->GetName() ] = ConCmd;
+	++generation;
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -91,6 +148,7 @@ void le::ConsoleSystem::UnregisterVar( const char* Name )
 
 	if ( it == vars.end() ) return;
 	vars.erase( it );
+	++generation;
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -102,6 +160,7 @@ void le::ConsoleSystem::UnregisterCommand( const char* Name )
 
 	if ( it == commands.end() ) return;
 	commands.erase( it );
+	++generation;
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -109,109 +168,147 @@ void le::ConsoleSystem::UnregisterCommand( const char* Name )
 // ------------------------------------------------------------------------------------ //
 bool le::ConsoleSystem::Exec( const char* Command )
 {
-	std::string			command( Command );
-	if ( command.empty() ) return false;
-
-	// Находим название комманды или переменной в строке
+	// Токенизатор на стеке, т.к. команда может выполнить другую команду
+	ConsoleTokenizer		tokenizer;
+	if ( !tokenizer.Tokenize( Command ) ) return false;
 
-	UInt32_t		startIndexName = command.find_first_not_of( ' ' );
-	UInt32_t		endIndexName = command.find_first_of( ' ', startIndexName );
-	std::string		name = command.substr( startIndexName, endIndexName - startIndexName );
-	std::string		arguments = endIndexName != std::string::npos ? command.substr( endIndexName + 1, command.size() - endIndexName ) : "";
+	lookupName.assign( tokenizer.GetName(), tokenizer.GetNameLength() );
 
 	// Ищем по названию переменную, если нашли то меняем ее значение
 
-	auto		itVar = vars.find( name );
+	auto		itVar = vars.find( lookupName );
 	if ( itVar != vars.end() )
 	{
-		IConVar*		var = itVar->second;
-
-		if ( !arguments.empty() && arguments.find_first_not_of( ' ' ) != std::string::npos )
-			var->SetValue( arguments.c_str(), var->GetType() );
-		else
-		{
-			std::string		conVar;
-			if ( var->GetType() == CVT_STRING )
-				conVar = var->GetValueString();
-			else
-				switch ( var->GetType() )
-				{
-				case CVT_INT:		conVar = std::to_string( var->GetValueInt() ); break;
-				case CVT_FLOAT:		conVar = std::to_string( var->GetValueFloat() ); break;
-				case CVT_BOOL:		conVar = var->GetValueBool() ? "true" : "fasle"; break;
-				default:			conVar = ""; break;
-				}
-
-			PrintInfo( "%s: %s", name.c_str(), itVar->second->GetHelpText() );
-			PrintInfo( "Value: %s", conVar.c_str() );
-			PrintInfo( "Default value: %s", itVar->second->GetValueDefault() );
-		}
-
+		ExecVar( itVar->second, tokenizer.IsArgumentsEmpty() ? nullptr : tokenizer.GetArgumentsString() );
 		return true;
 	}
 
 	// Ищем по названию комманду, если нашли то выполняем ее
 
-	auto		itCommand = commands.find( name );
+	auto		itCommand = commands.find( lookupName );
 	if ( itCommand != commands.end() )
-	{	
-		// Разбиваем строку на подстроки
-
-		bool							isFindApostrof = false;
-		bool							isEndSubstring = false;
-		std::string						tempString;
-		std::vector<const char*>		arrayArguments;
+	{
+		itCommand->second->Exec( tokenizer.GetCountArguments(), tokenizer.GetArguments() );
+		return true;
+	}
 
-		for ( UInt32_t index = 0, count = arguments.size(); index < count; ++index )
-		{
-			if ( arguments[ index ] == '\"' )
-			{
-				isFindApostrof = !isFindApostrof;
-
-				if ( isFindApostrof )	continue;
-				else					isEndSubstring = true;
-			}
-			else if ( !isFindApostrof && arguments[ index ] == ' ' && !tempString.empty() )
-				isEndSubstring = true;
-
-			if ( !isEndSubstring )		tempString += arguments[ index ];
-			if ( isEndSubstring || index + 1 >= count )
-			{
-				arrayArguments.push_back( new char[ tempString.size() ] );
-				strcpy( ( char* ) arrayArguments[ arrayArguments.size() - 1 ], tempString.data() );
-
-				tempString.clear();
-				isEndSubstring = false;
-			}
-		}
+	PrintError( "Not correct command: \"%s\"", Command );
+	return false;
+}
 
-		// Выполняем команду
+// ------------------------------------------------------------------------------------ //
+// Выполнить разобранную команду
+// ------------------------------------------------------------------------------------ //
+bool le::ConsoleSystem::Exec( PreparedCommand& PreparedCommand )
+{
+	// Переменные или команды регистрировались - связываем команду заново
+	if ( PreparedCommand.generation != generation )
+		Resolve( PreparedCommand );
 
-		itCommand->second->Exec( arrayArguments.size(), arrayArguments.data() );
+	if ( PreparedCommand.var )
+	{
+		ExecVar( PreparedCommand.var, PreparedCommand.value.empty() ? nullptr : PreparedCommand.value.c_str() );
+		return true;
+	}
 
-		for ( UInt32_t index = 0, count = arrayArguments.size(); index < count; index++ )	
-			delete[] arrayArguments[ index ];
+	if ( PreparedCommand.command )
+	{
+		// При копировании команды строки аргументов могли сменить адрес
+		if ( !PreparedCommand.argumentPointers.empty() && PreparedCommand.argumentPointers[ 0 ] != PreparedCommand.arguments[ 0 ].c_str() )
+			for ( UInt32_t index = 0, count = PreparedCommand.arguments.size(); index < count; ++index )
+				PreparedCommand.argumentPointers[ index ] = PreparedCommand.arguments[ index ].c_str();
 
+		PreparedCommand.command->Exec( PreparedCommand.argumentPointers.size(), PreparedCommand.argumentPointers.data() );
 		return true;
 	}
 
-	PrintError( "Not correct command: \"%s\"", Command );
+	PrintError( "Not correct command: \"%s\"", PreparedCommand.text.c_str() );
 	return false;
 }
 
+// ------------------------------------------------------------------------------------ //
+// Разобрать команду для многократного выполнения
+// ------------------------------------------------------------------------------------ //
+void le::ConsoleSystem::Prepare( const char* Command, PreparedCommand& PreparedCommand )
+{
+	PreparedCommand.text = Command ? Command : "";
+	Resolve( PreparedCommand );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Разобрать текст команды и найти переменную или команду
+// ------------------------------------------------------------------------------------ //
+void le::ConsoleSystem::Resolve( PreparedCommand& PreparedCommand )
+{
+	PreparedCommand.generation = generation;
+	PreparedCommand.var = nullptr;
+	PreparedCommand.command = nullptr;
+	PreparedCommand.value.clear();
+	PreparedCommand.arguments.clear();
+	PreparedCommand.argumentPointers.clear();
+
+	ConsoleTokenizer		tokenizer;
+	if ( !tokenizer.Tokenize( PreparedCommand.text.c_str() ) ) return;
+
+	lookupName.assign( tokenizer.GetName(), tokenizer.GetNameLength() );
+
+	auto		itVar = vars.find( lookupName );
+	if ( itVar != vars.end() )
+	{
+		PreparedCommand.var = itVar->second;
+		if ( !tokenizer.IsArgumentsEmpty() )		PreparedCommand.value = tokenizer.GetArgumentsString();
+		return;
+	}
+
+	auto		itCommand = commands.find( lookupName );
+	if ( itCommand == commands.end() ) return;
+
+	PreparedCommand.command = itCommand->second;
+	for ( UInt32_t index = 0, count = tokenizer.GetCountArguments(); index < count; ++index )
+		PreparedCommand.arguments.push_back( tokenizer.GetArguments()[ index ] );
+
+	for ( UInt32_t index = 0, count = PreparedCommand.arguments.size(); index < count; ++index )
+		PreparedCommand.argumentPointers.push_back( PreparedCommand.arguments[ index ].c_str() );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Задать значение переменной или вывести информацию о ней
+// ------------------------------------------------------------------------------------ //
+void le::ConsoleSystem::ExecVar( IConVar* ConVar, const char* Value )
+{
+	if ( Value )
+	{
+		ConVar->SetValue( Value, ConVar->GetType() );
+		return;
+	}
+
+	std::string		conVar;
+	if ( ConVar->GetType() == CVT_STRING )
+		conVar = ConVar->GetValueString();
+	else
+		switch ( ConVar->GetType() )
+		{
+		case CVT_INT:		conVar = std::to_string( ConVar->GetValueInt() ); break;
+		case CVT_FLOAT:		conVar = std::to_string( ConVar->GetValueFloat() ); break;
+		case CVT_BOOL:		conVar = ConVar->GetValueBool() ? "true" : "fasle"; break;
+		default:			conVar = ""; break;
+		}
+
+	PrintInfo( "%s: %s", ConVar->GetName(), ConVar->GetHelpText() );
+	PrintInfo( "Value: %s", conVar.c_str() );
+	PrintInfo( "Default value: %s", ConVar->GetValueDefault() );
+}
+
 // ------------------------------------------------------------------------------------ //
 // Вывести сообщение-информацию
 // ------------------------------------------------------------------------------------ //
 void le::ConsoleSystem::PrintInfo( const char* Message, ... )
 {
-	if ( !fileLog ) return;
-	va_list			argList = nullptr;	
+	va_list			argList = nullptr;
 
-	va_start( argList, Message );	
-	vfprintf( fileLog, ( "[Info] " + std::string( Message ) + "\n" ).c_str(), argList );
+	va_start( argList, Message );
+	logger.Print( LL_INFO, Message, argList );
 	va_end( argList );
-
-	fflush( fileLog );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -219,14 +316,11 @@ void le::ConsoleSystem::PrintInfo( const char* Message, ... )
 // ------------------------------------------------------------------------------------ //
 void le::ConsoleSystem::PrintWarning( const char* Message, ... )
 {
-	if ( !fileLog ) return;
 	va_list			argList = nullptr;
 
 	va_start( argList, Message );
-	vfprintf( fileLog, ( "[Warning] " + std::string( Message ) + "\n" ).c_str(), argList );
+	logger.Print( LL_WARNING, Message, argList );
 	va_end( argList );
-
-	fflush( fileLog );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -234,14 +328,11 @@ void le::ConsoleSystem::PrintWarning( const char* Message, ... )
 // ------------------------------------------------------------------------------------ //
 void le::ConsoleSystem::PrintError( const char* Message, ... )
 {
-	if ( !fileLog ) return;
 	va_list			argList = nullptr;
 
 	va_start( argList, Message );
-	vfprintf( fileLog, ( "[Error] " + std::string( Message ) + "\n" ).c_str(), argList );
+	logger.Print( LL_ERROR, Message, argList );
 	va_end( argList );
-
-	fflush( fileLog );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -278,7 +369,7 @@ le::IFactory* le::ConsoleSystem::GetFactory() const
 // Конструктор
 // ------------------------------------------------------------------------------------ //
 le::ConsoleSystem::ConsoleSystem() :
-	fileLog( nullptr )
+	generation( 1 )
 {}
 
 // ------------------------------------------------------------------------------------ //
@@ -286,10 +377,29 @@ le::ConsoleSystem::ConsoleSystem() :
 // ------------------------------------------------------------------------------------ //
 le::ConsoleSystem::~ConsoleSystem()
 {
-	if ( fileLog )		fclose( fileLog );
 	if ( con_help )
     {
 	    UnregisterCommand( "help" );
 	    delete con_help;
     }
+
+	if ( con_loglevel )
+	{
+		UnregisterVar( "con_loglevel" );
+		delete con_loglevel;
+	}
+
+	if ( con_ratelimit )
+	{
+		UnregisterVar( "con_ratelimit" );
+		delete con_ratelimit;
+	}
+
+	if ( con_benchmark )
+	{
+		UnregisterCommand( "con_benchmark" );
+		delete con_benchmark;
+	}
+
+	logger.Close();
 }
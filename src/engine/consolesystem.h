@@ -11,13 +11,15 @@
 #ifndef CONSOLESYSTEM_H
 #define CONSOLESYSTEM_H
 
-#include <stdio.h>
 #include <string>
+#include <vector>
 #include <unordered_map>
 
 #include "common/types.h"
 #include "engine/iconsolesysteminternal.h"
 #include "engine/consolesystemfactory.h"
+#include "engine/logger.h"
+#include "engine/consoletokenizer.h"
 
 //---------------------------------------------------------------------//
 
@@ -25,6 +27,26 @@ namespace le
 {
 	//---------------------------------------------------------------------//
 
+	// Команда, разобранная один раз и связанная с переменной или командой консоли
+	struct PreparedCommand
+	{
+		PreparedCommand() :
+			generation( 0 ),
+			var( nullptr ),
+			command( nullptr )
+		{}
+
+		std::string						text;
+		UInt32_t						generation;
+		IConVar*						var;
+		IConCmd*						command;
+		std::string						value;
+		std::vector< std::string >		arguments;
+		std::vector< const char* >		argumentPointers;
+	};
+
+	//---------------------------------------------------------------------//
+
 	class ConsoleSystem : public IConsoleSystemInternal
 	{
 	public:
@@ -51,8 +73,21 @@ namespace le
 		ConsoleSystem();
 		~ConsoleSystem();
 
+		void				Prepare( const char* Command, PreparedCommand& PreparedCommand );
+		bool				Exec( PreparedCommand& PreparedCommand );
+
+		inline Logger&		GetLogger()
+		{
+			return logger;
+		}
+
 	private:
-		FILE*												fileLog;
+		void				Resolve( PreparedCommand& PreparedCommand );
+		void				ExecVar( IConVar* ConVar, const char* Value );
+
+		Logger												logger;
+		std::string											lookupName;
+		UInt32_t											generation;
 
 		ConsoleSystemFactory								consoleSystemFactory;
 		std::unordered_map< std::string, IConVar* >			vars;
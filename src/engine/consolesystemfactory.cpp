@@ -19,10 +19,20 @@
 // ------------------------------------------------------------------------------------ //
 void* le::ConsoleSystemFactory::Create( const char* NameInterface )
 {
-	if ( strcmp( NameInterface, CONCMD_INTERFACE_VERSION ) == 0 )				return new ConCmd();
-	else if ( strcmp( NameInterface, CONVAR_INTERFACE_VERSION ) == 0 )			return new ConVar();
+	return Create( HashInterface( NameInterface ) );
+}
 
-	return nullptr;
+// ------------------------------------------------------------------------------------ //
+// Создать объект по хешу названия интерфейса
+// ------------------------------------------------------------------------------------ //
+void* le::ConsoleSystemFactory::Create( UInt32_t InterfaceID )
+{
+	switch ( InterfaceID )
+	{
+	case HashInterface( CONCMD_INTERFACE_VERSION ):			return new ConCmd();
+	case HashInterface( CONVAR_INTERFACE_VERSION ):			return new ConVar();
+	default:												return nullptr;
+	}
 }
 
 // ------------------------------------------------------------------------------------ //
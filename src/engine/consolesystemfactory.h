@@ -22,6 +22,7 @@ namespace le
 	public:
 		// IFactory
 		virtual void*			Create( const char* NameInterface );
+		virtual void*			Create( UInt32_t InterfaceID );
 		virtual void			Delete( void* Object );
 	};
 
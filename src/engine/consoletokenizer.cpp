@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#include "consoletokenizer.h"
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::ConsoleTokenizer::ConsoleTokenizer() :
+	buffer( inlineBuffer ),
+	tokens( inlineTokens ),
+	bufferOffset( 0 ),
+	countTokens( 0 ),
+	nameLength( 0 ),
+	argumentsString( "" )
+{
+	inlineBuffer[ 0 ] = '\0';
+	inlineTokens[ 0 ] = inlineBuffer;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Split command to tokens
+// ------------------------------------------------------------------------------------ //
+bool le::ConsoleTokenizer::Tokenize( const char* Command )
+{
+	UInt32_t		length = Command ? strlen( Command ) : 0;
+
+	// Tokens are separated by space or quote, so there are not more than half of chars
+	UInt32_t		maxTokens = ( length + 1 ) / 2 + 1;
+	UInt32_t		bufferSize = length + maxTokens;
+
+	if ( bufferSize <= CONSOLETOKENIZER_BUFFER_SIZE && maxTokens <= CONSOLETOKENIZER_MAX_TOKENS )
+	{
+		buffer = inlineBuffer;
+		tokens = inlineTokens;
+	}
+	else
+	{
+		if ( heapBuffer.size() < bufferSize )		heapBuffer.resize( bufferSize );
+		if ( heapTokens.size() < maxTokens )		heapTokens.resize( maxTokens );
+
+		buffer = heapBuffer.data();
+		tokens = heapTokens.data();
+	}
+
+	bufferOffset = 0;
+	countTokens = 0;
+	argumentsString = "";
+	buffer[ 0 ] = '\0';
+	tokens[ 0 ] = buffer;
+	if ( length == 0 )		return false;
+
+	// Name of command ends with first space
+	const char*		it = Command;
+	while ( *it == ' ' )		++it;
+
+	const char*		start = it;
+	while ( *it && *it != ' ' )		++it;
+
+	nameLength = it - start;
+	if ( nameLength == 0 )		return false;
+
+	AddToken( start, nameLength );
+	if ( *it == ' ' )		++it;
+	argumentsString = it;
+
+	// Arguments are split by spaces, text in quotes is one argument
+	while ( *it )
+	{
+		if ( *it == ' ' )
+		{
+			++it;
+			continue;
+		}
+
+		if ( *it == '\"' )
+		{
+			start = ++it;
+			while ( *it && *it != '\"' )		++it;
+
+			AddToken( start, it - start );
+			if ( *it )		++it;
+		}
+		else
+		{
+			start = it;
+			while ( *it && *it != ' ' )		++it;
+
+			AddToken( start, it - start );
+		}
+	}
+
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Add token to buffer
+// ------------------------------------------------------------------------------------ //
+void le::ConsoleTokenizer::AddToken( const char* Start, UInt32_t Length )
+{
+	char*		token = buffer + bufferOffset;
+	memcpy( token, Start, Length );
+	token[ Length ] = '\0';
+
+	tokens[ countTokens ] = token;
+	++countTokens;
+	bufferOffset += Length + 1;
+}
@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef CONSOLETOKENIZER_H
+#define CONSOLETOKENIZER_H
+
+#include <vector>
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+#define CONSOLETOKENIZER_BUFFER_SIZE		512
+#define CONSOLETOKENIZER_MAX_TOKENS			64
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Splits command to name and arguments. Tokens are written into inline buffer,
+	// heap is used only for very long commands
+	class ConsoleTokenizer
+	{
+	public:
+		ConsoleTokenizer();
+
+		// Returns false if command has no name. Command must live while tokens are used
+		bool					Tokenize( const char* Command );
+
+		inline const char*		GetName() const
+		{
+			return tokens[ 0 ];
+		}
+
+		inline UInt32_t			GetNameLength() const
+		{
+			return nameLength;
+		}
+
+		inline UInt32_t			GetCountArguments() const
+		{
+			return countTokens - 1;
+		}
+
+		inline const char**		GetArguments() const
+		{
+			return tokens + 1;
+		}
+
+		// Arguments as one string (value of console variable), points into command
+		inline const char*		GetArgumentsString() const
+		{
+			return argumentsString;
+		}
+
+		inline bool				IsArgumentsEmpty() const
+		{
+			return countTokens < 2;
+		}
+
+	private:
+		void					AddToken( const char* Start, UInt32_t Length );
+
+		char							inlineBuffer[ CONSOLETOKENIZER_BUFFER_SIZE ];
+		const char*						inlineTokens[ CONSOLETOKENIZER_MAX_TOKENS ];
+		std::vector< char >				heapBuffer;
+		std::vector< const char* >		heapTokens;
+
+		char*							buffer;
+		const char**					tokens;
+		UInt32_t						bufferOffset;
+		UInt32_t						countTokens;
+		UInt32_t						nameLength;
+		const char*						argumentsString;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !CONSOLETOKENIZER_H
@@ -11,6 +11,9 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <chrono>
+#include <thread>
+#include <csignal>
 #include <rapidjson/rapidjson.h>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
@@ -52,6 +55,32 @@ void CMD_Version( le::UInt32_t CountArguments, const char** Arguments )
 	le::g_consoleSystem->PrintInfo( "lifeEngine %s (build %i)", LIFEENGINE_VERSION, le::Engine_BuildNumber() );
 }
 
+// ------------------------------------------------------------------------------------ //
+// Консольная команда записи ввода
+// ------------------------------------------------------------------------------------ //
+void CMD_RecordInput( le::UInt32_t CountArguments, const char** Arguments )
+{
+	if ( !le::g_engine ) return;
+
+	if ( CountArguments < 1 || !Arguments )
+		le::g_engine->GetInputRecorder().StopRecord();
+	else
+		le::g_engine->GetInputRecorder().StartRecord( Arguments[ 0 ] );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Консольная команда воспроизведения записи ввода
+// ------------------------------------------------------------------------------------ //
+void CMD_ReplayInput( le::UInt32_t CountArguments, const char** Arguments )
+{
+	if ( !le::g_engine ) return;
+
+	if ( CountArguments < 1 || !Arguments )
+		le::g_engine->GetInputRecorder().StopReplay();
+	else
+		le::g_engine->GetInputRecorder().StartReplay( Arguments[ 0 ] );
+}
+
 // ------------------------------------------------------------------------------------ //
 // Конструктор
 // ------------------------------------------------------------------------------------ //
@@ -64,13 +93,16 @@ le::Engine::Engine() :
 	gameDescriptor( { nullptr, nullptr, nullptr, nullptr } ),
 	criticalError( nullptr ),
 	cmd_Exit( new ConCmd() ),
-	cmd_Version( new ConCmd() )
+	cmd_Version( new ConCmd() ),
+	cmd_RecordInput( new ConCmd() ),
+	cmd_ReplayInput( new ConCmd() )
 {
 	LIFEENGINE_ASSERT( !g_engine );
 
 	g_consoleSystem = &consoleSystem;
 	g_resourceSystem = &resourceSystem;
 	g_inputSystem = &inputSystem;
+	g_statsSystem = &statsSystem;
 	g_engine = this;
 
 	configurations.fov = 75.f;
@@ -79,14 +111,22 @@ le::Engine::Engine() :
 	configurations.sensitivityMouse = 0.15f;
 	configurations.windowWidth = 800;
 	configurations.windowHeight = 600;
+	configurations.isHeadless = false;
+	configurations.isCompactGBuffer = false;
+	configurations.tickRate = 60;
 
 	consoleSystem.Initialize();
 	inputSystem.Initialize( this );
+	statsSystem.Initialize();
 	cmd_Exit->Initialize( "exit", "close game", CMD_Exit );
 	cmd_Version->Initialize( "version", "show version engine", CMD_Version );
+	cmd_RecordInput->Initialize( "record_input", "record input to file: record_input <file>, without file - stop", CMD_RecordInput );
+	cmd_ReplayInput->Initialize( "replay_input", "replay input from file: replay_input <file>, without file - stop", CMD_ReplayInput );
 
 	consoleSystem.RegisterCommand( cmd_Exit );
 	consoleSystem.RegisterCommand( cmd_Version );
+	consoleSystem.RegisterCommand( cmd_RecordInput );
+	consoleSystem.RegisterCommand( cmd_ReplayInput );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -112,6 +152,18 @@ le::Engine::~Engine()
 		consoleSystem.UnregisterCommand( cmd_Version->GetName() );
 		delete cmd_Version;
 	}
+
+	if ( cmd_RecordInput )
+	{
+		consoleSystem.UnregisterCommand( cmd_RecordInput->GetName() );
+		delete cmd_RecordInput;
+	}
+
+	if ( cmd_ReplayInput )
+	{
+		consoleSystem.UnregisterCommand( cmd_ReplayInput->GetName() );
+		delete cmd_ReplayInput;
+	}
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -357,6 +409,18 @@ bool le::Engine::LoadConfig( const char* FilePath )
 				// Включена ли вертикальная синхронизация
 				else if ( strcmp( itObject->name.GetString(), "fov" ) == 0 && itObject->value.IsNumber() )
 					configurations.fov = itObject->value.GetFloat();
+
+				// Компактная раскладка G-буфера
+				else if ( strcmp( itObject->name.GetString(), "compactGBuffer" ) == 0 && itObject->value.IsBool() )
+					configurations.isCompactGBuffer = itObject->value.GetBool();
+			}
+
+			// Параметры выделенного сервера
+			else if ( strcmp( it->name.GetString(), "server" ) == 0 )
+			{
+				// Частота обновления логики
+				if ( strcmp( itObject->name.GetString(), "tickRate" ) == 0 && itObject->value.IsNumber() )
+					configurations.tickRate = itObject->value.GetUint();
 			}
 		}
 	}
@@ -389,7 +453,12 @@ bool le::Engine::SaveConfig( const char* FilePath )
 \n\
 	\"studiorender\": {\n\
 		\"vsinc\" : " << ( configurations.isVerticalSinc ? "true" : "false" ) << ",\n\
-		\"fov\" : " << configurations.fov << "\n\
+		\"fov\" : " << configurations.fov << ",\n\
+		\"compactGBuffer\" : " << ( configurations.isCompactGBuffer ? "true" : "false" ) << "\n\
+	},\n\
+\n\
+	\"server\": {\n\
+		\"tickRate\" : " << configurations.tickRate << "\n\
 	}\n\
 }";
 
@@ -402,7 +471,7 @@ bool le::Engine::SaveConfig( const char* FilePath )
 // ------------------------------------------------------------------------------------ //
 void le::Engine::RunSimulation()
 {
-	LIFEENGINE_ASSERT( window.IsOpen() && studioRender );
+	LIFEENGINE_ASSERT( configurations.isHeadless || window.IsOpen() && studioRender );
 	
 	if ( !game )
 	{
@@ -411,6 +480,13 @@ void le::Engine::RunSimulation()
 	}
 
 	consoleSystem.PrintInfo( "*** Game logic start ***" );
+
+	if ( configurations.isHeadless )
+	{
+		RunTickLoop();
+		StopSimulation();
+		return;
+	}
 	
 	UInt32_t			startTime = 0;
 	UInt32_t			deltaTime = 0;
@@ -424,6 +500,10 @@ void le::Engine::RunSimulation()
 
 		while ( window.PollEvent( event ) )
 		{
+			// При воспроизведении записи ввод игрока не применяется
+			if ( inputRecorder.IsReplaying() && InputRecorder::IsInputEvent( event ) )
+				continue;
+
 			switch ( event.type )
 			{
 			case Event::ET_WINDOW_CLOSE:
@@ -456,6 +536,7 @@ void le::Engine::RunSimulation()
 			}
 
 			game->OnEvent( event );
+			inputRecorder.WriteEvent( event );
 		}
 
 		if ( isFocus )
@@ -463,13 +544,25 @@ void le::Engine::RunSimulation()
 			// TODO: Исправить счетчик прошедшего времени, не удобно с ним работать
 
 			startTime = SDL_GetTicks();
+
+			// При воспроизведении события кадра и часы симуляции берутся из записи
+			UInt32_t		frameDeltaTime = deltaTime;
+			if ( inputRecorder.IsReplaying() && inputRecorder.BeginReplayFrame( frameDeltaTime ) )
+				while ( inputRecorder.ReadEvent( event ) )
+				{
+					inputSystem.ApplyEvent( event );
+					game->OnEvent( event );
+				}
+
 			studioRender->Begin();
 
 			inputSystem.Update();
-			game->Update( deltaTime );
+			game->Update( frameDeltaTime );
+			inputRecorder.EndFrame( frameDeltaTime );
 
 			studioRender->End();
 			studioRender->Present();
+			statsSystem.EndFrame();
 			deltaTime = ( SDL_GetTicks() - startTime );
 		}
 	}
@@ -477,6 +570,65 @@ void le::Engine::RunSimulation()
 	StopSimulation();
 }
 
+static volatile std::sig_atomic_t		g_isStopSignal = 0;
+
+// ------------------------------------------------------------------------------------ //
+// Обработчик SIGINT/SIGTERM в режиме без окна: только ставит флаг, цикл тиков завершится сам
+// ------------------------------------------------------------------------------------ //
+static void SignalHandler_StopTickLoop( int Signal )
+{
+	g_isStopSignal = 1;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Цикл симуляции без окна и рендера: логика обновляется с постоянной частотой
+// ------------------------------------------------------------------------------------ //
+void le::Engine::RunTickLoop()
+{
+	UInt32_t			tickRate = configurations.tickRate > 0 ? configurations.tickRate : 60;
+	auto				tickTime = std::chrono::nanoseconds( 1000000000ull / tickRate );
+	auto				startTime = std::chrono::steady_clock::now();
+	UInt64_t			countTicks = 0;
+	UInt64_t			simulationTime = 0;
+	isRunSimulation = true;
+
+	consoleSystem.PrintInfo( "Headless simulation with tick rate %i", tickRate );
+
+	// Без окна закрыть процесс можно только сигналом, завершаем симуляцию штатно
+	g_isStopSignal = 0;
+	auto				oldSignalInterrupt = std::signal( SIGINT, SignalHandler_StopTickLoop );
+	auto				oldSignalTerminate = std::signal( SIGTERM, SignalHandler_StopTickLoop );
+
+	while ( isRunSimulation && !g_isStopSignal )
+	{
+		// Время симуляции и расписание считаем от номера тика, поэтому дробная часть миллисекунды
+		// не теряется: при 60 Гц тики идут по 16, 17, 17 мс и симуляция не отстает от реального времени
+		++countTicks;
+		UInt64_t		nextSimulationTime = countTicks * 1000 / tickRate;
+		game->Update( ( UInt32_t ) ( nextSimulationTime - simulationTime ) );
+		statsSystem.EndFrame();
+		simulationTime = nextSimulationTime;
+
+		auto		nextTick = startTime + std::chrono::nanoseconds( countTicks * 1000000000ull / tickRate );
+
+		// Свободное время тика спим. Небольшое отставание догоняем тиками подряд,
+		// а при большом (загрузка уровня) сдвигаем расписание, чтобы не было лавины тиков
+		auto		currentTime = std::chrono::steady_clock::now();
+		if ( currentTime < nextTick )
+			std::this_thread::sleep_until( nextTick );
+		else if ( currentTime - nextTick > tickTime * ENGINE_MAX_LATE_TICKS )
+		{
+			startTime = currentTime;
+			countTicks = 0;
+			simulationTime = 0;
+		}
+	}
+
+	std::signal( SIGINT, oldSignalInterrupt );
+	std::signal( SIGTERM, oldSignalTerminate );
+	if ( g_isStopSignal )		consoleSystem.PrintInfo( "Headless simulation stopped by signal" );
+}
+
 // ------------------------------------------------------------------------------------ //
 // Остановить симуляцию
 // ------------------------------------------------------------------------------------ //
@@ -534,6 +686,14 @@ le::IInputSystem* le::Engine::GetInputSystem() const
 	return ( IInputSystem* ) &inputSystem;
 }
 
+// ------------------------------------------------------------------------------------ //
+// Получить систему статистики
+// ------------------------------------------------------------------------------------ //
+le::IStatsSystem* le::Engine::GetStatsSystem() const
+{
+	return ( IStatsSystem* ) &statsSystem;
+}
+
 // ------------------------------------------------------------------------------------ //
 // Получить окно
 // ------------------------------------------------------------------------------------ //
@@ -602,24 +762,31 @@ bool le::Engine::Initialize( WindowHandle_t WindowHandle )
 
 	try
 	{
-		// Инициализируем окно приложения. Если заголовок на окно в аргументах пуст, 
-		// то создаем свое окно, иначе запоминаем его
+		// Выделенному серверу окно и рендер не нужны
 
-		if ( !WindowHandle )
+		if ( configurations.isHeadless )
+			consoleSystem.PrintInfo( "Headless mode: window and studiorender not loaded" );
+		else
 		{
-			if ( !window.Create( "lifeEngine", configurations.windowWidth, configurations.windowHeight, configurations.isFullscreen ? SW_FULLSCREEN : SW_DEFAULT ) )
-				throw std::exception( SDL_GetError() );
-		}
-		else 
-			window.SetHandle( WindowHandle );
+			// Инициализируем окно приложения. Если заголовок на окно в аргументах пуст, 
+			// то создаем свое окно, иначе запоминаем его
 
-		// Загружаем и инициализируем подсистемы
+			if ( !WindowHandle )
+			{
+				if ( !window.Create( "lifeEngine", configurations.windowWidth, configurations.windowHeight, configurations.isFullscreen ? SW_FULLSCREEN : SW_DEFAULT ) )
+					throw std::exception( SDL_GetError() );
+			}
+			else 
+				window.SetHandle( WindowHandle );
 
-		if ( !LoadModule_StudioRender( LIFEENGINE_STUDIORENDER_DLL ) )		throw std::exception( "Failed loading studiorender" );
-	
-		auto*		shaderManager = studioRender->GetShaderManager();
-		if ( !shaderManager )		throw std::exception( "In studiorender not exist shader manager" );
-		if ( !shaderManager->LoadShaderDLL( LIFEENGINE_STDSHADERS_DLL ) )	throw std::exception( "Failed loading stdshaders" );
+			// Загружаем и инициализируем подсистемы
+
+			if ( !LoadModule_StudioRender( LIFEENGINE_STUDIORENDER_DLL ) )		throw std::exception( "Failed loading studiorender" );
+		
+			auto*		shaderManager = studioRender->GetShaderManager();
+			if ( !shaderManager )		throw std::exception( "In studiorender not exist shader manager" );
+			if ( !shaderManager->LoadShaderDLL( LIFEENGINE_STDSHADERS_DLL ) )	throw std::exception( "Failed loading stdshaders" );
+		}
 
 		resourceSystem.Initialize( this );
 	}
@@ -650,6 +817,8 @@ bool le::Engine::LoadGame( const char* DirGame )
 	if ( !LoadModule_Game( ( std::string( DirGame ) + "/" + gameInfo.gameDLL ).c_str() ) )
 		return false;
 
+	if ( configurations.isHeadless )		return true;
+
 	// Если есть иконка у игры - грузим ее
 	if ( gameInfo.icon )
 	{
@@ -21,6 +21,13 @@
 #include "engine/window.h"
 #include "engine/enginefactory.h"
 #include "engine/inputsystem.h"
+#include "engine/inputrecorder.h"
+#include "engine/statssystem.h"
+
+//---------------------------------------------------------------------//
+
+// Насколько тиков может отстать цикл выделенного сервера, прежде чем сбросить расписание
+#define ENGINE_MAX_LATE_TICKS		5
 
 //---------------------------------------------------------------------//
 
@@ -69,6 +76,7 @@ namespace le
 		virtual IStudioRender*			GetStudioRender() const;
 		virtual IResourceSystem*		GetResourceSystem() const;
 		virtual IInputSystem*			GetInputSystem() const;
+		virtual IStatsSystem*			GetStatsSystem() const;
 		virtual IWindow*				GetWindow() const;
 		virtual IFactory*				GetFactory() const;
 		virtual const Configurations&	GetConfigurations() const;
@@ -84,6 +92,7 @@ namespace le
 		~Engine();
 
 		inline const GameInfo&			GetGameInfo() const { return gameInfo; }
+		inline InputRecorder&			GetInputRecorder() { return inputRecorder; }
 
 	private:
 		bool							LoadModule_StudioRender( const char* PathDLL );
@@ -91,12 +100,15 @@ namespace le
 		bool							LoadGameInfo( const char* GameDir );
 		bool							LoadModule_Game( const char* PathDLL );
 		void							UnloadModule_Game();
+		void							RunTickLoop();
 
 		bool							isInit;
 		bool							isRunSimulation;
 
 		IConCmd*						cmd_Exit;
 		IConCmd*						cmd_Version;
+		IConCmd*						cmd_RecordInput;
+		IConCmd*						cmd_ReplayInput;
 
 		IStudioRenderInternal*			studioRender;
 		StudioRenderDescriptor			studioRenderDescriptor;
@@ -108,6 +120,8 @@ namespace le
 		ConsoleSystem					consoleSystem;
 		ResourceSystem					resourceSystem;
 		InputSystem						inputSystem;
+		InputRecorder					inputRecorder;
+		StatsSystem						statsSystem;
 		Window							window;
 		EngineFactory					engineFactory;
 		GameInfo						gameInfo;
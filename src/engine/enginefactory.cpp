@@ -21,12 +21,22 @@
 // ------------------------------------------------------------------------------------ //
 void* le::EngineFactory::Create( const char* NameInterface )
 {
-	if ( strcmp( NameInterface, CAMERA_INTERFACE_VERSION ) == 0 )				return new Camera();
-	else if ( strcmp( NameInterface, MODEL_INTERFACE_VERSION ) == 0 )			return new Model();
-	else if ( strcmp( NameInterface, MATERIAL_INTERFACE_VERSION ) == 0 )		return new Material();
-	else if ( strcmp( NameInterface, SPRITE_INTERFACE_VERSION ) == 0 )			return new Sprite();
+	return Create( HashInterface( NameInterface ) );
+}
 
-	return nullptr;
+// ------------------------------------------------------------------------------------ //
+// Создать объект по хешу названия интерфейса
+// ------------------------------------------------------------------------------------ //
+void* le::EngineFactory::Create( UInt32_t InterfaceID )
+{
+	switch ( InterfaceID )
+	{
+	case HashInterface( CAMERA_INTERFACE_VERSION ):			return new Camera();
+	case HashInterface( MODEL_INTERFACE_VERSION ):			return new Model();
+	case HashInterface( MATERIAL_INTERFACE_VERSION ):		return new Material();
+	case HashInterface( SPRITE_INTERFACE_VERSION ):			return new Sprite();
+	default:												return nullptr;
+	}
 }
 
 // ------------------------------------------------------------------------------------ //
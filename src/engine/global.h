@@ -46,6 +46,11 @@ namespace le
 	extern ResourceSystem*			g_resourceSystem;
 
 	//---------------------------------------------------------------------//
+
+	class StatsSystem;
+	extern StatsSystem*				g_statsSystem;
+
+	//---------------------------------------------------------------------//
 }
 
 //---------------------------------------------------------------------//
@@ -0,0 +1,374 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "engine/lifeengine.h"
+
+#include "global.h"
+#include "consolesystem.h"
+#include "inputrecorder.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	struct InputRecordHeader
+	{
+		char			id[ 4 ];
+		UInt32_t		version;
+	};
+
+	//---------------------------------------------------------------------//
+
+	enum INPUT_RECORD_MODIFIERS
+	{
+		IRM_ALT			= 1 << 0,
+		IRM_CONTROL		= 1 << 1,
+		IRM_SHIFT		= 1 << 2,
+		IRM_SUPER		= 1 << 3,
+		IRM_CAPSLOCK	= 1 << 4,
+		IRM_NUMLOCK		= 1 << 5
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::InputRecorder::InputRecorder() :
+	isReplaying( false ),
+	countFrameEvents( 0 ),
+	countFrames( 0 ),
+	simulationTime( 0 ),
+	replayOffset( 0 ),
+	countReplayEvents( 0 )
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor
+// ------------------------------------------------------------------------------------ //
+le::InputRecorder::~InputRecorder()
+{
+	StopRecord();
+	StopReplay();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Start recording to file
+// ------------------------------------------------------------------------------------ //
+bool le::InputRecorder::StartRecord( const char* Path )
+{
+	StopRecord();
+	StopReplay();
+
+	file.open( Path, std::ios::binary );
+	if ( !file.is_open() )
+	{
+		g_consoleSystem->PrintError( "Input record [%s] not created", Path );
+		return false;
+	}
+
+	InputRecordHeader		header = { { 'L', 'E', 'I', 'R' }, INPUTRECORDER_VERSION };
+	file.write( ( const char* ) &header, sizeof( InputRecordHeader ) );
+
+	frameBuffer.clear();
+	countFrameEvents = 0;
+	countFrames = 0;
+	simulationTime = 0;
+
+	g_consoleSystem->PrintInfo( "Input recording to [%s] started", Path );
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Stop recording
+// ------------------------------------------------------------------------------------ //
+void le::InputRecorder::StopRecord()
+{
+	if ( !file.is_open() )		return;
+
+	file.close();
+	g_consoleSystem->PrintInfo( "Input recording stopped: %i frames, %i ms of simulation", countFrames, simulationTime );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Start replay from file
+// ------------------------------------------------------------------------------------ //
+bool le::InputRecorder::StartReplay( const char* Path )
+{
+	StopRecord();
+	StopReplay();
+
+	std::ifstream		replayFile( Path, std::ios::binary | std::ios::ate );
+	if ( !replayFile.is_open() )
+	{
+		g_consoleSystem->PrintError( "Input record [%s] not found", Path );
+		return false;
+	}
+
+	replayData.resize( ( UInt32_t ) replayFile.tellg() );
+	replayFile.seekg( 0, std::ios::beg );
+	replayFile.read( ( char* ) replayData.data(), replayData.size() );
+
+	InputRecordHeader		header;
+	replayOffset = 0;
+	if ( !Read( header ) || memcmp( header.id, "LEIR", 4 ) != 0 || header.version != INPUTRECORDER_VERSION )
+	{
+		g_consoleSystem->PrintError( "Input record [%s] has not supported format or version", Path );
+		replayData.clear();
+		return false;
+	}
+
+	isReplaying = true;
+	countReplayEvents = 0;
+	countFrames = 0;
+	simulationTime = 0;
+	replayStartTime = std::chrono::steady_clock::now();
+
+	g_consoleSystem->PrintInfo( "Input replay from [%s] started", Path );
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Stop replay and print time of run
+// ------------------------------------------------------------------------------------ //
+void le::InputRecorder::StopReplay()
+{
+	if ( !isReplaying )		return;
+
+	double			realTime = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - replayStartTime ).count();
+	g_consoleSystem->PrintInfo( "Input replay finished: %i frames, %i ms of simulation, %.1f ms real time (%.3f ms per frame)",
+								countFrames, simulationTime, realTime, countFrames > 0 ? realTime / countFrames : 0.0 );
+
+	isReplaying = false;
+	replayData.clear();
+	replayData.shrink_to_fit();
+	replayOffset = 0;
+	countReplayEvents = 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Write event to current frame
+// ------------------------------------------------------------------------------------ //
+void le::InputRecorder::WriteEvent( const Event& Event )
+{
+	if ( !file.is_open() || !IsInputEvent( Event ) )		return;
+
+	Write( ( UInt8_t ) Event.type );
+	switch ( Event.type )
+	{
+	case Event::ET_KEY_PRESSED:
+	case Event::ET_KEY_RELEASED:
+	{
+		UInt8_t			modifiers = ( Event.key.isAlt ? IRM_ALT : 0 ) | ( Event.key.isControl ? IRM_CONTROL : 0 ) | ( Event.key.isShift ? IRM_SHIFT : 0 ) |
+									( Event.key.isSuper ? IRM_SUPER : 0 ) | ( Event.key.isCapsLock ? IRM_CAPSLOCK : 0 ) | ( Event.key.isNumLock ? IRM_NUMLOCK : 0 );
+
+		Write( ( UInt16_t ) Event.key.code );
+		Write( modifiers );
+		break;
+	}
+
+	case Event::ET_MOUSE_PRESSED:
+	case Event::ET_MOUSE_RELEASED:
+		Write( ( UInt16_t ) Event.mouseButton.code );
+		Write( ( Int32_t ) Event.mouseButton.x );
+		Write( ( Int32_t ) Event.mouseButton.y );
+		break;
+
+	case Event::ET_MOUSE_MOVE:
+		Write( ( Int32_t ) Event.mouseMove.x );
+		Write( ( Int32_t ) Event.mouseMove.y );
+		Write( ( Int32_t ) Event.mouseMove.xDirection );
+		Write( ( Int32_t ) Event.mouseMove.yDirection );
+		break;
+
+	case Event::ET_MOUSE_WHEEL:
+		Write( ( Int32_t ) Event.mouseWheel.x );
+		Write( ( Int32_t ) Event.mouseWheel.y );
+		break;
+
+	case Event::ET_TEXT_INPUT:
+	{
+		UInt16_t		length = Event.textInputEvent.text ? ( UInt16_t ) strlen( Event.textInputEvent.text ) : 0;
+		Write( length );
+		frameBuffer.insert( frameBuffer.end(), Event.textInputEvent.text, Event.textInputEvent.text + length );
+		break;
+	}
+
+	default: break;
+	}
+
+	++countFrameEvents;
+}
+
+// ------------------------------------------------------------------------------------ //
+// End frame: write its delta time and events to file
+// ------------------------------------------------------------------------------------ //
+void le::InputRecorder::EndFrame( UInt32_t DeltaTime )
+{
+	if ( !file.is_open() )		return;
+
+	file.write( ( const char* ) &countFrames, sizeof( UInt32_t ) );
+	file.write( ( const char* ) &DeltaTime, sizeof( UInt32_t ) );
+	file.write( ( const char* ) &countFrameEvents, sizeof( UInt32_t ) );
+	if ( !frameBuffer.empty() )		file.write( ( const char* ) frameBuffer.data(), frameBuffer.size() );
+
+	frameBuffer.clear();
+	countFrameEvents = 0;
+	simulationTime += DeltaTime;
+	++countFrames;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Begin next frame of replay, returns false at end of log
+// ------------------------------------------------------------------------------------ //
+bool le::InputRecorder::BeginReplayFrame( UInt32_t& DeltaTime )
+{
+	if ( !isReplaying )		return false;
+
+	// Events of previous frame not read up to end - skip them
+	Event			event;
+	while ( ReadEvent( event ) ) {}
+
+	UInt32_t		frame = 0;
+	UInt32_t		countEvents = 0;
+	if ( !isReplaying || !Read( frame ) || !Read( DeltaTime ) || !Read( countEvents ) )
+	{
+		StopReplay();
+		return false;
+	}
+
+	if ( frame != countFrames )
+		g_consoleSystem->PrintWarning( "Input replay: expected frame %i, in log frame %i", countFrames, frame );
+
+	countReplayEvents = countEvents;
+	simulationTime += DeltaTime;
+	++countFrames;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Read next event of current frame
+// ------------------------------------------------------------------------------------ //
+bool le::InputRecorder::ReadEvent( Event& Event )
+{
+	if ( !isReplaying || countReplayEvents == 0 )		return false;
+
+	UInt8_t			type = 0;
+	bool			isValid = Read( type );
+	Event.type = ( Event::EVENT_TYPE ) type;
+
+	switch ( Event.type )
+	{
+	case Event::ET_KEY_PRESSED:
+	case Event::ET_KEY_RELEASED:
+	{
+		UInt16_t		code = 0;
+		UInt8_t			modifiers = 0;
+		isValid = isValid && Read( code ) && Read( modifiers );
+
+		Event.key.code = ( BUTTON_CODE ) code;
+		Event.key.isAlt = modifiers & IRM_ALT;
+		Event.key.isControl = modifiers & IRM_CONTROL;
+		Event.key.isShift = modifiers & IRM_SHIFT;
+		Event.key.isSuper = modifiers & IRM_SUPER;
+		Event.key.isCapsLock = modifiers & IRM_CAPSLOCK;
+		Event.key.isNumLock = modifiers & IRM_NUMLOCK;
+		break;
+	}
+
+	case Event::ET_MOUSE_PRESSED:
+	case Event::ET_MOUSE_RELEASED:
+	{
+		UInt16_t		code = 0;
+		Int32_t			x = 0, y = 0;
+		isValid = isValid && Read( code ) && Read( x ) && Read( y );
+
+		Event.mouseButton.code = ( BUTTON_CODE ) code;
+		Event.mouseButton.x = x;
+		Event.mouseButton.y = y;
+		break;
+	}
+
+	case Event::ET_MOUSE_MOVE:
+	{
+		Int32_t			x = 0, y = 0, xDirection = 0, yDirection = 0;
+		isValid = isValid && Read( x ) && Read( y ) && Read( xDirection ) && Read( yDirection );
+
+		Event.mouseMove.x = x;
+		Event.mouseMove.y = y;
+		Event.mouseMove.xDirection = xDirection;
+		Event.mouseMove.yDirection = yDirection;
+		break;
+	}
+
+	case Event::ET_MOUSE_WHEEL:
+	{
+		Int32_t			x = 0, y = 0;
+		isValid = isValid && Read( x ) && Read( y );
+
+		Event.mouseWheel.x = x;
+		Event.mouseWheel.y = y;
+		break;
+	}
+
+	case Event::ET_TEXT_INPUT:
+	{
+		// Text lives in recorder until next event
+		UInt16_t		length = 0;
+		isValid = isValid && Read( length ) && replayOffset + length <= replayData.size();
+		if ( isValid )
+		{
+			replayText.assign( ( const char* ) &replayData[ replayOffset ], length );
+			replayOffset += length;
+		}
+
+		Event.textInputEvent.text = ( char* ) replayText.c_str();
+		break;
+	}
+
+	default:
+		isValid = false;
+		break;
+	}
+
+	if ( !isValid )
+	{
+		g_consoleSystem->PrintError( "Input replay: log is corrupted" );
+		StopReplay();
+		return false;
+	}
+
+	--countReplayEvents;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Is event from input devices
+// ------------------------------------------------------------------------------------ //
+bool le::InputRecorder::IsInputEvent( const Event& Event )
+{
+	switch ( Event.type )
+	{
+	case Event::ET_KEY_PRESSED:
+	case Event::ET_KEY_RELEASED:
+	case Event::ET_MOUSE_MOVE:
+	case Event::ET_MOUSE_PRESSED:
+	case Event::ET_MOUSE_RELEASED:
+	case Event::ET_MOUSE_WHEEL:
+	case Event::ET_TEXT_INPUT:
+		return true;
+
+	default:
+		return false;
+	}
+}
@@ -0,0 +1,105 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef INPUTRECORDER_H
+#define INPUTRECORDER_H
+
+#include <string.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "common/types.h"
+#include "common/event.h"
+
+//---------------------------------------------------------------------//
+
+#define INPUTRECORDER_VERSION			2
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Records input events of every simulated frame with its delta time into binary log
+	// and plays it back. On replay the log drives simulation clock, so run is repeatable.
+	// File: header { "LEIR", version }, then frames { index, delta time, count events, events }
+	class InputRecorder
+	{
+	public:
+		InputRecorder();
+		~InputRecorder();
+
+		bool					StartRecord( const char* Path );
+		void					StopRecord();
+		bool					StartReplay( const char* Path );
+		void					StopReplay();
+
+		// Recording: events are collected until end of frame
+		void					WriteEvent( const Event& Event );
+		void					EndFrame( UInt32_t DeltaTime );
+
+		// Replay: begin next frame of log, then read its events until false
+		bool					BeginReplayFrame( UInt32_t& DeltaTime );
+		bool					ReadEvent( Event& Event );
+
+		// Only input events are recorded, window events come from real window
+		static bool				IsInputEvent( const Event& Event );
+
+		inline bool				IsRecording() const
+		{
+			return file.is_open();
+		}
+
+		inline bool				IsReplaying() const
+		{
+			return isReplaying;
+		}
+
+	private:
+		template< typename Type >
+		inline void				Write( const Type& Value )
+		{
+			const Byte_t*		bytes = ( const Byte_t* ) &Value;
+			frameBuffer.insert( frameBuffer.end(), bytes, bytes + sizeof( Type ) );
+		}
+
+		template< typename Type >
+		inline bool				Read( Type& Value )
+		{
+			if ( replayOffset + sizeof( Type ) > replayData.size() )		return false;
+
+			memcpy( &Value, &replayData[ replayOffset ], sizeof( Type ) );
+			replayOffset += sizeof( Type );
+			return true;
+		}
+
+		bool										isReplaying;
+		std::ofstream								file;
+		std::vector< Byte_t >						frameBuffer;
+		UInt32_t									countFrameEvents;
+		UInt32_t									countFrames;
+		UInt32_t									simulationTime;
+
+		std::vector< Byte_t >						replayData;
+		UInt32_t									replayOffset;
+		UInt32_t									countReplayEvents;
+		std::string									replayText;
+		std::chrono::steady_clock::time_point		replayStartTime;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !INPUTRECORDER_H
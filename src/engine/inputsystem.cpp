@@ -36,7 +36,8 @@ namespace le
 		for ( UInt32_t index = 0, count = strButtonTrigger.size(); index < count; ++index )
 			strButtonTrigger[ index ] = tolower( strButtonTrigger[ index ] );
 
-		le::g_inputSystem->binds.push_back( le::BindDescriptor( ButtonCode_StringToButtonCode( strButtonTrigger.c_str() ), Arguments[ 1 ] ) );
+		le::g_inputSystem->binds.push_back( le::BindDescriptor( ButtonCode_StringToButtonCode( strButtonTrigger.c_str() ) ) );
+		le::g_consoleSystem->Prepare( Arguments[ 1 ], le::g_inputSystem->binds.back().command );
 	}
 }
 
@@ -98,7 +99,7 @@ void le::InputSystem::Update()
 		if ( buttonEvents[ bindDescriptor.buttonTrigger ] == BE_NONE ) 
 			continue;
 
-		g_consoleSystem->Exec( bindDescriptor.command.c_str() );
+		g_consoleSystem->Exec( bindDescriptor.command );
 	}
 }
 
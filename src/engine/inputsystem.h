@@ -17,6 +17,7 @@
 #include "common/event.h"
 #include "common/buttoncode.h"
 #include "engine/iinputsysteminternal.h"
+#include "engine/consolesystem.h"
 
 //---------------------------------------------------------------------//
 
@@ -39,13 +40,12 @@ namespace le
 		BindDescriptor()
 		{}
 
-		BindDescriptor( BUTTON_CODE ButtonTrigger, const std::string& Command ) :
-			buttonTrigger( ButtonTrigger ),
-			command( Command )
+		BindDescriptor( BUTTON_CODE ButtonTrigger ) :
+			buttonTrigger( ButtonTrigger )
 		{}
 
 		BUTTON_CODE				buttonTrigger;
-		std::string				command;
+		PreparedCommand			command;			// Разбирается один раз при бинде
 	};
 
 	//---------------------------------------------------------------------//
@@ -12,6 +12,13 @@
 #include <exception>
 #include <vector>
 #include <unordered_map>
+#include <algorithm>
+#include <tuple>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#	include <emmintrin.h>
+#	define LEVEL_SSE2
+#endif // _M_X64 || _M_IX86 || __SSE2__
 
 #include "common/meshsurface.h"
 #include "common/meshdescriptor.h"
@@ -33,6 +40,27 @@
 #include "level.h"
 #include "model.h"
 #include "sprite.h"
+#include "vertexpacker.h"
+#include "meshoptimizer.h"
+#include "convar.h"
+#include "statssystem.h"
+
+#define LEVEL_OCCLUDER_MIN_AREA			4096.f
+#define LEVEL_HALF_UV_MAX_SPAN			8.f
+
+le::ConVar*			r_occlusion = nullptr;
+le::ConVar*			r_showocclusion = nullptr;
+le::ConVar*			r_areaportals = nullptr;
+le::ConVar*			r_fronttoback = nullptr;
+le::ConVar*			r_clusterbatches = nullptr;
+
+le::Stat			stat_leafsVisited;
+le::Stat			stat_leafsVisible;
+le::Stat			stat_facesSubmitted;
+le::Stat			stat_clusterBatches;
+le::Stat			stat_clusterExtraLeafs;
+le::Stat			stat_modelsSubmitted;
+le::Stat			stat_lightsSubmitted;
 
 // ------------------------------------------------------------------------------------ //
 // Изменить гаму карты освещения
@@ -76,7 +104,7 @@ void Lightmap_ChangeGamma( le::Byte_t* ImageBits, uint32_t Size, float Factor )
 // ------------------------------------------------------------------------------------ //
 le::ITexture* Lightmap_Create( le::Byte_t* ImageBits, uint32_t Width, uint32_t Height )
 {
-	le::ITexture* texture = ( le::ITexture* ) le::g_studioRender->GetFactory()->Create( TEXTURE_INTERFACE_VERSION );
+	le::ITexture* texture = ( le::ITexture* ) le::g_studioRender->GetFactory()->Create( le::HashInterface( TEXTURE_INTERFACE_VERSION ) );
 	if ( !texture )		return nullptr;
 
 	texture->Initialize( le::TT_2D, le::IF_RGB_8UNORM, Width, Height );
@@ -113,12 +141,11 @@ bool le::Level::Load( const char* Path, IFactory* GameFactory )
 		std::vector< BSPVertex >		arrayVerteces;
 		std::vector< UInt32_t >			arrayIndices;
 		std::vector< BSPFace >			arrayFaces;
-		std::vector < BSPLightmap >		arrayBspLightmaps;
 		std::vector< BSPTexture >		arrayBspTextures;
 		std::vector< BSPModel >			arrayBspModels;
-		std::vector< IMaterial* >		arrayMaterials;
-		std::vector< MeshSurface >		arrayMeshSurfaces;
 		std::vector< int >				arrayLeafsFaces;
+		std::vector< BSPNode >			arrayBspNodes;
+		std::vector< BSPPlane >			arrayBspPlanes;
 
 		// Читаем заголовок и куски файла
 		file.read( ( char* ) &bspHeader, sizeof( BSPHeader ) );
@@ -133,7 +160,6 @@ bool le::Level::Load( const char* Path, IFactory* GameFactory )
 		arrayVerteces.resize( bspLumps[ BL_VERTICES ].length / sizeof( BSPVertex ) );
 		arrayIndices.resize( bspLumps[ BL_INDICES ].length / sizeof( UInt32_t ) );
 		arrayFaces.resize( bspLumps[ BL_FACES ].length / sizeof( BSPFace ) );
-		arrayBspLightmaps.resize( bspLumps[ BL_LIGHT_MAPS ].length / sizeof( BSPLightmap ) );
 		arrayLeafsFaces.resize( bspLumps[ BL_LEAF_FACES ].length / sizeof( int ) );
 		arrayBspTextures.resize( bspLumps[ BL_TEXTURES ].length / sizeof( BSPTexture ) );
 		arrayBspModels.resize( bspLumps[ BL_MODELS ].length / sizeof( BSPModel ) );
@@ -255,98 +281,109 @@ bool le::Level::Load( const char* Path, IFactory* GameFactory )
 			Plane->normal.z = -temp;
 		}
 
-		// Считываем информацию о видимой геометрии
-		if ( bspLumps[ BL_VIS_DATA ].length )
-		{
-			file.seekg( bspLumps[ BL_VIS_DATA ].offset, std::ios::beg );
-			file.read( ( char* ) &visData.numOfClusters, sizeof( int ) );
-			file.read( ( char* ) &visData.bytesPerCluster, sizeof( int ) );
+		// Перепаковываем дерево в компактный массив узлов для быстрого поиска листьев
+		BuildCompactNodes( arrayBspNodes, arrayBspPlanes );
 
-			UInt32_t		size = visData.numOfClusters * visData.bytesPerCluster;
-			visData.bitsets = new Byte_t[ size ];
+		// Ищем порталы между зонами: кисти с содержимым areaportal, которые касаются ровно двух зон.
+		// Первые шесть сторон кисти всегда осевые (-x, +x, -y, +y, -z, +z в осях Quake 3)
+		std::vector< BSPBrush >			arrayBspBrushes( bspLumps[ BL_BRUSHES ].length / sizeof( BSPBrush ) );
+		std::vector< BSPBrushSide >		arrayBspBrushSides( bspLumps[ BL_BRUSH_SIDES ].length / sizeof( BSPBrushSide ) );
+		std::vector< int >				arrayPortalLeafs;
 
-			file.read( ( char* ) &visData.bitsets[ 0 ], size * sizeof( Byte_t ) );
-		}
-		else
-			visData.bitsets = nullptr;
+		file.seekg( bspLumps[ BL_BRUSHES ].offset, std::ios::beg );
+		file.read( ( char* ) arrayBspBrushes.data(), arrayBspBrushes.size() * sizeof( BSPBrush ) );
 
-		// Считываем карту освещения
-		if ( arrayBspLightmaps.size() == 0 )
-		{
-			Byte_t				whiteLightmap[ 3 ] = { 255, 255,255 };
-			arrayLightmaps.push_back( Lightmap_Create( whiteLightmap, 1, 1 ) );
+		file.seekg( bspLumps[ BL_BRUSH_SIDES ].offset, std::ios::beg );
+		file.read( ( char* ) arrayBspBrushSides.data(), arrayBspBrushSides.size() * sizeof( BSPBrushSide ) );
 
-			for ( UInt32_t index = 0, count = arrayFaces.size(); index < count; ++index )
-				arrayFaces[ index ].lightmapID = 0;
-		}
-		else
+		countAreas = 0;
+		for ( UInt32_t index = 0, count = arrayBspLeafs.size(); index < count; ++index )
+			countAreas = glm::max( countAreas, ( UInt32_t ) ( arrayBspLeafs[ index ].area + 1 ) );
+
+		for ( UInt32_t index = 0, count = arrayBspBrushes.size(); index < count; ++index )
 		{
-			file.seekg( bspLumps[ BL_LIGHT_MAPS ].offset, std::ios::beg );
+			BSPBrush*		bspBrush = &arrayBspBrushes[ index ];
+			if ( bspBrush->textureID < 0 || bspBrush->textureID >= ( int ) arrayBspTextures.size() || bspBrush->numOfBrushSides < 6 ||
+				 !( arrayBspTextures[ bspBrush->textureID ].type & BC_AREAPORTAL ) )
+				continue;
+
+			float			distances[ 6 ];
+			for ( UInt32_t indexSide = 0; indexSide < 6; ++indexSide )
+				distances[ indexSide ] = arrayBspPlanes[ arrayBspBrushSides[ bspBrush->brushSide + indexSide ].plane ].distance;
+
+			// Меняем ось Z и Y местами, как и для остальной геометрии
+			AreaPortal		areaPortal;
+			areaPortal.isOpen = true;
+			areaPortal.min = Vector3D_t( -distances[ 0 ], -distances[ 4 ], -distances[ 3 ] );
+			areaPortal.max = Vector3D_t( distances[ 1 ], distances[ 5 ], distances[ 2 ] );
 
-			for ( UInt32_t index = 0, count = arrayBspLightmaps.size(); index < count; ++index )
+			arrayPortalLeafs.clear();
+			FindLeafs( areaPortal.min - 1.f, areaPortal.max + 1.f, arrayPortalLeafs );
+
+			UInt32_t		countPortalAreas = 0;
+			for ( UInt32_t indexLeaf = 0, countLeafs = arrayPortalLeafs.size(); indexLeaf < countLeafs; ++indexLeaf )
+			{
+				int			area = arrayBspLeafs[ arrayPortalLeafs[ indexLeaf ] ].area;
+				if ( area < 0 || ( countPortalAreas > 0 && areaPortal.areas[ 0 ] == area ) || ( countPortalAreas > 1 && areaPortal.areas[ 1 ] == area ) )
+					continue;
+
+				if ( countPortalAreas < 2 )		areaPortal.areas[ countPortalAreas ] = area;
+				++countPortalAreas;
+			}
+
+			if ( countPortalAreas != 2 )
 			{
-				file.read( ( char* ) &arrayBspLightmaps[ index ], sizeof( BSPLightmap ) );
-				arrayLightmaps.push_back( Lightmap_Create( ( Byte_t* ) arrayBspLightmaps[ index ].imageBits, 128, 128 ) );
+				g_consoleSystem->PrintWarning( "Area portal %i touches %i areas, ignored", index, countPortalAreas );
+				continue;
 			}
+
+			arrayAreaPortals.push_back( areaPortal );
 		}
 
-		// Загружаем все текстуры
-		for ( UInt32_t index = 0, count = arrayBspTextures.size(); index < count; ++index )
+		areasVisible.Resize( countAreas );
+
+		// Строим данные для трассировок по твердым кистям
+		std::vector< int >				arrayLeafBrushes( bspLumps[ BL_LEAF_BRUSHES ].length / sizeof( int ) );
+
+		file.seekg( bspLumps[ BL_LEAF_BRUSHES ].offset, std::ios::beg );
+		file.read( ( char* ) arrayLeafBrushes.data(), arrayLeafBrushes.size() * sizeof( int ) );
+
+		collisionModel.Build( arrayNodes, arrayBspLeafs, arrayLeafBrushes, arrayBspBrushes, arrayBspBrushSides, arrayBspPlanes, arrayBspTextures );
+
+		// Считываем сетку света для освещения динамических моделей
+		if ( bspLumps[ BL_LIGHT_VOLUMES ].length )
 		{
-			BSPTexture* bspTexture = &arrayBspTextures[ index ];
-			arrayMaterials.push_back( g_resourceSystem->LoadMaterial( bspTexture->strName, ( std::string( bspTexture->strName ) + ".lmt" ).c_str() ) );
+			std::vector< BSPLightVolume >		arrayLightVolumes( bspLumps[ BL_LIGHT_VOLUMES ].length / sizeof( BSPLightVolume ) );
+
+			file.seekg( bspLumps[ BL_LIGHT_VOLUMES ].offset, std::ios::beg );
+			file.read( ( char* ) arrayLightVolumes.data(), arrayLightVolumes.size() * sizeof( BSPLightVolume ) );
+
+			if ( !lightGrid.Build( arrayLightVolumes, arrayBspModels[ 0 ].min, arrayBspModels[ 0 ].max ) )
+				g_consoleSystem->PrintWarning( "Level [%s] has light grid with wrong size, ignored", Path );
 		}
 
-		// Инициализируем плоскости
-		for ( UInt32_t index = 0, count = arrayFaces.size(); index < count; ++index )
+		// Считываем информацию о видимой геометрии
+		if ( bspLumps[ BL_VIS_DATA ].length )
 		{
-			BSPFace* bspFace = &arrayFaces[ index ];
-			MeshSurface		meshSurface;
-
-			meshSurface.materialID = bspFace->textureID;
-			meshSurface.lightmapID = bspFace->lightmapID;
-			meshSurface.startVertexIndex = bspFace->startVertIndex;
-			meshSurface.startIndex = bspFace->startIndex;
-			meshSurface.countIndeces = bspFace->numOfIndices;
-			arrayMeshSurfaces.push_back( meshSurface );
-		}
+			file.seekg( bspLumps[ BL_VIS_DATA ].offset, std::ios::beg );
+			file.read( ( char* ) &visData.numOfClusters, sizeof( int ) );
+			file.read( ( char* ) &visData.bytesPerCluster, sizeof( int ) );
+
+			UInt32_t		size = visData.numOfClusters * visData.bytesPerCluster;
+			visData.bitsets = new Byte_t[ size ];
 
-		// Создаем описание для формата вершин
-		std::vector< le::StudioVertexElement >			vertexElements =
+			file.read( ( char* ) &visData.bitsets[ 0 ], size * sizeof( Byte_t ) );
+		}
+		else
 		{
-			{ 3, VET_FLOAT },
-			{ 2, VET_FLOAT },
-			{ 2, VET_FLOAT },
-			{ 3, VET_FLOAT },
-			{ 4, VET_UNSIGNED_BYTE }
-		};
-
-		// Создаем описание меша для загрузки его в модуль рендера
-		le::MeshDescriptor				meshDescriptor;
-		meshDescriptor.countIndeces = arrayIndices.size();
-		meshDescriptor.countMaterials = arrayMaterials.size();
-		meshDescriptor.countLightmaps = arrayLightmaps.size();
-		meshDescriptor.countSurfaces = arrayMeshSurfaces.size();
-		meshDescriptor.sizeVerteces = arrayVerteces.size() * sizeof( BSPVertex );
-
-		meshDescriptor.indeces = arrayIndices.data();
-		meshDescriptor.materials = arrayMaterials.data();
-		meshDescriptor.lightmaps = arrayLightmaps.data();
-		meshDescriptor.surfaces = arrayMeshSurfaces.data();
-		meshDescriptor.verteces = arrayVerteces.data();
-
-		meshDescriptor.min = arrayBspModels[ 0 ].min;
-		meshDescriptor.max = arrayBspModels[ 0 ].max;
-		meshDescriptor.primitiveType = le::PT_TRIANGLES;
-		meshDescriptor.countVertexElements = vertexElements.size();
-		meshDescriptor.vertexElements = vertexElements.data();
-
-		// Загружаем меш в GPU
-		mesh = ( le::IMesh* ) g_studioRender->GetFactory()->Create( MESH_INTERFACE_VERSION );
-		if ( !mesh )				std::exception( "Interfece mesh with required version not found in factory studiorender" );
-
-		mesh->Create( meshDescriptor );
-		if ( !mesh->IsCreated() )	std::exception( "Mesh level not created" );
+			// Без данных видимости рисуется все, что попало в пирамиду видимости
+			visData.bitsets = nullptr;
+			g_consoleSystem->PrintWarning( "Level [%s] has no vis data, compile it with levelvis", Path );
+		}
+
+		// Геометрия, карты освещения и материалы нужны только для рендера
+		if ( g_studioRender )
+			LoadRenderData( file, Path, bspLumps, arrayVerteces, arrayIndices, arrayFaces, arrayBspTextures, arrayBspModels[ 0 ] );
 
 		// Добавляем на уровень модели
 		for ( UInt32_t index = 0, count = arrayBspModels.size(); index < count; ++index )
@@ -399,20 +436,269 @@ bool le::Level::Load( const char* Path, IFactory* GameFactory )
 	return true;
 }
 
+// ------------------------------------------------------------------------------------ //
+// Загрузить данные уровня для рендера
+// ------------------------------------------------------------------------------------ //
+void le::Level::LoadRenderData( std::ifstream& File, const char* Path, const BSPLump* BspLumps, std::vector< BSPVertex >& Verteces, std::vector< UInt32_t >& Indices, std::vector< BSPFace >& Faces, std::vector< BSPTexture >& BspTextures, const BSPModel& WorldModel )
+{
+	std::vector < BSPLightmap >		arrayBspLightmaps( BspLumps[ BL_LIGHT_MAPS ].length / sizeof( BSPLightmap ) );
+	std::vector< IMaterial* >		arrayMaterials;
+	std::vector< MeshSurface >		arrayMeshSurfaces;
+	UInt32_t						countWideFaces = 0;
+
+	// Считываем карту освещения
+	if ( arrayBspLightmaps.size() == 0 )
+	{
+		Byte_t				whiteLightmap[ 3 ] = { 255, 255,255 };
+		arrayLightmaps.push_back( Lightmap_Create( whiteLightmap, 1, 1 ) );
+
+		for ( UInt32_t index = 0, count = Faces.size(); index < count; ++index )
+			Faces[ index ].lightmapID = 0;
+	}
+	else
+	{
+		File.seekg( BspLumps[ BL_LIGHT_MAPS ].offset, std::ios::beg );
+
+		for ( UInt32_t index = 0, count = arrayBspLightmaps.size(); index < count; ++index )
+		{
+			File.read( ( char* ) &arrayBspLightmaps[ index ], sizeof( BSPLightmap ) );
+			arrayLightmaps.push_back( Lightmap_Create( ( Byte_t* ) arrayBspLightmaps[ index ].imageBits, 128, 128 ) );
+		}
+	}
+
+	// Загружаем все текстуры
+	for ( UInt32_t index = 0, count = BspTextures.size(); index < count; ++index )
+	{
+		BSPTexture* bspTexture = &BspTextures[ index ];
+		arrayMaterials.push_back( g_resourceSystem->LoadMaterial( bspTexture->strName, ( std::string( bspTexture->strName ) + ".lmt" ).c_str() ) );
+	}
+
+	// Тесселируем кривые поверхности (патчи), у них нет индексов в BSP
+	PatchTessellator::Tessellate( Verteces, Indices, Faces, arrayPatches );
+
+	// Инициализируем плоскости
+	for ( UInt32_t index = 0, count = Faces.size(); index < count; ++index )
+	{
+		BSPFace* bspFace = &Faces[ index ];
+		MeshSurface		meshSurface;
+
+		// Сдвигаем текстурные координаты плоскости к нулю на целое число повторений,
+		// чтобы не терять точность при упаковке в half float
+		if ( bspFace->numOfVerts > 0 )
+		{
+			Vector2D_t		minTextureCoord = Verteces[ bspFace->startVertIndex ].textureCoord;
+			for ( int indexVertex = bspFace->startVertIndex, countVerteces = bspFace->startVertIndex + bspFace->numOfVerts; indexVertex < countVerteces; ++indexVertex )
+				minTextureCoord = glm::min( minTextureCoord, Verteces[ indexVertex ].textureCoord );
+
+			minTextureCoord = glm::floor( minTextureCoord );
+			Vector2D_t		maxTextureCoord( 0.f );
+			for ( int indexVertex = bspFace->startVertIndex, countVerteces = bspFace->startVertIndex + bspFace->numOfVerts; indexVertex < countVerteces; ++indexVertex )
+			{
+				Verteces[ indexVertex ].textureCoord -= minTextureCoord;
+				maxTextureCoord = glm::max( maxTextureCoord, Verteces[ indexVertex ].textureCoord );
+			}
+
+			// Сдвиг не ограничивает размах координат: на больших плоскостях с мелким тайлингом
+			// шаг half float становится заметен, такие плоскости требуют float координат
+			if ( maxTextureCoord.x > LEVEL_HALF_UV_MAX_SPAN || maxTextureCoord.y > LEVEL_HALF_UV_MAX_SPAN )
+			{
+				g_consoleSystem->PrintWarning( "Level [%s]: face %i has texture coords span %.1f x %.1f, too wide for half float", Path, index, maxTextureCoord.x, maxTextureCoord.y );
+				++countWideFaces;
+			}
+		}
+
+		meshSurface.materialID = bspFace->textureID;
+		meshSurface.lightmapID = bspFace->lightmapID;
+		meshSurface.startVertexIndex = bspFace->startVertIndex;
+		meshSurface.startIndex = bspFace->startIndex;
+		meshSurface.countIndeces = bspFace->numOfIndices;
+		arrayMeshSurfaces.push_back( meshSurface );
+	}
+
+	// Грубые LOD патчей добавляем отдельными поверхностями, они ссылаются на те же вершины,
+	// поэтому смена LOD лишь выбирает другой диапазон индексов
+	arrayFacePatches.resize( Faces.size(), -1 );
+	for ( UInt32_t index = 0, count = arrayPatches.size(); index < count; ++index )
+	{
+		Patch&			patch = arrayPatches[ index ];
+		arrayFacePatches[ patch.face ] = index;
+
+		for ( UInt32_t lod = 1; lod < PATCH_COUNT_LODS; ++lod )
+		{
+			MeshSurface		meshSurface = arrayMeshSurfaces[ patch.face ];
+			meshSurface.startIndex = patch.lods[ lod ].startIndex;
+			meshSurface.countIndeces = patch.lods[ lod ].countIndeces;
+
+			patch.lodSurfaces[ lod ] = arrayMeshSurfaces.size();
+			arrayMeshSurfaces.push_back( meshSurface );
+		}
+	}
+
+	// Собираем окклюдеры: крупные непрозрачные полигоны уровня, которые рисуются в буфер перекрытий.
+	// Делаем это до оптимизации меша, пока индексы указывают на исходные вершины
+	arrayFaceOccluders.resize( Faces.size() + 1, 0 );
+	for ( UInt32_t index = 0, count = Faces.size(); index < count; ++index )
+	{
+		BSPFace*		bspFace = &Faces[ index ];
+		arrayFaceOccluders[ index ] = arrayOccluderVerteces.size();
+
+		if ( bspFace->type != BTP_POLYGON_FACE || bspFace->textureID < 0 || bspFace->textureID >= ( int ) BspTextures.size() )
+			continue;
+
+		BSPTexture*		bspTexture = &BspTextures[ bspFace->textureID ];
+		if ( !( bspTexture->type & BC_SOLID ) || bspTexture->type & BC_TRANSLUCENT || bspTexture->flags & ( BSF_SKY | BSF_NODRAW ) )
+			continue;
+
+		float			area = 0.f;
+		for ( int indexVertex = bspFace->startIndex, countIndeces = bspFace->startIndex + bspFace->numOfIndices; indexVertex + 2 < countIndeces; indexVertex += 3 )
+		{
+			const Vector3D_t&		vertex0 = Verteces[ bspFace->startVertIndex + Indices[ indexVertex ] ].position;
+			const Vector3D_t&		vertex1 = Verteces[ bspFace->startVertIndex + Indices[ indexVertex + 1 ] ].position;
+			const Vector3D_t&		vertex2 = Verteces[ bspFace->startVertIndex + Indices[ indexVertex + 2 ] ].position;
+			area += glm::length( glm::cross( vertex1 - vertex0, vertex2 - vertex0 ) ) * 0.5f;
+		}
+
+		if ( area < LEVEL_OCCLUDER_MIN_AREA )		continue;
+
+		for ( int indexVertex = bspFace->startIndex, countIndeces = bspFace->startIndex + bspFace->numOfIndices; indexVertex < countIndeces; ++indexVertex )
+			arrayOccluderVerteces.push_back( Verteces[ bspFace->startVertIndex + Indices[ indexVertex ] ].position );
+	}
+
+	arrayFaceOccluders[ Faces.size() ] = arrayOccluderVerteces.size();
+
+	// Упаковываем вершины: текстурные координаты в half float, нормали в 10:10:10:2.
+	// Если хоть одна плоскость не помещается в точность half float, текстурные координаты
+	// всего меша остаются во float - формат вершин у меша уровня один
+	bool								isFloatTextureCoords = countWideFaces > 0;
+	UInt32_t							sizePackedVertex = isFloatTextureCoords ? sizeof( BSPPackedVertexFloatUV ) : sizeof( BSPPackedVertex );
+	std::vector< Byte_t >				arrayPackedVerteces( Verteces.size() * sizePackedVertex );
+	for ( UInt32_t index = 0, count = Verteces.size(); index < count; ++index )
+	{
+		BSPVertex*				vertex = &Verteces[ index ];
+		if ( isFloatTextureCoords )
+		{
+			BSPPackedVertexFloatUV*		packedVertex = ( BSPPackedVertexFloatUV* ) &arrayPackedVerteces[ index * sizePackedVertex ];
+			packedVertex->position = vertex->position;
+			packedVertex->textureCoord = vertex->textureCoord;
+			VertexPacker::FloatToHalf( &vertex->lightmapCoord.x, packedVertex->lightmapCoord, 2 );
+			packedVertex->normal = VertexPacker::PackSnorm1010102( Vector4D_t( vertex->normal, 0.f ) );
+			memcpy( packedVertex->color, vertex->color, sizeof( vertex->color ) );
+		}
+		else
+		{
+			BSPPackedVertex*			packedVertex = ( BSPPackedVertex* ) &arrayPackedVerteces[ index * sizePackedVertex ];
+			packedVertex->position = vertex->position;
+			VertexPacker::FloatToHalf( &vertex->textureCoord.x, packedVertex->textureCoord, 2 );
+			VertexPacker::FloatToHalf( &vertex->lightmapCoord.x, packedVertex->lightmapCoord, 2 );
+			packedVertex->normal = VertexPacker::PackSnorm1010102( Vector4D_t( vertex->normal, 0.f ) );
+			memcpy( packedVertex->color, vertex->color, sizeof( vertex->color ) );
+		}
+	}
+
+	if ( isFloatTextureCoords )
+		g_consoleSystem->PrintWarning( "Level [%s]: %i faces have too wide texture coords, level mesh keeps them in float", Path, countWideFaces );
+
+	VertexPacker::PrintReport( Path, Verteces.size(), Indices.size(), sizeof( BSPVertex ), sizePackedVertex );
+
+	// Оптимизируем порядок треугольников и вершин поверхностей под кэш вершин
+	MeshOptimizer::Optimize( Path, arrayPackedVerteces.data(), sizePackedVertex, Verteces.size(), Indices.data(), Indices.size(), arrayMeshSurfaces.data(), arrayMeshSurfaces.size() );
+
+	// Добавляем поверхности кластеров после оптимизации, чтобы они взяли уже переупорядоченные индексы
+	Clusters_Build( Path, Indices, arrayMeshSurfaces, Faces.size() );
+
+	// Создаем описание для формата вершин
+	std::vector< le::StudioVertexElement >			vertexElements =
+	{
+		{ 3, VET_FLOAT },
+		{ 2, isFloatTextureCoords ? VET_FLOAT : VET_HALF_FLOAT },
+		{ 2, VET_HALF_FLOAT },
+		{ 4, VET_INT_2_10_10_10_REV },
+		{ 4, VET_UNSIGNED_BYTE }
+	};
+
+	// Создаем описание меша для загрузки его в модуль рендера
+	le::MeshDescriptor				meshDescriptor;
+	meshDescriptor.countIndeces = Indices.size();
+	meshDescriptor.countMaterials = arrayMaterials.size();
+	meshDescriptor.countLightmaps = arrayLightmaps.size();
+	meshDescriptor.countSurfaces = arrayMeshSurfaces.size();
+	meshDescriptor.sizeVerteces = arrayPackedVerteces.size();
+
+	meshDescriptor.indeces = Indices.data();
+	meshDescriptor.materials = arrayMaterials.data();
+	meshDescriptor.lightmaps = arrayLightmaps.data();
+	meshDescriptor.surfaces = arrayMeshSurfaces.data();
+	meshDescriptor.verteces = arrayPackedVerteces.data();
+
+	meshDescriptor.min = WorldModel.min;
+	meshDescriptor.max = WorldModel.max;
+	meshDescriptor.primitiveType = le::PT_TRIANGLES;
+	meshDescriptor.countVertexElements = vertexElements.size();
+	meshDescriptor.vertexElements = vertexElements.data();
+
+	// Загружаем меш в GPU
+	mesh = ( le::IMesh* ) g_studioRender->GetFactory()->Create( le::HashInterface( MESH_INTERFACE_VERSION ) );
+	if ( !mesh )				std::exception( "Interfece mesh with required version not found in factory studiorender" );
+
+	mesh->Create( meshDescriptor );
+	if ( !mesh->IsCreated() )	std::exception( "Mesh level not created" );
+}
+
 // ------------------------------------------------------------------------------------ //
 // Обновить уровень
 // ------------------------------------------------------------------------------------ //
 void le::Level::Update( UInt32_t DeltaTime )
 {
+	// Без рендера (выделенный сервер) сцена не собирается, обновляется только логика сущностей
+	if ( !g_studioRender )
+	{
+		for ( UInt32_t index = 0, count = arrayEntities.size(); index < count; ++index )
+			arrayEntities[ index ]->Update( DeltaTime );
+
+		return;
+	}
+
 	for ( UInt32_t indexCamera = 0, countCameras = arrayCameras.size(); indexCamera < countCameras; ++indexCamera )
 	{
 		Camera* camera = arrayCameras[ indexCamera ];
 
 		g_studioRender->BeginScene( camera );
 
-		// Определяем в каком кластере находится камера
-		int			currentCluster = arrayBspLeafs[ FindLeaf( camera ) ].cluster;
+		// Определяем в каком кластере и зоне находится камера
+		const BSPLeaf&		cameraLeaf = arrayBspLeafs[ FindLeaf( camera ) ];
+		int					currentCluster = cameraLeaf.cluster;
+		bool				isOcclusion = r_occlusion->GetValueBool();
+		bool				isFrontToBack = r_fronttoback->GetValueBool() && !arrayNodes.empty();
 		facesDraw.ClearAll();
+		arrayVisibleLeafs.clear();
+
+		// Зоны, отделенные закрытыми порталами (дверями), не рисуем
+		isAllAreasVisible = !r_areaportals->GetValueBool() || cameraLeaf.area < 0 || arrayAreaPortals.empty();
+		if ( !isAllAreasVisible )
+			Areas_FloodFill( cameraLeaf.area );
+
+		// Отбираем листья, прошедшие проверку PVS и пирамиды видимости
+		UInt32_t		countVisitedLeafs = 0;
+		if ( isFrontToBack )
+			countVisitedLeafs = FindVisibleLeafs_FrontToBack( camera, currentCluster );
+		else
+			for ( UInt32_t indexLeaf = 0, countLeafs = arrayBspLeafs.size(); indexLeaf < countLeafs; ++indexLeaf )
+			{
+				BSPLeaf& bspLeaf = arrayBspLeafs[ indexLeaf ];
+				++countVisitedLeafs;
+
+				if ( IsClusterVisible( currentCluster, bspLeaf.cluster ) && IsAreaVisible( bspLeaf.area ) && camera->IsVisible( bspLeaf.min, bspLeaf.max ) )
+					arrayVisibleLeafs.push_back( indexLeaf );
+			}
+
+		if ( isOcclusion )
+			Occlusion_Rasterize( camera );
+
+		// Статистику считаем локально и отдаем один раз за камеру
+		UInt32_t		countVisibleLeafs = 0;
+		UInt32_t		countSubmittedFaces = 0;
+		UInt32_t		countSubmittedModels = 0;
+		UInt32_t		countSubmittedLights = 0;
 
 		// Обновляем логику сущностей
 		for ( UInt32_t index = 0, count = arrayEntities.size(); index < count; ++index )
@@ -425,44 +711,143 @@ void le::Level::Update( UInt32_t DeltaTime )
 		}
 
 		// Посылаем на отрисовку видимые части статичной геометрии уровня
-		for ( UInt32_t indexLeaf = 0, countLeafs = arrayBspLeafs.size(); indexLeaf < countLeafs; ++indexLeaf )
+		if ( r_clusterbatches->GetValueBool() && !arrayClusters.empty() )
 		{
-			BSPLeaf& bspLeaf = arrayBspLeafs[ indexLeaf ];
-			if ( !IsClusterVisible( currentCluster, bspLeaf.cluster ) || !camera->IsVisible( bspLeaf.min, bspLeaf.max ) )
-				continue;
+			// Кластер рисуется целиком, если виден хотя бы один его лист. Глубина кластера - ранг
+			// его ближайшего видимого листа, она же отмечает кластер видимым. Отсечение грубее, чем по листьям:
+			// листья видимого кластера, не прошедшие пирамиду видимости и окклюзию, тоже рисуются,
+			// их число показывает level.cluster_extra_leafs
+			UInt32_t		countClusterVisibleLeafs = 0;
+			UInt32_t		countClusterLeafs = 0;
+			arrayVisibleClusters.clear();
+			for ( UInt32_t indexLeaf = 0, countLeafs = arrayVisibleLeafs.size(); indexLeaf < countLeafs; ++indexLeaf )
+			{
+				BSPLeaf& bspLeaf = arrayBspLeafs[ arrayVisibleLeafs[ indexLeaf ] ];
+				if ( isOcclusion && !occlusionBuffer.IsVisible( Vector3D_t( bspLeaf.min ), Vector3D_t( bspLeaf.max ) ) )
+					continue;
 
-			for ( UInt32_t indexFace = 0; indexFace < bspLeaf.numOfLeafFaces; ++indexFace )
+				++countVisibleLeafs;
+				if ( bspLeaf.cluster < 0 )		continue;
+
+				++countClusterVisibleLeafs;
+				if ( arrayClustersDepth[ bspLeaf.cluster ] != STUDIORENDER_DRAWDEPTH_UNSORTED )		continue;
+
+				arrayClustersDepth[ bspLeaf.cluster ] = indexLeaf;
+				arrayVisibleClusters.push_back( bspLeaf.cluster );
+				countClusterLeafs += arrayClusters[ bspLeaf.cluster ].countLeafs;
+			}
+
+			// Плоскость, которую не собрали в поверхности кластера, рисует первый видимый кластер из ее списка,
+			// поэтому отмечать нарисованные плоскости не нужно
+			UInt32_t		countClusterBatches = 0;
+			for ( UInt32_t index = 0, count = arrayVisibleClusters.size(); index < count; ++index )
 			{
-				int			faceIndex = arrayBspLeafsFaces[ bspLeaf.leafFace + indexFace ];
-				if ( !facesDraw.On( faceIndex ) )
+				int							cluster = arrayVisibleClusters[ index ];
+				const ClusterGeometry&		clusterGeometry = arrayClusters[ cluster ];
+				if ( isFrontToBack )		g_studioRender->SetDrawDepth( arrayClustersDepth[ cluster ] );
+
+				if ( clusterGeometry.countSurfaces > 0 )
+				{
+					g_studioRender->SubmitMesh( mesh, Matrix4x4_t( 1.f ), clusterGeometry.startSurface, clusterGeometry.countSurfaces );
+					countClusterBatches += clusterGeometry.countSurfaces;
+					countSubmittedFaces += clusterGeometry.countBatchedFaces;
+				}
+
+				for ( UInt32_t indexFace = clusterGeometry.startFace, countFaces = clusterGeometry.startFace + clusterGeometry.countFaces; indexFace < countFaces; ++indexFace )
 				{
-					facesDraw.Set( faceIndex );
-					g_studioRender->SubmitMesh( mesh, Matrix4x4_t( 1.f ), faceIndex, 1 );
+					int			faceIndex = arrayClusterFaces[ indexFace ];
+					if ( GetFaceVisibleCluster( faceIndex ) != cluster )		continue;
+
+					g_studioRender->SubmitMesh( mesh, Matrix4x4_t( 1.f ), GetFaceSurface( faceIndex, camera ), 1 );
+					++countSubmittedFaces;
 				}
 			}
+
+			for ( UInt32_t index = 0, count = arrayVisibleClusters.size(); index < count; ++index )
+				arrayClustersDepth[ arrayVisibleClusters[ index ] ] = STUDIORENDER_DRAWDEPTH_UNSORTED;
+
+			stat_clusterBatches.Add( countClusterBatches );
+			stat_clusterExtraLeafs.Add( countClusterLeafs - countClusterVisibleLeafs );
 		}
+		else
+			for ( UInt32_t indexLeaf = 0, countLeafs = arrayVisibleLeafs.size(); indexLeaf < countLeafs; ++indexLeaf )
+			{
+				BSPLeaf& bspLeaf = arrayBspLeafs[ arrayVisibleLeafs[ indexLeaf ] ];
+				if ( isOcclusion && !occlusionBuffer.IsVisible( Vector3D_t( bspLeaf.min ), Vector3D_t( bspLeaf.max ) ) )
+					continue;
+
+				++countVisibleLeafs;
+				if ( isFrontToBack )		g_studioRender->SetDrawDepth( indexLeaf );
+
+				for ( UInt32_t indexFace = 0; indexFace < bspLeaf.numOfLeafFaces; ++indexFace )
+				{
+					int			faceIndex = arrayBspLeafsFaces[ bspLeaf.leafFace + indexFace ];
+					if ( !facesDraw.On( faceIndex ) )
+					{
+						facesDraw.Set( faceIndex );
+						g_studioRender->SubmitMesh( mesh, Matrix4x4_t( 1.f ), GetFaceSurface( faceIndex, camera ), 1 );
+						++countSubmittedFaces;
+					}
+				}
+			}
+
+		// Листья моделей и точечных источников света ищем одним пакетным запросом
+		UInt32_t		countQueryModels = arrayModels.empty() ? 0 : arrayModels.size() - 1;
+		arrayQueryPositions.clear();
+
+		for ( UInt32_t index = 1, count = arrayModels.size(); index < count; ++index )
+			arrayQueryPositions.push_back( ( arrayModels[ index ].model->GetMax() + arrayModels[ index ].model->GetMin() ) / 2.f );
+
+		for ( UInt32_t index = 0, count = arrayPointLights.size(); index < count; ++index )
+			arrayQueryPositions.push_back( arrayPointLights[ index ]->GetPosition() );
+
+		arrayQueryLeafs.resize( arrayQueryPositions.size() );
+		FindLeafs( arrayQueryPositions.data(), arrayQueryLeafs.data(), arrayQueryPositions.size() );
 
 		// Посылаем на отрисовку видимые части динамической геометрии уровня
 		for ( UInt32_t index = 1, count = arrayModels.size(); index < count; ++index )
 		{
 			ModelDescriptor&		modelDescriptor = arrayModels[ index ];
-			int						cluster = arrayBspLeafs[ FindLeaf( ( modelDescriptor.model->GetMax() + modelDescriptor.model->GetMin() ) / 2.f ) ].cluster;
+			const BSPLeaf&			leaf = arrayBspLeafs[ arrayQueryLeafs[ index - 1 ] ];
 
-			if ( !IsClusterVisible( cluster, currentCluster ) || !camera->IsVisible( modelDescriptor.model->GetMin(), modelDescriptor.model->GetMax() ) )
+			if ( !IsClusterVisible( leaf.cluster, currentCluster ) || !IsAreaVisible( leaf.area ) || !camera->IsVisible( modelDescriptor.model->GetMin(), modelDescriptor.model->GetMax() ) ||
+				 isOcclusion && !occlusionBuffer.IsVisible( modelDescriptor.model->GetMin(), modelDescriptor.model->GetMax() ) )
 				continue;
 
+			// Модель рисуется вместе с листом, в котором лежит ее центр
+			++countSubmittedModels;
+			if ( isFrontToBack )		g_studioRender->SetDrawDepth( arrayLeafsDepth[ arrayQueryLeafs[ index - 1 ] ] );
+
 			if ( !modelDescriptor.isBspModel )
-				g_studioRender->SubmitMesh( modelDescriptor.model->GetMesh(), modelDescriptor.model->GetTransformation(), modelDescriptor.model->GetStartFace(), modelDescriptor.model->GetCountFace() );
+			{
+				if ( !lightGrid.IsBuilded() )
+				{
+					g_studioRender->SubmitMesh( modelDescriptor.model->GetMesh(), modelDescriptor.model->GetTransformation(), modelDescriptor.model->GetStartFace(), modelDescriptor.model->GetCountFace() );
+					continue;
+				}
+
+				const Vector3D_t&		center = arrayQueryPositions[ index - 1 ];
+				if ( !modelDescriptor.isLightSampleValid || modelDescriptor.lightSampleOrigin != center )
+				{
+					lightGrid.Sample( center, modelDescriptor.lightSample );
+					modelDescriptor.lightSampleOrigin = center;
+					modelDescriptor.isLightSampleValid = true;
+				}
+
+				g_studioRender->SubmitMesh( modelDescriptor.model->GetMesh(), modelDescriptor.model->GetTransformation(), modelDescriptor.model->GetStartFace(), modelDescriptor.model->GetCountFace(), modelDescriptor.lightSample );
+			}
 			else
 				for ( UInt32_t indexFace = modelDescriptor.model->GetStartFace(), countFace = modelDescriptor.model->GetStartFace() + modelDescriptor.model->GetCountFace(); indexFace < countFace; ++indexFace )
 					if ( !facesDraw.On( indexFace ) )
 					{
 						facesDraw.Set( indexFace );
-						g_studioRender->SubmitMesh( modelDescriptor.model->GetMesh(), modelDescriptor.model->GetTransformation(), indexFace, 1 );
+						g_studioRender->SubmitMesh( modelDescriptor.model->GetMesh(), modelDescriptor.model->GetTransformation(), GetFaceSurface( indexFace, camera ), 1 );
+						++countSubmittedFaces;
 					}
 		}
 
 		// Send to render visible sprites
+		g_studioRender->SetDrawDepth( STUDIORENDER_DRAWDEPTH_UNSORTED );
 		for ( UInt32_t index = 0, count = arraySprites.size(); index < count; ++index )
 		{
 			Sprite*			sprite = arraySprites[ index ];
@@ -475,12 +860,13 @@ void le::Level::Update( UInt32_t DeltaTime )
 		for ( UInt32_t index = 0, count = arrayPointLights.size(); index < count; ++index )
 		{
 			IPointLight*	pointLight = arrayPointLights[ index ];
-			int				cluster = arrayBspLeafs[ FindLeaf( pointLight->GetPosition() ) ].cluster;
+			const BSPLeaf&	leaf = arrayBspLeafs[ arrayQueryLeafs[ countQueryModels + index ] ];
 
-			if ( !IsClusterVisible( cluster, currentCluster ) || !camera->IsVisible( pointLight->GetPosition(), pointLight->GetRadius() ) )
+			if ( !IsClusterVisible( leaf.cluster, currentCluster ) || !IsAreaVisible( leaf.area ) || !camera->IsVisible( pointLight->GetPosition(), pointLight->GetRadius() ) )
 				continue;
 
 			g_studioRender->SubmitLight( pointLight );
+			++countSubmittedLights;
 		}
 
 		// Посылаем на отрисовку видимые прожекторные источники света
@@ -490,12 +876,20 @@ void le::Level::Update( UInt32_t DeltaTime )
 			int				cluster = arrayBspLeafs[ FindLeaf( spotLight->GetPosition() ) ].cluster;
 
 			g_studioRender->SubmitLight( spotLight );
+			++countSubmittedLights;
 		}
 
 		// Посылаем на отрисовку направленые источники света
 		for ( UInt32_t index = 0, count = arrayDirectionalLights.size(); index < count; ++index )
 			g_studioRender->SubmitLight( arrayDirectionalLights[ index ] );
 
+		countSubmittedLights += arrayDirectionalLights.size();
+		stat_leafsVisited.Add( countVisitedLeafs );
+		stat_leafsVisible.Add( countVisibleLeafs );
+		stat_facesSubmitted.Add( countSubmittedFaces );
+		stat_modelsSubmitted.Add( countSubmittedModels );
+		stat_lightsSubmitted.Add( countSubmittedLights );
+
 		g_studioRender->EndScene();
 	}
 }
@@ -505,21 +899,38 @@ void le::Level::Update( UInt32_t DeltaTime )
 // ------------------------------------------------------------------------------------ //
 void le::Level::Clear()
 {
-	IFactory* studioRenderFactory = g_studioRender->GetFactory();
+	IFactory* studioRenderFactory = g_studioRender ? g_studioRender->GetFactory() : nullptr;
 
-	for ( UInt32_t index = 0, count = arrayLightmaps.size(); index < count; ++index )
-		studioRenderFactory->Delete( arrayLightmaps[ index ] );
+	if ( studioRenderFactory )
+		for ( UInt32_t index = 0, count = arrayLightmaps.size(); index < count; ++index )
+			studioRenderFactory->Delete( arrayLightmaps[ index ] );
 
 	for ( UInt32_t index = 0, count = arrayModels.size(); index < count; ++index )
 		if ( arrayModels[ index ].isBspModel )
 			delete arrayModels[ index ].model;
 
-	if ( !mesh )	studioRenderFactory->Delete( mesh );
+	if ( mesh && studioRenderFactory )	studioRenderFactory->Delete( mesh );
+	mesh = nullptr;
 
 	arrayBspLeafs.clear();
 	arrayBspLeafsFaces.clear();
-	arrayBspNodes.clear();
-	arrayBspPlanes.clear();
+	arrayVisibleLeafs.clear();
+	arrayLeafsDepth.clear();
+	arrayFaceOccluders.clear();
+	arrayOccluderVerteces.clear();
+	arrayAreaPortals.clear();
+	arrayPatches.clear();
+	arrayFacePatches.clear();
+	arrayClusters.clear();
+	arrayClusterFaces.clear();
+	arrayFaceClusters.clear();
+	arrayFaceClustersStart.clear();
+	arrayClustersDepth.clear();
+	arrayVisibleClusters.clear();
+	countAreas = 0;
+	arrayNodes.clear();
+	collisionModel.Clear();
+	lightGrid.Clear();
 	arrayModels.clear();
 	arrayLightmaps.clear();
 	arrayCameras.clear();
@@ -546,7 +957,7 @@ void le::Level::AddCamera( ICamera* Camera )
 void le::Level::AddModel( IModel* Model )
 {
 	LIFEENGINE_ASSERT( Model );
-	arrayModels.push_back( { false, ( le::Model* ) Model } );
+	arrayModels.push_back( { false, ( le::Model* ) Model, false } );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -757,7 +1168,7 @@ void le::Level::RemoveSprite( UInt32_t Index )
 // ------------------------------------------------------------------------------------ //
 bool le::Level::IsLoaded() const
 {
-	return mesh;
+	return isLoaded;
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -905,8 +1316,43 @@ le::ISprite* le::Level::GetSprite( UInt32_t Index ) const
 // ------------------------------------------------------------------------------------ //
 le::Level::Level() :
 	mesh( nullptr ),
-	isLoaded( false )
-{}
+	isLoaded( false ),
+	isAllAreasVisible( true ),
+	countAreas( 0 )
+{
+	// Консольные переменные общие для всех уровней, поэтому создаем их один раз
+	if ( !r_occlusion )
+	{
+		r_occlusion = new ConVar();
+		r_occlusion->Initialize( "r_occlusion", "1", CVT_BOOL, "Enable CPU occlusion culling of leafs and models", true, 0, true, 1, nullptr );
+
+		r_showocclusion = new ConVar();
+		r_showocclusion->Initialize( "r_showocclusion", "0", CVT_BOOL, "Save occlusion buffer of next frame to occlusionbuffer.pgm", true, 0, true, 1, nullptr );
+
+		r_areaportals = new ConVar();
+		r_areaportals->Initialize( "r_areaportals", "1", CVT_BOOL, "Enable culling of areas behind closed area portals", true, 0, true, 1, nullptr );
+
+		r_fronttoback = new ConVar();
+		r_fronttoback->Initialize( "r_fronttoback", "1", CVT_BOOL, "Draw visible leafs in front-to-back order of BSP tree", true, 0, true, 1, nullptr );
+
+		g_consoleSystem->RegisterVar( r_occlusion );
+		g_consoleSystem->RegisterVar( r_showocclusion );
+		g_consoleSystem->RegisterVar( r_areaportals );
+		r_clusterbatches = new ConVar();
+		r_clusterbatches->Initialize( "r_clusterbatches", "1", CVT_BOOL, "Draw static world by clusters with faces merged by material and lightmap", true, 0, true, 1, nullptr );
+
+		g_consoleSystem->RegisterVar( r_fronttoback );
+		g_consoleSystem->RegisterVar( r_clusterbatches );
+
+		stat_leafsVisited.Register( g_statsSystem, "level.leafs_visited", ST_COUNTER );
+		stat_leafsVisible.Register( g_statsSystem, "level.leafs_visible", ST_COUNTER );
+		stat_facesSubmitted.Register( g_statsSystem, "level.faces_submitted", ST_COUNTER );
+		stat_clusterBatches.Register( g_statsSystem, "level.cluster_batches", ST_COUNTER );
+		stat_clusterExtraLeafs.Register( g_statsSystem, "level.cluster_extra_leafs", ST_COUNTER );
+		stat_modelsSubmitted.Register( g_statsSystem, "level.models_submitted", ST_COUNTER );
+		stat_lightsSubmitted.Register( g_statsSystem, "level.lights_submitted", ST_COUNTER );
+	}
+}
 
 // ------------------------------------------------------------------------------------ //
 // Деструктор
@@ -929,18 +1375,281 @@ int le::Level::FindLeaf( const Vector3D_t& Position ) const
 
 	while ( index >= 0 )
 	{
-		const BSPNode& node = arrayBspNodes[ index ];
-		const BSPPlane& plane = arrayBspPlanes[ node.plane ];
+		// Ветвление по осевым плоскостям здесь дороже полного скалярного произведения
+		const BSPCompactNode& node = arrayNodes[ index ];
+		distance = glm::dot( node.normal, Position ) - node.distance;
+		index = node.children[ distance < 0 ];
+	}
 
-		distance = glm::dot( plane.normal, Position ) - plane.distance;
+	return -index - 1;
+}
 
-		if ( distance >= 0 )
-			index = node.front;
-		else
-			index = node.back;
+// ------------------------------------------------------------------------------------ //
+// Найти листья для нескольких точек, по четыре точки спускаются по дереву одновременно
+// ------------------------------------------------------------------------------------ //
+void le::Level::FindLeafs( const Vector3D_t* Positions, int* Leafs, UInt32_t Count ) const
+{
+	UInt32_t		index = 0;
+
+#ifdef LEVEL_SSE2
+	if ( isLoaded )
+		for ( ; index + 4 <= Count; index += 4 )
+		{
+			const Vector3D_t*		positions = &Positions[ index ];
+			__m128					positionX = _mm_setr_ps( positions[ 0 ].x, positions[ 1 ].x, positions[ 2 ].x, positions[ 3 ].x );
+			__m128					positionY = _mm_setr_ps( positions[ 0 ].y, positions[ 1 ].y, positions[ 2 ].y, positions[ 3 ].y );
+			__m128					positionZ = _mm_setr_ps( positions[ 0 ].z, positions[ 1 ].z, positions[ 2 ].z, positions[ 3 ].z );
+			__m128					zero = _mm_setzero_ps();
+			int						nodes[ 4 ] = { 0, 0, 0, 0 };
+
+			// Спускаемся, пока хотя бы одна точка не дошла до листа. Дошедшие точки
+			// считают расстояние до корня, но их результат не используется
+			while ( ( nodes[ 0 ] & nodes[ 1 ] & nodes[ 2 ] & nodes[ 3 ] ) >= 0 )
+			{
+				const BSPCompactNode&		node0 = arrayNodes[ glm::max( nodes[ 0 ], 0 ) ];
+				const BSPCompactNode&		node1 = arrayNodes[ glm::max( nodes[ 1 ], 0 ) ];
+				const BSPCompactNode&		node2 = arrayNodes[ glm::max( nodes[ 2 ], 0 ) ];
+				const BSPCompactNode&		node3 = arrayNodes[ glm::max( nodes[ 3 ], 0 ) ];
+
+				__m128		distance = _mm_mul_ps( _mm_setr_ps( node0.normal.x, node1.normal.x, node2.normal.x, node3.normal.x ), positionX );
+				distance = _mm_add_ps( distance, _mm_mul_ps( _mm_setr_ps( node0.normal.y, node1.normal.y, node2.normal.y, node3.normal.y ), positionY ) );
+				distance = _mm_add_ps( distance, _mm_mul_ps( _mm_setr_ps( node0.normal.z, node1.normal.z, node2.normal.z, node3.normal.z ), positionZ ) );
+				distance = _mm_sub_ps( distance, _mm_setr_ps( node0.distance, node1.distance, node2.distance, node3.distance ) );
+
+				int			maskBack = _mm_movemask_ps( _mm_cmplt_ps( distance, zero ) );
+				if ( nodes[ 0 ] >= 0 )		nodes[ 0 ] = node0.children[ maskBack & 1 ];
+				if ( nodes[ 1 ] >= 0 )		nodes[ 1 ] = node1.children[ ( maskBack >> 1 ) & 1 ];
+				if ( nodes[ 2 ] >= 0 )		nodes[ 2 ] = node2.children[ ( maskBack >> 2 ) & 1 ];
+				if ( nodes[ 3 ] >= 0 )		nodes[ 3 ] = node3.children[ ( maskBack >> 3 ) & 1 ];
+			}
+
+			for ( UInt32_t lane = 0; lane < 4; ++lane )
+				Leafs[ index + lane ] = -nodes[ lane ] - 1;
+		}
+#endif // LEVEL_SSE2
+
+	for ( ; index < Count; ++index )
+		Leafs[ index ] = FindLeaf( Positions[ index ] );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Перепаковать дерево в компактный массив узлов в порядке обхода в глубину
+// ------------------------------------------------------------------------------------ //
+void le::Level::BuildCompactNodes( const std::vector< BSPNode >& Nodes, const std::vector< BSPPlane >& Planes )
+{
+	arrayNodes.clear();
+	if ( Nodes.empty() )		return;
+
+	std::vector< int >		remap( Nodes.size(), -1 );
+	std::vector< int >		stackNodes;
+
+	arrayNodes.reserve( Nodes.size() );
+	stackNodes.push_back( 0 );
+
+	while ( !stackNodes.empty() )
+	{
+		int					index = stackNodes.back();
+		const BSPNode&		node = Nodes[ index ];
+		const BSPPlane&		plane = Planes[ node.plane ];
+		BSPCompactNode		compactNode;
+
+		stackNodes.pop_back();
+		remap[ index ] = arrayNodes.size();
+
+		compactNode.normal = plane.normal;
+		compactNode.distance = plane.distance;
+		compactNode.children[ 0 ] = node.front;
+		compactNode.children[ 1 ] = node.back;
+		compactNode.axis = BSP_NODE_NOT_AXIAL;
+		compactNode.padding = 0;
+
+		for ( UInt32_t axis = 0; axis < 3; ++axis )
+			if ( fabsf( plane.normal[ axis ] ) == 1.f )
+				compactNode.axis = axis;
+
+		arrayNodes.push_back( compactNode );
+
+		// Заднего потомка кладем первым, чтобы передний шел сразу за родителем
+		if ( node.back >= 0 )		stackNodes.push_back( node.back );
+		if ( node.front >= 0 )		stackNodes.push_back( node.front );
 	}
 
-	return -index - 1;
+	for ( UInt32_t index = 0, count = arrayNodes.size(); index < count; ++index )
+		for ( UInt32_t child = 0; child < 2; ++child )
+			if ( arrayNodes[ index ].children[ child ] >= 0 )
+				arrayNodes[ index ].children[ child ] = remap[ arrayNodes[ index ].children[ child ] ];
+}
+
+// ------------------------------------------------------------------------------------ //
+// Найти листья, которые пересекает параллелепипед
+// ------------------------------------------------------------------------------------ //
+void le::Level::FindLeafs( const Vector3D_t& Min, const Vector3D_t& Max, std::vector< int >& Leafs ) const
+{
+	if ( arrayNodes.empty() )		return;
+
+	std::vector< int >		stackNodes;
+	stackNodes.push_back( 0 );
+
+	while ( !stackNodes.empty() )
+	{
+		int			index = stackNodes.back();
+		stackNodes.pop_back();
+
+		if ( index < 0 )
+		{
+			Leafs.push_back( -index - 1 );
+			continue;
+		}
+
+		const BSPCompactNode&		node = arrayNodes[ index ];
+
+		// Осевую плоскость параллелепипед пересекает, если плоскость между его гранями
+		if ( node.axis != BSP_NODE_NOT_AXIAL )
+		{
+			float		minDistance = node.normal[ node.axis ] * Min[ node.axis ] - node.distance;
+			float		maxDistance = node.normal[ node.axis ] * Max[ node.axis ] - node.distance;
+
+			if ( glm::max( minDistance, maxDistance ) >= 0.f )		stackNodes.push_back( node.children[ 0 ] );
+			if ( glm::min( minDistance, maxDistance ) < 0.f )		stackNodes.push_back( node.children[ 1 ] );
+			continue;
+		}
+
+		// Ближняя и дальняя вершины параллелепипеда относительно нормали плоскости
+		Vector3D_t			nearPoint( node.normal.x >= 0.f ? Min.x : Max.x, node.normal.y >= 0.f ? Min.y : Max.y, node.normal.z >= 0.f ? Min.z : Max.z );
+		Vector3D_t			farPoint( node.normal.x >= 0.f ? Max.x : Min.x, node.normal.y >= 0.f ? Max.y : Min.y, node.normal.z >= 0.f ? Max.z : Min.z );
+
+		if ( glm::dot( node.normal, farPoint ) - node.distance >= 0.f )		stackNodes.push_back( node.children[ 0 ] );
+		if ( glm::dot( node.normal, nearPoint ) - node.distance < 0.f )		stackNodes.push_back( node.children[ 1 ] );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Задать состояние порталов между зонами, которые пересекает параллелепипед (например дверь)
+// ------------------------------------------------------------------------------------ //
+bool le::Level::SetAreaPortalState( const Vector3D_t& Min, const Vector3D_t& Max, bool IsOpen )
+{
+	bool		isFound = false;
+
+	for ( UInt32_t index = 0, count = arrayAreaPortals.size(); index < count; ++index )
+	{
+		AreaPortal&		areaPortal = arrayAreaPortals[ index ];
+		if ( glm::any( glm::lessThan( Max, areaPortal.min ) ) || glm::any( glm::greaterThan( Min, areaPortal.max ) ) )
+			continue;
+
+		areaPortal.isOpen = IsOpen;
+		isFound = true;
+	}
+
+	return isFound;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Трассировать луч по кистям уровня
+// ------------------------------------------------------------------------------------ //
+void le::Level::TraceRay( const Vector3D_t& Start, const Vector3D_t& End, TraceResult& Result )
+{
+	TraceRequest		request;
+	request.type = TRT_RAY;
+	request.start = Start;
+	request.end = End;
+
+	collisionModel.Trace( request, Result );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Трассировать параллелепипед по кистям уровня
+// ------------------------------------------------------------------------------------ //
+void le::Level::TraceBox( const Vector3D_t& Start, const Vector3D_t& End, const Vector3D_t& Min, const Vector3D_t& Max, TraceResult& Result )
+{
+	TraceRequest		request;
+	request.type = TRT_BOX;
+	request.start = Start;
+	request.end = End;
+	request.min = Min;
+	request.max = Max;
+
+	collisionModel.Trace( request, Result );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Трассировать сферу по кистям уровня
+// ------------------------------------------------------------------------------------ //
+void le::Level::TraceSphere( const Vector3D_t& Start, const Vector3D_t& End, float Radius, TraceResult& Result )
+{
+	TraceRequest		request;
+	request.type = TRT_SPHERE;
+	request.start = Start;
+	request.end = End;
+	request.radius = Radius;
+
+	collisionModel.Trace( request, Result );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Выполнить пачку трассировок, большие пачки делятся между потоками
+// ------------------------------------------------------------------------------------ //
+void le::Level::TraceBatch( const TraceRequest* Requests, TraceResult* Results, UInt32_t Count )
+{
+	collisionModel.TraceBatch( Requests, Results, Count );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Отметить зоны, достижимые из начальной через открытые порталы
+// ------------------------------------------------------------------------------------ //
+void le::Level::Areas_FloodFill( int StartArea )
+{
+	areasVisible.ClearAll();
+	areasVisible.Set( StartArea );
+
+	arrayAreasStack.clear();
+	arrayAreasStack.push_back( StartArea );
+
+	while ( !arrayAreasStack.empty() )
+	{
+		int			area = arrayAreasStack.back();
+		arrayAreasStack.pop_back();
+
+		for ( UInt32_t index = 0, count = arrayAreaPortals.size(); index < count; ++index )
+		{
+			AreaPortal&		areaPortal = arrayAreaPortals[ index ];
+			if ( !areaPortal.isOpen )		continue;
+
+			int				nextArea;
+			if ( areaPortal.areas[ 0 ] == area )				nextArea = areaPortal.areas[ 1 ];
+			else if ( areaPortal.areas[ 1 ] == area )			nextArea = areaPortal.areas[ 0 ];
+			else												continue;
+
+			if ( !areasVisible.On( nextArea ) )
+			{
+				areasVisible.Set( nextArea );
+				arrayAreasStack.push_back( nextArea );
+			}
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Получить поверхность плоскости, для патчей выбирается LOD по размеру на экране
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::Level::GetFaceSurface( int FaceIndex, Camera* Camera ) const
+{
+	int			patchIndex = arrayFacePatches[ FaceIndex ];
+	if ( patchIndex < 0 )		return FaceIndex;
+
+	const Patch&		patch = arrayPatches[ patchIndex ];
+	return patch.lodSurfaces[ PatchTessellator::SelectLod( patch, Camera->GetPosition(), Camera->GetProjectionMatrix()[ 1 ][ 1 ] ) ];
+}
+
+// ------------------------------------------------------------------------------------ //
+// Получить первый видимый кластер из списка кластеров плоскости, -1 если таких нет
+// ------------------------------------------------------------------------------------ //
+int le::Level::GetFaceVisibleCluster( int FaceIndex ) const
+{
+	for ( UInt32_t index = arrayFaceClustersStart[ FaceIndex ], count = arrayFaceClustersStart[ FaceIndex + 1 ]; index < count; ++index )
+		if ( arrayClustersDepth[ arrayFaceClusters[ index ] ] != STUDIORENDER_DRAWDEPTH_UNSORTED )
+			return arrayFaceClusters[ index ];
+
+	return -1;
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -959,6 +1668,164 @@ bool le::Level::IsClusterVisible( int CurrentCluster, int TestCluster ) const
 	return true;
 }
 
+// ------------------------------------------------------------------------------------ //
+// Собрать статичную геометрию по кластерам: индексы уровня перестраиваются так, что у кластера
+// на каждую пару материал и карта освещения один непрерывный диапазон. Строится при каждой загрузке
+// ------------------------------------------------------------------------------------ //
+void le::Level::Clusters_Build( const char* Path, std::vector< UInt32_t >& Indices, std::vector< MeshSurface >& Surfaces, UInt32_t CountFaces )
+{
+	// Собираем пары (плоскость, кластер). Листья вне кластеров сплошные, плоскостей для отрисовки в них нет
+	int											countClusters = 0;
+	std::vector< std::pair< int, int > >		arrayFaceClusterPairs;
+
+	for ( UInt32_t indexLeaf = 0, countLeafs = arrayBspLeafs.size(); indexLeaf < countLeafs; ++indexLeaf )
+	{
+		const BSPLeaf&		bspLeaf = arrayBspLeafs[ indexLeaf ];
+		if ( bspLeaf.cluster < 0 )		continue;
+
+		countClusters = glm::max( countClusters, bspLeaf.cluster + 1 );
+		for ( int indexFace = 0; indexFace < bspLeaf.numOfLeafFaces; ++indexFace )
+		{
+			int			faceIndex = arrayBspLeafsFaces[ bspLeaf.leafFace + indexFace ];
+			if ( faceIndex >= 0 && faceIndex < ( int ) CountFaces )
+				arrayFaceClusterPairs.push_back( std::make_pair( faceIndex, bspLeaf.cluster ) );
+		}
+	}
+
+	if ( countClusters == 0 )		return;
+
+	std::sort( arrayFaceClusterPairs.begin(), arrayFaceClusterPairs.end() );
+	arrayFaceClusterPairs.erase( std::unique( arrayFaceClusterPairs.begin(), arrayFaceClusterPairs.end() ), arrayFaceClusterPairs.end() );
+
+	// Кластеры каждой плоскости лежат по возрастанию, владелец плоскости - первый из них
+	arrayFaceClustersStart.assign( CountFaces + 1, 0 );
+	arrayFaceClusters.resize( arrayFaceClusterPairs.size() );
+
+	for ( UInt32_t index = 0, count = arrayFaceClusterPairs.size(); index < count; ++index )
+	{
+		++arrayFaceClustersStart[ arrayFaceClusterPairs[ index ].first + 1 ];
+		arrayFaceClusters[ index ] = arrayFaceClusterPairs[ index ].second;
+	}
+
+	for ( UInt32_t index = 0; index < CountFaces; ++index )
+		arrayFaceClustersStart[ index + 1 ] += arrayFaceClustersStart[ index ];
+
+	// Владелец собирает плоскость в свои поверхности. Патчи (LOD выбирается каждый кадр) и плоскости
+	// других кластеров остаются отдельными, их рисует первый видимый кластер из списка плоскости
+	std::vector< std::tuple< UInt32_t, UInt32_t, UInt32_t, int > >		arrayBatchFaces;
+	std::vector< std::pair< int, int > >								arraySeparateFaces;
+
+	for ( UInt32_t index = 0, count = arrayFaceClusterPairs.size(); index < count; ++index )
+	{
+		int						faceIndex = arrayFaceClusterPairs[ index ].first;
+		int						cluster = arrayFaceClusterPairs[ index ].second;
+		const MeshSurface&		surface = Surfaces[ faceIndex ];
+		if ( surface.countIndeces == 0 )		continue;
+
+		if ( arrayFacePatches[ faceIndex ] < 0 && arrayFaceClusters[ arrayFaceClustersStart[ faceIndex ] ] == cluster )
+			arrayBatchFaces.push_back( std::make_tuple( ( UInt32_t ) cluster, surface.materialID, surface.lightmapID, faceIndex ) );
+		else
+			arraySeparateFaces.push_back( std::make_pair( cluster, faceIndex ) );
+	}
+
+	std::sort( arrayBatchFaces.begin(), arrayBatchFaces.end() );
+	std::sort( arraySeparateFaces.begin(), arraySeparateFaces.end() );
+
+	ClusterGeometry			emptyCluster = { 0, 0, 0, 0, 0, 0 };
+	arrayClusters.assign( countClusters, emptyCluster );
+	arrayClustersDepth.assign( countClusters, STUDIORENDER_DRAWDEPTH_UNSORTED );
+
+	for ( UInt32_t indexLeaf = 0, countLeafs = arrayBspLeafs.size(); indexLeaf < countLeafs; ++indexLeaf )
+		if ( arrayBspLeafs[ indexLeaf ].cluster >= 0 )
+			++arrayClusters[ arrayBspLeafs[ indexLeaf ].cluster ].countLeafs;
+
+	// Индексы строим заново: сначала группы кластеров, затем поверхности вне групп. Индексы плоскости группы
+	// пересчитываются от наименьшей базовой вершины группы (чтобы поверхность по возможности осталась
+	// с 16-битными индексами), а поверхность плоскости указывает внутрь диапазона группы. Так у пути
+	// по кластерам и пути по плоскостям одна копия индексов, меш тоже не копирует вложенные диапазоны
+	std::vector< UInt32_t >		arrayIndices;
+	std::vector< bool >			isBatchedSurfaces( Surfaces.size(), false );
+	UInt32_t					countSurfaces = Surfaces.size();
+	UInt32_t					countBatches = 0;
+	arrayIndices.reserve( Indices.size() );
+
+	for ( UInt32_t index = 0, count = arrayBatchFaces.size(); index < count; )
+	{
+		UInt32_t			cluster = std::get< 0 >( arrayBatchFaces[ index ] );
+		UInt32_t			materialID = std::get< 1 >( arrayBatchFaces[ index ] );
+		UInt32_t			lightmapID = std::get< 2 >( arrayBatchFaces[ index ] );
+		UInt32_t			indexEnd = index;
+		UInt32_t			baseVertex = Surfaces[ std::get< 3 >( arrayBatchFaces[ index ] ) ].startVertexIndex;
+
+		while ( indexEnd < count && std::get< 0 >( arrayBatchFaces[ indexEnd ] ) == cluster && std::get< 1 >( arrayBatchFaces[ indexEnd ] ) == materialID && std::get< 2 >( arrayBatchFaces[ indexEnd ] ) == lightmapID )
+		{
+			baseVertex = glm::min( baseVertex, Surfaces[ std::get< 3 >( arrayBatchFaces[ indexEnd ] ) ].startVertexIndex );
+			++indexEnd;
+		}
+
+		MeshSurface			batchSurface;
+		batchSurface.materialID = materialID;
+		batchSurface.lightmapID = lightmapID;
+		batchSurface.startVertexIndex = baseVertex;
+		batchSurface.startIndex = arrayIndices.size();
+		batchSurface.countIndeces = 0;
+
+		for ( ; index < indexEnd; ++index )
+		{
+			int					faceIndex = std::get< 3 >( arrayBatchFaces[ index ] );
+			MeshSurface&		faceSurface = Surfaces[ faceIndex ];
+			UInt32_t			startIndex = arrayIndices.size();
+
+			for ( UInt32_t indexVertex = 0; indexVertex < faceSurface.countIndeces; ++indexVertex )
+				arrayIndices.push_back( Indices[ faceSurface.startIndex + indexVertex ] + faceSurface.startVertexIndex - baseVertex );
+
+			faceSurface.startIndex = startIndex;
+			faceSurface.startVertexIndex = baseVertex;
+			isBatchedSurfaces[ faceIndex ] = true;
+
+			batchSurface.countIndeces += faceSurface.countIndeces;
+			++arrayClusters[ cluster ].countBatchedFaces;
+		}
+
+		ClusterGeometry&	clusterGeometry = arrayClusters[ cluster ];
+		if ( clusterGeometry.countSurfaces == 0 )		clusterGeometry.startSurface = Surfaces.size();
+
+		++clusterGeometry.countSurfaces;
+		++countBatches;
+		Surfaces.push_back( batchSurface );
+	}
+
+	for ( UInt32_t index = 0; index < countSurfaces; ++index )
+	{
+		if ( isBatchedSurfaces[ index ] )		continue;
+
+		MeshSurface&		surface = Surfaces[ index ];
+		UInt32_t			startIndex = arrayIndices.size();
+
+		if ( surface.startIndex + surface.countIndeces <= Indices.size() )
+			arrayIndices.insert( arrayIndices.end(), Indices.begin() + surface.startIndex, Indices.begin() + surface.startIndex + surface.countIndeces );
+		else
+			surface.countIndeces = 0;
+
+		surface.startIndex = startIndex;
+	}
+
+	Indices.swap( arrayIndices );
+
+	arrayClusterFaces.resize( arraySeparateFaces.size() );
+	for ( UInt32_t index = 0, count = arraySeparateFaces.size(); index < count; ++index )
+	{
+		ClusterGeometry&	clusterGeometry = arrayClusters[ arraySeparateFaces[ index ].first ];
+		if ( clusterGeometry.countFaces == 0 )		clusterGeometry.startFace = index;
+
+		++clusterGeometry.countFaces;
+		arrayClusterFaces[ index ] = arraySeparateFaces[ index ].second;
+	}
+
+	g_consoleSystem->PrintInfo( "Level [%s]: %i clusters, %i faces merged into %i surfaces, %i faces drawn separately, %i -> %i indices",
+								Path, countClusters, ( UInt32_t ) arrayBatchFaces.size(), countBatches, ( UInt32_t ) arraySeparateFaces.size(), ( UInt32_t ) arrayIndices.size(), ( UInt32_t ) Indices.size() );
+}
+
 // ------------------------------------------------------------------------------------ //
 // Пропарсить параметры сущностей
 // ------------------------------------------------------------------------------------ //
@@ -1028,3 +1895,96 @@ void le::Level::EntitiesParse( std::vector< Entity >& ArrayEntities, BSPEntities
 		}
 	}
 }
+
+// ------------------------------------------------------------------------------------ //
+// Отобрать видимые листья обходом дерева спереди назад: в каждом узле первым идет потомок
+// со стороны камеры. Листья нигде не пересекаются, поэтому порядок обхода - порядок глубины
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::Level::FindVisibleLeafs_FrontToBack( Camera* Camera, int CurrentCluster )
+{
+	const Vector3D_t&		cameraPosition = Camera->GetPosition();
+	UInt32_t				countVisitedLeafs = 0;
+	arrayLeafsDepth.assign( arrayBspLeafs.size(), STUDIORENDER_DRAWDEPTH_UNSORTED );
+	arrayStackNodes.clear();
+	arrayStackNodes.push_back( 0 );
+
+	while ( !arrayStackNodes.empty() )
+	{
+		int			index = arrayStackNodes.back();
+		arrayStackNodes.pop_back();
+
+		if ( index < 0 )
+		{
+			int				indexLeaf = -index - 1;
+			BSPLeaf&		bspLeaf = arrayBspLeafs[ indexLeaf ];
+
+			++countVisitedLeafs;
+			if ( IsClusterVisible( CurrentCluster, bspLeaf.cluster ) && IsAreaVisible( bspLeaf.area ) && Camera->IsVisible( bspLeaf.min, bspLeaf.max ) )
+			{
+				arrayLeafsDepth[ indexLeaf ] = arrayVisibleLeafs.size();
+				arrayVisibleLeafs.push_back( indexLeaf );
+			}
+
+			continue;
+		}
+
+		const BSPCompactNode&		node = arrayNodes[ index ];
+		float						distance = ( node.axis != BSP_NODE_NOT_AXIAL ? node.normal[ node.axis ] * cameraPosition[ node.axis ] : glm::dot( node.normal, cameraPosition ) ) - node.distance;
+		UInt32_t					nearChild = distance >= 0.f ? 0 : 1;
+
+		// Дальнего потомка кладем первым, чтобы ближний обходился раньше
+		arrayStackNodes.push_back( node.children[ 1 - nearChild ] );
+		arrayStackNodes.push_back( node.children[ nearChild ] );
+	}
+
+	return countVisitedLeafs;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Нарисовать окклюдеры видимых листьев и моделей в буфер перекрытий
+// ------------------------------------------------------------------------------------ //
+void le::Level::Occlusion_Rasterize( Camera* Camera )
+{
+	occlusionBuffer.Begin( Camera->GetProjectionMatrix() * Camera->GetViewMatrix(), Camera->GetNear() );
+
+	// Плоскость может лежать в нескольких листьях, поэтому отмечаем добавленные в facesDraw
+	for ( UInt32_t indexLeaf = 0, countLeafs = arrayVisibleLeafs.size(); indexLeaf < countLeafs; ++indexLeaf )
+	{
+		BSPLeaf& bspLeaf = arrayBspLeafs[ arrayVisibleLeafs[ indexLeaf ] ];
+
+		for ( UInt32_t indexFace = 0; indexFace < bspLeaf.numOfLeafFaces; ++indexFace )
+		{
+			int			faceIndex = arrayBspLeafsFaces[ bspLeaf.leafFace + indexFace ];
+			UInt32_t	startVertex = arrayFaceOccluders[ faceIndex ];
+			UInt32_t	countVerteces = arrayFaceOccluders[ faceIndex + 1 ] - startVertex;
+
+			if ( countVerteces > 0 && !facesDraw.On( faceIndex ) )
+			{
+				facesDraw.Set( faceIndex );
+				occlusionBuffer.AddOccluder( &arrayOccluderVerteces[ startVertex ], countVerteces );
+			}
+		}
+	}
+
+	facesDraw.ClearAll();
+
+	// Модели-окклюдеры закрывают сцену своим ограничивающим объемом
+	for ( UInt32_t index = 1, count = arrayModels.size(); index < count; ++index )
+	{
+		Model*		model = arrayModels[ index ].model;
+		if ( model->IsOccluder() && Camera->IsVisible( model->GetMin(), model->GetMax() ) )
+			occlusionBuffer.AddOccluder( model->GetMin(), model->GetMax() );
+	}
+
+	occlusionBuffer.Rasterize();
+
+	if ( r_showocclusion->GetValueBool() )
+	{
+		if ( occlusionBuffer.Save( "occlusionbuffer.pgm" ) )
+			g_consoleSystem->PrintInfo( "Occlusion buffer saved to occlusionbuffer.pgm (%i triangles)", occlusionBuffer.GetCountTriangles() );
+		else
+			g_consoleSystem->PrintError( "Failed to save occlusion buffer" );
+
+		r_showocclusion->SetValueBool( false );
+	}
+}
@@ -12,6 +12,7 @@
 #define LEVEL_H
 
 #include <vector>
+#include <fstream>
 
 #include "engine/ilevel.h"
 #include "engine/camera.h"
@@ -19,6 +20,10 @@
 #include "studiorender/imesh.h"
 #include "bsp.h"
 #include "bitset.h"
+#include "occlusionbuffer.h"
+#include "patchtessellator.h"
+#include "collisionmodel.h"
+#include "lightgrid.h"
 
 //---------------------------------------------------------------------//
 
@@ -59,6 +64,11 @@ namespace le
 		virtual void					RemoveDirectionalLight( UInt32_t Index );
 		virtual void					RemoveSprite( ISprite* Sprite );
 		virtual void					RemoveSprite( UInt32_t Index );
+		virtual bool					SetAreaPortalState( const Vector3D_t& Min, const Vector3D_t& Max, bool IsOpen );
+		virtual void					TraceRay( const Vector3D_t& Start, const Vector3D_t& End, TraceResult& Result );
+		virtual void					TraceBox( const Vector3D_t& Start, const Vector3D_t& End, const Vector3D_t& Min, const Vector3D_t& Max, TraceResult& Result );
+		virtual void					TraceSphere( const Vector3D_t& Start, const Vector3D_t& End, float Radius, TraceResult& Result );
+		virtual void					TraceBatch( const TraceRequest* Requests, TraceResult* Results, UInt32_t Count );
 
 		virtual bool					IsLoaded() const;
 		virtual const char*				GetNameFormat() const;
@@ -87,16 +97,38 @@ namespace le
 			return FindLeaf( Camera->GetPosition() );
 		}
 
+		void					FindLeafs( const Vector3D_t& Min, const Vector3D_t& Max, std::vector< int >& Leafs ) const;
+		void					FindLeafs( const Vector3D_t* Positions, int* Leafs, UInt32_t Count ) const;
 		bool					IsClusterVisible( int CurrentCluster, int TestCluster ) const;
 
+		inline bool				IsAreaVisible( int Area )
+		{
+			return isAllAreasVisible || Area < 0 || areasVisible.On( Area );
+		}
+
 	private:
 
 		//---------------------------------------------------------------------//
 
+		struct AreaPortal
+		{
+			bool			isOpen;
+			int				areas[ 2 ];
+			Vector3D_t		min;
+			Vector3D_t		max;
+		};
+
+		//---------------------------------------------------------------------//
+
 		struct ModelDescriptor
 		{
 			bool			isBspModel;
 			Model*			model;
+
+			// Освещение из сетки света, пересчитывается только когда модель сдвинулась
+			bool			isLightSampleValid;
+			Vector3D_t		lightSampleOrigin;
+			LightSample		lightSample;
 		};
 
 		//---------------------------------------------------------------------//
@@ -109,17 +141,61 @@ namespace le
 
 		//---------------------------------------------------------------------//
 
+		// Статичная геометрия кластера: поверхности, собранные из его плоскостей по материалу
+		// и карте освещения, и плоскости, которые посылаются на отрисовку по одной
+		struct ClusterGeometry
+		{
+			UInt32_t		startSurface;
+			UInt32_t		countSurfaces;
+			UInt32_t		countBatchedFaces;
+			UInt32_t		startFace;
+			UInt32_t		countFaces;
+			UInt32_t		countLeafs;
+		};
+
+		//---------------------------------------------------------------------//
+
+		void					LoadRenderData( std::ifstream& File, const char* Path, const BSPLump* BspLumps, std::vector< BSPVertex >& Verteces, std::vector< UInt32_t >& Indices, std::vector< BSPFace >& Faces, std::vector< BSPTexture >& BspTextures, const BSPModel& WorldModel );
+		void					Clusters_Build( const char* Path, std::vector< UInt32_t >& Indices, std::vector< MeshSurface >& Surfaces, UInt32_t CountFaces );
 		void					EntitiesParse( std::vector< Entity >& ArrayEntities, BSPEntities& BSPEntities, UInt32_t Size );
+		void					BuildCompactNodes( const std::vector< BSPNode >& Nodes, const std::vector< BSPPlane >& Planes );
+		void					Occlusion_Rasterize( Camera* Camera );
+		UInt32_t				FindVisibleLeafs_FrontToBack( Camera* Camera, int CurrentCluster );
+		void					Areas_FloodFill( int StartArea );
+		UInt32_t				GetFaceSurface( int FaceIndex, Camera* Camera ) const;
+		int						GetFaceVisibleCluster( int FaceIndex ) const;
 
 		bool								isLoaded;
+		bool								isAllAreasVisible;
+		UInt32_t							countAreas;
 		BSPVisData							visData;
 		Bitset								facesDraw;
+		Bitset								areasVisible;
 		IMesh*								mesh;
+		OcclusionBuffer						occlusionBuffer;
+		CollisionModel						collisionModel;
+		LightGrid							lightGrid;
 				
-		std::vector< BSPNode >				arrayBspNodes;
+		std::vector< BSPCompactNode >		arrayNodes;
 		std::vector< BSPLeaf >				arrayBspLeafs;
-		std::vector< BSPPlane >				arrayBspPlanes;	
 		std::vector< int >					arrayBspLeafsFaces;
+		std::vector< UInt32_t >				arrayVisibleLeafs;
+		std::vector< UInt32_t >				arrayLeafsDepth;
+		std::vector< int >					arrayStackNodes;
+		std::vector< Vector3D_t >			arrayQueryPositions;
+		std::vector< int >					arrayQueryLeafs;
+		std::vector< UInt32_t >				arrayFaceOccluders;
+		std::vector< Vector3D_t >			arrayOccluderVerteces;
+		std::vector< AreaPortal >			arrayAreaPortals;
+		std::vector< Patch >				arrayPatches;
+		std::vector< int >					arrayFacePatches;
+		std::vector< int >					arrayAreasStack;
+		std::vector< ClusterGeometry >		arrayClusters;
+		std::vector< int >					arrayClusterFaces;
+		std::vector< int >					arrayFaceClusters;
+		std::vector< UInt32_t >				arrayFaceClustersStart;
+		std::vector< UInt32_t >				arrayClustersDepth;
+		std::vector< int >					arrayVisibleClusters;
 
 		std::vector< ITexture* >			arrayLightmaps;
 		std::vector< Camera* >				arrayCameras;
@@ -0,0 +1,127 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+
+#include "lightgrid.h"
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::LightGrid::LightGrid() :
+	origin( 0.f ),
+	size( 0 )
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Build grid from light volumes
+// ------------------------------------------------------------------------------------ //
+bool le::LightGrid::Build( const std::vector< BSPLightVolume >& Volumes, const Vector3D_t& Min, const Vector3D_t& Max )
+{
+	Clear();
+
+	// Grid is laid in Quake 3 axes, so bounds are converted back
+	Vector3D_t		cellSize( LIGHTGRID_CELL_SIZE_X, LIGHTGRID_CELL_SIZE_Y, LIGHTGRID_CELL_SIZE_Z );
+	Vector3D_t		worldMin( Min.x, -glm::max( Min.z, Max.z ), Min.y );
+	Vector3D_t		worldMax( Max.x, -glm::min( Min.z, Max.z ), Max.y );
+	Vector3D_t		firstCell = glm::ceil( worldMin / cellSize );
+
+	origin = cellSize * firstCell;
+	size = Vector3DInt_t( glm::floor( worldMax / cellSize ) - firstCell ) + 1;
+
+	UInt32_t		countCells = size.x * size.y * size.z;
+	if ( glm::any( glm::lessThanEqual( size, Vector3DInt_t( 0 ) ) ) || countCells != Volumes.size() )
+	{
+		size = Vector3DInt_t( 0 );
+		return false;
+	}
+
+	ambientColors.resize( countCells );
+	directedColors.resize( countCells );
+	directions.resize( countCells );
+
+	for ( UInt32_t index = 0; index < countCells; ++index )
+	{
+		const BSPLightVolume&		volume = Volumes[ index ];
+
+		ambientColors[ index ] = Vector3D_t( volume.ambient[ 0 ], volume.ambient[ 1 ], volume.ambient[ 2 ] ) / 255.f;
+		directedColors[ index ] = Vector3D_t( volume.directional[ 0 ], volume.directional[ 1 ], volume.directional[ 2 ] ) / 255.f;
+
+		// Direction is packed as two angles, each byte is 1/256 of turn
+		float		latitude = volume.direction[ 1 ] * ( glm::two_pi< float >() / 256.f );
+		float		longitude = volume.direction[ 0 ] * ( glm::two_pi< float >() / 256.f );
+		Vector3D_t	direction( cosf( latitude ) * sinf( longitude ), sinf( latitude ) * sinf( longitude ), cosf( longitude ) );
+
+		directions[ index ] = Vector3D_t( direction.x, direction.z, -direction.y );
+	}
+
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Clear grid
+// ------------------------------------------------------------------------------------ //
+void le::LightGrid::Clear()
+{
+	origin = Vector3D_t( 0.f );
+	size = Vector3DInt_t( 0 );
+	ambientColors.clear();
+	directedColors.clear();
+	directions.clear();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Sample lighting at point
+// ------------------------------------------------------------------------------------ //
+bool le::LightGrid::Sample( const Vector3D_t& Position, LightSample& LightSample ) const
+{
+	LightSample.ambientColor = Vector3D_t( 0.f );
+	LightSample.directedColor = Vector3D_t( 0.f );
+	LightSample.direction = Vector3D_t( 0.f, 1.f, 0.f );
+
+	if ( ambientColors.empty() )		return false;
+
+	Vector3D_t		cellSize( LIGHTGRID_CELL_SIZE_X, LIGHTGRID_CELL_SIZE_Y, LIGHTGRID_CELL_SIZE_Z );
+	Vector3D_t		gridPosition = ( Vector3D_t( Position.x, -Position.z, Position.y ) - origin ) / cellSize;
+	Vector3D_t		cell = glm::floor( gridPosition );
+	Vector3D_t		fraction = gridPosition - cell;
+	Vector3DInt_t	base = glm::clamp( Vector3DInt_t( cell ), Vector3DInt_t( 0 ), size - 1 );
+	Vector3D_t		direction( 0.f );
+	float			totalFactor = 0.f;
+
+	// Trilinear filter over eight cells, cells inside walls are black and are skipped
+	for ( UInt32_t corner = 0; corner < 8; ++corner )
+	{
+		Vector3DInt_t		offset( corner & 1, ( corner >> 1 ) & 1, ( corner >> 2 ) & 1 );
+		Vector3DInt_t		position = glm::min( base + offset, size - 1 );
+		UInt32_t			index = position.x + position.y * size.x + position.z * size.x * size.y;
+
+		if ( ambientColors[ index ] == Vector3D_t( 0.f ) && directedColors[ index ] == Vector3D_t( 0.f ) )
+			continue;
+
+		float				factor = ( offset.x ? fraction.x : 1.f - fraction.x ) * ( offset.y ? fraction.y : 1.f - fraction.y ) * ( offset.z ? fraction.z : 1.f - fraction.z );
+		totalFactor += factor;
+
+		LightSample.ambientColor += ambientColors[ index ] * factor;
+		LightSample.directedColor += directedColors[ index ] * factor;
+		direction += directions[ index ] * factor;
+	}
+
+	if ( totalFactor > 0.f && totalFactor < 0.99f )
+	{
+		LightSample.ambientColor /= totalFactor;
+		LightSample.directedColor /= totalFactor;
+	}
+
+	if ( glm::dot( direction, direction ) > 0.f )
+		LightSample.direction = glm::normalize( direction );
+
+	return true;
+}
@@ -0,0 +1,66 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef LIGHTGRID_H
+#define LIGHTGRID_H
+
+#include <vector>
+
+#include "common/types.h"
+#include "common/lightsample.h"
+#include "bsp.h"
+
+//---------------------------------------------------------------------//
+
+// Size of grid cell in Quake 3 axes
+#define LIGHTGRID_CELL_SIZE_X		64.f
+#define LIGHTGRID_CELL_SIZE_Y		64.f
+#define LIGHTGRID_CELL_SIZE_Z		128.f
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Light volumes of Quake 3 map, sampled trilinearly to light dynamic models
+	class LightGrid
+	{
+	public:
+		LightGrid();
+
+		// Min and Max are bounds of world model in engine axes
+		bool					Build( const std::vector< BSPLightVolume >& Volumes, const Vector3D_t& Min, const Vector3D_t& Max );
+		void					Clear();
+
+		// Sample lighting at point in engine axes, returns false if grid is empty
+		bool					Sample( const Vector3D_t& Position, LightSample& LightSample ) const;
+
+		inline bool				IsBuilded() const
+		{
+			return !ambientColors.empty();
+		}
+
+	private:
+		Vector3D_t					origin;
+		Vector3DInt_t				size;
+
+		// Cells in structure of arrays, colors in range [ 0, 1 ], direction in engine axes
+		std::vector< Vector3D_t >	ambientColors;
+		std::vector< Vector3D_t >	directedColors;
+		std::vector< Vector3D_t >	directions;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !LIGHTGRID_H
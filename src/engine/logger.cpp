@@ -0,0 +1,274 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+
+#include "engine/lifeengine.h"
+#include "logger.h"
+
+// Each logger gets own ID, so thread never writes into ring of destroyed or other logger
+static std::atomic< le::UInt32_t >		g_nextLoggerID( 1 );
+
+// ------------------------------------------------------------------------------------ //
+// Constructor of ring of thread
+// ------------------------------------------------------------------------------------ //
+le::Logger::ThreadRing::ThreadRing() :
+	loggerID( 0 )
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor of ring of thread, called when thread exits
+// ------------------------------------------------------------------------------------ //
+le::Logger::ThreadRing::~ThreadRing()
+{
+	Retire();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Give ring to logger, it is removed after rest of messages is written
+// ------------------------------------------------------------------------------------ //
+void le::Logger::ThreadRing::Retire()
+{
+	if ( !ring )		return;
+
+	ring->isRetired.store( true, std::memory_order_release );
+	ring.reset();
+	loggerID = 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::Logger::Logger() :
+	id( g_nextLoggerID.fetch_add( 1 ) ),
+	fileLog( nullptr ),
+	isOpened( false ),
+	minLevel( LL_INFO ),
+	rateLimit( 0 ),
+	countDropped( 0 ),
+	countSuppressed( 0 ),
+	isStopping( false )
+{
+	for ( UInt32_t index = 0; index < LOGGER_COUNT_CALLSITES; ++index )
+	{
+		callSites[ index ].format = nullptr;
+		callSites[ index ].second = 0;
+		callSites[ index ].count = 0;
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor
+// ------------------------------------------------------------------------------------ //
+le::Logger::~Logger()
+{
+	Close();
+	rings.clear();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Open file of log and start writer thread
+// ------------------------------------------------------------------------------------ //
+bool le::Logger::Open( const char* Path )
+{
+	if ( isOpened )		Close();
+
+	fileLog = fopen( Path, "w" );
+	if ( !fileLog )		return false;
+
+	isStopping = false;
+	isOpened = true;
+	writer = std::thread( &Logger::WriterThread, this );
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Stop writer thread, write rest of messages and close file
+// ------------------------------------------------------------------------------------ //
+void le::Logger::Close()
+{
+	if ( !isOpened )		return;
+	isOpened = false;
+
+	{
+		std::unique_lock< std::mutex >		lock( mutex );
+		isStopping = true;
+	}
+
+	conditionWrite.notify_one();
+	if ( writer.joinable() )	writer.join();
+
+	Drain();
+
+	std::unique_lock< std::mutex >		lock( mutexWrite );
+	fclose( fileLog );
+	fileLog = nullptr;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Print message
+// ------------------------------------------------------------------------------------ //
+void le::Logger::Print( LOG_LEVEL Level, const char* Format, va_list Arguments )
+{
+	if ( !isOpened || Level < minLevel )		return;
+	if ( IsRateLimited( Format ) )
+	{
+		++countSuppressed;
+		return;
+	}
+
+	// Ring is full - message is dropped, caller must not wait for disk
+	Ring*			ring = GetThreadRing();
+	UInt32_t		head = ring->head.load( std::memory_order_relaxed );
+	UInt32_t		tail = ring->tail.load( std::memory_order_acquire );
+	if ( head - tail >= LOGGER_COUNT_MESSAGES )
+	{
+		++countDropped;
+		return;
+	}
+
+	// Arguments can point to temporary strings of caller, so message is formatted here,
+	// but directly into ring without heap allocations
+	Message&		message = ring->messages[ head % LOGGER_COUNT_MESSAGES ];
+	int				length = vsnprintf( message.text, LOGGER_MESSAGE_SIZE, Format, Arguments );
+
+	message.level = Level;
+	message.length = length < 0 ? 0 : ( length < LOGGER_MESSAGE_SIZE ? length : LOGGER_MESSAGE_SIZE - 1 );
+	ring->head.store( head + 1, std::memory_order_release );
+
+	// Error is written and flushed before return, it can be last message before crash.
+	// Other messages wait for interval or half of ring
+	if ( Level == LL_ERROR )
+		Drain();
+	else if ( head - tail + 1 >= LOGGER_COUNT_MESSAGES / 2 )
+		conditionWrite.notify_one();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get ring of current thread, it is created on first message of thread to this logger
+// ------------------------------------------------------------------------------------ //
+le::Logger::Ring* le::Logger::GetThreadRing()
+{
+	static thread_local ThreadRing		threadRing;
+	if ( threadRing.ring && threadRing.loggerID == id )		return threadRing.ring.get();
+
+	threadRing.Retire();
+	threadRing.ring = std::make_shared< Ring >();
+	threadRing.loggerID = id;
+
+	std::unique_lock< std::mutex >		lock( mutex );
+	rings.push_back( threadRing.ring );
+	return threadRing.ring.get();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Is message of call site over limit in current second. Call site is identified by format
+// string, table has no locks, so collisions and races only make limit approximate
+// ------------------------------------------------------------------------------------ //
+bool le::Logger::IsRateLimited( const char* Format )
+{
+	UInt32_t		limit = rateLimit.load( std::memory_order_relaxed );
+	if ( limit == 0 )		return false;
+
+	UInt32_t		second = ( UInt32_t ) std::chrono::duration_cast< std::chrono::seconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+	CallSite&		callSite = callSites[ ( ( size_t ) Format >> 4 ) % LOGGER_COUNT_CALLSITES ];
+
+	if ( callSite.format.load( std::memory_order_relaxed ) != Format || callSite.second.load( std::memory_order_relaxed ) != second )
+	{
+		callSite.format.store( Format, std::memory_order_relaxed );
+		callSite.second.store( second, std::memory_order_relaxed );
+		callSite.count.store( 0, std::memory_order_relaxed );
+	}
+
+	return callSite.count.fetch_add( 1, std::memory_order_relaxed ) >= limit;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Write messages of all rings to file and flush it once. Called by writer thread,
+// by thread of error and on close, so whole drain is under lock of writing
+// ------------------------------------------------------------------------------------ //
+void le::Logger::Drain()
+{
+	std::unique_lock< std::mutex >		lockWrite( mutexWrite );
+	if ( !fileLog )		return;
+
+	{
+		std::unique_lock< std::mutex >		lock( mutex );
+		drainRings.assign( rings.begin(), rings.end() );
+	}
+
+	bool			isWritten = false;
+	bool			isRetiredRings = false;
+	for ( UInt32_t index = 0, count = drainRings.size(); index < count; ++index )
+	{
+		Ring*			ring = drainRings[ index ].get();
+
+		// Retired flag is read before head, so all messages of exited thread are seen
+		bool			isRetired = ring->isRetired.load( std::memory_order_acquire );
+		UInt32_t		tail = ring->tail.load( std::memory_order_relaxed );
+		UInt32_t		head = ring->head.load( std::memory_order_acquire );
+
+		for ( ; tail != head; ++tail )
+		{
+			const Message&		message = ring->messages[ tail % LOGGER_COUNT_MESSAGES ];
+			switch ( message.level )
+			{
+			case LL_WARNING:	fputs( "[Warning] ", fileLog ); break;
+			case LL_ERROR:		fputs( "[Error] ", fileLog ); break;
+			default:			fputs( "[Info] ", fileLog ); break;
+			}
+
+			fwrite( message.text, 1, message.length, fileLog );
+			fputc( '\n', fileLog );
+			isWritten = true;
+		}
+
+		ring->tail.store( tail, std::memory_order_release );
+		isRetiredRings |= isRetired;
+	}
+
+	// Rings of exited threads are written out, remove them
+	if ( isRetiredRings )
+	{
+		std::unique_lock< std::mutex >		lock( mutex );
+		for ( UInt32_t index = 0; index < rings.size(); )
+			if ( rings[ index ]->isRetired.load( std::memory_order_acquire ) && rings[ index ]->tail.load( std::memory_order_relaxed ) == rings[ index ]->head.load( std::memory_order_acquire ) )
+				rings.erase( rings.begin() + index );
+			else
+				++index;
+	}
+
+	drainRings.clear();
+
+	UInt32_t		dropped = countDropped.exchange( 0 );
+	UInt32_t		suppressed = countSuppressed.exchange( 0 );
+	if ( dropped > 0 )			fprintf( fileLog, "[Warning] Log: %u messages dropped, ring of thread is full\n", dropped );
+	if ( suppressed > 0 )		fprintf( fileLog, "[Warning] Log: %u messages suppressed by rate limit\n", suppressed );
+
+	if ( isWritten || dropped > 0 || suppressed > 0 )
+		fflush( fileLog );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Writer thread
+// ------------------------------------------------------------------------------------ //
+void le::Logger::WriterThread()
+{
+	while ( true )
+	{
+		{
+			std::unique_lock< std::mutex >		lock( mutex );
+			conditionWrite.wait_for( lock, std::chrono::milliseconds( LOGGER_FLUSH_INTERVAL ) );
+			if ( isStopping )		return;
+		}
+
+		Drain();
+	}
+}
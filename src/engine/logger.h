@@ -0,0 +1,160 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+#define LOGGER_MESSAGE_SIZE				512
+#define LOGGER_COUNT_MESSAGES			256			// Size of ring of one thread
+#define LOGGER_COUNT_CALLSITES			256
+#define LOGGER_FLUSH_INTERVAL			10			// In milliseconds
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	enum LOG_LEVEL
+	{
+		LL_INFO,
+		LL_WARNING,
+		LL_ERROR
+	};
+
+	//---------------------------------------------------------------------//
+
+	// Asynchronous log. Each thread formats messages into own lock-free ring,
+	// writer thread drains rings to file and flushes it once per batch. Errors are
+	// written and flushed by calling thread, so last error before crash is not lost
+	class Logger
+	{
+	public:
+		Logger();
+		~Logger();
+
+		bool					Open( const char* Path );
+		void					Close();
+
+		// Can be called from any thread, blocks on file only for errors
+		void					Print( LOG_LEVEL Level, const char* Format, va_list Arguments );
+
+		inline void				SetMinLevel( LOG_LEVEL Level )
+		{
+			minLevel = Level;
+		}
+
+		// Max count of messages per second from one call site, 0 - without limit
+		inline void				SetRateLimit( UInt32_t MessagesPerSecond )
+		{
+			rateLimit = MessagesPerSecond;
+		}
+
+		inline bool				IsOpened() const
+		{
+			return isOpened;
+		}
+
+	private:
+
+		//---------------------------------------------------------------------//
+
+		struct Message
+		{
+			LOG_LEVEL		level;
+			UInt32_t		length;
+			char			text[ LOGGER_MESSAGE_SIZE ];
+		};
+
+		//---------------------------------------------------------------------//
+
+		// Single producer (owner thread), single consumer (writer thread)
+		struct Ring
+		{
+			Ring() :
+				head( 0 ),
+				tail( 0 ),
+				isRetired( false )
+			{}
+
+			std::atomic< UInt32_t >		head;
+			std::atomic< UInt32_t >		tail;
+			std::atomic< bool >			isRetired;		// Owner thread exited, ring is removed after drain
+			Message						messages[ LOGGER_COUNT_MESSAGES ];
+		};
+
+		//---------------------------------------------------------------------//
+
+		// Ring of thread is shared with logger: thread keeps it alive while writes to it,
+		// logger - until rest of messages is written
+		struct ThreadRing
+		{
+			ThreadRing();
+			~ThreadRing();
+
+			void						Retire();
+
+			UInt32_t					loggerID;
+			std::shared_ptr< Ring >		ring;
+		};
+
+		//---------------------------------------------------------------------//
+
+		struct CallSite
+		{
+			std::atomic< const char* >		format;
+			std::atomic< UInt32_t >			second;
+			std::atomic< UInt32_t >			count;
+		};
+
+		//---------------------------------------------------------------------//
+
+		Ring*					GetThreadRing();
+		bool					IsRateLimited( const char* Format );
+		void					Drain();
+		void					WriterThread();
+
+		UInt32_t								id;
+		FILE*									fileLog;
+		std::atomic< bool >						isOpened;
+		std::atomic< LOG_LEVEL >				minLevel;
+		std::atomic< UInt32_t >					rateLimit;
+		std::atomic< UInt32_t >					countDropped;
+		std::atomic< UInt32_t >					countSuppressed;
+		CallSite								callSites[ LOGGER_COUNT_CALLSITES ];
+
+		bool									isStopping;
+		std::vector< std::shared_ptr< Ring > >	rings;
+		std::vector< std::shared_ptr< Ring > >	drainRings;
+		std::mutex								mutex;
+		std::mutex								mutexWrite;
+		std::condition_variable					conditionWrite;
+		std::thread								writer;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !LOGGER_H
@@ -0,0 +1,349 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "common/meshsurface.h"
+#include "engine/iconsolesystem.h"
+
+#include "global.h"
+#include "consolesystem.h"
+#include "meshoptimizer.h"
+
+#define FORSYTH_CACHE_SIZE				32
+#define FORSYTH_CACHE_DECAY_POWER		1.5f
+#define FORSYTH_LAST_TRIANGLE_SCORE		0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE		2.f
+#define FORSYTH_VALENCE_BOOST_POWER		0.5f
+#define ANALYZE_CACHE_SIZE				16
+
+// ------------------------------------------------------------------------------------ //
+// Score of vertex by position in cache and count of not added triangles
+// ------------------------------------------------------------------------------------ //
+inline float Forsyth_VertexScore( le::Int32_t CachePosition, le::UInt32_t CountTrianglesLeft )
+{
+	if ( CountTrianglesLeft == 0 )		return -1.f;
+
+	float			score = 0.f;
+	if ( CachePosition >= 0 )
+	{
+		// Verteces of last triangle get fixed score, so triangle strips are not preferred too much
+		if ( CachePosition < 3 )
+			score = FORSYTH_LAST_TRIANGLE_SCORE;
+		else
+			score = powf( 1.f - ( CachePosition - 3 ) / ( float ) ( FORSYTH_CACHE_SIZE - 3 ), FORSYTH_CACHE_DECAY_POWER );
+	}
+
+	// Boost verteces with few triangles left, so lone triangles are not left at end
+	return score + FORSYTH_VALENCE_BOOST_SCALE * powf( ( float ) CountTrianglesLeft, -FORSYTH_VALENCE_BOOST_POWER );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Optimize mesh
+// ------------------------------------------------------------------------------------ //
+void le::MeshOptimizer::Optimize( const char* Name, void* Verteces, UInt32_t Stride, UInt32_t CountVerteces, UInt32_t* Indeces, UInt32_t CountIndeces, MeshSurface* Surfaces, UInt32_t CountSurfaces )
+{
+	if ( !Verteces || !Indeces || !Surfaces || Stride == 0 )		return;
+
+	// Surface can be optimized only if nobody else uses its indeces,
+	// verteces can be reordered only if nobody else uses its vertex range
+	std::vector< Int32_t >		indexOwners( CountIndeces, -1 );
+	std::vector< Int32_t >		vertexOwners( CountVerteces, -1 );
+	std::vector< UInt32_t >		minIndeces( CountSurfaces, 0 );
+	std::vector< UInt32_t >		maxIndeces( CountSurfaces, 0 );
+	std::vector< bool >			isValidSurfaces( CountSurfaces, false );
+
+	for ( UInt32_t indexSurface = 0; indexSurface < CountSurfaces; ++indexSurface )
+	{
+		MeshSurface&		surface = Surfaces[ indexSurface ];
+		if ( surface.countIndeces < 3 || surface.startIndex + surface.countIndeces > CountIndeces )		continue;
+
+		UInt32_t			minIndex = UINT32_MAX;
+		UInt32_t			maxIndex = 0;
+		bool				isValid = true;
+
+		for ( UInt32_t index = surface.startIndex, count = surface.startIndex + surface.countIndeces; index < count; ++index )
+		{
+			minIndex = glm::min( minIndex, Indeces[ index ] );
+			maxIndex = glm::max( maxIndex, Indeces[ index ] );
+
+			if ( indexOwners[ index ] == -1 )					indexOwners[ index ] = indexSurface;
+			else if ( indexOwners[ index ] != indexSurface )	indexOwners[ index ] = -2;
+		}
+
+		if ( surface.startVertexIndex + maxIndex >= CountVerteces )		continue;
+
+		for ( UInt32_t vertex = surface.startVertexIndex + minIndex, count = surface.startVertexIndex + maxIndex; vertex <= count; ++vertex )
+			if ( vertexOwners[ vertex ] == -1 )						vertexOwners[ vertex ] = indexSurface;
+			else if ( vertexOwners[ vertex ] != indexSurface )		vertexOwners[ vertex ] = -2;
+
+		minIndeces[ indexSurface ] = minIndex;
+		maxIndeces[ indexSurface ] = maxIndex;
+		isValidSurfaces[ indexSurface ] = true;
+	}
+
+	UInt32_t		countTriangles = 0;
+	UInt32_t		countTransformedBefore = 0;
+	UInt32_t		countTransformedAfter = 0;
+	UInt32_t		countUniqueVerteces = 0;
+	UInt32_t		countShortSurfaces = 0;
+	UInt32_t		countOptimizedSurfaces = 0;
+
+	for ( UInt32_t indexSurface = 0; indexSurface < CountSurfaces; ++indexSurface )
+	{
+		if ( !isValidSurfaces[ indexSurface ] )		continue;
+
+		MeshSurface&		surface = Surfaces[ indexSurface ];
+		UInt32_t*			indeces = &Indeces[ surface.startIndex ];
+		bool				isExclusiveIndeces = true;
+		bool				isExclusiveVerteces = true;
+
+		for ( UInt32_t index = surface.startIndex, count = surface.startIndex + surface.countIndeces; index < count && isExclusiveIndeces; ++index )
+			isExclusiveIndeces = indexOwners[ index ] == indexSurface;
+
+		if ( !isExclusiveIndeces )		continue;
+
+		for ( UInt32_t vertex = surface.startVertexIndex + minIndeces[ indexSurface ], count = surface.startVertexIndex + maxIndeces[ indexSurface ]; vertex <= count && isExclusiveVerteces; ++vertex )
+			isExclusiveVerteces = vertexOwners[ vertex ] == indexSurface;
+
+		// Rebase indeces to first used vertex, then all work is done in local range of surface
+		UInt32_t			minIndex = minIndeces[ indexSurface ];
+		UInt32_t			countRangeVerteces = maxIndeces[ indexSurface ] - minIndex + 1;
+
+		for ( UInt32_t index = 0; index < surface.countIndeces; ++index )
+			indeces[ index ] -= minIndex;
+
+		surface.startVertexIndex += minIndex;
+		countTransformedBefore += AnalyzeVertexCache( indeces, surface.countIndeces, countRangeVerteces );
+		countUniqueVerteces += CountUsedVerteces( indeces, surface.countIndeces, countRangeVerteces );
+
+		OptimizeVertexCache( indeces, surface.countIndeces, countRangeVerteces );
+		if ( isExclusiveVerteces )
+			OptimizeVertexFetch( ( Byte_t* ) Verteces + surface.startVertexIndex * Stride, Stride, countRangeVerteces, indeces, surface.countIndeces );
+
+		countTransformedAfter += AnalyzeVertexCache( indeces, surface.countIndeces, countRangeVerteces );
+		countTriangles += surface.countIndeces / 3;
+		++countOptimizedSurfaces;
+
+		if ( countRangeVerteces <= UINT16_MAX + 1 )
+			++countShortSurfaces;
+	}
+
+	if ( countTriangles == 0 )		return;
+
+	g_consoleSystem->PrintInfo( "Mesh optimization of [%s]: %i/%i surfaces, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, 16-bit index surfaces %i",
+								Name, countOptimizedSurfaces, CountSurfaces,
+								countTransformedBefore / ( float ) countTriangles, countTransformedAfter / ( float ) countTriangles,
+								countTransformedBefore / ( float ) countUniqueVerteces, countTransformedAfter / ( float ) countUniqueVerteces,
+								countShortSurfaces );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Optimize triangle order for post transform cache
+// ------------------------------------------------------------------------------------ //
+void le::MeshOptimizer::OptimizeVertexCache( UInt32_t* Indeces, UInt32_t CountIndeces, UInt32_t CountVerteces )
+{
+	UInt32_t					countTriangles = CountIndeces / 3;
+	if ( countTriangles < 2 )	return;
+
+	// Build lists of triangles for every vertex
+	std::vector< UInt32_t >		countTrianglesLeft( CountVerteces, 0 );
+	std::vector< UInt32_t >		triangleOffsets( CountVerteces + 1, 0 );
+	std::vector< UInt32_t >		adjacency( countTriangles * 3 );
+
+	for ( UInt32_t index = 0, count = countTriangles * 3; index < count; ++index )
+		++countTrianglesLeft[ Indeces[ index ] ];
+
+	for ( UInt32_t vertex = 0; vertex < CountVerteces; ++vertex )
+		triangleOffsets[ vertex + 1 ] = triangleOffsets[ vertex ] + countTrianglesLeft[ vertex ];
+
+	std::vector< UInt32_t >		adjacencyCursors( triangleOffsets.begin(), triangleOffsets.end() - 1 );
+	for ( UInt32_t index = 0, count = countTriangles * 3; index < count; ++index )
+		adjacency[ adjacencyCursors[ Indeces[ index ] ]++ ] = index / 3;
+
+	// Initial scores
+	std::vector< Int32_t >		cachePositions( CountVerteces, -1 );
+	std::vector< float >		vertexScores( CountVerteces );
+	std::vector< float >		triangleScores( countTriangles );
+	std::vector< bool >			isTriangleAdded( countTriangles, false );
+
+	for ( UInt32_t vertex = 0; vertex < CountVerteces; ++vertex )
+		vertexScores[ vertex ] = Forsyth_VertexScore( -1, countTrianglesLeft[ vertex ] );
+
+	Int32_t						bestTriangle = -1;
+	float						bestScore = -1.f;
+
+	for ( UInt32_t triangle = 0; triangle < countTriangles; ++triangle )
+	{
+		const UInt32_t*			verteces = &Indeces[ triangle * 3 ];
+		triangleScores[ triangle ] = vertexScores[ verteces[ 0 ] ] + vertexScores[ verteces[ 1 ] ] + vertexScores[ verteces[ 2 ] ];
+
+		if ( triangleScores[ triangle ] > bestScore )
+		{
+			bestScore = triangleScores[ triangle ];
+			bestTriangle = triangle;
+		}
+	}
+
+	// Add triangles one by one, choosing best one among triangles of verteces in cache
+	std::vector< UInt32_t >		result;
+	UInt32_t					cache[ FORSYTH_CACHE_SIZE + 3 ];
+	UInt32_t					newCache[ FORSYTH_CACHE_SIZE + 3 ];
+	UInt32_t					countCache = 0;
+	UInt32_t					cursor = 0;
+
+	result.reserve( countTriangles * 3 );
+	while ( result.size() < countTriangles * 3 )
+	{
+		if ( bestTriangle < 0 )
+		{
+			while ( cursor < countTriangles && isTriangleAdded[ cursor ] )		++cursor;
+			if ( cursor == countTriangles )		break;
+			bestTriangle = cursor;
+		}
+
+		const UInt32_t*			triangleVerteces = &Indeces[ bestTriangle * 3 ];
+		UInt32_t				countNewCache = 0;
+		isTriangleAdded[ bestTriangle ] = true;
+
+		for ( UInt32_t index = 0; index < 3; ++index )
+		{
+			UInt32_t			vertex = triangleVerteces[ index ];
+			result.push_back( vertex );
+
+			// Remove triangle from list of vertex
+			UInt32_t*			triangles = &adjacency[ triangleOffsets[ vertex ] ];
+			UInt32_t&			countTriangles = countTrianglesLeft[ vertex ];
+			for ( UInt32_t triangle = 0; triangle < countTriangles; ++triangle )
+				if ( triangles[ triangle ] == ( UInt32_t ) bestTriangle )
+				{
+					triangles[ triangle ] = triangles[ countTriangles - 1 ];
+					--countTriangles;
+					break;
+				}
+
+			bool				isInCache = false;
+			for ( UInt32_t indexCache = 0; indexCache < countNewCache && !isInCache; ++indexCache )
+				isInCache = newCache[ indexCache ] == vertex;
+
+			if ( !isInCache )		newCache[ countNewCache++ ] = vertex;
+		}
+
+		// Verteces of added triangle go to front of LRU cache
+		for ( UInt32_t indexCache = 0; indexCache < countCache; ++indexCache )
+		{
+			UInt32_t			vertex = cache[ indexCache ];
+			if ( vertex != triangleVerteces[ 0 ] && vertex != triangleVerteces[ 1 ] && vertex != triangleVerteces[ 2 ] )
+				newCache[ countNewCache++ ] = vertex;
+		}
+
+		for ( UInt32_t indexCache = 0; indexCache < countNewCache; ++indexCache )
+		{
+			UInt32_t			vertex = newCache[ indexCache ];
+			cachePositions[ vertex ] = indexCache < FORSYTH_CACHE_SIZE ? indexCache : -1;
+			vertexScores[ vertex ] = Forsyth_VertexScore( cachePositions[ vertex ], countTrianglesLeft[ vertex ] );
+		}
+
+		countCache = glm::min( countNewCache, ( UInt32_t ) FORSYTH_CACHE_SIZE );
+		memcpy( cache, newCache, countCache * sizeof( UInt32_t ) );
+
+		// Update scores of triangles touched by cache changes and find next best
+		bestTriangle = -1;
+		bestScore = -1.f;
+
+		for ( UInt32_t indexCache = 0; indexCache < countNewCache; ++indexCache )
+		{
+			UInt32_t			vertex = newCache[ indexCache ];
+			const UInt32_t*		triangles = &adjacency[ triangleOffsets[ vertex ] ];
+
+			for ( UInt32_t triangle = 0, count = countTrianglesLeft[ vertex ]; triangle < count; ++triangle )
+			{
+				const UInt32_t*		verteces = &Indeces[ triangles[ triangle ] * 3 ];
+				float				score = vertexScores[ verteces[ 0 ] ] + vertexScores[ verteces[ 1 ] ] + vertexScores[ verteces[ 2 ] ];
+
+				triangleScores[ triangles[ triangle ] ] = score;
+				if ( score > bestScore )
+				{
+					bestScore = score;
+					bestTriangle = triangles[ triangle ];
+				}
+			}
+		}
+	}
+
+	memcpy( Indeces, result.data(), result.size() * sizeof( UInt32_t ) );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Optimize vertex order for vertex fetch
+// ------------------------------------------------------------------------------------ //
+void le::MeshOptimizer::OptimizeVertexFetch( void* Verteces, UInt32_t Stride, UInt32_t CountVerteces, UInt32_t* Indeces, UInt32_t CountIndeces )
+{
+	std::vector< UInt32_t >		remap( CountVerteces, UINT32_MAX );
+	UInt32_t					nextVertex = 0;
+
+	for ( UInt32_t index = 0; index < CountIndeces; ++index )
+	{
+		UInt32_t&		vertex = remap[ Indeces[ index ] ];
+		if ( vertex == UINT32_MAX )		vertex = nextVertex++;
+
+		Indeces[ index ] = vertex;
+	}
+
+	for ( UInt32_t vertex = 0; vertex < CountVerteces; ++vertex )
+		if ( remap[ vertex ] == UINT32_MAX )
+			remap[ vertex ] = nextVertex++;
+
+	std::vector< Byte_t >		oldVerteces( ( Byte_t* ) Verteces, ( Byte_t* ) Verteces + CountVerteces * Stride );
+	for ( UInt32_t vertex = 0; vertex < CountVerteces; ++vertex )
+		memcpy( ( Byte_t* ) Verteces + remap[ vertex ] * Stride, &oldVerteces[ vertex * Stride ], Stride );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Analyze post transform cache
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::MeshOptimizer::AnalyzeVertexCache( const UInt32_t* Indeces, UInt32_t CountIndeces, UInt32_t CountVerteces )
+{
+	std::vector< UInt32_t >		cacheTimestamps( CountVerteces, 0 );
+	UInt32_t					timestamp = ANALYZE_CACHE_SIZE + 1;
+	UInt32_t					countTransformed = 0;
+
+	for ( UInt32_t index = 0; index < CountIndeces; ++index )
+	{
+		UInt32_t		vertex = Indeces[ index ];
+		if ( timestamp - cacheTimestamps[ vertex ] > ANALYZE_CACHE_SIZE )
+		{
+			cacheTimestamps[ vertex ] = timestamp++;
+			++countTransformed;
+		}
+	}
+
+	return countTransformed;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Count verteces referenced by indeces
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::MeshOptimizer::CountUsedVerteces( const UInt32_t* Indeces, UInt32_t CountIndeces, UInt32_t CountVerteces )
+{
+	std::vector< bool >			isUsedVerteces( CountVerteces, false );
+	UInt32_t					countUsed = 0;
+
+	for ( UInt32_t index = 0; index < CountIndeces; ++index )
+		if ( !isUsedVerteces[ Indeces[ index ] ] )
+		{
+			isUsedVerteces[ Indeces[ index ] ] = true;
+			++countUsed;
+		}
+
+	return countUsed;
+}
@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	struct MeshSurface;
+
+	//---------------------------------------------------------------------//
+
+	class MeshOptimizer
+	{
+	public:
+		// Optimize triangle lists of surfaces for post transform cache and vertex fetch,
+		// rebase indeces of surfaces to smallest range and print ACMR/ATVR report
+		static void				Optimize( const char* Name, void* Verteces, UInt32_t Stride, UInt32_t CountVerteces, UInt32_t* Indeces, UInt32_t CountIndeces, MeshSurface* Surfaces, UInt32_t CountSurfaces );
+
+		// Reorder triangles for post transform cache (Tom Forsyth's linear-speed algorithm)
+		static void				OptimizeVertexCache( UInt32_t* Indeces, UInt32_t CountIndeces, UInt32_t CountVerteces );
+
+		// Reorder verteces in order of first use and remap indeces, unused verteces are moved to end
+		static void				OptimizeVertexFetch( void* Verteces, UInt32_t Stride, UInt32_t CountVerteces, UInt32_t* Indeces, UInt32_t CountIndeces );
+
+		// Simulate FIFO post transform cache, returns count of transformed verteces
+		static UInt32_t			AnalyzeVertexCache( const UInt32_t* Indeces, UInt32_t CountIndeces, UInt32_t CountVerteces );
+
+		// Count of verteces referenced by indeces, range of indeces may have unused verteces
+		static UInt32_t			CountUsedVerteces( const UInt32_t* Indeces, UInt32_t CountIndeces, UInt32_t CountVerteces );
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !MESHOPTIMIZER_H
@@ -63,6 +63,14 @@ void le::Model::SetCountFace( UInt32_t CountFace )
 	countFace = CountFace;
 }
 
+// ------------------------------------------------------------------------------------ //
+// Задать является ли модель окклюдером (ее ограничивающий объем закрывает все позади)
+// ------------------------------------------------------------------------------------ //
+void le::Model::SetOccluder( bool IsOccluder )
+{
+	isOccluder = IsOccluder;
+}
+
 // ------------------------------------------------------------------------------------ //
 // Получить меш
 // ------------------------------------------------------------------------------------ //
@@ -109,6 +117,14 @@ le::UInt32_t le::Model::GetCountFace() const
 	return countFace;
 }
 
+// ------------------------------------------------------------------------------------ //
+// Является ли модель окклюдером
+// ------------------------------------------------------------------------------------ //
+bool le::Model::IsOccluder() const
+{
+	return isOccluder;
+}
+
 // ------------------------------------------------------------------------------------ //
 // Сместить
 // ------------------------------------------------------------------------------------ //
@@ -248,6 +264,7 @@ const le::Matrix4x4_t& le::Model::GetTransformation()
 le::Model::Model() :
 	isNeedUpdateTransformation( true ),
 	isNeedUpdateBoundingBox( true ),
+	isOccluder( false ),
 	mesh( nullptr ), 
 	position( 0.f ),
 	rotation( 1.f, 0.f, 0.f, 0.f ),
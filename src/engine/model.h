@@ -28,12 +28,14 @@ namespace le
 		virtual void					SetMax( const Vector3D_t& MaxPosition );
 		virtual void					SetStartFace( UInt32_t StartFace );
 		virtual void					SetCountFace( UInt32_t CountFace );
+		virtual void					SetOccluder( bool IsOccluder );
 
 		virtual IMesh*					GetMesh() const;
 		virtual const Vector3D_t&		GetMin();
 		virtual const Vector3D_t&		GetMax();
 		virtual UInt32_t				GetStartFace() const;
 		virtual UInt32_t				GetCountFace() const;
+		virtual bool					IsOccluder() const;
 
 		// ITransformable
 		virtual void					Move( const Vector3D_t& FactorMove );
@@ -61,6 +63,7 @@ namespace le
 
 		bool				isNeedUpdateTransformation;
 		bool				isNeedUpdateBoundingBox;
+		bool				isOccluder;
 
 		IMesh*				mesh;
 		Vector3D_t			localMin;
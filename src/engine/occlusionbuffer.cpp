@@ -0,0 +1,383 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <fstream>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#	include <emmintrin.h>
+#	define OCCLUSIONBUFFER_SSE2
+#endif // _M_X64 || _M_IX86 || __SSE2__
+
+#include "occlusionbuffer.h"
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::OcclusionBuffer::OcclusionBuffer() :
+	nearPlane( 0.f ),
+	viewProjection( 1.f ),
+	depthBuffer( OCCLUSIONBUFFER_WIDTH * OCCLUSIONBUFFER_HEIGHT, 0.f ),
+	isStopping( false ),
+	frame( 0 ),
+	nextBand( 0 ),
+	countDoneBands( 0 )
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor
+// ------------------------------------------------------------------------------------ //
+le::OcclusionBuffer::~OcclusionBuffer()
+{
+	{
+		std::lock_guard< std::mutex >		lock( mutex );
+		isStopping = true;
+	}
+
+	conditionStart.notify_all();
+	for ( UInt32_t index = 0, count = workers.size(); index < count; ++index )
+		workers[ index ].join();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Start new frame
+// ------------------------------------------------------------------------------------ //
+void le::OcclusionBuffer::Begin( const Matrix4x4_t& ViewProjection, float Near )
+{
+	viewProjection = ViewProjection;
+	nearPlane = Near;
+	triangles.clear();
+	memset( depthBuffer.data(), 0, depthBuffer.size() * sizeof( float ) );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Add occluder as list of triangles
+// ------------------------------------------------------------------------------------ //
+void le::OcclusionBuffer::AddOccluder( const Vector3D_t* Verteces, UInt32_t CountVerteces )
+{
+	for ( UInt32_t index = 0; index + 2 < CountVerteces; index += 3 )
+		AddClippedTriangle( viewProjection * Vector4D_t( Verteces[ index ], 1.f ),
+							viewProjection * Vector4D_t( Verteces[ index + 1 ], 1.f ),
+							viewProjection * Vector4D_t( Verteces[ index + 2 ], 1.f ) );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Add solid box as occluder
+// ------------------------------------------------------------------------------------ //
+void le::OcclusionBuffer::AddOccluder( const Vector3D_t& Min, const Vector3D_t& Max )
+{
+	static const UInt32_t		boxIndeces[ 36 ] =
+	{
+		0, 1, 3,	0, 3, 2,
+		4, 6, 7,	4, 7, 5,
+		0, 4, 5,	0, 5, 1,
+		2, 3, 7,	2, 7, 6,
+		0, 2, 6,	0, 6, 4,
+		1, 5, 7,	1, 7, 3
+	};
+
+	Vector3D_t			verteces[ 36 ];
+	for ( UInt32_t index = 0; index < 36; ++index )
+	{
+		UInt32_t		corner = boxIndeces[ index ];
+		verteces[ index ] = Vector3D_t( corner & 4 ? Max.x : Min.x, corner & 2 ? Max.y : Min.y, corner & 1 ? Max.z : Min.z );
+	}
+
+	AddOccluder( verteces, 36 );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Clip triangle by near plane
+// ------------------------------------------------------------------------------------ //
+void le::OcclusionBuffer::AddClippedTriangle( const Vector4D_t& Vertex0, const Vector4D_t& Vertex1, const Vector4D_t& Vertex2 )
+{
+	const Vector4D_t*		verteces[ 3 ] = { &Vertex0, &Vertex1, &Vertex2 };
+	Vector4D_t				clipped[ 4 ];
+	UInt32_t				countClipped = 0;
+
+	for ( UInt32_t index = 0; index < 3; ++index )
+	{
+		const Vector4D_t&		current = *verteces[ index ];
+		const Vector4D_t&		next = *verteces[ ( index + 1 ) % 3 ];
+		bool					isCurrentInside = current.w >= nearPlane;
+		bool					isNextInside = next.w >= nearPlane;
+
+		if ( isCurrentInside )
+			clipped[ countClipped++ ] = current;
+
+		if ( isCurrentInside != isNextInside )
+			clipped[ countClipped++ ] = glm::mix( current, next, ( nearPlane - current.w ) / ( next.w - current.w ) );
+	}
+
+	if ( countClipped < 3 )		return;
+
+	AddScreenTriangle( clipped[ 0 ], clipped[ 1 ], clipped[ 2 ] );
+	if ( countClipped == 4 )
+		AddScreenTriangle( clipped[ 0 ], clipped[ 2 ], clipped[ 3 ] );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Project triangle and setup edge functions
+// ------------------------------------------------------------------------------------ //
+void le::OcclusionBuffer::AddScreenTriangle( const Vector4D_t& Vertex0, const Vector4D_t& Vertex1, const Vector4D_t& Vertex2 )
+{
+	const Vector4D_t*		clipVerteces[ 3 ] = { &Vertex0, &Vertex1, &Vertex2 };
+	Vector3D_t				verteces[ 3 ];
+
+	for ( UInt32_t index = 0; index < 3; ++index )
+	{
+		const Vector4D_t&		vertex = *clipVerteces[ index ];
+		float					invW = 1.f / vertex.w;
+
+		verteces[ index ] = Vector3D_t( ( vertex.x * invW * 0.5f + 0.5f ) * OCCLUSIONBUFFER_WIDTH,
+										( vertex.y * invW * 0.5f + 0.5f ) * OCCLUSIONBUFFER_HEIGHT,
+										invW );
+	}
+
+	float			area = ( verteces[ 1 ].x - verteces[ 0 ].x ) * ( verteces[ 2 ].y - verteces[ 0 ].y ) - ( verteces[ 1 ].y - verteces[ 0 ].y ) * ( verteces[ 2 ].x - verteces[ 0 ].x );
+	if ( fabsf( area ) < 1e-6f )	return;
+
+	// Occluders are rasterized with both sides, so bring triangle to one winding
+	if ( area < 0.f )
+	{
+		std::swap( verteces[ 1 ], verteces[ 2 ] );
+		area = -area;
+	}
+
+	Triangle		triangle;
+	Vector3D_t		minPosition = glm::min( verteces[ 0 ], glm::min( verteces[ 1 ], verteces[ 2 ] ) );
+	Vector3D_t		maxPosition = glm::max( verteces[ 0 ], glm::max( verteces[ 1 ], verteces[ 2 ] ) );
+
+	triangle.minX = glm::max( ( Int32_t ) floorf( minPosition.x ), 0 );
+	triangle.minY = glm::max( ( Int32_t ) floorf( minPosition.y ), 0 );
+	triangle.maxX = glm::min( ( Int32_t ) ceilf( maxPosition.x ), OCCLUSIONBUFFER_WIDTH - 1 );
+	triangle.maxY = glm::min( ( Int32_t ) ceilf( maxPosition.y ), OCCLUSIONBUFFER_HEIGHT - 1 );
+	if ( triangle.minX > triangle.maxX || triangle.minY > triangle.maxY )		return;
+
+	// Edge function is positive inside triangle
+	for ( UInt32_t index = 0; index < 3; ++index )
+	{
+		const Vector3D_t&		start = verteces[ index ];
+		const Vector3D_t&		end = verteces[ ( index + 1 ) % 3 ];
+		float*					edge = triangle.edges[ index ];
+
+		edge[ 0 ] = start.y - end.y;
+		edge[ 1 ] = end.x - start.x;
+		edge[ 2 ] = -( edge[ 0 ] * start.x + edge[ 1 ] * start.y );
+	}
+
+	Vector3D_t		normal = glm::cross( verteces[ 1 ] - verteces[ 0 ], verteces[ 2 ] - verteces[ 0 ] );
+	triangle.depth[ 0 ] = -normal.x / normal.z;
+	triangle.depth[ 1 ] = -normal.y / normal.z;
+	triangle.depth[ 2 ] = verteces[ 0 ].z - triangle.depth[ 0 ] * verteces[ 0 ].x - triangle.depth[ 1 ] * verteces[ 0 ].y;
+
+	triangles.push_back( triangle );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Rasterize occluders
+// ------------------------------------------------------------------------------------ //
+void le::OcclusionBuffer::Rasterize()
+{
+	if ( triangles.empty() )		return;
+
+	// Workers are created once and sleep between frames
+	if ( workers.empty() )
+	{
+		UInt32_t		countWorkers = glm::min( std::thread::hardware_concurrency(), ( UInt32_t ) OCCLUSIONBUFFER_COUNT_BANDS );
+		for ( UInt32_t index = 1; index < countWorkers; ++index )
+			workers.push_back( std::thread( &OcclusionBuffer::WorkerThread, this ) );
+	}
+
+	// Counter is reset first: late worker of previous frame can take band only after nextBand reset
+	countDoneBands = 0;
+	nextBand = 0;
+
+	{
+		std::lock_guard< std::mutex >		lock( mutex );
+		++frame;
+	}
+
+	conditionStart.notify_all();
+	RasterizeBands();
+
+	std::unique_lock< std::mutex >		lock( mutex );
+	conditionDone.wait( lock, [ this ]() { return countDoneBands == OCCLUSIONBUFFER_COUNT_BANDS; } );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Test bounding box against depth buffer
+// ------------------------------------------------------------------------------------ //
+bool le::OcclusionBuffer::IsVisible( const Vector3D_t& Min, const Vector3D_t& Max ) const
+{
+	if ( triangles.empty() )		return true;
+
+	Vector2D_t		minPosition( FLT_MAX );
+	Vector2D_t		maxPosition( -FLT_MAX );
+	float			maxDepth = 0.f;
+
+	// Nearest point of box is always one of its corners
+	for ( UInt32_t index = 0; index < 8; ++index )
+	{
+		Vector4D_t		vertex = viewProjection * Vector4D_t( index & 4 ? Max.x : Min.x, index & 2 ? Max.y : Min.y, index & 1 ? Max.z : Min.z, 1.f );
+		if ( vertex.w < nearPlane )		return true;
+
+		float			invW = 1.f / vertex.w;
+		Vector2D_t		position( ( vertex.x * invW * 0.5f + 0.5f ) * OCCLUSIONBUFFER_WIDTH, ( vertex.y * invW * 0.5f + 0.5f ) * OCCLUSIONBUFFER_HEIGHT );
+
+		minPosition = glm::min( minPosition, position );
+		maxPosition = glm::max( maxPosition, position );
+		maxDepth = glm::max( maxDepth, invW );
+	}
+
+	Int32_t			minX = glm::max( ( Int32_t ) floorf( minPosition.x ), 0 );
+	Int32_t			minY = glm::max( ( Int32_t ) floorf( minPosition.y ), 0 );
+	Int32_t			maxX = glm::min( ( Int32_t ) floorf( maxPosition.x ), OCCLUSIONBUFFER_WIDTH - 1 );
+	Int32_t			maxY = glm::min( ( Int32_t ) floorf( maxPosition.y ), OCCLUSIONBUFFER_HEIGHT - 1 );
+
+	// Box is visible if at least one pixel of occluders is not nearer than box
+	for ( Int32_t y = minY; y <= maxY; ++y )
+	{
+		const float*		row = &depthBuffer[ y * OCCLUSIONBUFFER_WIDTH ];
+		for ( Int32_t x = minX; x <= maxX; ++x )
+			if ( row[ x ] <= maxDepth )
+				return true;
+	}
+
+	return false;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Save depth buffer to PGM image
+// ------------------------------------------------------------------------------------ //
+bool le::OcclusionBuffer::Save( const char* Path ) const
+{
+	std::ofstream			file( Path, std::ios::binary );
+	if ( !file.is_open() )	return false;
+
+	float					maxDepth = 0.f;
+	for ( UInt32_t index = 0, count = depthBuffer.size(); index < count; ++index )
+		maxDepth = glm::max( maxDepth, depthBuffer[ index ] );
+
+	// Image rows go from top to bottom, buffer rows from bottom to top
+	std::vector< Byte_t >	image( OCCLUSIONBUFFER_WIDTH * OCCLUSIONBUFFER_HEIGHT );
+	for ( UInt32_t y = 0; y < OCCLUSIONBUFFER_HEIGHT; ++y )
+		for ( UInt32_t x = 0; x < OCCLUSIONBUFFER_WIDTH; ++x )
+		{
+			float		depth = depthBuffer[ ( OCCLUSIONBUFFER_HEIGHT - 1 - y ) * OCCLUSIONBUFFER_WIDTH + x ];
+			image[ y * OCCLUSIONBUFFER_WIDTH + x ] = maxDepth > 0.f ? ( Byte_t ) ( sqrtf( depth / maxDepth ) * 255.f ) : 0;
+		}
+
+	file << "P5\n" << OCCLUSIONBUFFER_WIDTH << " " << OCCLUSIONBUFFER_HEIGHT << "\n255\n";
+	file.write( ( char* ) image.data(), image.size() );
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Rasterize bands until all are taken
+// ------------------------------------------------------------------------------------ //
+void le::OcclusionBuffer::RasterizeBands()
+{
+	for ( UInt32_t band = nextBand++; band < OCCLUSIONBUFFER_COUNT_BANDS; band = nextBand++ )
+	{
+		RasterizeBand( band );
+
+		if ( ++countDoneBands == OCCLUSIONBUFFER_COUNT_BANDS )
+		{
+			std::lock_guard< std::mutex >		lock( mutex );
+			conditionDone.notify_all();
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Rasterize all triangles into one band
+// ------------------------------------------------------------------------------------ //
+void le::OcclusionBuffer::RasterizeBand( UInt32_t Band )
+{
+	Int32_t			bandMinY = Band * OCCLUSIONBUFFER_BAND_HEIGHT;
+	Int32_t			bandMaxY = bandMinY + OCCLUSIONBUFFER_BAND_HEIGHT - 1;
+
+	for ( UInt32_t index = 0, count = triangles.size(); index < count; ++index )
+	{
+		const Triangle&		triangle = triangles[ index ];
+		Int32_t				minY = glm::max( triangle.minY, bandMinY );
+		Int32_t				maxY = glm::min( triangle.maxY, bandMaxY );
+		Int32_t				minX = triangle.minX & ~3;
+
+		for ( Int32_t y = minY; y <= maxY; ++y )
+		{
+			float*			row = &depthBuffer[ y * OCCLUSIONBUFFER_WIDTH ];
+			float			pixelY = y + 0.5f;
+
+#ifdef OCCLUSIONBUFFER_SSE2
+			// Four pixels per step: mask of coverage selects interpolated depth, max keeps nearest
+			const __m128	laneOffsets = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+			__m128			edgeA[ 3 ];
+			__m128			edgeRow[ 3 ];
+
+			for ( UInt32_t edge = 0; edge < 3; ++edge )
+			{
+				edgeA[ edge ] = _mm_set1_ps( triangle.edges[ edge ][ 0 ] );
+				edgeRow[ edge ] = _mm_set1_ps( triangle.edges[ edge ][ 1 ] * pixelY + triangle.edges[ edge ][ 2 ] );
+			}
+
+			__m128			depthA = _mm_set1_ps( triangle.depth[ 0 ] );
+			__m128			depthRow = _mm_set1_ps( triangle.depth[ 1 ] * pixelY + triangle.depth[ 2 ] );
+			__m128			zero = _mm_setzero_ps();
+
+			for ( Int32_t x = minX; x <= triangle.maxX; x += 4 )
+			{
+				__m128		pixelX = _mm_add_ps( _mm_set1_ps( ( float ) x ), laneOffsets );
+				__m128		mask = _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( edgeA[ 0 ], pixelX ), edgeRow[ 0 ] ), zero );
+				mask = _mm_and_ps( mask, _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( edgeA[ 1 ], pixelX ), edgeRow[ 1 ] ), zero ) );
+				mask = _mm_and_ps( mask, _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( edgeA[ 2 ], pixelX ), edgeRow[ 2 ] ), zero ) );
+
+				__m128		depth = _mm_and_ps( mask, _mm_add_ps( _mm_mul_ps( depthA, pixelX ), depthRow ) );
+				_mm_storeu_ps( row + x, _mm_max_ps( _mm_loadu_ps( row + x ), depth ) );
+			}
+#else
+			for ( Int32_t x = minX; x <= triangle.maxX; ++x )
+			{
+				float		pixelX = x + 0.5f;
+				if ( triangle.edges[ 0 ][ 0 ] * pixelX + triangle.edges[ 0 ][ 1 ] * pixelY + triangle.edges[ 0 ][ 2 ] < 0.f ||
+					 triangle.edges[ 1 ][ 0 ] * pixelX + triangle.edges[ 1 ][ 1 ] * pixelY + triangle.edges[ 1 ][ 2 ] < 0.f ||
+					 triangle.edges[ 2 ][ 0 ] * pixelX + triangle.edges[ 2 ][ 1 ] * pixelY + triangle.edges[ 2 ][ 2 ] < 0.f )
+					continue;
+
+				row[ x ] = glm::max( row[ x ], triangle.depth[ 0 ] * pixelX + triangle.depth[ 1 ] * pixelY + triangle.depth[ 2 ] );
+			}
+#endif // OCCLUSIONBUFFER_SSE2
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Worker thread
+// ------------------------------------------------------------------------------------ //
+void le::OcclusionBuffer::WorkerThread()
+{
+	UInt32_t		lastFrame = 0;
+
+	while ( true )
+	{
+		{
+			std::unique_lock< std::mutex >		lock( mutex );
+			conditionStart.wait( lock, [ this, lastFrame ]() { return isStopping || frame != lastFrame; } );
+
+			if ( isStopping )		return;
+			lastFrame = frame;
+		}
+
+		RasterizeBands();
+	}
+}
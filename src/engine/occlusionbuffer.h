@@ -0,0 +1,109 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef OCCLUSIONBUFFER_H
+#define OCCLUSIONBUFFER_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+#define OCCLUSIONBUFFER_WIDTH			256
+#define OCCLUSIONBUFFER_HEIGHT			128
+#define OCCLUSIONBUFFER_BAND_HEIGHT		16
+#define OCCLUSIONBUFFER_COUNT_BANDS		( OCCLUSIONBUFFER_HEIGHT / OCCLUSIONBUFFER_BAND_HEIGHT )
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	class OcclusionBuffer
+	{
+	public:
+		OcclusionBuffer();
+		~OcclusionBuffer();
+
+		// Start new frame: clear buffer and list of occluders
+		void					Begin( const Matrix4x4_t& ViewProjection, float Near );
+
+		// Add occluder as list of triangles in world space
+		void					AddOccluder( const Vector3D_t* Verteces, UInt32_t CountVerteces );
+
+		// Add solid box as occluder
+		void					AddOccluder( const Vector3D_t& Min, const Vector3D_t& Max );
+
+		// Rasterize occluders into depth buffer, bands are rasterized in parallel
+		void					Rasterize();
+
+		// Test bounding box against depth buffer, call only after Rasterize
+		bool					IsVisible( const Vector3D_t& Min, const Vector3D_t& Max ) const;
+
+		// Save depth buffer to grayscale PGM image
+		bool					Save( const char* Path ) const;
+
+		inline UInt32_t			GetCountTriangles() const
+		{
+			return triangles.size();
+		}
+
+	private:
+
+		//---------------------------------------------------------------------//
+
+		struct Triangle
+		{
+			// Edge functions and depth plane in form A * x + B * y + C
+			float			edges[ 3 ][ 3 ];
+			float			depth[ 3 ];
+			Int32_t			minX;
+			Int32_t			maxX;
+			Int32_t			minY;
+			Int32_t			maxY;
+		};
+
+		//---------------------------------------------------------------------//
+
+		void					AddClippedTriangle( const Vector4D_t& Vertex0, const Vector4D_t& Vertex1, const Vector4D_t& Vertex2 );
+		void					AddScreenTriangle( const Vector4D_t& Vertex0, const Vector4D_t& Vertex1, const Vector4D_t& Vertex2 );
+		void					RasterizeBands();
+		void					RasterizeBand( UInt32_t Band );
+		void					WorkerThread();
+
+		float							nearPlane;
+		Matrix4x4_t						viewProjection;
+		std::vector< Triangle >			triangles;
+
+		// Depth stored as 1 / w, so it interpolates linearly in screen space. Greater is nearer
+		std::vector< float >			depthBuffer;
+
+		bool							isStopping;
+		UInt32_t						frame;
+		std::atomic< UInt32_t >			nextBand;
+		std::atomic< UInt32_t >			countDoneBands;
+		std::mutex						mutex;
+		std::condition_variable			conditionStart;
+		std::condition_variable			conditionDone;
+		std::vector< std::thread >		workers;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !OCCLUSIONBUFFER_H
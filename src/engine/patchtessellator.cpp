@@ -0,0 +1,294 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <thread>
+
+#include "patchtessellator.h"
+
+// Projected size (in NDC height) below which coarser LOD is used
+#define PATCH_LOD1_SIZE			0.5f
+#define PATCH_LOD2_SIZE			0.15f
+
+//---------------------------------------------------------------------//
+
+struct PatchJob
+{
+	le::UInt32_t		face;
+	le::UInt32_t		startVertex;
+	le::UInt32_t		startIndeces[ PATCH_COUNT_LODS ];
+	le::UInt32_t		countIndeces[ PATCH_COUNT_LODS ];
+};
+
+// ------------------------------------------------------------------------------------ //
+// Step of LOD in fine grid
+// ------------------------------------------------------------------------------------ //
+inline le::UInt32_t Patch_LodStep( le::UInt32_t Lod )
+{
+	return 1 << Lod;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Count of indeces of LOD
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t Patch_CountIndeces( le::UInt32_t GridWidth, le::UInt32_t GridHeight, le::UInt32_t Lod )
+{
+	le::UInt32_t		step = Patch_LodStep( Lod );
+	le::UInt32_t		countCellsX = ( GridWidth - 1 ) / step;
+	le::UInt32_t		countCellsY = ( GridHeight - 1 ) / step;
+	le::UInt32_t		countIndeces = 0;
+
+	for ( le::UInt32_t cellY = 0; cellY < countCellsY; ++cellY )
+		for ( le::UInt32_t cellX = 0; cellX < countCellsX; ++cellX )
+		{
+			le::UInt32_t	countBorders = ( cellX == 0 ) + ( cellX == countCellsX - 1 ) + ( cellY == 0 ) + ( cellY == countCellsY - 1 );
+
+			// Cell on border of face is fan with fine verteces on border edges
+			if ( step == 1 || countBorders == 0 )
+				countIndeces += 6;
+			else
+				countIndeces += ( 4 + countBorders * ( step - 1 ) ) * 3;
+		}
+
+	return countIndeces;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Evaluate biquadratic Bezier basis
+// ------------------------------------------------------------------------------------ //
+inline void Patch_Basis( float T, float* Basis )
+{
+	Basis[ 0 ] = ( 1.f - T ) * ( 1.f - T );
+	Basis[ 1 ] = 2.f * T * ( 1.f - T );
+	Basis[ 2 ] = T * T;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Tessellate verteces of face to fine grid
+// ------------------------------------------------------------------------------------ //
+void Patch_TessellateVerteces( const le::BSPFace& Face, const le::BSPVertex* ControlPoints, le::BSPVertex* Verteces )
+{
+	le::UInt32_t		countPatchesX = ( Face.size[ 0 ] - 1 ) / 2;
+	le::UInt32_t		countPatchesY = ( Face.size[ 1 ] - 1 ) / 2;
+	le::UInt32_t		gridWidth = countPatchesX * PATCH_MAX_TESSELLATION + 1;
+	le::UInt32_t		gridHeight = countPatchesY * PATCH_MAX_TESSELLATION + 1;
+
+	for ( le::UInt32_t y = 0; y < gridHeight; ++y )
+	{
+		// Verteces on border of two patches are computed from the same control points
+		le::UInt32_t	patchY = glm::min( y / PATCH_MAX_TESSELLATION, countPatchesY - 1 );
+		float			basisY[ 3 ];
+		Patch_Basis( ( y - patchY * PATCH_MAX_TESSELLATION ) / ( float ) PATCH_MAX_TESSELLATION, basisY );
+
+		for ( le::UInt32_t x = 0; x < gridWidth; ++x )
+		{
+			le::UInt32_t	patchX = glm::min( x / PATCH_MAX_TESSELLATION, countPatchesX - 1 );
+			float			basisX[ 3 ];
+			Patch_Basis( ( x - patchX * PATCH_MAX_TESSELLATION ) / ( float ) PATCH_MAX_TESSELLATION, basisX );
+
+			le::BSPVertex&	vertex = Verteces[ y * gridWidth + x ];
+			le::Vector4D_t	color( 0.f );
+
+			vertex.position = le::Vector3D_t( 0.f );
+			vertex.textureCoord = le::Vector2D_t( 0.f );
+			vertex.lightmapCoord = le::Vector2D_t( 0.f );
+			vertex.normal = le::Vector3D_t( 0.f );
+
+			for ( le::UInt32_t row = 0; row < 3; ++row )
+				for ( le::UInt32_t column = 0; column < 3; ++column )
+				{
+					const le::BSPVertex&	controlPoint = ControlPoints[ ( patchY * 2 + row ) * Face.size[ 0 ] + patchX * 2 + column ];
+					float					weight = basisY[ row ] * basisX[ column ];
+
+					vertex.position += controlPoint.position * weight;
+					vertex.textureCoord += controlPoint.textureCoord * weight;
+					vertex.lightmapCoord += controlPoint.lightmapCoord * weight;
+					vertex.normal += controlPoint.normal * weight;
+					color += le::Vector4D_t( controlPoint.color[ 0 ], controlPoint.color[ 1 ], controlPoint.color[ 2 ], controlPoint.color[ 3 ] ) * weight;
+				}
+
+			if ( glm::length( vertex.normal ) > 0.f )
+				vertex.normal = glm::normalize( vertex.normal );
+
+			for ( le::UInt32_t component = 0; component < 4; ++component )
+				vertex.color[ component ] = ( le::Byte_t ) glm::clamp( color[ component ] + 0.5f, 0.f, 255.f );
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Build indeces of LOD
+// ------------------------------------------------------------------------------------ //
+void Patch_BuildIndeces( le::UInt32_t GridWidth, le::UInt32_t GridHeight, le::UInt32_t Lod, le::UInt32_t* Indeces )
+{
+	le::UInt32_t		step = Patch_LodStep( Lod );
+	le::UInt32_t		countCellsX = ( GridWidth - 1 ) / step;
+	le::UInt32_t		countCellsY = ( GridHeight - 1 ) / step;
+	le::UInt32_t		perimeter[ 4 * PATCH_MAX_TESSELLATION ];
+
+	for ( le::UInt32_t cellY = 0; cellY < countCellsY; ++cellY )
+		for ( le::UInt32_t cellX = 0; cellX < countCellsX; ++cellX )
+		{
+			le::UInt32_t	x0 = cellX * step;
+			le::UInt32_t	y0 = cellY * step;
+			le::UInt32_t	x1 = x0 + step;
+			le::UInt32_t	y1 = y0 + step;
+			bool			isLeft = cellX == 0;
+			bool			isRight = cellX == countCellsX - 1;
+			bool			isBottom = cellY == 0;
+			bool			isTop = cellY == countCellsY - 1;
+
+			// Same winding as Quake 3 grids
+			if ( step == 1 || !( isLeft || isRight || isBottom || isTop ) )
+			{
+				*Indeces++ = y0 * GridWidth + x0;
+				*Indeces++ = y1 * GridWidth + x0;
+				*Indeces++ = y0 * GridWidth + x1;
+
+				*Indeces++ = y0 * GridWidth + x1;
+				*Indeces++ = y1 * GridWidth + x0;
+				*Indeces++ = y1 * GridWidth + x1;
+				continue;
+			}
+
+			// Walk perimeter in the same direction, border edges use every fine vertex,
+			// inner edges only corners, so neighbour cells and patches match without cracks
+			le::UInt32_t	countPerimeter = 0;
+			le::UInt32_t	stepLeft = isLeft ? 1 : step;
+			le::UInt32_t	stepTop = isTop ? 1 : step;
+			le::UInt32_t	stepRight = isRight ? 1 : step;
+			le::UInt32_t	stepBottom = isBottom ? 1 : step;
+
+			for ( le::UInt32_t y = y0; y < y1; y += stepLeft )			perimeter[ countPerimeter++ ] = y * GridWidth + x0;
+			for ( le::UInt32_t x = x0; x < x1; x += stepTop )			perimeter[ countPerimeter++ ] = y1 * GridWidth + x;
+			for ( le::UInt32_t y = y1; y > y0; y -= stepRight )			perimeter[ countPerimeter++ ] = y * GridWidth + x1;
+			for ( le::UInt32_t x = x1; x > x0; x -= stepBottom )		perimeter[ countPerimeter++ ] = y0 * GridWidth + x;
+
+			le::UInt32_t	center = ( y0 + step / 2 ) * GridWidth + x0 + step / 2;
+			for ( le::UInt32_t index = 0; index < countPerimeter; ++index )
+			{
+				*Indeces++ = center;
+				*Indeces++ = perimeter[ index ];
+				*Indeces++ = perimeter[ ( index + 1 ) % countPerimeter ];
+			}
+		}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Tessellate patches
+// ------------------------------------------------------------------------------------ //
+void le::PatchTessellator::Tessellate( std::vector< BSPVertex >& Verteces, std::vector< UInt32_t >& Indeces, std::vector< BSPFace >& Faces, std::vector< Patch >& Patches )
+{
+	// Sizes are known before tessellation, so pools are allocated once and faces are filled in parallel
+	std::vector< PatchJob >		jobs;
+	UInt32_t					countVerteces = Verteces.size();
+	UInt32_t					countIndeces = Indeces.size();
+
+	for ( UInt32_t index = 0, count = Faces.size(); index < count; ++index )
+	{
+		BSPFace&		face = Faces[ index ];
+		if ( face.type != BTP_PATCH || face.size[ 0 ] < 3 || face.size[ 1 ] < 3 || face.size[ 0 ] % 2 == 0 || face.size[ 1 ] % 2 == 0 ||
+			 face.size[ 0 ] * face.size[ 1 ] > face.numOfVerts )
+			continue;
+
+		UInt32_t		gridWidth = ( face.size[ 0 ] - 1 ) / 2 * PATCH_MAX_TESSELLATION + 1;
+		UInt32_t		gridHeight = ( face.size[ 1 ] - 1 ) / 2 * PATCH_MAX_TESSELLATION + 1;
+		PatchJob		job;
+
+		job.face = index;
+		job.startVertex = countVerteces;
+		countVerteces += gridWidth * gridHeight;
+
+		for ( UInt32_t lod = 0; lod < PATCH_COUNT_LODS; ++lod )
+		{
+			job.startIndeces[ lod ] = countIndeces;
+			job.countIndeces[ lod ] = Patch_CountIndeces( gridWidth, gridHeight, lod );
+			countIndeces += job.countIndeces[ lod ];
+		}
+
+		jobs.push_back( job );
+	}
+
+	if ( jobs.empty() )		return;
+
+	Verteces.resize( countVerteces );
+	Indeces.resize( countIndeces );
+
+	std::vector< std::thread >		threads;
+	UInt32_t						countThreads = glm::clamp( std::thread::hardware_concurrency(), 1u, ( UInt32_t ) jobs.size() );
+
+	for ( UInt32_t indexThread = 0; indexThread < countThreads; ++indexThread )
+		threads.push_back( std::thread( [ &, indexThread ]()
+		{
+			for ( UInt32_t indexJob = indexThread, countJobs = jobs.size(); indexJob < countJobs; indexJob += countThreads )
+			{
+				const PatchJob&		job = jobs[ indexJob ];
+				const BSPFace&		face = Faces[ job.face ];
+				UInt32_t			gridWidth = ( face.size[ 0 ] - 1 ) / 2 * PATCH_MAX_TESSELLATION + 1;
+				UInt32_t			gridHeight = ( face.size[ 1 ] - 1 ) / 2 * PATCH_MAX_TESSELLATION + 1;
+
+				Patch_TessellateVerteces( face, &Verteces[ face.startVertIndex ], &Verteces[ job.startVertex ] );
+				for ( UInt32_t lod = 0; lod < PATCH_COUNT_LODS; ++lod )
+					Patch_BuildIndeces( gridWidth, gridHeight, lod, &Indeces[ job.startIndeces[ lod ] ] );
+			}
+		} ) );
+
+	for ( UInt32_t index = 0; index < countThreads; ++index )
+		threads[ index ].join();
+
+	// Re-point faces to tessellated geometry and remember bounds for LOD selection
+	for ( UInt32_t index = 0, count = jobs.size(); index < count; ++index )
+	{
+		const PatchJob&		job = jobs[ index ];
+		BSPFace&			face = Faces[ job.face ];
+		UInt32_t			gridWidth = ( face.size[ 0 ] - 1 ) / 2 * PATCH_MAX_TESSELLATION + 1;
+		UInt32_t			gridHeight = ( face.size[ 1 ] - 1 ) / 2 * PATCH_MAX_TESSELLATION + 1;
+		Vector3D_t			min = Verteces[ job.startVertex ].position;
+		Vector3D_t			max = min;
+		Patch				patch;
+
+		face.startVertIndex = job.startVertex;
+		face.numOfVerts = gridWidth * gridHeight;
+		face.startIndex = job.startIndeces[ 0 ];
+		face.numOfIndices = job.countIndeces[ 0 ];
+
+		for ( UInt32_t indexVertex = job.startVertex, countVerteces = job.startVertex + face.numOfVerts; indexVertex < countVerteces; ++indexVertex )
+		{
+			min = glm::min( min, Verteces[ indexVertex ].position );
+			max = glm::max( max, Verteces[ indexVertex ].position );
+		}
+
+		patch.face = job.face;
+		patch.center = ( min + max ) * 0.5f;
+		patch.radius = glm::length( max - min ) * 0.5f;
+
+		for ( UInt32_t lod = 0; lod < PATCH_COUNT_LODS; ++lod )
+		{
+			patch.lods[ lod ].startIndex = job.startIndeces[ lod ];
+			patch.lods[ lod ].countIndeces = job.countIndeces[ lod ];
+			patch.lodSurfaces[ lod ] = job.face;
+		}
+
+		Patches.push_back( patch );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Select LOD of patch
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::PatchTessellator::SelectLod( const Patch& Patch, const Vector3D_t& CameraPosition, float ProjectionScale )
+{
+	float		distance = glm::distance( CameraPosition, Patch.center );
+	if ( distance <= Patch.radius )		return 0;
+
+	float		size = Patch.radius * ProjectionScale / distance;
+	if ( size >= PATCH_LOD1_SIZE )		return 0;
+	if ( size >= PATCH_LOD2_SIZE )		return 1;
+	return 2;
+}
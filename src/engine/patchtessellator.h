@@ -0,0 +1,68 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PATCHTESSELLATOR_H
+#define PATCHTESSELLATOR_H
+
+#include <vector>
+
+#include "common/types.h"
+#include "bsp.h"
+
+//---------------------------------------------------------------------//
+
+#define PATCH_MAX_TESSELLATION		8
+#define PATCH_COUNT_LODS			3
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	struct PatchLod
+	{
+		UInt32_t		startIndex;
+		UInt32_t		countIndeces;
+	};
+
+	//---------------------------------------------------------------------//
+
+	struct Patch
+	{
+		UInt32_t		face;
+		Vector3D_t		center;
+		float			radius;
+
+		// Index ranges of LODs in index pool, all LODs use the same verteces.
+		// LOD 0 is the finest one and is stored in face
+		PatchLod		lods[ PATCH_COUNT_LODS ];
+		UInt32_t		lodSurfaces[ PATCH_COUNT_LODS ];
+	};
+
+	//---------------------------------------------------------------------//
+
+	class PatchTessellator
+	{
+	public:
+		// Tessellate all BTP_PATCH faces in parallel. Verteces and indeces are appended to pools,
+		// faces are re-pointed to tessellated geometry of LOD 0
+		static void				Tessellate( std::vector< BSPVertex >& Verteces, std::vector< UInt32_t >& Indeces, std::vector< BSPFace >& Faces, std::vector< Patch >& Patches );
+
+		// Select LOD by projected size of patch, ProjectionScale is element [1][1] of projection matrix
+		static UInt32_t			SelectLod( const Patch& Patch, const Vector3D_t& CameraPosition, float ProjectionScale );
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !PATCHTESSELLATOR_H
@@ -35,6 +35,8 @@
 #include "consolesystem.h"
 #include "resourcesystem.h"
 #include "level.h"
+#include "vertexpacker.h"
+#include "meshoptimizer.h"
 
 #define LMD_ID			"LMD"
 #define LMD_VERSION		2
@@ -49,6 +51,14 @@ struct Vertex
 	le::Vector3D_t			bitangent;
 };
 
+struct PackedVertex
+{
+	le::Vector3D_t			position;
+	le::UInt32_t			normal;
+	le::UInt16_t			texCoords[ 2 ];
+	le::UInt32_t			tangent;
+};
+
 struct MaterialPass
 {
 	MaterialPass() :
@@ -244,7 +254,7 @@ le::ITexture* LE_LoadTexture( const char* Path, le::IFactory* StudioRenderFactor
 	LE_LoadImage( Path, image, isError, false, true );
 	if ( isError )			return nullptr;
 
-	le::ITexture* texture = ( le::ITexture* ) StudioRenderFactory->Create( TEXTURE_INTERFACE_VERSION );
+	le::ITexture* texture = ( le::ITexture* ) StudioRenderFactory->Create( le::HashInterface( TEXTURE_INTERFACE_VERSION ) );
 	if ( !texture )			return nullptr;
 
 	texture->Initialize( le::TT_2D, image.aMask > 0 ? le::IF_RGBA_8UNORM : le::IF_RGB_8UNORM, image.width, image.height );
@@ -357,14 +367,14 @@ le::IMaterial* LE_LoadMaterial( const char* Path, le::IResourceSystem* ResourceS
 
 	for ( auto itTechnique = techniques.begin(), itTechniqueEnd = techniques.end(); itTechnique != itTechniqueEnd; ++itTechnique )
 	{
-		le::IStudioRenderTechnique* technique = ( le::IStudioRenderTechnique* ) StudioRenderFactory->Create( TECHNIQUE_INTERFACE_VERSION );
+		le::IStudioRenderTechnique* technique = ( le::IStudioRenderTechnique* ) StudioRenderFactory->Create( le::HashInterface( TECHNIQUE_INTERFACE_VERSION ) );
 		if ( !technique )		return nullptr;
 
 		technique->SetType( RenderTechnique_StringToEnum( itTechnique->first.c_str() ) );
 		for ( le::UInt32_t indexPass = 0, countPasses = itTechnique->second.passes.size(); indexPass < countPasses; ++indexPass )
 		{
 			auto& materialPass = itTechnique->second.passes[ indexPass ];
-			le::IStudioRenderPass* pass = ( le::IStudioRenderPass* ) StudioRenderFactory->Create( PASS_INTERFACE_VERSION );
+			le::IStudioRenderPass* pass = ( le::IStudioRenderPass* ) StudioRenderFactory->Create( le::HashInterface( PASS_INTERFACE_VERSION ) );
 			if ( !pass )		return nullptr;
 			
 			pass->SetShader( materialPass.shader.c_str() );
@@ -377,7 +387,7 @@ le::IMaterial* LE_LoadMaterial( const char* Path, le::IResourceSystem* ResourceS
 			for ( auto itParameters = materialPass.parameters.begin(), itParametersEnd = materialPass.parameters.end(); itParameters != itParametersEnd; ++itParameters )
 			{
 				auto& value = itParameters->second;
-				le::IShaderParameter* parameter = ( le::IShaderParameter* ) StudioRenderFactory->Create( SHADERPARAMETER_INTERFACE_VERSION );
+				le::IShaderParameter* parameter = ( le::IShaderParameter* ) StudioRenderFactory->Create( le::HashInterface( SHADERPARAMETER_INTERFACE_VERSION ) );
 				if ( !parameter )		return nullptr;
 
 				parameter->SetName( itParameters->first.c_str() );
@@ -521,18 +531,38 @@ le::IMesh* LE_LoadMesh( const char* Path, le::IResourceSystem* ResourceSystem, l
 		max.z = glm::max( max.z, arrayVerteces[ index ].position.z );
 	}
 
+	// Упаковываем вершины: нормаль и касательная в 10:10:10:2, текстурные координаты в half float.
+	// Бинормаль не храним, в W касательной записываем ее направление
+	std::vector< PackedVertex >			arrayPackedVerteces( sizeArrayVerteces );
+
+	for ( le::UInt32_t index = 0; index < sizeArrayVerteces; ++index )
+	{
+		Vertex*				vertex = &arrayVerteces[ index ];
+		PackedVertex*		packedVertex = &arrayPackedVerteces[ index ];
+		float				bitangentSign = glm::dot( glm::cross( vertex->normal, vertex->tangent ), vertex->bitangent ) < 0.f ? -1.f : 1.f;
+
+		packedVertex->position = vertex->position;
+		packedVertex->normal = le::VertexPacker::PackSnorm1010102( le::Vector4D_t( vertex->normal, 0.f ) );
+		packedVertex->tangent = le::VertexPacker::PackSnorm1010102( le::Vector4D_t( vertex->tangent, bitangentSign ) );
+		le::VertexPacker::FloatToHalf( &vertex->texCoords.x, packedVertex->texCoords, 2 );
+	}
+
+	le::VertexPacker::PrintReport( Path, sizeArrayVerteces, sizeArrayIndices, sizeof( Vertex ), sizeof( PackedVertex ) );
+
+	// Оптимизируем порядок треугольников и вершин поверхностей под кэш вершин
+	le::MeshOptimizer::Optimize( Path, arrayPackedVerteces.data(), sizeof( PackedVertex ), sizeArrayVerteces, arrayIndices.data(), arrayIndices.size(), arraySurfaces.data(), arraySurfaces.size() );
+
 	// Создаем сам меш
-	le::IMesh* mesh = ( le::IMesh* ) StudioRenderFactory->Create( MESH_INTERFACE_VERSION );
+	le::IMesh* mesh = ( le::IMesh* ) StudioRenderFactory->Create( le::HashInterface( MESH_INTERFACE_VERSION ) );
 	if ( !mesh )				return nullptr;
 
 	// Создаем описание для формата вершин
 	std::vector< le::StudioVertexElement >			vertexElements =
 	{
 		{ 3, le::VET_FLOAT },
-		{ 3, le::VET_FLOAT },
-		{ 2, le::VET_FLOAT },
-		{ 3, le::VET_FLOAT },
-		{ 3, le::VET_FLOAT }
+		{ 4, le::VET_INT_2_10_10_10_REV },
+		{ 2, le::VET_HALF_FLOAT },
+		{ 4, le::VET_INT_2_10_10_10_REV }
 	};
 
 	// Создаем описание меша для загрузки его в модуль рендера
@@ -541,13 +571,13 @@ le::IMesh* LE_LoadMesh( const char* Path, le::IResourceSystem* ResourceSystem, l
 	meshDescriptor.countMaterials = arrayMaterials.size();
 	meshDescriptor.countLightmaps = 0;
 	meshDescriptor.countSurfaces = arraySurfaces.size();
-	meshDescriptor.sizeVerteces = arrayVerteces.size() * sizeof( Vertex );
+	meshDescriptor.sizeVerteces = arrayPackedVerteces.size() * sizeof( PackedVertex );
 
 	meshDescriptor.indeces = arrayIndices.data();
 	meshDescriptor.materials = arrayMaterials.data();
 	meshDescriptor.lightmaps = nullptr;
 	meshDescriptor.surfaces = arraySurfaces.data();
-	meshDescriptor.verteces = arrayVerteces.data();
+	meshDescriptor.verteces = arrayPackedVerteces.data();
 
 	meshDescriptor.min = min;
 	meshDescriptor.max = max;
@@ -873,8 +903,6 @@ le::ILevel* le::ResourceSystem::LoadLevel( const char* Name, const char* Path, I
 
 	try
 	{
-		if ( !studioRenderFactory )							throw std::exception( "Resource system not initialized" );
-
 		if ( levels.find( Name ) != levels.end() )			return levels[ Name ];
 		if ( loaderLevels.empty() )							throw std::exception( "No level loaders" );
 
@@ -1128,20 +1156,26 @@ bool le::ResourceSystem::Initialize( IEngine* Engine )
 {
 	try
 	{
+		RegisterLoader_Image( "png", LE_LoadImage );
+		RegisterLoader_Image( "jpg", LE_LoadImage );
+		RegisterLoader_Image( "tga", LE_LoadImage );
+		RegisterLoader_Level( "bsp", LE_LoadLevel );
+
+		// Без рендера (выделенный сервер) грузятся только картинки и уровни
 		IStudioRender* studioRender = Engine->GetStudioRender();
-		if ( !studioRender )	throw std::exception( "Resource system requared studiorender" );
+		if ( !studioRender )
+		{
+			if ( !Engine->GetConfigurations().isHeadless )	throw std::exception( "Resource system requared studiorender" );
+			return true;
+		}
 
 		studioRenderFactory = studioRender->GetFactory();
 
-		RegisterLoader_Image( "png", LE_LoadImage );
-		RegisterLoader_Image( "jpg", LE_LoadImage );
-		RegisterLoader_Image( "tga", LE_LoadImage );
 		RegisterLoader_Texture( "png", LE_LoadTexture );
 		RegisterLoader_Texture( "jpg", LE_LoadTexture );
 		RegisterLoader_Texture( "tga", LE_LoadTexture );
 		RegisterLoader_Material( "lmt", LE_LoadMaterial );
 		RegisterLoader_Mesh( "lmd", LE_LoadMesh );
-		RegisterLoader_Level( "bsp", LE_LoadLevel );
 	}
 	catch ( std::exception & Exception )
 	{
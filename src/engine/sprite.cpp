@@ -106,7 +106,7 @@ bool le::Sprite::Initialize( const Vector2D_t& Size, IMaterial* Material, SPRITE
 	LIFEENGINE_ASSERT( g_studioRender );
 	if ( IsCreated() )		mesh->Delete();
 
-	mesh = ( IMesh* ) g_studioRender->GetFactory()->Create( MESH_INTERFACE_VERSION );
+	mesh = ( IMesh* ) g_studioRender->GetFactory()->Create( HashInterface( MESH_INTERFACE_VERSION ) );
 	if ( !mesh ) 		return false;
 
 	// Filling vertices array for sprite mesh 
@@ -154,7 +154,7 @@ bool le::Sprite::Initialize( const Vector2D_t& Size, IMaterial* Material, SPRITE
 	meshDescriptor.countVertexElements = vertexElements.size();
 	meshDescriptor.vertexElements = vertexElements.data();
 
-	mesh = ( le::IMesh* ) g_studioRender->GetFactory()->Create( MESH_INTERFACE_VERSION );
+	mesh = ( le::IMesh* ) g_studioRender->GetFactory()->Create( le::HashInterface( MESH_INTERFACE_VERSION ) );
 	if ( !mesh ) 		return false;
 
 	mesh->Create( meshDescriptor );
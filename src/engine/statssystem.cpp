@@ -0,0 +1,361 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <stdio.h>
+
+#include "engine/lifeengine.h"
+#include "engine/iwindow.h"
+#include "engine.h"
+#include "convar.h"
+#include "concmd.h"
+#include "consolesystem.h"
+#include "statssystem.h"
+#include "global.h"
+
+le::ConVar*		r_stats = nullptr;
+le::ConCmd*		stats_dump = nullptr;
+le::ConCmd*		stats_csv = nullptr;
+
+namespace le
+{
+	// ------------------------------------------------------------------------------------ //
+	// Owner of block of thread, retires block when thread exits
+	// ------------------------------------------------------------------------------------ //
+	struct StatsThreadBlockOwner
+	{
+		StatsThreadBlockOwner() :
+			block( nullptr )
+		{}
+
+		~StatsThreadBlockOwner()
+		{
+			if ( block && g_statsSystem )		g_statsSystem->RetireThreadBlock( block );
+		}
+
+		StatsThreadBlock*		block;
+	};
+
+	// ------------------------------------------------------------------------------------ //
+	// Console command for print stats of last frame
+	// ------------------------------------------------------------------------------------ //
+	void CMD_StatsDump( le::UInt32_t CountArguments, const char** Arguments )
+	{
+		g_statsSystem->Dump();
+	}
+
+	// ------------------------------------------------------------------------------------ //
+	// Console command for write stats of every frame to CSV file
+	// ------------------------------------------------------------------------------------ //
+	void CMD_StatsCSV( le::UInt32_t CountArguments, const char** Arguments )
+	{
+		if ( CountArguments < 1 || !Arguments )
+			g_statsSystem->StopCSV();
+		else
+			g_statsSystem->StartCSV( Arguments[ 0 ] );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::StatsSystem::StatsSystem() :
+	countStats( 0 ),
+	countFrames( 0 ),
+	csvCountStats( 0 ),
+	isOverlay( false )
+{
+	for ( UInt32_t index = 0; index < STATSSYSTEM_MAX_STATS; ++index )
+	{
+		stats[ index ].type = ST_COUNTER;
+		stats[ index ].total = 0;
+		stats[ index ].retired = 0;
+		stats[ index ].value = 0;
+		gauges[ index ].store( 0, std::memory_order_relaxed );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor
+// ------------------------------------------------------------------------------------ //
+le::StatsSystem::~StatsSystem()
+{
+	StopCSV();
+
+	if ( r_stats )
+	{
+		g_consoleSystem->UnregisterVar( "r_stats" );
+		delete r_stats;
+	}
+
+	if ( stats_dump )
+	{
+		g_consoleSystem->UnregisterCommand( "stats_dump" );
+		delete stats_dump;
+	}
+
+	if ( stats_csv )
+	{
+		g_consoleSystem->UnregisterCommand( "stats_csv" );
+		delete stats_csv;
+	}
+
+	for ( UInt32_t index = 0, count = blocks.size(); index < count; ++index )
+		delete blocks[ index ];
+
+	// Threads exiting later must not retire blocks into destroyed system
+	if ( g_statsSystem == this )		g_statsSystem = nullptr;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Initialize console variables and commands
+// ------------------------------------------------------------------------------------ //
+void le::StatsSystem::Initialize()
+{
+	r_stats = new ConVar();
+	r_stats->Initialize( "r_stats", "0", CVT_BOOL, "Show stats of frame in title of window",
+						 []( le::IConVar* Var )
+						 {
+							 g_statsSystem->SetOverlay( Var->GetValueBool() );
+						 } );
+	g_consoleSystem->RegisterVar( r_stats );
+
+	stats_dump = new ConCmd();
+	stats_dump->Initialize( "stats_dump", "Print stats of last frame", CMD_StatsDump );
+	g_consoleSystem->RegisterCommand( stats_dump );
+
+	stats_csv = new ConCmd();
+	stats_csv->Initialize( "stats_csv", "Write stats of every frame to CSV file: stats_csv <file>, without file - stop", CMD_StatsCSV );
+	g_consoleSystem->RegisterCommand( stats_csv );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Register stat
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::StatsSystem::RegisterStat( const char* Name, STAT_TYPE Type )
+{
+	std::unique_lock< std::mutex >		lock( mutex );
+	for ( UInt32_t index = 0; index < countStats; ++index )
+		if ( stats[ index ].name == Name )
+			return index;
+
+	if ( countStats >= STATSSYSTEM_MAX_STATS )
+	{
+		g_consoleSystem->PrintWarning( "Stat [%s] not registered, max count of stats is %i", Name, STATSSYSTEM_MAX_STATS );
+		return STATSSYSTEM_INVALID_STAT;
+	}
+
+	StatInfo&		stat = stats[ countStats ];
+	stat.name = Name;
+	stat.type = Type;
+	return countStats++;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get block of current thread, it is created on first write of thread
+// ------------------------------------------------------------------------------------ //
+le::StatsThreadBlock* le::StatsSystem::GetThreadBlock()
+{
+	static thread_local StatsThreadBlockOwner		threadBlockOwner;
+	if ( threadBlockOwner.block )		return threadBlockOwner.block;
+
+	StatsThreadBlock*		threadBlock = new StatsThreadBlock();
+	for ( UInt32_t index = 0; index < STATSSYSTEM_MAX_STATS; ++index )
+		threadBlock->values[ index ].store( 0, std::memory_order_relaxed );
+
+	std::unique_lock< std::mutex >		lock( mutex );
+	blocks.push_back( threadBlock );
+	threadBlockOwner.block = threadBlock;
+	return threadBlock;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Retire block of exited thread: its counters are kept in registry, block is deleted
+// ------------------------------------------------------------------------------------ //
+void le::StatsSystem::RetireThreadBlock( StatsThreadBlock* Block )
+{
+	std::unique_lock< std::mutex >		lock( mutex );
+	for ( UInt32_t index = 0, count = blocks.size(); index < count; ++index )
+		if ( blocks[ index ] == Block )
+		{
+			for ( UInt32_t indexStat = 0; indexStat < countStats; ++indexStat )
+				stats[ indexStat ].retired += Block->values[ indexStat ].load( std::memory_order_relaxed );
+
+			blocks.erase( blocks.begin() + index );
+			delete Block;
+			return;
+		}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get shared value of gauge
+// ------------------------------------------------------------------------------------ //
+std::atomic< le::Int64_t >* le::StatsSystem::GetGauge( UInt32_t ID )
+{
+	if ( ID >= STATSSYSTEM_MAX_STATS )		return nullptr;
+	return &gauges[ ID ];
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get value of stat in last frame
+// ------------------------------------------------------------------------------------ //
+le::Int64_t le::StatsSystem::GetValue( UInt32_t ID ) const
+{
+	if ( ID >= countStats )		return 0;
+	return stats[ ID ].value;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Find stat by name
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::StatsSystem::FindStat( const char* Name ) const
+{
+	std::unique_lock< std::mutex >		lock( mutex );
+	for ( UInt32_t index = 0; index < countStats; ++index )
+		if ( stats[ index ].name == Name )
+			return index;
+
+	return STATSSYSTEM_INVALID_STAT;
+}
+
+// ------------------------------------------------------------------------------------ //
+// End frame: collect blocks of threads
+// ------------------------------------------------------------------------------------ //
+void le::StatsSystem::EndFrame()
+{
+	{
+		std::unique_lock< std::mutex >		lock( mutex );
+		for ( UInt32_t indexStat = 0; indexStat < countStats; ++indexStat )
+		{
+			StatInfo&		stat = stats[ indexStat ];
+			if ( stat.type == ST_GAUGE )
+			{
+				stat.value = gauges[ indexStat ].load( std::memory_order_relaxed );
+				continue;
+			}
+
+			// Threads only add to counters, so value of frame is growth of sum
+			Int64_t			sum = stat.retired;
+			for ( UInt32_t indexBlock = 0, countBlocks = blocks.size(); indexBlock < countBlocks; ++indexBlock )
+				sum += blocks[ indexBlock ]->values[ indexStat ].load( std::memory_order_relaxed );
+
+			stat.value = sum - stat.total;
+			stat.total = sum;
+		}
+	}
+
+	++countFrames;
+	if ( csvFile.is_open() )		WriteCSV();
+	if ( isOverlay )				UpdateOverlay();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Print stats of last frame
+// ------------------------------------------------------------------------------------ //
+void le::StatsSystem::Dump() const
+{
+	g_consoleSystem->PrintInfo( "** Stats of frame %i **", countFrames );
+	for ( UInt32_t index = 0; index < countStats; ++index )
+		g_consoleSystem->PrintInfo( "%s : %lld", stats[ index ].name.c_str(), stats[ index ].value );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Start writing stats to CSV file
+// ------------------------------------------------------------------------------------ //
+bool le::StatsSystem::StartCSV( const char* Path )
+{
+	StopCSV();
+
+	csvFile.open( Path );
+	if ( !csvFile.is_open() )
+	{
+		g_consoleSystem->PrintError( "Stats file [%s] not created", Path );
+		return false;
+	}
+
+	csvCountStats = 0;
+	g_consoleSystem->PrintInfo( "Writing stats to [%s] started", Path );
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Stop writing stats to CSV file
+// ------------------------------------------------------------------------------------ //
+void le::StatsSystem::StopCSV()
+{
+	if ( !csvFile.is_open() )		return;
+
+	csvFile.close();
+	g_consoleSystem->PrintInfo( "Writing stats stopped" );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Enable or disable overlay
+// ------------------------------------------------------------------------------------ //
+void le::StatsSystem::SetOverlay( bool IsEnabled )
+{
+	isOverlay = IsEnabled;
+	overlayTime = std::chrono::steady_clock::time_point();
+
+	// Title of game is restored when overlay is disabled
+	IWindow*		window = g_engine ? g_engine->GetWindow() : nullptr;
+	if ( !isOverlay && window && window->IsOpen() && g_engine->GetGameInfo().title )
+		window->SetTitle( g_engine->GetGameInfo().title );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Write row of frame to CSV file
+// ------------------------------------------------------------------------------------ //
+void le::StatsSystem::WriteCSV()
+{
+	// Columns are fixed by stats registered before first row
+	if ( csvCountStats == 0 )
+	{
+		csvCountStats = countStats;
+		csvFile << "frame";
+		for ( UInt32_t index = 0; index < csvCountStats; ++index )
+			csvFile << "," << stats[ index ].name;
+
+		csvFile << "\n";
+	}
+
+	csvFile << countFrames;
+	for ( UInt32_t index = 0; index < csvCountStats; ++index )
+		csvFile << "," << stats[ index ].value;
+
+	csvFile << "\n";
+}
+
+// ------------------------------------------------------------------------------------ //
+// Show stats in title of window. Renderer has no text output yet, title is updated
+// not often than interval, because it's slow call of OS
+// ------------------------------------------------------------------------------------ //
+void le::StatsSystem::UpdateOverlay()
+{
+	IWindow*		window = g_engine ? g_engine->GetWindow() : nullptr;
+	if ( !window || !window->IsOpen() )		return;
+
+	auto			currentTime = std::chrono::steady_clock::now();
+	if ( currentTime - overlayTime < std::chrono::milliseconds( STATSSYSTEM_OVERLAY_INTERVAL ) )		return;
+	overlayTime = currentTime;
+
+	char			buffer[ 64 ];
+	overlayText = g_engine->GetGameInfo().title ? g_engine->GetGameInfo().title : "";
+
+	for ( UInt32_t index = 0; index < countStats; ++index )
+	{
+		snprintf( buffer, 64, ": %lld", stats[ index ].value );
+		overlayText += index == 0 ? " | " : ", ";
+		overlayText += stats[ index ].name;
+		overlayText += buffer;
+	}
+
+	window->SetTitle( overlayText.c_str() );
+}
@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef STATSSYSTEM_H
+#define STATSSYSTEM_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+#include "common/types.h"
+#include "engine/istatssystem.h"
+
+//---------------------------------------------------------------------//
+
+#define STATSSYSTEM_OVERLAY_INTERVAL		500			// In milliseconds
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Registry of named counters and gauges. Modules add counters into blocks of their threads,
+	// at end of frame blocks are summed and counters give delta to previous frame. Gauges are
+	// shared values, frame takes last set one
+	class StatsSystem : public IStatsSystem
+	{
+	public:
+		// IStatsSystem
+		virtual UInt32_t				RegisterStat( const char* Name, STAT_TYPE Type );
+		virtual StatsThreadBlock*		GetThreadBlock();
+		virtual std::atomic< Int64_t >*	GetGauge( UInt32_t ID );
+		virtual Int64_t					GetValue( UInt32_t ID ) const;
+		virtual UInt32_t				FindStat( const char* Name ) const;
+
+		// StatsSystem
+		StatsSystem();
+		~StatsSystem();
+
+		void							Initialize();
+		void							EndFrame();
+		void							RetireThreadBlock( StatsThreadBlock* Block );
+		void							Dump() const;
+		bool							StartCSV( const char* Path );
+		void							StopCSV();
+		void							SetOverlay( bool IsEnabled );
+
+	private:
+		struct StatInfo
+		{
+			std::string			name;
+			STAT_TYPE			type;
+			Int64_t				total;
+			Int64_t				retired;			// Sum of counter in blocks of exited threads
+			Int64_t				value;
+		};
+
+		void							WriteCSV();
+		void							UpdateOverlay();
+
+		mutable std::mutex						mutex;
+		std::vector< StatsThreadBlock* >		blocks;
+		StatInfo								stats[ STATSSYSTEM_MAX_STATS ];
+		std::atomic< Int64_t >					gauges[ STATSSYSTEM_MAX_STATS ];
+		UInt32_t								countStats;
+		UInt32_t								countFrames;
+
+		std::ofstream							csvFile;
+		UInt32_t								csvCountStats;
+
+		bool									isOverlay;
+		std::string								overlayText;
+		std::chrono::steady_clock::time_point	overlayTime;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !STATSSYSTEM_H
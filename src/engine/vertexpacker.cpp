@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#	include <emmintrin.h>
+#	define VERTEXPACKER_SSE2
+#endif // _M_X64 || _M_IX86 || __SSE2__
+
+#include "engine/iconsolesystem.h"
+
+#include "global.h"
+#include "consolesystem.h"
+#include "vertexpacker.h"
+
+#ifdef VERTEXPACKER_SSE2
+// ------------------------------------------------------------------------------------ //
+// Convert four floats to half floats. Result in low 16 bits of each lane
+// ------------------------------------------------------------------------------------ //
+inline __m128i VertexPacker_FloatToHalf_SSE2( __m128 Value )
+{
+	const __m128i		maskSign = _mm_set1_epi32( 0x80000000 );
+	const __m128i		maskRound = _mm_set1_epi32( ~0xFFF );
+	const __m128i		f32Infinity = _mm_set1_epi32( 255 << 23 );
+	const __m128i		magic = _mm_set1_epi32( 15 << 23 );
+	const __m128i		nanBit = _mm_set1_epi32( 0x200 );
+	const __m128i		f16Infinity = _mm_set1_epi32( 0x7C00 );
+	const __m128i		clamp = _mm_set1_epi32( ( 31 << 23 ) - 0x1000 );
+
+	__m128				sign = _mm_and_ps( _mm_castsi128_ps( maskSign ), Value );
+	__m128				absValue = _mm_xor_ps( Value, sign );
+	__m128i				absValueInt = _mm_castps_si128( absValue );
+
+	// NaN and infinity
+	__m128i				isNan = _mm_cmpgt_epi32( absValueInt, f32Infinity );
+	__m128i				isNormal = _mm_cmpgt_epi32( f32Infinity, absValueInt );
+	__m128i				infinityOrNan = _mm_or_si128( _mm_and_si128( isNan, nanBit ), f16Infinity );
+
+	// Rebias exponent with magic multiply, overflow is clamped to infinity
+	__m128				noSticky = _mm_and_ps( absValue, _mm_castsi128_ps( maskRound ) );
+	__m128				scaled = _mm_mul_ps( noSticky, _mm_castsi128_ps( magic ) );
+	__m128				clamped = _mm_min_ps( scaled, _mm_castsi128_ps( clamp ) );
+	__m128i				biased = _mm_sub_epi32( _mm_castps_si128( clamped ), maskRound );
+	__m128i				normal = _mm_and_si128( _mm_srli_epi32( biased, 13 ), isNormal );
+	__m128i				notNormal = _mm_andnot_si128( isNormal, infinityOrNan );
+
+	return _mm_or_si128( _mm_or_si128( normal, notNormal ), _mm_srli_epi32( _mm_castps_si128( sign ), 16 ) );
+}
+#else
+// ------------------------------------------------------------------------------------ //
+// Convert float to half float
+// ------------------------------------------------------------------------------------ //
+inline le::UInt16_t VertexPacker_FloatToHalf( float Value )
+{
+	le::UInt32_t		bits;
+	memcpy( &bits, &Value, sizeof( float ) );
+
+	le::UInt32_t		sign = ( bits >> 16 ) & 0x8000;
+	le::Int32_t			exponent = ( ( bits >> 23 ) & 0xFF ) - 127 + 15;
+	le::UInt32_t		mantissa = bits & 0x7FFFFF;
+
+	if ( ( ( bits >> 23 ) & 0xFF ) == 0xFF )		return sign | 0x7C00 | ( mantissa ? 0x200 : 0 );
+	if ( exponent >= 31 )							return sign | 0x7C00;
+	if ( exponent <= 0 )
+	{
+		if ( exponent < -10 )		return sign;
+
+		mantissa |= 0x800000;
+		return sign | ( ( mantissa >> ( 14 - exponent ) ) + ( ( mantissa >> ( 13 - exponent ) ) & 1 ) );
+	}
+
+	return sign | ( ( exponent << 10 ) + ( mantissa >> 13 ) + ( ( mantissa >> 12 ) & 1 ) );
+}
+#endif // VERTEXPACKER_SSE2
+
+// ------------------------------------------------------------------------------------ //
+// Convert floats to half floats
+// ------------------------------------------------------------------------------------ //
+void le::VertexPacker::FloatToHalf( const float* Source, UInt16_t* Destination, UInt32_t Count )
+{
+#ifdef VERTEXPACKER_SSE2
+	UInt32_t			result[ 4 ];
+	float				tail[ 4 ] = { 0.f, 0.f, 0.f, 0.f };
+
+	for ( UInt32_t index = 0; index < Count; index += 4 )
+	{
+		UInt32_t		countValues = Count - index < 4 ? Count - index : 4;
+		__m128			values;
+
+		if ( countValues == 4 )
+			values = _mm_loadu_ps( Source + index );
+		else
+		{
+			memcpy( tail, Source + index, countValues * sizeof( float ) );
+			values = _mm_loadu_ps( tail );
+		}
+
+		_mm_storeu_si128( ( __m128i* ) result, VertexPacker_FloatToHalf_SSE2( values ) );
+		for ( UInt32_t value = 0; value < countValues; ++value )
+			Destination[ index + value ] = ( UInt16_t ) result[ value ];
+	}
+#else
+	for ( UInt32_t index = 0; index < Count; ++index )
+		Destination[ index ] = VertexPacker_FloatToHalf( Source[ index ] );
+#endif // VERTEXPACKER_SSE2
+}
+
+// ------------------------------------------------------------------------------------ //
+// Pack vector to signed normalized 10:10:10:2
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::VertexPacker::PackSnorm1010102( const Vector4D_t& Value )
+{
+	Int32_t				components[ 4 ];
+
+#ifdef VERTEXPACKER_SSE2
+	__m128				values = _mm_loadu_ps( &Value.x );
+	values = _mm_min_ps( _mm_max_ps( values, _mm_set1_ps( -1.f ) ), _mm_set1_ps( 1.f ) );
+	values = _mm_mul_ps( values, _mm_setr_ps( 511.f, 511.f, 511.f, 1.f ) );
+	_mm_storeu_si128( ( __m128i* ) components, _mm_cvtps_epi32( values ) );
+#else
+	for ( UInt32_t index = 0; index < 4; ++index )
+	{
+		float			value = glm::clamp( Value[ index ], -1.f, 1.f ) * ( index < 3 ? 511.f : 1.f );
+		components[ index ] = ( Int32_t ) glm::round( value );
+	}
+#endif // VERTEXPACKER_SSE2
+
+	return	( ( UInt32_t ) components[ 0 ] & 0x3FF ) |
+			( ( ( UInt32_t ) components[ 1 ] & 0x3FF ) << 10 ) |
+			( ( ( UInt32_t ) components[ 2 ] & 0x3FF ) << 20 ) |
+			( ( ( UInt32_t ) components[ 3 ] & 0x3 ) << 30 );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Print report about packed vertex format
+// ------------------------------------------------------------------------------------ //
+void le::VertexPacker::PrintReport( const char* Name, UInt32_t CountVerteces, UInt32_t CountIndeces, UInt32_t SourceStride, UInt32_t PackedStride )
+{
+	// Vertex fetch of geometry pass is estimated without post transform cache: one fetch per index
+	g_consoleSystem->PrintInfo( "Vertex format of [%s]: %i verteces, stride %i -> %i bytes, memory %.1f -> %.1f KB, geometry pass fetch %.1f -> %.1f KB per draw",
+								Name, CountVerteces, SourceStride, PackedStride,
+								CountVerteces * SourceStride / 1024.f, CountVerteces * PackedStride / 1024.f,
+								CountIndeces * SourceStride / 1024.f, CountIndeces * PackedStride / 1024.f );
+}
@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef VERTEXPACKER_H
+#define VERTEXPACKER_H
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	class VertexPacker
+	{
+	public:
+		// Convert floats to IEEE half floats, four at a time
+		static void				FloatToHalf( const float* Source, UInt16_t* Destination, UInt32_t Count );
+
+		// Pack vector to signed normalized 10:10:10:2 (GL_INT_2_10_10_10_REV), W is sign of bitangent
+		static UInt32_t			PackSnorm1010102( const Vector4D_t& Value );
+
+		// Print size of vertex data and vertex fetch of geometry pass before and after packing
+		static void				PrintReport( const char* Name, UInt32_t CountVerteces, UInt32_t CountIndeces, UInt32_t SourceStride, UInt32_t PackedStride );
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !VERTEXPACKER_H
@@ -86,7 +86,16 @@ int WINAPI WinMain( HINSTANCE hInst, HINSTANCE hPreInst, LPSTR lpCmdLine, int nC
 			// Парсим аргументы запуска и меняем конфигурации
 			for ( int index = 0; index < argc; ++index )
 			{
-				if ( ( strstr( argv[ index ], "-game" ) || strstr( argv[ index ], "-g" ) ) && index + 1 < argc )
+				if ( strstr( argv[ index ], "-dedicated" ) )
+					configurations.isHeadless = true;
+				else if ( strstr( argv[ index ], "-compactgbuffer" ) )
+					configurations.isCompactGBuffer = true;
+				else if ( strstr( argv[ index ], "-tickrate" ) && index + 1 < argc )
+				{
+					configurations.tickRate = atoi( argv[ index + 1 ] );
+					++index;
+				}
+				else if ( ( strstr( argv[ index ], "-game" ) || strstr( argv[ index ], "-g" ) ) && index + 1 < argc )
 				{
 					gameDir = argv[ index + 1 ];
 					++index;
@@ -0,0 +1,157 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include <thread>
+
+#include "engine/bsp.h"
+#include "portalbuilder.h"
+#include "portalflow.h"
+
+// ------------------------------------------------------------------------------------ //
+// Copy lump of BSP file into array
+// ------------------------------------------------------------------------------------ //
+template< typename Type_t >
+static void ReadLump( const std::vector< le::Byte_t >& File, const le::BSPLump& Lump, std::vector< Type_t >& Array )
+{
+	Array.resize( Lump.length / sizeof( Type_t ) );
+	if ( !Array.empty() )
+		memcpy( Array.data(), File.data() + Lump.offset, Array.size() * sizeof( Type_t ) );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Print usage
+// ------------------------------------------------------------------------------------ //
+static void PrintUsage()
+{
+	printf( "Usage: levelvis [-fast] [-threads <count>] <input.bsp> [output.bsp]\n" );
+	printf( "  -fast       approximate vis, only flood through portals facing each other\n" );
+	printf( "  -threads    count of worker threads, by default all cores are used\n" );
+	printf( "Vis lump is written into output map, by default into input map\n" );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Entry point
+// ------------------------------------------------------------------------------------ //
+int main( int CountArguments, char** Arguments )
+{
+	bool				isFast = false;
+	le::UInt32_t		countThreads = std::thread::hardware_concurrency();
+	std::string			inputPath;
+	std::string			outputPath;
+
+	for ( int index = 1; index < CountArguments; ++index )
+	{
+		if ( !strcmp( Arguments[ index ], "-fast" ) )
+			isFast = true;
+		else if ( !strcmp( Arguments[ index ], "-threads" ) && index + 1 < CountArguments )
+			countThreads = atoi( Arguments[ ++index ] );
+		else if ( inputPath.empty() )
+			inputPath = Arguments[ index ];
+		else if ( outputPath.empty() )
+			outputPath = Arguments[ index ];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if ( inputPath.empty() )
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if ( outputPath.empty() )		outputPath = inputPath;
+	if ( countThreads < 1 )			countThreads = 1;
+
+	// Read whole map, vis lump is appended to it
+	std::ifstream			inputFile( inputPath, std::ios::binary | std::ios::ate );
+	if ( !inputFile.is_open() )
+	{
+		printf( "Error: map %s not found\n", inputPath.c_str() );
+		return 1;
+	}
+
+	std::vector< le::Byte_t >		file( ( size_t ) inputFile.tellg() );
+	inputFile.seekg( 0, std::ios::beg );
+	inputFile.read( ( char* ) file.data(), file.size() );
+	inputFile.close();
+
+	le::BSPHeader		bspHeader;
+	le::BSPLump			bspLumps[ le::BL_MAX_LUMPS ];
+
+	if ( file.size() < sizeof( le::BSPHeader ) + sizeof( bspLumps ) )
+	{
+		printf( "Error: map %s is broken\n", inputPath.c_str() );
+		return 1;
+	}
+
+	memcpy( &bspHeader, file.data(), sizeof( le::BSPHeader ) );
+	memcpy( bspLumps, file.data() + sizeof( le::BSPHeader ), sizeof( bspLumps ) );
+
+	if ( std::string( bspHeader.strID, 4 ) != "IBSP" || bspHeader.version != 46 )
+	{
+		printf( "Error: not supported format bsp or version\n" );
+		return 1;
+	}
+
+	std::vector< le::BSPPlane >		planes;
+	std::vector< le::BSPNode >		nodes;
+	std::vector< le::BSPLeaf >		leafs;
+
+	ReadLump( file, bspLumps[ le::BL_PLANES ], planes );
+	ReadLump( file, bspLumps[ le::BL_NODES ], nodes );
+	ReadLump( file, bspLumps[ le::BL_LEAFS ], leafs );
+
+	auto						startTime = std::chrono::steady_clock::now();
+	le::PortalBuilder			portalBuilder;
+	le::PortalFlow				portalFlow;
+	std::vector< le::Byte_t >	visData;
+
+	portalBuilder.Build( nodes, planes, leafs );
+	printf( "%u clusters, %u portals\n", portalBuilder.GetCountClusters(), ( le::UInt32_t ) portalBuilder.GetPortals().size() / 2 );
+
+	portalFlow.Compute( portalBuilder.GetPortals(), portalBuilder.GetCountClusters(), isFast, countThreads );
+	portalFlow.GetVisData( visData );
+
+	printf( "%s vis on %u threads: %.2f sec, average %.1f visible clusters\n", isFast ? "Fast" : "Full", countThreads,
+			std::chrono::duration< double >( std::chrono::steady_clock::now() - startTime ).count(), portalFlow.GetAverageVisible() );
+
+	// Old vis lump at end of file is replaced, otherwise new lump is appended
+	le::BSPLump&		visLump = bspLumps[ le::BL_VIS_DATA ];
+	if ( visLump.length > 0 && ( size_t ) ( visLump.offset + visLump.length ) == file.size() )
+		file.resize( visLump.offset );
+
+	file.resize( ( file.size() + 3 ) & ~( size_t ) 3, 0 );
+	visLump.offset = file.size();
+	visLump.length = visData.size();
+
+	file.insert( file.end(), visData.begin(), visData.end() );
+	memcpy( file.data() + sizeof( le::BSPHeader ), bspLumps, sizeof( bspLumps ) );
+
+	std::ofstream			outputFile( outputPath, std::ios::binary | std::ios::trunc );
+	if ( !outputFile.is_open() )
+	{
+		printf( "Error: failed to write map %s\n", outputPath.c_str() );
+		return 1;
+	}
+
+	outputFile.write( ( const char* ) file.data(), file.size() );
+	printf( "Vis lump written to %s (%u bytes)\n", outputPath.c_str(), ( le::UInt32_t ) visData.size() );
+	return 0;
+}
@@ -0,0 +1,299 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "portalbuilder.h"
+
+// Space between world bounds and head portals
+#define PORTALBUILDER_SIDE_SPACE		8.0
+
+// Epsilon for clipping and splitting of tree portals
+#define PORTALBUILDER_EPSILON			0.001
+
+// Epsilon for clipping new portal by portals of its node
+#define PORTALBUILDER_CLIP_EPSILON		0.1
+
+// Portal without at least three edges of this length is dropped
+#define PORTALBUILDER_EDGE_LENGTH		0.2
+
+// ------------------------------------------------------------------------------------ //
+// Is portal too small to see through
+// ------------------------------------------------------------------------------------ //
+static bool IsTinyWinding( const le::Winding& Winding )
+{
+	le::UInt32_t		countEdges = 0;
+	for ( le::UInt32_t index = 0, count = Winding.points.size(); index < count; ++index )
+		if ( glm::length( Winding.points[ ( index + 1 ) % count ] - Winding.points[ index ] ) > PORTALBUILDER_EDGE_LENGTH )
+			if ( ++countEdges == 3 )
+				return false;
+
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Build portals
+// ------------------------------------------------------------------------------------ //
+void le::PortalBuilder::Build( const std::vector< BSPNode >& Nodes, const std::vector< BSPPlane >& Planes, const std::vector< BSPLeaf >& Leafs )
+{
+	countNodes = Nodes.size();
+	countLeafs = Leafs.size();
+	countClusters = 0;
+	bspNodes = &Nodes;
+
+	nodePlanes.resize( countNodes );
+	nodeParents.assign( countNodes + countLeafs + 1, -1 );
+	nodePortals.assign( countNodes + countLeafs + 1, std::vector< UInt32_t >() );
+	treePortals.clear();
+	visPortals.clear();
+
+	for ( UInt32_t index = 0; index < countLeafs; ++index )
+		countClusters = glm::max( countClusters, ( UInt32_t ) ( Leafs[ index ].cluster + 1 ) );
+
+	if ( Nodes.empty() )		return;
+
+	for ( UInt32_t index = 0; index < countNodes; ++index )
+	{
+		const BSPPlane&		plane = Planes[ Nodes[ index ].plane ];
+		nodePlanes[ index ].normal = glm::dvec3( plane.normal );
+		nodePlanes[ index ].distance = plane.distance;
+
+		for ( UInt32_t side = 0; side < 2; ++side )
+			nodeParents[ GetChild( index, side ) ] = index;
+	}
+
+	MakeHeadPortals( glm::dvec3( Nodes[ 0 ].min ), glm::dvec3( Nodes[ 0 ].max ) );
+	MakeTreePortals( 0 );
+
+	// Keep portals between two different clusters, each one gives portal for both directions
+	for ( UInt32_t index = 0, count = treePortals.size(); index < count; ++index )
+	{
+		const TreePortal&		treePortal = treePortals[ index ];
+		if ( treePortal.winding.IsEmpty() || treePortal.nodes[ 0 ] < countNodes || treePortal.nodes[ 1 ] < countNodes ||
+			 treePortal.nodes[ 0 ] >= countNodes + countLeafs || treePortal.nodes[ 1 ] >= countNodes + countLeafs )
+			continue;
+
+		int			frontCluster = Leafs[ treePortal.nodes[ 0 ] - countNodes ].cluster;
+		int			backCluster = Leafs[ treePortal.nodes[ 1 ] - countNodes ].cluster;
+		if ( frontCluster < 0 || backCluster < 0 || frontCluster == backCluster )
+			continue;
+
+		VisPortal		visPortal;
+		visPortal.winding = treePortal.winding;
+		visPortal.plane = treePortal.plane;
+		visPortal.origin = visPortal.winding.GetCenter();
+		visPortal.radius = visPortal.winding.GetRadius( visPortal.origin );
+		visPortal.cluster = frontCluster;
+		visPortal.ownerCluster = backCluster;
+		visPortals.push_back( visPortal );
+
+		visPortal.winding.Reverse();
+		visPortal.plane.normal = -visPortal.plane.normal;
+		visPortal.plane.distance = -visPortal.plane.distance;
+		visPortal.cluster = backCluster;
+		visPortal.ownerCluster = frontCluster;
+		visPortals.push_back( visPortal );
+	}
+
+	treePortals.clear();
+	nodePortals.clear();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Make six portals between head node and outside of world
+// ------------------------------------------------------------------------------------ //
+void le::PortalBuilder::MakeHeadPortals( const glm::dvec3& Min, const glm::dvec3& Max )
+{
+	UInt32_t		outsideNode = countNodes + countLeafs;
+	UInt32_t		firstPortal = treePortals.size();
+	glm::dvec3		bounds[ 2 ] = { Min - PORTALBUILDER_SIDE_SPACE, Max + PORTALBUILDER_SIDE_SPACE };
+
+	// Planes look inside of world, so head node is on front side
+	for ( UInt32_t axis = 0; axis < 3; ++axis )
+		for ( UInt32_t side = 0; side < 2; ++side )
+		{
+			TreePortal		treePortal;
+			treePortal.plane.normal = glm::dvec3( 0.0 );
+			treePortal.plane.normal[ axis ] = side ? -1.0 : 1.0;
+			treePortal.plane.distance = side ? -bounds[ 1 ][ axis ] : bounds[ 0 ][ axis ];
+			treePortal.winding.MakeBase( treePortal.plane );
+
+			treePortals.push_back( treePortal );
+			AddPortal( treePortals.size() - 1, 0, outsideNode );
+		}
+
+	for ( UInt32_t index = firstPortal, count = treePortals.size(); index < count; ++index )
+		for ( UInt32_t indexPlane = firstPortal; indexPlane < count; ++indexPlane )
+			if ( index != indexPlane )
+				treePortals[ index ].winding.Chop( treePortals[ indexPlane ].plane, PORTALBUILDER_EPSILON );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Make portals for node and all its children
+// ------------------------------------------------------------------------------------ //
+void le::PortalBuilder::MakeTreePortals( UInt32_t Node )
+{
+	std::vector< UInt32_t >		stackNodes;
+	stackNodes.push_back( Node );
+
+	// Parent is always processed before children, order of siblings does not matter
+	while ( !stackNodes.empty() )
+	{
+		UInt32_t		node = stackNodes.back();
+		stackNodes.pop_back();
+
+		MakeNodePortal( node );
+		SplitNodePortals( node );
+
+		for ( UInt32_t side = 0; side < 2; ++side )
+		{
+			UInt32_t		child = GetChild( node, side );
+			if ( child < countNodes )		stackNodes.push_back( child );
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Make portal on plane of node between its children
+// ------------------------------------------------------------------------------------ //
+void le::PortalBuilder::MakeNodePortal( UInt32_t Node )
+{
+	Winding			winding;
+	winding.MakeBase( nodePlanes[ Node ] );
+
+	// Clip by planes of parents to get cross section of node cell
+	for ( UInt32_t child = Node; nodeParents[ child ] >= 0 && !winding.IsEmpty(); child = nodeParents[ child ] )
+	{
+		UInt32_t		parent = nodeParents[ child ];
+		VisPlane		plane = nodePlanes[ parent ];
+
+		if ( GetChild( parent, 1 ) == child )
+		{
+			plane.normal = -plane.normal;
+			plane.distance = -plane.distance;
+		}
+
+		winding.Chop( plane, PORTALBUILDER_EPSILON );
+	}
+
+	// Clip by portals that bound the cell
+	const std::vector< UInt32_t >&		portals = nodePortals[ Node ];
+	for ( UInt32_t index = 0, count = portals.size(); index < count && !winding.IsEmpty(); ++index )
+	{
+		const TreePortal&		treePortal = treePortals[ portals[ index ] ];
+		VisPlane				plane = treePortal.plane;
+
+		if ( treePortal.nodes[ 1 ] == Node )
+		{
+			plane.normal = -plane.normal;
+			plane.distance = -plane.distance;
+		}
+
+		winding.Chop( plane, PORTALBUILDER_CLIP_EPSILON );
+	}
+
+	if ( winding.IsEmpty() || IsTinyWinding( winding ) )
+		return;
+
+	TreePortal		treePortal;
+	treePortal.winding = winding;
+	treePortal.plane = nodePlanes[ Node ];
+
+	treePortals.push_back( treePortal );
+	AddPortal( treePortals.size() - 1, GetChild( Node, 0 ), GetChild( Node, 1 ) );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Move portals of node to its children, portals crossing plane of node are split
+// ------------------------------------------------------------------------------------ //
+void le::PortalBuilder::SplitNodePortals( UInt32_t Node )
+{
+	std::vector< UInt32_t >		portals;
+	UInt32_t					frontChild = GetChild( Node, 0 );
+	UInt32_t					backChild = GetChild( Node, 1 );
+
+	portals.swap( nodePortals[ Node ] );
+
+	for ( UInt32_t index = 0, count = portals.size(); index < count; ++index )
+	{
+		UInt32_t		portal = portals[ index ];
+		UInt32_t		side = treePortals[ portal ].nodes[ 0 ] == Node ? 0 : 1;
+		UInt32_t		otherNode = treePortals[ portal ].nodes[ side ^ 1 ];
+		Winding			frontWinding;
+		Winding			backWinding;
+
+		RemovePortal( portal, otherNode );
+		treePortals[ portal ].winding.Split( nodePlanes[ Node ], PORTALBUILDER_EPSILON, frontWinding, backWinding );
+
+		if ( !frontWinding.IsEmpty() && IsTinyWinding( frontWinding ) )		frontWinding.points.clear();
+		if ( !backWinding.IsEmpty() && IsTinyWinding( backWinding ) )		backWinding.points.clear();
+
+		if ( frontWinding.IsEmpty() && backWinding.IsEmpty() )
+			continue;
+
+		if ( !frontWinding.IsEmpty() && !backWinding.IsEmpty() )
+		{
+			TreePortal		newPortal = treePortals[ portal ];
+			newPortal.winding = backWinding;
+			treePortals[ portal ].winding = frontWinding;
+			treePortals.push_back( newPortal );
+
+			UInt32_t		backPortal = treePortals.size() - 1;
+			if ( side == 0 )
+			{
+				AddPortal( portal, frontChild, otherNode );
+				AddPortal( backPortal, backChild, otherNode );
+			}
+			else
+			{
+				AddPortal( portal, otherNode, frontChild );
+				AddPortal( backPortal, otherNode, backChild );
+			}
+
+			continue;
+		}
+
+		UInt32_t		child = frontWinding.IsEmpty() ? backChild : frontChild;
+		if ( side == 0 )	AddPortal( portal, child, otherNode );
+		else				AddPortal( portal, otherNode, child );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Link portal with two nodes
+// ------------------------------------------------------------------------------------ //
+void le::PortalBuilder::AddPortal( UInt32_t Portal, UInt32_t FrontNode, UInt32_t BackNode )
+{
+	treePortals[ Portal ].nodes[ 0 ] = FrontNode;
+	treePortals[ Portal ].nodes[ 1 ] = BackNode;
+	nodePortals[ FrontNode ].push_back( Portal );
+	nodePortals[ BackNode ].push_back( Portal );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Unlink portal from node
+// ------------------------------------------------------------------------------------ //
+void le::PortalBuilder::RemovePortal( UInt32_t Portal, UInt32_t Node )
+{
+	std::vector< UInt32_t >&		portals = nodePortals[ Node ];
+	auto							it = std::find( portals.begin(), portals.end(), Portal );
+
+	if ( it != portals.end() )
+		portals.erase( it );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get child of node in shared index space
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::PortalBuilder::GetChild( UInt32_t Node, UInt32_t Side ) const
+{
+	int			child = Side ? ( *bspNodes )[ Node ].back : ( *bspNodes )[ Node ].front;
+	return child >= 0 ? child : countNodes + ( -child - 1 );
+}
@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PORTALBUILDER_H
+#define PORTALBUILDER_H
+
+#include <vector>
+
+#include "common/types.h"
+#include "engine/bsp.h"
+#include "winding.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// One way portal, plane normal points into cluster the portal leads to
+	struct VisPortal
+	{
+		Winding					winding;
+		VisPlane				plane;
+		glm::dvec3				origin;
+		double					radius;
+		int						cluster;
+		int						ownerCluster;
+	};
+
+	//---------------------------------------------------------------------//
+
+	// Cuts BSP tree into convex cells and extracts portals between clusters
+	class PortalBuilder
+	{
+	public:
+		void								Build( const std::vector< BSPNode >& Nodes, const std::vector< BSPPlane >& Planes, const std::vector< BSPLeaf >& Leafs );
+
+		inline std::vector< VisPortal >&	GetPortals()
+		{
+			return visPortals;
+		}
+
+		inline UInt32_t						GetCountClusters() const
+		{
+			return countClusters;
+		}
+
+	private:
+
+		//---------------------------------------------------------------------//
+
+		// Portal between two nodes of tree, nodes[ 0 ] is on front side of plane
+		struct TreePortal
+		{
+			Winding			winding;
+			VisPlane		plane;
+			UInt32_t		nodes[ 2 ];
+		};
+
+		//---------------------------------------------------------------------//
+
+		void								MakeHeadPortals( const glm::dvec3& Min, const glm::dvec3& Max );
+		void								MakeTreePortals( UInt32_t Node );
+		void								MakeNodePortal( UInt32_t Node );
+		void								SplitNodePortals( UInt32_t Node );
+		void								AddPortal( UInt32_t Portal, UInt32_t FrontNode, UInt32_t BackNode );
+		void								RemovePortal( UInt32_t Portal, UInt32_t Node );
+		UInt32_t							GetChild( UInt32_t Node, UInt32_t Side ) const;
+
+		// Nodes of tree and leafs share one index space: leaf N is countNodes + N, outside of world is last
+		UInt32_t										countNodes;
+		UInt32_t										countLeafs;
+		UInt32_t										countClusters;
+		const std::vector< BSPNode >*					bspNodes;
+		std::vector< VisPlane >							nodePlanes;
+		std::vector< int >								nodeParents;
+		std::vector< std::vector< UInt32_t > >			nodePortals;
+		std::vector< TreePortal >						treePortals;
+		std::vector< VisPortal >						visPortals;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !PORTALBUILDER_H
@@ -0,0 +1,419 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <algorithm>
+#include <thread>
+
+#include "portalflow.h"
+
+// Epsilon for classification of points against planes
+#define PORTALFLOW_ON_EPSILON		0.1
+
+// ------------------------------------------------------------------------------------ //
+// Run function for indices [ 0, Count ) on several threads
+// ------------------------------------------------------------------------------------ //
+template< typename Function_t >
+static void RunParallel( le::UInt32_t Count, le::UInt32_t CountThreads, Function_t Function )
+{
+	std::atomic< le::UInt32_t >		nextIndex( 0 );
+	std::vector< std::thread >		threads;
+
+	auto							worker = [ & ]()
+	{
+		for ( le::UInt32_t index = nextIndex++; index < Count; index = nextIndex++ )
+			Function( index );
+	};
+
+	for ( le::UInt32_t indexThread = 1; indexThread < CountThreads; ++indexThread )
+		threads.push_back( std::thread( worker ) );
+
+	worker();
+
+	for ( le::UInt32_t index = 0, count = threads.size(); index < count; ++index )
+		threads[ index ].join();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Count of set bits
+// ------------------------------------------------------------------------------------ //
+static le::UInt32_t CountBits( const std::vector< le::UInt64_t >& Bits )
+{
+	le::UInt32_t		count = 0;
+	for ( le::UInt32_t index = 0, countWords = Bits.size(); index < countWords; ++index )
+		for ( le::UInt64_t word = Bits[ index ]; word; word &= word - 1 )
+			++count;
+
+	return count;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Compute visibility
+// ------------------------------------------------------------------------------------ //
+void le::PortalFlow::Compute( const std::vector< VisPortal >& Portals, UInt32_t CountClusters, bool IsFast, UInt32_t CountThreads )
+{
+	UInt32_t		countPortals = Portals.size();
+
+	portals = &Portals;
+	countClusters = CountClusters;
+	countWords = ( countPortals + 63 ) / 64;
+	bytesPerCluster = ( ( countClusters + 63 ) & ~63 ) >> 3;
+
+	clusterPortals.assign( countClusters, std::vector< UInt32_t >() );
+	for ( UInt32_t index = 0; index < countPortals; ++index )
+		clusterPortals[ Portals[ index ].ownerCluster ].push_back( index );
+
+	portalMightSee.assign( countPortals, PortalBits_t( countWords, 0 ) );
+	portalVis.assign( countPortals, PortalBits_t( countWords, 0 ) );
+
+	std::vector< std::atomic< bool > >		done( countPortals );
+	portalDone.swap( done );
+	for ( UInt32_t index = 0; index < countPortals; ++index )
+		portalDone[ index ] = false;
+
+	RunParallel( countPortals, CountThreads, [ this ]( UInt32_t Index ) { BasePortalVis( Index ); } );
+
+	if ( IsFast )
+		portalVis = portalMightSee;
+	else
+	{
+		// Portals that can see less are done first, their results narrow flow of the rest
+		std::vector< UInt32_t >		order( countPortals );
+		std::vector< UInt32_t >		countMightSee( countPortals );
+
+		for ( UInt32_t index = 0; index < countPortals; ++index )
+		{
+			order[ index ] = index;
+			countMightSee[ index ] = CountBits( portalMightSee[ index ] );
+		}
+
+		std::stable_sort( order.begin(), order.end(), [ & ]( UInt32_t Left, UInt32_t Right ) { return countMightSee[ Left ] < countMightSee[ Right ]; } );
+		RunParallel( countPortals, CountThreads, [ & ]( UInt32_t Index ) { FlowPortal( order[ Index ] ); } );
+	}
+
+	ClusterMerge();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get vis data in format of BSP lump
+// ------------------------------------------------------------------------------------ //
+void le::PortalFlow::GetVisData( std::vector< Byte_t >& VisData ) const
+{
+	int			header[ 2 ] = { ( int ) countClusters, ( int ) bytesPerCluster };
+
+	VisData.resize( sizeof( header ) + clusterVis.size() );
+	memcpy( VisData.data(), header, sizeof( header ) );
+
+	if ( !clusterVis.empty() )
+		memcpy( VisData.data() + sizeof( header ), clusterVis.data(), clusterVis.size() );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get average count of visible clusters
+// ------------------------------------------------------------------------------------ //
+float le::PortalFlow::GetAverageVisible() const
+{
+	if ( !countClusters )		return 0.f;
+
+	UInt32_t		countVisible = 0;
+	for ( UInt32_t index = 0, count = clusterVis.size(); index < count; ++index )
+		for ( Byte_t byte = clusterVis[ index ]; byte; byte &= byte - 1 )
+			++countVisible;
+
+	return ( float ) countVisible / countClusters;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Find portals that portal can possibly see
+// ------------------------------------------------------------------------------------ //
+void le::PortalFlow::BasePortalVis( UInt32_t Portal )
+{
+	const VisPortal&		portal = ( *portals )[ Portal ];
+	PortalBits_t			portalFront( countWords, 0 );
+
+	for ( UInt32_t index = 0, count = portals->size(); index < count; ++index )
+	{
+		if ( index == Portal )		continue;
+		const VisPortal&		testPortal = ( *portals )[ index ];
+
+		// Test portal must have point in front of portal and portal must have point behind test portal
+		bool		isFront = false;
+		for ( UInt32_t indexPoint = 0, countPoints = testPortal.winding.points.size(); indexPoint < countPoints && !isFront; ++indexPoint )
+			isFront = glm::dot( testPortal.winding.points[ indexPoint ], portal.plane.normal ) - portal.plane.distance > PORTALFLOW_ON_EPSILON;
+
+		if ( !isFront )		continue;
+
+		bool		isBack = false;
+		for ( UInt32_t indexPoint = 0, countPoints = portal.winding.points.size(); indexPoint < countPoints && !isBack; ++indexPoint )
+			isBack = glm::dot( portal.winding.points[ indexPoint ], testPortal.plane.normal ) - testPortal.plane.distance < -PORTALFLOW_ON_EPSILON;
+
+		if ( isBack )		SetBit( portalFront, index );
+	}
+
+	SimpleFlood( Portal, portal.cluster, portalFront );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Flood through portals facing each other
+// ------------------------------------------------------------------------------------ //
+void le::PortalFlow::SimpleFlood( UInt32_t Portal, int Cluster, const PortalBits_t& PortalFront )
+{
+	PortalBits_t&		mightSee = portalMightSee[ Portal ];
+	std::vector< int >	stackClusters;
+
+	stackClusters.push_back( Cluster );
+
+	while ( !stackClusters.empty() )
+	{
+		int				cluster = stackClusters.back();
+		stackClusters.pop_back();
+
+		const std::vector< UInt32_t >&		portalsCluster = clusterPortals[ cluster ];
+		for ( UInt32_t index = 0, count = portalsCluster.size(); index < count; ++index )
+		{
+			UInt32_t		portal = portalsCluster[ index ];
+			if ( !IsBitSet( PortalFront, portal ) || IsBitSet( mightSee, portal ) )
+				continue;
+
+			SetBit( mightSee, portal );
+			stackClusters.push_back( ( *portals )[ portal ].cluster );
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Find portals visible through portal
+// ------------------------------------------------------------------------------------ //
+void le::PortalFlow::FlowPortal( UInt32_t Portal )
+{
+	const VisPortal&		portal = ( *portals )[ Portal ];
+	FlowThread				thread;
+
+	thread.base = Portal;
+	thread.vis = &portalVis[ Portal ];
+	thread.stack.resize( 1 );
+
+	FlowStack&				head = thread.stack[ 0 ];
+	head.cluster = portal.ownerCluster;
+	head.portal = &portal;
+	head.source = portal.winding;
+	head.portalPlane = portal.plane;
+	head.mightSee = portalMightSee[ Portal ];
+
+	RecursiveClusterFlow( portal.cluster, thread, 0 );
+	portalDone[ Portal ].store( true, std::memory_order_release );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Flow through cluster, every step clips windings by separating planes of source and pass portals
+// ------------------------------------------------------------------------------------ //
+void le::PortalFlow::RecursiveClusterFlow( int Cluster, FlowThread& Thread, UInt32_t Depth )
+{
+	// Deque keeps references to previous levels valid while it grows
+	if ( Thread.stack.size() <= Depth + 1 )
+		Thread.stack.resize( Depth + 2 );
+
+	const VisPortal&		base = ( *portals )[ Thread.base ];
+	const FlowStack&		head = Thread.stack[ 0 ];
+	const FlowStack&		previous = Thread.stack[ Depth ];
+	FlowStack&				stack = Thread.stack[ Depth + 1 ];
+	PortalBits_t&			vis = *Thread.vis;
+
+	stack.cluster = Cluster;
+	stack.mightSee.resize( countWords );
+
+	const std::vector< UInt32_t >&		portalsCluster = clusterPortals[ Cluster ];
+	for ( UInt32_t index = 0, count = portalsCluster.size(); index < count; ++index )
+	{
+		UInt32_t			portalIndex = portalsCluster[ index ];
+		const VisPortal&	portal = ( *portals )[ portalIndex ];
+
+		if ( !IsBitSet( previous.mightSee, portalIndex ) )
+			continue;
+
+		// Skip portal if it can not see anything new
+		const PortalBits_t&		test = portalDone[ portalIndex ].load( std::memory_order_acquire ) ? portalVis[ portalIndex ] : portalMightSee[ portalIndex ];
+		UInt64_t				more = 0;
+
+		for ( UInt32_t word = 0; word < countWords; ++word )
+		{
+			stack.mightSee[ word ] = previous.mightSee[ word ] & test[ word ];
+			more |= stack.mightSee[ word ] & ~vis[ word ];
+		}
+
+		if ( !more && IsBitSet( vis, portalIndex ) )
+			continue;
+
+		VisPlane		backPlane = { -portal.plane.normal, -portal.plane.distance };
+		stack.portal = &portal;
+		stack.portalPlane = portal.plane;
+		SetBit( vis, portalIndex );
+
+		// Part of portal in front of source portal
+		double			distance = glm::dot( portal.origin, head.portalPlane.normal ) - head.portalPlane.distance;
+		if ( distance < -portal.radius )
+			continue;
+
+		stack.pass = portal.winding;
+		if ( distance <= portal.radius && !stack.pass.Chop( head.portalPlane, PORTALFLOW_ON_EPSILON ) )
+			continue;
+
+		// Part of source portal behind this portal
+		distance = glm::dot( base.origin, portal.plane.normal ) - portal.plane.distance;
+		if ( distance > base.radius )
+			continue;
+
+		stack.source = previous.source;
+		if ( distance >= -base.radius && !stack.source.Chop( backPlane, PORTALFLOW_ON_EPSILON ) )
+			continue;
+
+		// Portal next to source can be blocked only if coplanar
+		if ( previous.pass.IsEmpty() )
+		{
+			RecursiveClusterFlow( portal.cluster, Thread, Depth + 1 );
+			continue;
+		}
+
+		if ( !stack.pass.Chop( previous.portalPlane, PORTALFLOW_ON_EPSILON ) )
+			continue;
+
+		if ( !ClipToSeparators( stack.source, previous.pass, stack.pass, false ) )
+			continue;
+
+		if ( !ClipToSeparators( previous.pass, stack.source, stack.pass, true ) )
+			continue;
+
+		RecursiveClusterFlow( portal.cluster, Thread, Depth + 1 );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Clip target by planes that separate source and pass portals
+// ------------------------------------------------------------------------------------ //
+bool le::PortalFlow::ClipToSeparators( const Winding& Source, const Winding& Pass, Winding& Target, bool IsFlipClip ) const
+{
+	UInt32_t		countSource = Source.points.size();
+	UInt32_t		countPass = Pass.points.size();
+
+	for ( UInt32_t index = 0; index < countSource; ++index )
+	{
+		UInt32_t			next = ( index + 1 ) % countSource;
+		glm::dvec3			edge = Source.points[ next ] - Source.points[ index ];
+
+		for ( UInt32_t indexPass = 0; indexPass < countPass; ++indexPass )
+		{
+			// Plane through edge of source and point of pass
+			VisPlane		plane;
+			plane.normal = glm::cross( edge, Pass.points[ indexPass ] - Source.points[ index ] );
+
+			double			length = glm::length( plane.normal );
+			if ( length < PORTALFLOW_ON_EPSILON )		continue;
+
+			plane.normal /= length;
+			plane.distance = glm::dot( Pass.points[ indexPass ], plane.normal );
+
+			// Source must be on negative side of plane
+			bool			isFlipTest = false;
+			bool			isPlanar = true;
+
+			for ( UInt32_t indexPoint = 0; indexPoint < countSource; ++indexPoint )
+			{
+				if ( indexPoint == index || indexPoint == next )		continue;
+
+				double		distance = glm::dot( Source.points[ indexPoint ], plane.normal ) - plane.distance;
+				if ( distance < -PORTALFLOW_ON_EPSILON )
+				{
+					isFlipTest = false;
+					isPlanar = false;
+					break;
+				}
+				else if ( distance > PORTALFLOW_ON_EPSILON )
+				{
+					isFlipTest = true;
+					isPlanar = false;
+					break;
+				}
+			}
+
+			if ( isPlanar )		continue;
+
+			if ( isFlipTest )
+			{
+				plane.normal = -plane.normal;
+				plane.distance = -plane.distance;
+			}
+
+			// Plane separates portals if whole pass is on positive side
+			UInt32_t		countFront = 0;
+			bool			isSeparator = true;
+
+			for ( UInt32_t indexPoint = 0; indexPoint < countPass; ++indexPoint )
+			{
+				if ( indexPoint == indexPass )		continue;
+
+				double		distance = glm::dot( Pass.points[ indexPoint ], plane.normal ) - plane.distance;
+				if ( distance < -PORTALFLOW_ON_EPSILON )
+				{
+					isSeparator = false;
+					break;
+				}
+				else if ( distance > PORTALFLOW_ON_EPSILON )
+					++countFront;
+			}
+
+			if ( !isSeparator || !countFront )		continue;
+
+			if ( IsFlipClip )
+			{
+				plane.normal = -plane.normal;
+				plane.distance = -plane.distance;
+			}
+
+			if ( !Target.Chop( plane, PORTALFLOW_ON_EPSILON ) )
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Merge visible portals into visible clusters
+// ------------------------------------------------------------------------------------ //
+void le::PortalFlow::ClusterMerge()
+{
+	PortalBits_t		portalVector( countWords );
+	clusterVis.assign( countClusters * bytesPerCluster, 0 );
+
+	for ( UInt32_t cluster = 0; cluster < countClusters; ++cluster )
+	{
+		Byte_t*								bitset = &clusterVis[ cluster * bytesPerCluster ];
+		const std::vector< UInt32_t >&		portalsCluster = clusterPortals[ cluster ];
+
+		std::fill( portalVector.begin(), portalVector.end(), 0 );
+		for ( UInt32_t index = 0, count = portalsCluster.size(); index < count; ++index )
+		{
+			const PortalBits_t&		vis = portalVis[ portalsCluster[ index ] ];
+			for ( UInt32_t word = 0; word < countWords; ++word )
+				portalVector[ word ] |= vis[ word ];
+
+			SetBit( portalVector, portalsCluster[ index ] );
+		}
+
+		for ( UInt32_t index = 0, count = portals->size(); index < count; ++index )
+			if ( IsBitSet( portalVector, index ) )
+			{
+				int			visibleCluster = ( *portals )[ index ].cluster;
+				bitset[ visibleCluster >> 3 ] |= 1 << ( visibleCluster & 7 );
+			}
+
+		bitset[ cluster >> 3 ] |= 1 << ( cluster & 7 );
+	}
+}
@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef PORTALFLOW_H
+#define PORTALFLOW_H
+
+#include <vector>
+#include <deque>
+#include <atomic>
+
+#include "common/types.h"
+#include "portalbuilder.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Computes potentially visible set of clusters from portals
+	class PortalFlow
+	{
+	public:
+		// In fast mode only flood through portals facing each other is done, without clipping of windings
+		void						Compute( const std::vector< VisPortal >& Portals, UInt32_t CountClusters, bool IsFast, UInt32_t CountThreads );
+
+		// Vis data in format of BSP lump: count of clusters, bytes per cluster, bitsets
+		void						GetVisData( std::vector< Byte_t >& VisData ) const;
+
+		// Average count of clusters visible from cluster
+		float						GetAverageVisible() const;
+
+	private:
+
+		//---------------------------------------------------------------------//
+
+		typedef std::vector< UInt64_t >			PortalBits_t;
+
+		//---------------------------------------------------------------------//
+
+		struct FlowStack
+		{
+			int					cluster;
+			const VisPortal*	portal;
+			Winding				source;
+			Winding				pass;
+			VisPlane			portalPlane;
+			PortalBits_t		mightSee;
+		};
+
+		//---------------------------------------------------------------------//
+
+		struct FlowThread
+		{
+			UInt32_t					base;
+			PortalBits_t*				vis;
+			std::deque< FlowStack >		stack;
+		};
+
+		//---------------------------------------------------------------------//
+
+		void						BasePortalVis( UInt32_t Portal );
+		void						SimpleFlood( UInt32_t Portal, int Cluster, const PortalBits_t& PortalFront );
+		void						FlowPortal( UInt32_t Portal );
+		void						RecursiveClusterFlow( int Cluster, FlowThread& Thread, UInt32_t Depth );
+		bool						ClipToSeparators( const Winding& Source, const Winding& Pass, Winding& Target, bool IsFlipClip ) const;
+		void						ClusterMerge();
+
+		inline bool					IsBitSet( const PortalBits_t& Bits, UInt32_t Index ) const
+		{
+			return ( Bits[ Index >> 6 ] >> ( Index & 63 ) ) & 1;
+		}
+
+		inline void					SetBit( PortalBits_t& Bits, UInt32_t Index ) const
+		{
+			Bits[ Index >> 6 ] |= 1ull << ( Index & 63 );
+		}
+
+		UInt32_t										countClusters;
+		UInt32_t										countWords;
+		UInt32_t										bytesPerCluster;
+		const std::vector< VisPortal >*					portals;
+		std::vector< std::vector< UInt32_t > >			clusterPortals;
+		std::vector< PortalBits_t >						portalMightSee;
+		std::vector< PortalBits_t >						portalVis;
+		std::vector< std::atomic< bool > >				portalDone;
+		std::vector< Byte_t >							clusterVis;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !PORTALFLOW_H
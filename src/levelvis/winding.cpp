@@ -0,0 +1,168 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+
+#include "winding.h"
+
+// ------------------------------------------------------------------------------------ //
+// Make polygon on plane that covers whole world
+// ------------------------------------------------------------------------------------ //
+void le::Winding::MakeBase( const VisPlane& Plane )
+{
+	// Major axis of normal gives up vector that is not parallel to plane
+	glm::dvec3		absNormal = glm::abs( Plane.normal );
+	glm::dvec3		up( 0.0 );
+
+	if ( absNormal.z >= absNormal.x && absNormal.z >= absNormal.y )
+		up.x = 1.0;
+	else
+		up.z = 1.0;
+
+	up = glm::normalize( up - Plane.normal * glm::dot( up, Plane.normal ) );
+
+	glm::dvec3		origin = Plane.normal * Plane.distance;
+	glm::dvec3		right = glm::cross( up, Plane.normal );
+
+	up *= WINDING_MAX_WORLD_COORD;
+	right *= WINDING_MAX_WORLD_COORD;
+
+	points.resize( 4 );
+	points[ 0 ] = origin - right + up;
+	points[ 1 ] = origin + right + up;
+	points[ 2 ] = origin + right - up;
+	points[ 3 ] = origin - right - up;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Keep only part in front of plane
+// ------------------------------------------------------------------------------------ //
+bool le::Winding::Chop( const VisPlane& Plane, double Epsilon )
+{
+	Winding			front;
+	Winding			back;
+
+	Split( Plane, Epsilon, front, back );
+	if ( front.IsEmpty() )
+	{
+		points.clear();
+		return false;
+	}
+
+	points.swap( front.points );
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Split polygon by plane
+// ------------------------------------------------------------------------------------ //
+void le::Winding::Split( const VisPlane& Plane, double Epsilon, Winding& Front, Winding& Back ) const
+{
+	UInt32_t					countPoints = points.size();
+	std::vector< double >		distances( countPoints );
+	std::vector< int >			sides( countPoints );
+	UInt32_t					countFront = 0;
+	UInt32_t					countBack = 0;
+
+	Front.points.clear();
+	Back.points.clear();
+
+	for ( UInt32_t index = 0; index < countPoints; ++index )
+	{
+		distances[ index ] = glm::dot( points[ index ], Plane.normal ) - Plane.distance;
+
+		if ( distances[ index ] > Epsilon )
+		{
+			sides[ index ] = 1;
+			++countFront;
+		}
+		else if ( distances[ index ] < -Epsilon )
+		{
+			sides[ index ] = -1;
+			++countBack;
+		}
+		else
+			sides[ index ] = 0;
+	}
+
+	// Polygon lying on plane goes to front side
+	if ( !countBack )
+	{
+		Front.points = points;
+		return;
+	}
+
+	if ( !countFront )
+	{
+		Back.points = points;
+		return;
+	}
+
+	for ( UInt32_t index = 0; index < countPoints; ++index )
+	{
+		const glm::dvec3&		point = points[ index ];
+		UInt32_t				next = ( index + 1 ) % countPoints;
+
+		if ( sides[ index ] == 0 )
+		{
+			Front.points.push_back( point );
+			Back.points.push_back( point );
+			continue;
+		}
+
+		if ( sides[ index ] == 1 )		Front.points.push_back( point );
+		else							Back.points.push_back( point );
+
+		if ( sides[ next ] == 0 || sides[ next ] == sides[ index ] )
+			continue;
+
+		// Edge crosses plane, add point of intersection to both parts
+		double			fraction = distances[ index ] / ( distances[ index ] - distances[ next ] );
+		glm::dvec3		middle = point + ( points[ next ] - point ) * fraction;
+
+		Front.points.push_back( middle );
+		Back.points.push_back( middle );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Reverse order of points
+// ------------------------------------------------------------------------------------ //
+void le::Winding::Reverse()
+{
+	for ( UInt32_t index = 0, count = points.size(); index < count / 2; ++index )
+		std::swap( points[ index ], points[ count - 1 - index ] );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get center of polygon
+// ------------------------------------------------------------------------------------ //
+glm::dvec3 le::Winding::GetCenter() const
+{
+	glm::dvec3		center( 0.0 );
+	if ( points.empty() )		return center;
+
+	for ( UInt32_t index = 0, count = points.size(); index < count; ++index )
+		center += points[ index ];
+
+	return center / ( double ) points.size();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get radius of sphere around polygon
+// ------------------------------------------------------------------------------------ //
+double le::Winding::GetRadius( const glm::dvec3& Center ) const
+{
+	double			radius = 0.0;
+	for ( UInt32_t index = 0, count = points.size(); index < count; ++index )
+		radius = glm::max( radius, glm::length( points[ index ] - Center ) );
+
+	return radius;
+}
@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef WINDING_H
+#define WINDING_H
+
+#include <vector>
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+// Half size of polygon made for plane, must cover whole world
+#define WINDING_MAX_WORLD_COORD		131072.0
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	struct VisPlane
+	{
+		glm::dvec3		normal;
+		double			distance;
+	};
+
+	//---------------------------------------------------------------------//
+
+	// Convex polygon, computed in double precision because portals are cut from huge polygons
+	class Winding
+	{
+	public:
+		// Make polygon on plane that covers whole world
+		void					MakeBase( const VisPlane& Plane );
+
+		// Keep only part in front of plane, returns false if nothing is left
+		bool					Chop( const VisPlane& Plane, double Epsilon );
+
+		// Split polygon by plane, Front or Back stays empty if polygon is on one side
+		void					Split( const VisPlane& Plane, double Epsilon, Winding& Front, Winding& Back ) const;
+
+		// Reverse order of points, so polygon faces other side
+		void					Reverse();
+
+		glm::dvec3				GetCenter() const;
+		double					GetRadius( const glm::dvec3& Center ) const;
+
+		inline bool				IsEmpty() const
+		{
+			return points.size() < 3;
+		}
+
+		std::vector< glm::dvec3 >		points;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !WINDING_H
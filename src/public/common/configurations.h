@@ -23,12 +23,15 @@ namespace le
 	{
 		bool		isFullscreen;
 		bool		isVerticalSinc;
+		bool		isHeadless;			// Выделенный сервер: без окна и рендера
+		bool		isCompactGBuffer;	// Компактный G-буфер: меньше трафика памяти на больших разрешениях
 
 		float		fov;
 		float		sensitivityMouse;
 
 		UInt32_t	windowWidth;
 		UInt32_t	windowHeight;
+		UInt32_t	tickRate;			// Частота обновления логики без рендера
 	};
 
 	//---------------------------------------------------------------------//
@@ -0,0 +1,37 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef LIGHTSAMPLE_H
+#define LIGHTSAMPLE_H
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Baked lighting at one point: ambient part plus one light from direction
+	struct LightSample
+	{
+		Vector3D_t			ambientColor;
+		Vector3D_t			directedColor;
+
+		// Direction to the light, normalized
+		Vector3D_t			direction;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !LIGHTSAMPLE_H
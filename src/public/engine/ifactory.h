@@ -11,14 +11,25 @@
 #ifndef IFACTORY_H
 #define IFACTORY_H
 
+#include "common/types.h"
+
 namespace le
 {
 	//---------------------------------------------------------------------//
 
+	// Хеш FNV-1a названия интерфейса, для строковых литералов считается при компиляции
+	constexpr UInt32_t			HashInterface( const char* NameInterface, UInt32_t Hash = 2166136261u )
+	{
+		return *NameInterface ? HashInterface( NameInterface + 1, ( Hash ^ ( UInt8_t ) *NameInterface ) * 16777619u ) : Hash;
+	}
+
+	//---------------------------------------------------------------------//
+
 	class IFactory
 	{
 	public:
 		virtual void*			Create( const char* NameInterface ) = 0;
+		virtual void*			Create( UInt32_t InterfaceID ) = 0;
 		virtual void			Delete( void* Object ) = 0;
 	};
 
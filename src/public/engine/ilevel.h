@@ -12,6 +12,7 @@
 #define ILEVEL_H
 
 #include "common/types.h"
+#include "engine/trace.h"
 
 //---------------------------------------------------------------------//
 
@@ -57,6 +58,11 @@ namespace le
 		virtual void					RemoveDirectionalLight( UInt32_t Index ) = 0;
 		virtual void					RemoveSprite( ISprite* Sprite ) = 0;
 		virtual void					RemoveSprite( UInt32_t Index ) = 0;
+		virtual bool					SetAreaPortalState( const Vector3D_t& Min, const Vector3D_t& Max, bool IsOpen ) = 0;
+		virtual void					TraceRay( const Vector3D_t& Start, const Vector3D_t& End, TraceResult& Result ) = 0;
+		virtual void					TraceBox( const Vector3D_t& Start, const Vector3D_t& End, const Vector3D_t& Min, const Vector3D_t& Max, TraceResult& Result ) = 0;
+		virtual void					TraceSphere( const Vector3D_t& Start, const Vector3D_t& End, float Radius, TraceResult& Result ) = 0;
+		virtual void					TraceBatch( const TraceRequest* Requests, TraceResult* Results, UInt32_t Count ) = 0;
 
 		virtual bool					IsLoaded() const = 0;
 		virtual const char*				GetNameFormat() const = 0;
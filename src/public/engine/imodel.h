@@ -31,12 +31,14 @@ namespace le
 		virtual void					SetMax( const Vector3D_t& MaxPosition ) = 0;
 		virtual void					SetStartFace( UInt32_t StartFace ) = 0;
 		virtual void					SetCountFace( UInt32_t CountFace ) = 0;
+		virtual void					SetOccluder( bool IsOccluder ) = 0;
 
 		virtual IMesh*					GetMesh() const = 0;
 		virtual const Vector3D_t&		GetMin() = 0;
 		virtual const Vector3D_t&		GetMax() = 0;
 		virtual UInt32_t				GetStartFace() const = 0;
 		virtual UInt32_t				GetCountFace() const = 0;
+		virtual bool					IsOccluder() const = 0;
 	};
 
 	//---------------------------------------------------------------------//
@@ -44,7 +46,7 @@ namespace le
 
 //---------------------------------------------------------------------//
 
-#define MODEL_INTERFACE_VERSION "LE_Model003"
+#define MODEL_INTERFACE_VERSION "LE_Model004"
 
 //---------------------------------------------------------------------//
 
@@ -0,0 +1,113 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef ISTATSSYSTEM_H
+#define ISTATSSYSTEM_H
+
+#include <atomic>
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+#define STATSSYSTEM_MAX_STATS			128
+#define STATSSYSTEM_INVALID_STAT		0xFFFFFFFF
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	enum STAT_TYPE
+	{
+		ST_COUNTER,			// Sum of all adds in frame, reset every frame
+		ST_GAUGE			// Last set value of any thread
+	};
+
+	//---------------------------------------------------------------------//
+
+	// Values of stats written by one thread. Only owner thread writes it, stats system only reads
+	struct StatsThreadBlock
+	{
+		std::atomic< Int64_t >			values[ STATSSYSTEM_MAX_STATS ];
+	};
+
+	//---------------------------------------------------------------------//
+
+	class IStatsSystem
+	{
+	public:
+		// Stat with same name gets same ID, returns STATSSYSTEM_INVALID_STAT if registry is full
+		virtual UInt32_t				RegisterStat( const char* Name, STAT_TYPE Type ) = 0;
+		virtual StatsThreadBlock*		GetThreadBlock() = 0;
+
+		// Gauge is one value shared by all threads, last set wins
+		virtual std::atomic< Int64_t >*	GetGauge( UInt32_t ID ) = 0;
+
+		// Value of stat in last finished frame
+		virtual Int64_t					GetValue( UInt32_t ID ) const = 0;
+		virtual UInt32_t				FindStat( const char* Name ) const = 0;
+	};
+
+	//---------------------------------------------------------------------//
+
+	// Handle of stat for modules. Add and Set have no locks and virtual calls: counter
+	// lives in block of current thread, stats system collects blocks at end of frame
+	class Stat
+	{
+	public:
+		Stat() :
+			statsSystem( nullptr ),
+			gauge( nullptr ),
+			id( STATSSYSTEM_INVALID_STAT )
+		{}
+
+		inline void						Register( IStatsSystem* StatsSystem, const char* Name, STAT_TYPE Type )
+		{
+			statsSystem = StatsSystem;
+			id = StatsSystem ? StatsSystem->RegisterStat( Name, Type ) : STATSSYSTEM_INVALID_STAT;
+			gauge = id != STATSSYSTEM_INVALID_STAT && Type == ST_GAUGE ? StatsSystem->GetGauge( id ) : nullptr;
+		}
+
+		inline void						Add( Int64_t Value ) const
+		{
+			if ( id == STATSSYSTEM_INVALID_STAT )		return;
+
+			std::atomic< Int64_t >&		value = GetThreadBlock()->values[ id ];
+			value.store( value.load( std::memory_order_relaxed ) + Value, std::memory_order_relaxed );
+		}
+
+		// Gauge may be set from any thread (e.g. render stats move between threads with r_multithread)
+		inline void						Set( Int64_t Value ) const
+		{
+			if ( !gauge )		return;
+			gauge->store( Value, std::memory_order_relaxed );
+		}
+
+	private:
+		inline StatsThreadBlock*		GetThreadBlock() const
+		{
+			static thread_local StatsThreadBlock*		threadBlock = nullptr;
+			if ( !threadBlock )		threadBlock = statsSystem->GetThreadBlock();
+			return threadBlock;
+		}
+
+		IStatsSystem*					statsSystem;
+		std::atomic< Int64_t >*			gauge;
+		UInt32_t						id;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !ISTATSSYSTEM_H
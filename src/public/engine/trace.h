@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	enum TRACE_TYPE
+	{
+		TRT_RAY,
+		TRT_BOX,
+		TRT_SPHERE
+	};
+
+	//---------------------------------------------------------------------//
+
+	struct TraceRequest
+	{
+		TRACE_TYPE		type;
+		Vector3D_t		start;
+		Vector3D_t		end;
+
+		// Bounds of box relative to start, used only for TRT_BOX
+		Vector3D_t		min;
+		Vector3D_t		max;
+
+		// Radius of sphere, used only for TRT_SPHERE
+		float			radius;
+	};
+
+	//---------------------------------------------------------------------//
+
+	struct TraceResult
+	{
+		// Trace started inside a brush
+		bool			isStartSolid;
+
+		// Trace never left a brush, fraction is 0
+		bool			isAllSolid;
+
+		// Part of the way traveled before hit, 1 if nothing was hit
+		float			fraction;
+		Vector3D_t		endPosition;
+
+		// Normal of the brush side that was hit
+		Vector3D_t		normal;
+
+		// Index of the brush that was hit, -1 if nothing was hit
+		int				brush;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !TRACE_H
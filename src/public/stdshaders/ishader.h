@@ -23,6 +23,7 @@ namespace le
 	class ICamera;
 	class IShaderParameter;
 	class ITexture;
+	struct LightSample;
 
 	//---------------------------------------------------------------------//
 
@@ -30,7 +31,7 @@ namespace le
 	{
 	public:
 		virtual bool					InitInstance( UInt32_t CountParams, IShaderParameter** ShaderParameters ) = 0;
-		virtual void					OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap = nullptr ) = 0;
+		virtual void					OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap = nullptr, const LightSample* LightSample = nullptr ) = 0;
 
 		virtual const char*				GetName() const = 0;
 		virtual const char*				GetFallbackShader() const = 0;
@@ -28,10 +28,16 @@ namespace le
 	class ISpotLight;
 	class IDirectionalLight;
 	class ISprite;
+	struct LightSample;
 	struct StudioRenderViewport;
 
 	//---------------------------------------------------------------------//
 
+	// Глубина отрисовки по умолчанию: такие меши рисуются после упорядоченных, в порядке отправки
+	#define STUDIORENDER_DRAWDEPTH_UNSORTED		0xFFFFFFFF
+
+	//---------------------------------------------------------------------//
+
 	enum CULLFACE_TYPE
 	{
 		CT_FRONT,
@@ -46,6 +52,10 @@ namespace le
 		virtual void							BeginScene( ICamera* Camera ) = 0;
 		virtual void							SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformation ) = 0;
 		virtual void							SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformation, UInt32_t StartSurface, UInt32_t CountSurface ) = 0;
+		virtual void							SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformation, UInt32_t StartSurface, UInt32_t CountSurface, const LightSample& LightSample ) = 0;
+
+		// Порядок от камеры (меньше - ближе) для следующих мешей сцены, непрозрачная геометрия рисуется спереди назад
+		virtual void							SetDrawDepth( UInt32_t Depth ) = 0;
 		virtual void							SubmitLight( IPointLight* PointLight ) = 0;
 		virtual void							SubmitLight( ISpotLight* SpotLight ) = 0;
 		virtual void							SubmitLight( IDirectionalLight* DirectionalLight ) = 0;
@@ -29,7 +29,9 @@ namespace le
 		IF_RGB_8UNORM,
 		IF_RGBA_16FLOAT,
 		IF_RGB_16FLOAT,
-		IF_DEPTH24_STENCIL8		
+		IF_DEPTH24_STENCIL8,
+		IF_RGB10_A2_UNORM,
+		IF_R11G11B10_FLOAT
 	};
 
 	//---------------------------------------------------------------------//
@@ -23,13 +23,28 @@ namespace le
 	{
 		VET_FLOAT,
 		VET_UNSIGNED_INT,
-		VET_UNSIGNED_BYTE
+		VET_UNSIGNED_BYTE,
+		VET_HALF_FLOAT,
+		VET_INT_2_10_10_10_REV
 	};
 
 	//---------------------------------------------------------------------//
 
 	struct StudioVertexElement
 	{
+		inline UInt32_t					GetSize() const
+		{
+			switch ( type )
+			{
+			case VET_FLOAT:
+			case VET_UNSIGNED_INT:			return count * 4;
+			case VET_UNSIGNED_BYTE:			return count;
+			case VET_HALF_FLOAT:			return count * 2;
+			case VET_INT_2_10_10_10_REV:	return 4;
+			default:						return 0;
+			}
+		}
+
 		UInt32_t						count;
 		VERTEX_ELEMENT_TYPE				type;
 	};
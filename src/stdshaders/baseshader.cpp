@@ -65,7 +65,7 @@ bool le::BaseShader::LoadShader( const ShaderDescriptor& ShaderDescriptor, const
 	if ( gpuPrograms.find( Flags ) != gpuPrograms.end() )
 		return true;
 
-	IGPUProgram*			gpuProgram = ( IGPUProgram* ) g_studioRenderFactory->Create( GPUPROGRAM_INTERFACE_VERSION );
+	IGPUProgram*			gpuProgram = ( IGPUProgram* ) g_studioRenderFactory->Create( HashInterface( GPUPROGRAM_INTERFACE_VERSION ) );
 	if ( !gpuProgram ) return false;
 
 	if ( !gpuProgram->Compile( ShaderDescriptor, Defines.size(), ( const char** ) Defines.data() ) )
@@ -24,6 +24,8 @@ bool le::LightmappedGeneric::InitInstance( UInt32_t CountParams, IShaderParamete
 	shaderDescriptor.vertexShaderSource = " \
 	#version 330 core\n \
 	\n \
+	invariant gl_Position;\n \
+	\n \
 	layout( location = 0 ) 			in vec3 vertex_position; \n \
 	layout( location = 1 ) 			in vec2 vertex_texCoords; \n \
 	layout( location = 2 ) 			in vec2 vertex_lightmapCoords; \n \
@@ -35,8 +37,15 @@ bool le::LightmappedGeneric::InitInstance( UInt32_t CountParams, IShaderParamete
 		out vec4 				vertexColor; \n \
 		out vec3				normal; \n \
 	\n \
-		uniform mat4    		matrix_Projection; \n \
-		uniform mat4			matrix_Transformation; \n \
+		layout( std140 ) uniform SceneData \n \
+		{ \n \
+			mat4		matrix_Projection; \n \
+		}; \n \
+		\n \
+		layout( std140 ) uniform ObjectData \n \
+		{ \n \
+			mat4		matrix_Transformation; \n \
+		}; \n \
 	\n \
 	void main() \n \
 	{\n \
@@ -65,7 +74,7 @@ bool le::LightmappedGeneric::InitInstance( UInt32_t CountParams, IShaderParamete
 	void main()\n\
 	{\n\
 		out_albedoSpecular = vec4( texture2D( basetexture, texCoords ).rgb, 0.f ); \n \
-		out_normalShininess = vec4( normalize( normal ), 1 );\n\
+		out_normalShininess = GBuffer_EncodeNormal( normalize( normal ), 1.f );\n\
 		out_emission = texture2D( lightmap, lightmapCoords ) * vertexColor;\n\
 	}\n";
 
@@ -89,7 +98,7 @@ bool le::LightmappedGeneric::InitInstance( UInt32_t CountParams, IShaderParamete
 // ------------------------------------------------------------------------------------ //
 // Подготовка к отрисовке элементов
 // ------------------------------------------------------------------------------------ //
-void le::LightmappedGeneric::OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap )
+void le::LightmappedGeneric::OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap, const LightSample* LightSample )
 {
 	IGPUProgram*		gpuProgram = GetGPUProgram( 0 );
 	if ( !gpuProgram ) return;
@@ -98,8 +107,6 @@ void le::LightmappedGeneric::OnDrawMesh( UInt32_t CountParams, IShaderParameter*
 	if ( Lightmap )			Lightmap->Bind( 1 );
 
 	gpuProgram->Bind();
-	gpuProgram->SetUniform( "matrix_Transformation", Transformation );
-	gpuProgram->SetUniform( "matrix_Projection", Camera->GetProjectionMatrix() * Camera->GetViewMatrix() );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -24,7 +24,7 @@ namespace le
 	public:
 		// IShader
 		virtual bool					InitInstance( UInt32_t CountParams, IShaderParameter** ShaderParameters );
-		virtual void					OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap = nullptr );
+		virtual void					OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap = nullptr, const LightSample* LightSample = nullptr );
 
 		virtual const char* 			GetName() const;
 		virtual const char* 			GetFallbackShader() const;
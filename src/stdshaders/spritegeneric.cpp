@@ -27,6 +27,8 @@ bool le::SpriteGeneric::InitInstance( UInt32_t CountParams, IShaderParameter** S
 	shaderDescriptor.vertexShaderSource = " \
 	#version 330 core\n \
 	\n \
+	invariant gl_Position;\n \
+	\n \
 	layout( location = 0 ) 			in vec3 vertex_position; \n \
     layout( location = 1 ) 			in vec3 vertex_normal; \n \
 	layout( location = 2 ) 			in vec2 vertex_texCoords; \n \
@@ -35,8 +37,15 @@ bool le::SpriteGeneric::InitInstance( UInt32_t CountParams, IShaderParameter** S
         out vec3 				normal; \n \
 	\n \
         uniform vec4            textureRect; \n\
-		uniform mat4    		matrix_Projection; \n \
-		uniform mat4			matrix_Transformation; \n \
+		layout( std140 ) uniform SceneData \n \
+		{ \n \
+			mat4		matrix_Projection; \n \
+		}; \n \
+		\n \
+		layout( std140 ) uniform ObjectData \n \
+		{ \n \
+			mat4		matrix_Transformation; \n \
+		}; \n \
 	\n \
 	void main() \n \
 	{\n \
@@ -60,7 +69,7 @@ bool le::SpriteGeneric::InitInstance( UInt32_t CountParams, IShaderParameter** S
 	void main()\n\
 	{\n\
 		out_albedoSpecular = vec4( texture2D( basetexture, texCoords ).rgb, 0.f ); \n \
-		out_normalShininess = vec4( normalize( normal ), 1.f );\n\
+		out_normalShininess = GBuffer_EncodeNormal( normalize( normal ), 1.f );\n\
 		out_emission = vec4( 0.f );\n\
 	}\n";
 
@@ -83,7 +92,7 @@ bool le::SpriteGeneric::InitInstance( UInt32_t CountParams, IShaderParameter** S
 // ------------------------------------------------------------------------------------ //
 // Подготовка к отрисовке элементов
 // ------------------------------------------------------------------------------------ //
-void le::SpriteGeneric::OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap )
+void le::SpriteGeneric::OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap, const LightSample* LightSample )
 {
 	IGPUProgram*		gpuProgram = GetGPUProgram( 0 );
 	if ( !gpuProgram ) return;
@@ -97,9 +106,6 @@ void le::SpriteGeneric::OnDrawMesh( UInt32_t CountParams, IShaderParameter** Sha
         if ( strcmp( shaderParameter->GetName(), "basetexture" ) == 0 )           shaderParameter->GetValueTexture()->Bind();
         else if ( strcmp( shaderParameter->GetName(), "textureRect" ) == 0  )     gpuProgram->SetUniform( "textureRect", shaderParameter->GetValueVector4D() );
     }
-	
-	gpuProgram->SetUniform( "matrix_Transformation", Transformation );
-	gpuProgram->SetUniform( "matrix_Projection", Camera->GetProjectionMatrix() * Camera->GetViewMatrix() );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -25,6 +25,8 @@ bool le::TestShader::InitInstance( UInt32_t CountParams, IShaderParameter** Shad
 	shaderDescriptor.vertexShaderSource = " \
 	#version 330 core\n \
 	\n \
+	invariant gl_Position;\n \
+	\n \
 	layout( location = 0 ) 			in vec3 vertex_position; \n \
 	layout( location = 1 ) 			in vec3 vertex_normal; \n \
 	layout( location = 2 ) 			in vec2 vertex_texCoords; \n \
@@ -32,8 +34,15 @@ bool le::TestShader::InitInstance( UInt32_t CountParams, IShaderParameter** Shad
 		out vec2 				texCoords; \n \
 		out vec3				normal; \n \
 	\n \
-		uniform mat4    		matrix_Projection; \n \
-		uniform mat4			matrix_Transformation; \n \
+		layout( std140 ) uniform SceneData \n \
+		{ \n \
+			mat4		matrix_Projection; \n \
+		}; \n \
+		\n \
+		layout( std140 ) uniform ObjectData \n \
+		{ \n \
+			mat4		matrix_Transformation; \n \
+		}; \n \
 	\n \
 	void main() \n \
 	{\n \
@@ -58,7 +67,7 @@ bool le::TestShader::InitInstance( UInt32_t CountParams, IShaderParameter** Shad
 	{\n\
 		vec4 texelColor = texture2D( basetexture, texCoords );\n\
 		out_albedoSpecular = vec4( texelColor.rgb * vec3( 0.5f, 0.f, 0.f ), 0 ); \n \
-		out_normalShininess = vec4( normal, 1 );\n\
+		out_normalShininess = GBuffer_EncodeNormal( normal, 1.f );\n\
 		out_emission = vec4( 0, 0, 0, 1 );\n\
 	}\n";
 
@@ -81,7 +90,7 @@ bool le::TestShader::InitInstance( UInt32_t CountParams, IShaderParameter** Shad
 // ------------------------------------------------------------------------------------ //
 // Подготовка к отрисовке элементов
 // ------------------------------------------------------------------------------------ //
-void le::TestShader::OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap )
+void le::TestShader::OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap, const LightSample* LightSample )
 {
 	IGPUProgram*		gpuProgram = GetGPUProgram( 0 );
 	if ( !gpuProgram ) return;
@@ -89,8 +98,6 @@ void le::TestShader::OnDrawMesh( UInt32_t CountParams, IShaderParameter** Shader
 	ShaderParameters[ 0 ]->GetValueTexture()->Bind();
 
 	gpuProgram->Bind();
-	gpuProgram->SetUniform( "matrix_Transformation", Transformation );
-	gpuProgram->SetUniform( "matrix_Projection", Camera->GetProjectionMatrix() * Camera->GetViewMatrix() );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -13,6 +13,7 @@
 #include "engine/icamera.h"
 #include "studiorender/igpuprogram.h"
 #include "studiorender/itexture.h"
+#include "common/lightsample.h"
 
 #include "global.h"
 #include "unlitgeneric.h"
@@ -26,13 +27,14 @@ bool le::UnlitGeneric::InitInstance( UInt32_t CountParams, IShaderParameter** Sh
 	shaderDescriptor.vertexShaderSource = " \
 	#version 330 core\n \
 	\n \
+	invariant gl_Position;\n \
+	\n \
 	layout( location = 0 ) 			in vec3 vertex_position; \n \
 	layout( location = 1 ) 			in vec3 vertex_normal; \n \
 	layout( location = 2 ) 			in vec2 vertex_texCoords; \n \
 	\n\
 	#ifdef NORMAL_MAP \n\
-		layout( location = 3 ) 			in vec3 vertex_tangent; \n \
-		layout( location = 4 ) 			in vec3 vertex_bitangent; \n \
+		layout( location = 3 ) 			in vec4 vertex_tangent; \n \
 	#endif \n\
 	\n \
 		out vec2 				texCoords; \n \
@@ -43,8 +45,15 @@ bool le::UnlitGeneric::InitInstance( UInt32_t CountParams, IShaderParameter** Sh
 		out vec3				normal; \n\
 	#endif \n\
 	\n \
-		uniform mat4    		matrix_Projection; \n \
-		uniform mat4			matrix_Transformation; \n \
+		layout( std140 ) uniform SceneData \n \
+		{ \n \
+			mat4		matrix_Projection; \n \
+		}; \n \
+		\n \
+		layout( std140 ) uniform ObjectData \n \
+		{ \n \
+			mat4		matrix_Transformation; \n \
+		}; \n \
 	\n \
 	void main() \n \
 	{\n \
@@ -52,8 +61,8 @@ bool le::UnlitGeneric::InitInstance( UInt32_t CountParams, IShaderParameter** Sh
 		\n\
 		#ifdef NORMAL_MAP \n\
 			vec3 normal = ( matrix_Transformation * vec4( vertex_normal, 0.f ) ).xyz; \n \
-			vec3 tangent = ( matrix_Transformation * vec4( vertex_tangent, 0.f ) ).xyz; \n \
-			vec3 bitangent = ( matrix_Transformation * vec4( vertex_bitangent, 0.f ) ).xyz; \n \
+			vec3 tangent = ( matrix_Transformation * vec4( vertex_tangent.xyz, 0.f ) ).xyz; \n \
+			vec3 bitangent = cross( normal, tangent ) * ( vertex_tangent.w < 0.f ? -1.f : 1.f ); \n \
 			tbnMatrix = mat3( tangent, bitangent, normal );\n\
 		#else \n\
 			normal = ( matrix_Transformation * vec4( vertex_normal, 0.f ) ).xyz; \n \
@@ -86,6 +95,10 @@ bool le::UnlitGeneric::InitInstance( UInt32_t CountParams, IShaderParameter** Sh
 		#ifdef SPECULAR_MAP\n\
 			uniform sampler2D		specularmap;\n\
 		#endif \n\
+		\n\
+		uniform vec3			light_Ambient;\n\
+		uniform vec3			light_Directed;\n\
+		uniform vec3			light_Direction;\n\
 	\n\
 	void main()\n\
 	{\n\
@@ -98,12 +111,13 @@ bool le::UnlitGeneric::InitInstance( UInt32_t CountParams, IShaderParameter** Sh
 		\n\
 		#ifdef NORMAL_MAP \n\
 			vec3 normal = texture2D( normalmap, texCoords ).rgb * 2.0 - 1.0;\n\
-			out_normalShininess = vec4( normalize( tbnMatrix * normal ), 32.f );\n\
+			vec3 worldNormal = normalize( tbnMatrix * normal );\n\
 		#else \n\
-			out_normalShininess = vec4( normalize( normal ), 32.f );\n\
+			vec3 worldNormal = normalize( normal );\n\
 		#endif \n\
 		\n\
-		out_emission = vec4( 0.f );\n\
+		out_normalShininess = GBuffer_EncodeNormal( worldNormal, 32.f );\n\
+		out_emission = vec4( light_Ambient + light_Directed * max( dot( worldNormal, light_Direction ), 0.f ), 1.f );\n\
 	}\n";
 
 	std::vector< const char* >			defines;
@@ -142,7 +156,7 @@ bool le::UnlitGeneric::InitInstance( UInt32_t CountParams, IShaderParameter** Sh
 // ------------------------------------------------------------------------------------ //
 // Подготовка к отрисовке элементов
 // ------------------------------------------------------------------------------------ //
-void le::UnlitGeneric::OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap )
+void le::UnlitGeneric::OnDrawMesh( UInt32_t CountParams, IShaderParameter** ShaderParameters, const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap, const LightSample* LightSample )
 {
 	UInt32_t			flags = 0;
 	
@@ -171,8 +185,19 @@ void le::UnlitGeneric::OnDrawMesh( UInt32_t CountParams, IShaderParameter** Shad
 	if ( !gpuProgram ) return;
 
 	gpuProgram->Bind();
-	gpuProgram->SetUniform( "matrix_Transformation", Transformation );
-	gpuProgram->SetUniform( "matrix_Projection", Camera->GetProjectionMatrix() * Camera->GetViewMatrix() );
+
+	// Освещение из сетки света уровня, без него модель освещается только источниками света
+	if ( LightSample )
+	{
+		gpuProgram->SetUniform( "light_Ambient", LightSample->ambientColor );
+		gpuProgram->SetUniform( "light_Directed", LightSample->directedColor );
+		gpuProgram->SetUniform( "light_Direction", LightSample->direction );
+	}
+	else
+	{
+		gpuProgram->SetUniform( "light_Ambient", Vector3D_t( 0.f ) );
+		gpuProgram->SetUniform( "light_Directed", Vector3D_t( 0.f ) );
+	}
 }
 
 // ------------------------------------------------------------------------------------ //
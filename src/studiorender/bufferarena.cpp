@@ -0,0 +1,300 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <GL/glew.h>
+
+#include "engine/lifeengine.h"
+#include "engine/iconsolesystem.h"
+
+#include "global.h"
+#include "bufferarena.h"
+
+// ------------------------------------------------------------------------------------ //
+// Allocate storage of buffer without data
+// ------------------------------------------------------------------------------------ //
+static void BufferArena_Reserve( le::UInt32_t Handle, le::UInt32_t Size )
+{
+	glBindBuffer( GL_COPY_WRITE_BUFFER, Handle );
+	glBufferData( GL_COPY_WRITE_BUFFER, Size, nullptr, GL_STATIC_DRAW );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Copy range between buffers on GPU
+// ------------------------------------------------------------------------------------ //
+static void BufferArena_Copy( le::UInt32_t Source, le::UInt32_t SourceOffset, le::UInt32_t Destination, le::UInt32_t DestinationOffset, le::UInt32_t Size )
+{
+	if ( Size == 0 || Source == 0 )		return;
+
+	glBindBuffer( GL_COPY_READ_BUFFER, Source );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, Destination );
+	glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, SourceOffset, DestinationOffset, Size );
+	glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::BufferArena::BufferArena() :
+	isNeedDefragment( false )
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor
+// ------------------------------------------------------------------------------------ //
+le::BufferArena::~BufferArena()
+{
+	Clear();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Allocate range for mesh and upload data to it
+// ------------------------------------------------------------------------------------ //
+le::BufferArenaAllocation* le::BufferArena::Allocate( VertexBufferLayout& Layout, const void* Verteces, UInt32_t SizeVerteces, const void* Indeces, UInt32_t SizeIndeces )
+{
+	UInt32_t		stride = Layout.GetStride();
+	if ( stride == 0 || SizeVerteces == 0 || SizeVerteces % stride != 0 || !Verteces || ( SizeIndeces > 0 && !Indeces ) )
+		return nullptr;
+
+	UInt32_t		indexSize = ( SizeIndeces + BUFFERARENA_INDEX_ALIGNMENT - 1 ) & ~( BUFFERARENA_INDEX_ALIGNMENT - 1 );
+	Pool*			pool = FindPool( Layout );
+
+	if ( !pool )
+	{
+		pool = new Pool();
+		pool->layout = Layout;
+		pool->vertexArrayObject.Create();
+		ResizePool( pool, glm::max< UInt32_t >( BUFFERARENA_VERTEX_BLOCK_SIZE, SizeVerteces ), glm::max< UInt32_t >( BUFFERARENA_INDEX_BLOCK_SIZE, indexSize ), false );
+		pools.push_back( pool );
+	}
+
+	// If pool is full, it grows twice and old data is copied on GPU
+	UInt32_t		vertexOffset = 0;
+	UInt32_t		indexOffset = 0;
+
+	if ( !pool->vertexAllocator.Allocate( SizeVerteces, stride, vertexOffset ) )
+	{
+		UInt32_t		capacity = pool->vertexAllocator.GetSize();
+		ResizePool( pool, glm::max( capacity * 2, capacity + SizeVerteces + stride ), pool->indexAllocator.GetSize(), false );
+
+		if ( !pool->vertexAllocator.Allocate( SizeVerteces, stride, vertexOffset ) )
+			return nullptr;
+	}
+
+	if ( indexSize > 0 && !pool->indexAllocator.Allocate( indexSize, BUFFERARENA_INDEX_ALIGNMENT, indexOffset ) )
+	{
+		UInt32_t		capacity = pool->indexAllocator.GetSize();
+		ResizePool( pool, pool->vertexAllocator.GetSize(), glm::max( capacity * 2, capacity + indexSize ), false );
+
+		if ( !pool->indexAllocator.Allocate( indexSize, BUFFERARENA_INDEX_ALIGNMENT, indexOffset ) )
+		{
+			pool->vertexAllocator.Free( vertexOffset, SizeVerteces );
+			return nullptr;
+		}
+	}
+
+	// Index buffer is bound to VAO of pool, so VAO is unbound before upload
+	VertexArrayObject::Unbind();
+
+	pool->vertexBufferObject.Bind();
+	pool->vertexBufferObject.Update( Verteces, SizeVerteces, vertexOffset );
+	VertexBufferObject::Unbind();
+
+	if ( SizeIndeces > 0 )
+	{
+		pool->indexBufferObject.Bind();
+		pool->indexBufferObject.Update( Indeces, SizeIndeces, indexOffset );
+		IndexBufferObject::Unbind();
+	}
+
+	BufferArenaAllocation*		allocation = new BufferArenaAllocation();
+	allocation->vertexArrayObject = &pool->vertexArrayObject;
+	allocation->stride = stride;
+	allocation->vertexOffset = vertexOffset;
+	allocation->vertexSize = SizeVerteces;
+	allocation->indexOffset = indexOffset;
+	allocation->indexSize = indexSize;
+
+	pool->allocations.push_back( allocation );
+	return allocation;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Free range of mesh
+// ------------------------------------------------------------------------------------ //
+void le::BufferArena::Free( BufferArenaAllocation* Allocation )
+{
+	if ( !Allocation )		return;
+
+	for ( UInt32_t indexPool = 0, countPools = pools.size(); indexPool < countPools; ++indexPool )
+	{
+		Pool*			pool = pools[ indexPool ];
+		if ( &pool->vertexArrayObject != Allocation->vertexArrayObject )		continue;
+
+		for ( UInt32_t index = 0, count = pool->allocations.size(); index < count; ++index )
+			if ( pool->allocations[ index ] == Allocation )
+			{
+				pool->allocations[ index ] = pool->allocations.back();
+				pool->allocations.pop_back();
+				break;
+			}
+
+		pool->vertexAllocator.Free( Allocation->vertexOffset, Allocation->vertexSize );
+		pool->indexAllocator.Free( Allocation->indexOffset, Allocation->indexSize );
+		break;
+	}
+
+	delete Allocation;
+	isNeedDefragment = true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Compact pools with many holes. Called between frames, because it moves ranges of meshes
+// ------------------------------------------------------------------------------------ //
+void le::BufferArena::Defragment()
+{
+	for ( UInt32_t index = 0, count = pools.size(); index < count; ++index )
+	{
+		Pool*			pool = pools[ index ];
+		UInt32_t		liveVertexSize = pool->vertexAllocator.GetSize() - pool->vertexAllocator.GetFreeSize();
+		UInt32_t		liveIndexSize = pool->indexAllocator.GetSize() - pool->indexAllocator.GetFreeSize();
+		UInt32_t		holeSize = pool->vertexAllocator.GetHoleSize() + pool->indexAllocator.GetHoleSize();
+		UInt32_t		usedSize = pool->vertexAllocator.GetUsedSize() + pool->indexAllocator.GetUsedSize();
+		bool			isEmptyGrown = pool->allocations.empty() && ( pool->vertexAllocator.GetSize() > BUFFERARENA_VERTEX_BLOCK_SIZE || pool->indexAllocator.GetSize() > BUFFERARENA_INDEX_BLOCK_SIZE );
+
+		if ( !isEmptyGrown && ( holeSize < BUFFERARENA_DEFRAGMENT_MIN_HOLE_SIZE || holeSize < usedSize * BUFFERARENA_DEFRAGMENT_HOLE_FACTOR ) )
+			continue;
+
+		ResizePool( pool, glm::max< UInt32_t >( BUFFERARENA_VERTEX_BLOCK_SIZE, liveVertexSize + liveVertexSize / 2 ), glm::max< UInt32_t >( BUFFERARENA_INDEX_BLOCK_SIZE, liveIndexSize + liveIndexSize / 2 ), true );
+		g_consoleSystem->PrintInfo( "Buffer arena pool %i defragmented: %i KB of holes removed", index, holeSize / 1024 );
+	}
+
+	isNeedDefragment = false;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Delete all pools
+// ------------------------------------------------------------------------------------ //
+void le::BufferArena::Clear()
+{
+	for ( UInt32_t index = 0, count = pools.size(); index < count; ++index )
+	{
+		Pool*			pool = pools[ index ];
+		for ( UInt32_t indexAllocation = 0, countAllocations = pool->allocations.size(); indexAllocation < countAllocations; ++indexAllocation )
+			delete pool->allocations[ indexAllocation ];
+
+		delete pool;
+	}
+
+	pools.clear();
+	isNeedDefragment = false;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Print stats of pools
+// ------------------------------------------------------------------------------------ //
+void le::BufferArena::PrintStats()
+{
+	for ( UInt32_t index = 0, count = pools.size(); index < count; ++index )
+	{
+		Pool*			pool = pools[ index ];
+		g_consoleSystem->PrintInfo( "Buffer arena pool %i: stride %i, %i meshes, verteces %i/%i KB (fragmentation %.0f%%), indeces %i/%i KB (fragmentation %.0f%%)",
+									index, pool->layout.GetStride(), ( UInt32_t ) pool->allocations.size(),
+									( pool->vertexAllocator.GetSize() - pool->vertexAllocator.GetFreeSize() ) / 1024, pool->vertexAllocator.GetSize() / 1024, pool->vertexAllocator.GetFragmentation() * 100.f,
+									( pool->indexAllocator.GetSize() - pool->indexAllocator.GetFreeSize() ) / 1024, pool->indexAllocator.GetSize() / 1024, pool->indexAllocator.GetFragmentation() * 100.f );
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Find pool with same vertex format
+// ------------------------------------------------------------------------------------ //
+le::BufferArena::Pool* le::BufferArena::FindPool( VertexBufferLayout& Layout )
+{
+	const std::vector< VertexBufferElement >&		elements = Layout.GetElements();
+
+	for ( UInt32_t index = 0, count = pools.size(); index < count; ++index )
+	{
+		Pool*											pool = pools[ index ];
+		const std::vector< VertexBufferElement >&		poolElements = pool->layout.GetElements();
+		if ( pool->layout.GetStride() != Layout.GetStride() || poolElements.size() != elements.size() )
+			continue;
+
+		bool			isEqual = true;
+		for ( UInt32_t indexElement = 0, countElements = elements.size(); indexElement < countElements && isEqual; ++indexElement )
+			isEqual = elements[ indexElement ].type == poolElements[ indexElement ].type && elements[ indexElement ].count == poolElements[ indexElement ].count &&
+					  elements[ indexElement ].normalized == poolElements[ indexElement ].normalized && elements[ indexElement ].isInteger == poolElements[ indexElement ].isInteger;
+
+		if ( isEqual )		return pool;
+	}
+
+	return nullptr;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Recreate buffers of pool with new capacity. On grow data is copied as is,
+// on compact live ranges are packed to begin of buffers
+// ------------------------------------------------------------------------------------ //
+void le::BufferArena::ResizePool( Pool* Pool, UInt32_t VertexCapacity, UInt32_t IndexCapacity, bool IsCompact )
+{
+	VertexBufferObject		vertexBufferObject;
+	IndexBufferObject		indexBufferObject;
+
+	vertexBufferObject.Create();
+	indexBufferObject.Create();
+	BufferArena_Reserve( vertexBufferObject.GetHandle(), VertexCapacity );
+	BufferArena_Reserve( indexBufferObject.GetHandle(), IndexCapacity );
+
+	if ( !IsCompact )
+	{
+		BufferArena_Copy( Pool->vertexBufferObject.GetHandle(), 0, vertexBufferObject.GetHandle(), 0, glm::min( Pool->vertexAllocator.GetUsedSize(), VertexCapacity ) );
+		BufferArena_Copy( Pool->indexBufferObject.GetHandle(), 0, indexBufferObject.GetHandle(), 0, glm::min( Pool->indexAllocator.GetUsedSize(), IndexCapacity ) );
+		Pool->vertexAllocator.Grow( VertexCapacity );
+		Pool->indexAllocator.Grow( IndexCapacity );
+	}
+	else
+	{
+		std::vector< BufferArenaAllocation* >		allocations = Pool->allocations;
+		UInt32_t									vertexOffset = 0;
+		UInt32_t									indexOffset = 0;
+		UInt32_t									offset = 0;
+
+		// Sizes of ranges are multiple of stride and index alignment, so packed ranges stay aligned
+		std::sort( allocations.begin(), allocations.end(), []( const BufferArenaAllocation* Left, const BufferArenaAllocation* Right ) { return Left->vertexOffset < Right->vertexOffset; } );
+		for ( UInt32_t index = 0, count = allocations.size(); index < count; ++index )
+		{
+			BufferArenaAllocation*		allocation = allocations[ index ];
+			BufferArena_Copy( Pool->vertexBufferObject.GetHandle(), allocation->vertexOffset, vertexBufferObject.GetHandle(), vertexOffset, allocation->vertexSize );
+			allocation->vertexOffset = vertexOffset;
+			vertexOffset += allocation->vertexSize;
+		}
+
+		std::sort( allocations.begin(), allocations.end(), []( const BufferArenaAllocation* Left, const BufferArenaAllocation* Right ) { return Left->indexOffset < Right->indexOffset; } );
+		for ( UInt32_t index = 0, count = allocations.size(); index < count; ++index )
+		{
+			BufferArenaAllocation*		allocation = allocations[ index ];
+			BufferArena_Copy( Pool->indexBufferObject.GetHandle(), allocation->indexOffset, indexBufferObject.GetHandle(), indexOffset, allocation->indexSize );
+			allocation->indexOffset = indexOffset;
+			indexOffset += allocation->indexSize;
+		}
+
+		Pool->vertexAllocator.Initialize( VertexCapacity );
+		Pool->indexAllocator.Initialize( IndexCapacity );
+		if ( vertexOffset > 0 )		Pool->vertexAllocator.Allocate( vertexOffset, 1, offset );
+		if ( indexOffset > 0 )		Pool->indexAllocator.Allocate( indexOffset, 1, offset );
+	}
+
+	// Old buffers are deleted with local objects after swap, VAO is pointed to new ones
+	Pool->vertexBufferObject.Swap( vertexBufferObject );
+	Pool->indexBufferObject.Swap( indexBufferObject );
+	Pool->vertexArrayObject.AddBuffer( Pool->vertexBufferObject, Pool->layout );
+	Pool->vertexArrayObject.AddBuffer( Pool->indexBufferObject );
+}
@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef BUFFERARENA_H
+#define BUFFERARENA_H
+
+#include <vector>
+
+#include "common/types.h"
+#include "vertexarrayobject.h"
+#include "vertexbufferobject.h"
+#include "indexbufferobject.h"
+#include "vertexbufferlayout.h"
+#include "freelistallocator.h"
+
+//---------------------------------------------------------------------//
+
+#define BUFFERARENA_VERTEX_BLOCK_SIZE			( 4 * 1024 * 1024 )
+#define BUFFERARENA_INDEX_BLOCK_SIZE			( 1 * 1024 * 1024 )
+#define BUFFERARENA_INDEX_ALIGNMENT				4
+
+// Pool is compacted when holes between allocations take this part of used size
+#define BUFFERARENA_DEFRAGMENT_HOLE_FACTOR		0.25f
+#define BUFFERARENA_DEFRAGMENT_MIN_HOLE_SIZE	( 256 * 1024 )
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Range of mesh in buffers of pool. Offsets can be changed by defragmentation,
+	// so they are read on every submit and never cached
+	struct BufferArenaAllocation
+	{
+		VertexArrayObject*		vertexArrayObject;
+		UInt32_t				stride;
+		UInt32_t				vertexOffset;
+		UInt32_t				vertexSize;
+		UInt32_t				indexOffset;
+		UInt32_t				indexSize;
+	};
+
+	//---------------------------------------------------------------------//
+
+	// Big vertex and index buffers shared by static meshes. Every vertex format has own pool
+	// with one VAO, so meshes of one format are drawn without VAO switches
+	class BufferArena
+	{
+	public:
+		//---------------------------------------------------------------------//
+
+		struct Pool
+		{
+			VertexBufferLayout							layout;
+			VertexArrayObject							vertexArrayObject;
+			VertexBufferObject							vertexBufferObject;
+			IndexBufferObject							indexBufferObject;
+			FreeListAllocator							vertexAllocator;
+			FreeListAllocator							indexAllocator;
+			std::vector< BufferArenaAllocation* >		allocations;
+		};
+
+		//---------------------------------------------------------------------//
+
+		BufferArena();
+		~BufferArena();
+
+		BufferArenaAllocation*		Allocate( VertexBufferLayout& Layout, const void* Verteces, UInt32_t SizeVerteces, const void* Indeces, UInt32_t SizeIndeces );
+		void						Free( BufferArenaAllocation* Allocation );
+		void						Defragment();
+		void						Clear();
+		void						PrintStats();
+
+		inline bool					IsNeedDefragment() const
+		{
+			return isNeedDefragment;
+		}
+
+	private:
+		Pool*						FindPool( VertexBufferLayout& Layout );
+		void						ResizePool( Pool* Pool, UInt32_t VertexCapacity, UInt32_t IndexCapacity, bool IsCompact );
+
+		bool						isNeedDefragment;
+		std::vector< Pool* >		pools;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !BUFFERARENA_H
@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <GL/glew.h>
+#include <math.h>
+
+#include "engine/lifeengine.h"
+#include "dynamicresolution.h"
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::DynamicResolution::DynamicResolution() :
+	countUsedResults( 0 ),
+	scale( 1.f )
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Create timer queries
+// ------------------------------------------------------------------------------------ //
+bool le::DynamicResolution::Create()
+{
+	return timer.Create( GL_TIME_ELAPSED );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Delete timer queries
+// ------------------------------------------------------------------------------------ //
+void le::DynamicResolution::Delete()
+{
+	timer.Delete();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Move scale toward target frame time
+// ------------------------------------------------------------------------------------ //
+void le::DynamicResolution::Update( float TargetFrameTime, float MinScale, float MaxScale )
+{
+	if ( MaxScale < MinScale )		MaxScale = MinScale;
+
+	float			gpuTime = GetGPUTime();
+	if ( timer.GetCountResults() != countUsedResults && TargetFrameTime > 0.f && gpuTime > 0.f )
+	{
+		// Cost of passes grows with count of pixels, i.e. with square of scale. Time is measured
+		// at scale of that frame, not current one, otherwise controller overshoots while scale changes
+		float			measuredScale = ( float ) timer.GetResultFrameValue();
+		float			desiredScale = measuredScale * sqrtf( TargetFrameTime * DYNAMICRESOLUTION_HEADROOM / gpuTime );
+		if ( desiredScale < MinScale )			desiredScale = MinScale;
+		else if ( desiredScale > MaxScale )		desiredScale = MaxScale;
+
+		if ( fabsf( desiredScale - scale ) > DYNAMICRESOLUTION_DEADBAND )
+			scale += ( desiredScale - scale ) * DYNAMICRESOLUTION_SMOOTHING;
+	}
+
+	countUsedResults = timer.GetCountResults();
+	if ( scale < MinScale )				scale = MinScale;
+	else if ( scale > MaxScale )		scale = MaxScale;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Reset scale to full resolution
+// ------------------------------------------------------------------------------------ //
+void le::DynamicResolution::Reset()
+{
+	scale = 1.f;
+	countUsedResults = timer.GetCountResults();
+}
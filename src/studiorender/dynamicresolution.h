@@ -0,0 +1,76 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+#include "common/types.h"
+#include "gpucounter.h"
+
+//---------------------------------------------------------------------//
+
+#define DYNAMICRESOLUTION_HEADROOM			0.9f		// Part of target frame time controller aims for
+#define DYNAMICRESOLUTION_SMOOTHING			0.2f		// Part of difference to desired scale applied per measure
+#define DYNAMICRESOLUTION_DEADBAND			0.02f		// Smaller changes of scale are ignored, so viewport doesn't jitter
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Measures GPU time of frame with timer queries and adjusts scale of render resolution
+	// toward target frame time. Used only by thread of render
+	class DynamicResolution
+	{
+	public:
+		DynamicResolution();
+
+		bool					Create();
+		void					Delete();
+
+		// Scale of frame is kept with its query, result comes frames later when scale could change
+		inline void				BeginFrame()
+		{
+			timer.Begin( scale );
+		}
+
+		inline void				EndFrame()
+		{
+			timer.End();
+		}
+
+		// Move scale toward target frame time (in ms) using last measured GPU time
+		void					Update( float TargetFrameTime, float MinScale, float MaxScale );
+		void					Reset();
+
+		inline float			GetScale() const
+		{
+			return scale;
+		}
+
+		// GPU time of last measured frame in ms
+		inline float			GetGPUTime() const
+		{
+			return timer.GetResult() / 1000000.f;
+		}
+
+	private:
+		GPUCounter				timer;
+		UInt32_t				countUsedResults;
+		float					scale;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !DYNAMICRESOLUTION_H
@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef FRAME_DESCRIPTOR_H
+#define FRAME_DESCRIPTOR_H
+
+#include <vector>
+
+#include "common/types.h"
+#include "scenedescriptor.h"
+
+//---------------------------------------------------------------------//
+
+// Count of frame buffers: game fills one while render thread draws other
+#define FRAMEDESCRIPTOR_COUNT_FRAMES		2
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Transient data of one frame. Arrays are never freed, Reset only drops counters,
+	// so in steady state frame is filled without heap allocations
+	struct FrameDescriptor
+	{
+		FrameDescriptor() :
+			countScenes( 0 ),
+			countAllocations( 0 )
+		{}
+
+		inline void							Reset()
+		{
+			countScenes = 0;
+			countAllocations = 0;
+			transformations.clear();
+			transformOffsets.clear();
+		}
+
+		// Push value to array of frame and count reallocation of array
+		template< typename Type >
+		inline void							Push( std::vector< Type >& Array, const Type& Value )
+		{
+			if ( Array.size() == Array.capacity() )		++countAllocations;
+			Array.push_back( Value );
+		}
+
+		inline SceneDescriptor&				AllocateScene()
+		{
+			if ( countScenes == scenes.size() )		Push( scenes, SceneDescriptor() );
+
+			SceneDescriptor&		sceneDescriptor = scenes[ countScenes ];
+			sceneDescriptor.renderObjects.clear();
+			sceneDescriptor.sortKeys.clear();
+			sceneDescriptor.pointLights.clear();
+			sceneDescriptor.spotLights.clear();
+			sceneDescriptor.directionalLights.clear();
+
+			++countScenes;
+			return sceneDescriptor;
+		}
+
+		inline UInt32_t						AllocateTransformation( const Matrix4x4_t& Transformation )
+		{
+			// Surfaces of one mesh are submitted in a row, they share one matrix
+			if ( !transformations.empty() && transformations.back() == Transformation )
+				return transformations.size() - 1;
+
+			Push( transformations, Transformation );
+			return transformations.size() - 1;
+		}
+
+		UInt32_t							countScenes;
+		UInt32_t							countAllocations;
+		std::vector< SceneDescriptor >		scenes;
+		std::vector< Matrix4x4_t >			transformations;		// Pool of object matrices, render objects hold index
+		std::vector< UInt32_t >				transformOffsets;		// Offsets of matrices in streaming buffer
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !FRAME_DESCRIPTOR_H
@@ -0,0 +1,149 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "engine/lifeengine.h"
+
+#include "freelistallocator.h"
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::FreeListAllocator::FreeListAllocator() :
+	size( 0 ),
+	freeSize( 0 )
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Initialize allocator with one free block
+// ------------------------------------------------------------------------------------ //
+void le::FreeListAllocator::Initialize( UInt32_t Size )
+{
+	size = Size;
+	freeSize = Size;
+	freeBlocks.clear();
+
+	if ( Size > 0 )		freeBlocks.push_back( { 0, Size } );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Allocate range
+// ------------------------------------------------------------------------------------ //
+bool le::FreeListAllocator::Allocate( UInt32_t Size, UInt32_t Alignment, UInt32_t& Offset )
+{
+	LIFEENGINE_ASSERT( Alignment > 0 );
+	if ( Size == 0 || Size > freeSize )		return false;
+
+	for ( UInt32_t index = 0, count = freeBlocks.size(); index < count; ++index )
+	{
+		Block			block = freeBlocks[ index ];
+		UInt32_t		alignedOffset = ( ( block.offset + Alignment - 1 ) / Alignment ) * Alignment;
+		UInt32_t		padding = alignedOffset - block.offset;
+
+		if ( padding + Size > block.size )		continue;
+
+		// Padding before aligned offset stays in place of block, tail after range becomes new block
+		UInt32_t		tailSize = block.size - padding - Size;
+		if ( padding > 0 )
+		{
+			freeBlocks[ index ].size = padding;
+			if ( tailSize > 0 )		freeBlocks.insert( freeBlocks.begin() + index + 1, { alignedOffset + Size, tailSize } );
+		}
+		else if ( tailSize > 0 )
+			freeBlocks[ index ] = { alignedOffset + Size, tailSize };
+		else
+			freeBlocks.erase( freeBlocks.begin() + index );
+
+		freeSize -= Size;
+		Offset = alignedOffset;
+		return true;
+	}
+
+	return false;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Free range
+// ------------------------------------------------------------------------------------ //
+void le::FreeListAllocator::Free( UInt32_t Offset, UInt32_t Size )
+{
+	if ( Size == 0 )		return;
+	LIFEENGINE_ASSERT( Offset + Size <= size );
+
+	UInt32_t		index = 0;
+	UInt32_t		count = freeBlocks.size();
+	while ( index < count && freeBlocks[ index ].offset < Offset )
+		++index;
+
+	freeSize += Size;
+
+	bool			isMergePrev = index > 0 && freeBlocks[ index - 1 ].offset + freeBlocks[ index - 1 ].size == Offset;
+	bool			isMergeNext = index < count && Offset + Size == freeBlocks[ index ].offset;
+
+	if ( isMergePrev && isMergeNext )
+	{
+		freeBlocks[ index - 1 ].size += Size + freeBlocks[ index ].size;
+		freeBlocks.erase( freeBlocks.begin() + index );
+	}
+	else if ( isMergePrev )
+		freeBlocks[ index - 1 ].size += Size;
+	else if ( isMergeNext )
+	{
+		freeBlocks[ index ].offset = Offset;
+		freeBlocks[ index ].size += Size;
+	}
+	else
+		freeBlocks.insert( freeBlocks.begin() + index, { Offset, Size } );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Grow allocator, new space is added to the end
+// ------------------------------------------------------------------------------------ //
+void le::FreeListAllocator::Grow( UInt32_t Size )
+{
+	if ( Size <= size )		return;
+
+	UInt32_t		oldSize = size;
+	size = Size;
+	Free( oldSize, Size - oldSize );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get end of last allocated range
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::FreeListAllocator::GetUsedSize() const
+{
+	if ( freeBlocks.empty() )		return size;
+
+	const Block&		lastBlock = freeBlocks.back();
+	return lastBlock.offset + lastBlock.size == size ? lastBlock.offset : size;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get size of free blocks between allocated ranges
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::FreeListAllocator::GetHoleSize() const
+{
+	return freeSize - ( size - GetUsedSize() );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get fragmentation of free space: 0 - one free block, near 1 - many small blocks
+// ------------------------------------------------------------------------------------ //
+float le::FreeListAllocator::GetFragmentation() const
+{
+	if ( freeSize == 0 )		return 0.f;
+
+	UInt32_t		largestBlock = 0;
+	for ( UInt32_t index = 0, count = freeBlocks.size(); index < count; ++index )
+		if ( freeBlocks[ index ].size > largestBlock )
+			largestBlock = freeBlocks[ index ].size;
+
+	return 1.f - ( float ) largestBlock / freeSize;
+}
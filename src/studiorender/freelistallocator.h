@@ -0,0 +1,72 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef FREELISTALLOCATOR_H
+#define FREELISTALLOCATOR_H
+
+#include <vector>
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Suballocator of ranges in one big buffer. Free blocks are sorted by offset
+	// and merged with neighbours on free, allocation takes first block that fits
+	class FreeListAllocator
+	{
+	public:
+		//---------------------------------------------------------------------//
+
+		struct Block
+		{
+			UInt32_t		offset;
+			UInt32_t		size;
+		};
+
+		//---------------------------------------------------------------------//
+
+		FreeListAllocator();
+
+		void					Initialize( UInt32_t Size );
+		bool					Allocate( UInt32_t Size, UInt32_t Alignment, UInt32_t& Offset );
+		void					Free( UInt32_t Offset, UInt32_t Size );
+		void					Grow( UInt32_t Size );
+
+		// Used size is end of last allocated range, free blocks below it are holes
+		UInt32_t				GetUsedSize() const;
+		UInt32_t				GetHoleSize() const;
+		float					GetFragmentation() const;
+
+		inline UInt32_t			GetSize() const
+		{
+			return size;
+		}
+
+		inline UInt32_t			GetFreeSize() const
+		{
+			return freeSize;
+		}
+
+	private:
+		UInt32_t					size;
+		UInt32_t					freeSize;
+		std::vector< Block >		freeBlocks;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !FREELISTALLOCATOR_H
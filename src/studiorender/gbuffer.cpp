@@ -12,16 +12,35 @@
 
 #include "common/types.h"
 #include "engine/iconsolesystem.h"
-#include "studiorender/studiorendersampler.h"
 #include "global.h"
+#include "rendertargetpool.h"
 #include "gbuffer.h"
 
+// Форматы буферов для раскладок: альбедо + блик, нормаль + блеск, эмиссия, итоговый кадр
+static const le::IMAGE_FORMAT		gbufferFormats[ 2 ][ 4 ] =
+{
+	{ le::IF_RGBA_16FLOAT, le::IF_RGBA_16FLOAT, le::IF_RGBA_16FLOAT, le::IF_RGBA_16FLOAT },
+	{ le::IF_RGBA_8UNORM, le::IF_RGB10_A2_UNORM, le::IF_R11G11B10_FLOAT, le::IF_R11G11B10_FLOAT }
+};
+
 // ------------------------------------------------------------------------------------ //
 // Конструктор
 // ------------------------------------------------------------------------------------ //
 le::GBuffer::GBuffer() :
 	isInitialize( false ),
-	handle_frameBuffer( 0 )
+	layoutType( LT_DEFAULT ),
+	size( 0, 0 ),
+	outputSize( 0, 0 ),
+	targetSize( 0, 0 ),
+	countShrinkFrames( 0 ),
+	renderTargetPool( nullptr ),
+	handle_frameBuffer( 0 ),
+	depth( nullptr ),
+	albedoSpecular( nullptr ),
+	normalShininess( nullptr ),
+	emission( nullptr ),
+	finalFrame( nullptr ),
+	isTargetsAcquired( false )
 {}
 
 // ------------------------------------------------------------------------------------ //
@@ -33,93 +52,137 @@ le::GBuffer::~GBuffer()
 }
 
 // ------------------------------------------------------------------------------------ //
-// Инициализировать графический буфер
+// Инициализировать графический буфер. Текстуры берутся из пула в начале каждого кадра
 // ------------------------------------------------------------------------------------ //
-bool le::GBuffer::Initialize( const Vector2DInt_t& WindowSize )
+bool le::GBuffer::Initialize( RenderTargetPool* RenderTargetPool, const Vector2DInt_t& WindowSize, LAYOUT_TYPE LayoutType )
 {
 	if ( isInitialize ) return true;
-
-	// Генерируем буферы
+	LIFEENGINE_ASSERT( RenderTargetPool );
 
 	glGenFramebuffers( 1, &handle_frameBuffer );
-	glBindFramebuffer( GL_FRAMEBUFFER, handle_frameBuffer );
 
-	StudioRenderSampler			sampler;
-	sampler.minFilter = SF_NEAREST;
-	sampler.magFilter = SF_NEAREST;
+	renderTargetPool = RenderTargetPool;
+	layoutType = LayoutType;
+	isInitialize = true;
 
-	// Присоединяем буфер Albedo + Specular
-	
-	albedoSpecular.Initialize( TT_2D, IF_RGBA_16FLOAT, WindowSize.x, WindowSize.y );
-	albedoSpecular.Bind();
-	albedoSpecular.Append( nullptr );
-	albedoSpecular.SetSampler( sampler );
-	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoSpecular.GetHandle(), 0 );
+	// Создаем буферы сразу, чтобы проверить поддержку форматов раскладки
+	if ( !Begin( WindowSize, WindowSize ) )
+	{
+		Delete();
+		return false;
+	}
 
-	// Присоединяем буфер Normal + Shininess
+	End();
 
-	normalShininess.Initialize( TT_2D, IF_RGBA_16FLOAT, WindowSize.x, WindowSize.y );
-	normalShininess.Bind();
-	normalShininess.Append( nullptr );
-	normalShininess.SetSampler( sampler );
-	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalShininess.GetHandle(), 0 );
+	// Для сравнения выводим трафик обеих раскладок: эмиссия и один направленный свет
+	g_consoleSystem->PrintInfo( "GBuffer initialized with size (%ix%i), %s layout, %i bytes per pixel", size.x, size.y,
+								layoutType == LT_COMPACT ? "compact" : "default", GetBytesPerPixel( layoutType ) );
+	g_consoleSystem->PrintInfo( "GBuffer bandwidth per frame: default layout %.1f MB, compact layout %.1f MB",
+								GetFrameBandwidth( LT_DEFAULT, size, 2 ) / ( 1024.f * 1024.f ), GetFrameBandwidth( LT_COMPACT, size, 2 ) / ( 1024.f * 1024.f ) );
+	return true;
+}
 
-	// Присоединяем буфер Emission
-	
-	emission.Initialize( TT_2D, IF_RGBA_16FLOAT, WindowSize.x, WindowSize.y );
-	emission.Bind();
-	emission.Append( nullptr );
-	emission.SetSampler( sampler );
-	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, emission.GetHandle(), 0 );
+// ------------------------------------------------------------------------------------ //
+// Удалить графический буфер
+// ------------------------------------------------------------------------------------ //
+void le::GBuffer::Delete()
+{
+	if ( isTargetsAcquired )			End();
+	if ( handle_frameBuffer > 0 )		glDeleteFramebuffers( 1, &handle_frameBuffer );
 
-	// Инициалищируем финальный кадр
+	handle_frameBuffer = 0;
+	depth = albedoSpecular = normalShininess = emission = finalFrame = nullptr;
+	targetSize = Vector2DInt_t( 0, 0 );
+	isInitialize = false;
+}
 
-	finalFrame.Initialize( TT_2D, IF_RGBA_16FLOAT, WindowSize.x, WindowSize.y );
-	finalFrame.Bind();
-	finalFrame.Append( nullptr );
-	finalFrame.SetSampler( sampler );
-	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, finalFrame.GetHandle(), 0 );
+// ------------------------------------------------------------------------------------ //
+// Начать кадр: взять буферы из пула для размера вывода
+// ------------------------------------------------------------------------------------ //
+bool le::GBuffer::Begin( const Vector2DInt_t& RenderSize, const Vector2DInt_t& OutputSize )
+{
+	if ( !isInitialize || isTargetsAcquired ) return isTargetsAcquired;
 
-	// Инициализируем буфер глубины
+	// Размер буферов зависит только от вывода, поэтому смена масштаба кадра не пересоздает их
+	Vector2DInt_t		frameSize = glm::max( RenderSize, OutputSize );
 
-	depth.Initialize( TT_2D, IF_DEPTH24_STENCIL8, WindowSize.x, WindowSize.y );
-	depth.Bind();
-	depth.Append( nullptr );
-	depth.SetSampler( sampler );
-	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth.GetHandle(), 0 );
+	// Под увеличенный кадр буферы выделяем сразу, с шагом, чтобы растягивание окна не создавало их каждый кадр.
+	// Уменьшаем только когда меньший размер держится GBUFFER_SHRINK_FRAMES кадров, до этого рисуем в часть буфера
+	Vector2DInt_t		alignedSize = ( ( glm::max( frameSize, Vector2DInt_t( 1, 1 ) ) + GBUFFER_SIZE_STEP - 1 ) / GBUFFER_SIZE_STEP ) * GBUFFER_SIZE_STEP;
+	if ( frameSize.x > targetSize.x || frameSize.y > targetSize.y )
+	{
+		targetSize = alignedSize;
+		countShrinkFrames = 0;
+	}
+	else if ( alignedSize != targetSize )
+	{
+		if ( ++countShrinkFrames >= GBUFFER_SHRINK_FRAMES )
+		{
+			targetSize = alignedSize;
+			countShrinkFrames = 0;
+		}
+	}
+	else
+		countShrinkFrames = 0;
 
-	// Проверяем статус FBO, создан ли он
+	const IMAGE_FORMAT*		formats = gbufferFormats[ layoutType ];
+	Texture*				targets[] =
+	{
+		renderTargetPool->Acquire( formats[ 0 ], targetSize.x, targetSize.y ),
+		renderTargetPool->Acquire( formats[ 1 ], targetSize.x, targetSize.y ),
+		renderTargetPool->Acquire( formats[ 2 ], targetSize.x, targetSize.y ),
+		renderTargetPool->Acquire( formats[ 3 ], targetSize.x, targetSize.y ),
+		renderTargetPool->Acquire( IF_DEPTH24_STENCIL8, targetSize.x, targetSize.y )
+	};
+
+	size = glm::max( RenderSize, Vector2DInt_t( 1, 1 ) );
+	outputSize = OutputSize;
+	isTargetsAcquired = true;
+
+	// Пул отдает текстуры прошлого кадра, поэтому присоединяем их заново только после смены размера
+	if ( targets[ 0 ] == albedoSpecular && targets[ 1 ] == normalShininess && targets[ 2 ] == emission && targets[ 3 ] == finalFrame && targets[ 4 ] == depth )
+		return true;
+
+	albedoSpecular = targets[ 0 ];
+	normalShininess = targets[ 1 ];
+	emission = targets[ 2 ];
+	finalFrame = targets[ 3 ];
+	depth = targets[ 4 ];
+
+	glBindFramebuffer( GL_FRAMEBUFFER, handle_frameBuffer );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoSpecular->GetHandle(), 0 );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalShininess->GetHandle(), 0 );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, emission->GetHandle(), 0 );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, finalFrame->GetHandle(), 0 );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth->GetHandle(), 0 );
 
+	// Проверяем статус FBO, создан ли он
 	GLenum		status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
 	if ( status != GL_FRAMEBUFFER_COMPLETE )
 	{
 		g_consoleSystem->PrintError( "Framebuffer status [0x%i]", status );
-		Delete();
+		End();
 		return false;
 	}
 
-	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
-
-	windowSize = WindowSize;
-	isInitialize = true;
-
-	g_consoleSystem->PrintInfo( "GBuffer initialized with size (%ix%i)", windowSize.x, windowSize.y );
 	return true;
 }
 
 // ------------------------------------------------------------------------------------ //
-// Удалить графический буфер
+// Закончить кадр: вернуть буферы в пул, их могут взять другие проходы
 // ------------------------------------------------------------------------------------ //
-void le::GBuffer::Delete()
+void le::GBuffer::End()
 {
-	if ( handle_frameBuffer > 0 )		glDeleteFramebuffers( 1, &handle_frameBuffer );
-	if ( depth.IsCreated() )			depth.Delete();
-	if ( albedoSpecular.IsCreated() )	albedoSpecular.Delete();
-	if ( normalShininess.IsCreated() )	normalShininess.Delete();
-	if ( emission.IsCreated() )			emission.Delete();
-	if ( finalFrame.IsCreated() )		finalFrame.Delete();
-
-	isInitialize = false;
+	if ( !isTargetsAcquired ) return;
+
+	renderTargetPool->Release( albedoSpecular );
+	renderTargetPool->Release( normalShininess );
+	renderTargetPool->Release( emission );
+	renderTargetPool->Release( finalFrame );
+	renderTargetPool->Release( depth );
+	isTargetsAcquired = false;
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -127,7 +190,7 @@ void le::GBuffer::Delete()
 // ------------------------------------------------------------------------------------ //
 void le::GBuffer::Bind( BIND_TYPE BindType )
 {
-	if ( !isInitialize ) return;
+	if ( !isTargetsAcquired ) return;
 
 	switch ( BindType )
 	{
@@ -144,16 +207,16 @@ void le::GBuffer::Bind( BIND_TYPE BindType )
 		glDrawBuffer( GL_COLOR_ATTACHMENT3 );
 
 		// Albedo + Specular
-		albedoSpecular.Bind( 0 );
+		albedoSpecular->Bind( 0 );
 
 		// Normal + Shininess
-		normalShininess.Bind( 1 );
+		normalShininess->Bind( 1 );
 
 		// Emission
-		emission.Bind( 2 );
+		emission->Bind( 2 );
 
 		// Depth
-		depth.Bind( 3 );
+		depth->Bind( 3 );
 		break;
 
 	default:
@@ -176,11 +239,14 @@ void le::GBuffer::Unbind()
 // ------------------------------------------------------------------------------------ //
 void le::GBuffer::ShowFinalFrame()
 {
+	if ( !isTargetsAcquired ) return;
+
 	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
 	glBindFramebuffer( GL_READ_FRAMEBUFFER, handle_frameBuffer );
 
+	// Буфер может быть больше кадра, копируем только занятую кадром часть и растягиваем ее на весь вывод
 	glReadBuffer( GL_COLOR_ATTACHMENT3 ); 
-	glBlitFramebuffer( 0, 0, windowSize.x, windowSize.y, 0, 0, windowSize.x, windowSize.y, GL_COLOR_BUFFER_BIT, GL_LINEAR );
+	glBlitFramebuffer( 0, 0, size.x, size.y, 0, 0, outputSize.x, outputSize.y, GL_COLOR_BUFFER_BIT, GL_LINEAR );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -188,23 +254,25 @@ void le::GBuffer::ShowFinalFrame()
 // ------------------------------------------------------------------------------------ //
 void le::GBuffer::ShowBuffers()
 {
+	if ( !isTargetsAcquired ) return;
+
 	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
 	glBindFramebuffer( GL_READ_FRAMEBUFFER, handle_frameBuffer );
 
-	float			halfWidth = windowSize.x / 2.f;
-	float			halfHeight = windowSize.y / 2.f;
+	float			halfWidth = outputSize.x / 2.f;
+	float			halfHeight = outputSize.y / 2.f;
 
 	 //Albedo + Specular
 	glReadBuffer( GL_COLOR_ATTACHMENT0 ); 
-	glBlitFramebuffer( 0, 0, windowSize.x, windowSize.y, 0, 0, halfWidth, halfHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR );
+	glBlitFramebuffer( 0, 0, size.x, size.y, 0, 0, halfWidth, halfHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR );
 	
 	// Normal + Shininess
 	glReadBuffer( GL_COLOR_ATTACHMENT1 ); 
-	glBlitFramebuffer( 0, 0, windowSize.x, windowSize.y, 0, halfHeight, halfWidth, windowSize.y, GL_COLOR_BUFFER_BIT, GL_LINEAR );
+	glBlitFramebuffer( 0, 0, size.x, size.y, 0, halfHeight, halfWidth, outputSize.y, GL_COLOR_BUFFER_BIT, GL_LINEAR );
 	
 	// Emission
 	glReadBuffer( GL_COLOR_ATTACHMENT2 ); 
-	glBlitFramebuffer( 0, 0, windowSize.x, windowSize.y, halfWidth, halfHeight, windowSize.x, windowSize.y, GL_COLOR_BUFFER_BIT, GL_LINEAR );
+	glBlitFramebuffer( 0, 0, size.x, size.y, halfWidth, halfHeight, outputSize.x, outputSize.y, GL_COLOR_BUFFER_BIT, GL_LINEAR );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -214,3 +282,73 @@ bool le::GBuffer::IsInitialize() const
 {
 	return isInitialize;
 }
+
+// ------------------------------------------------------------------------------------ //
+// Получить трафик кадра
+// ------------------------------------------------------------------------------------ //
+le::UInt64_t le::GBuffer::GetFrameBandwidth( UInt32_t CountFullscreenPasses ) const
+{
+	return GetFrameBandwidth( layoutType, size, CountFullscreenPasses );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Получить размер пикселя всех буферов раскладки
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::GBuffer::GetBytesPerPixel( LAYOUT_TYPE LayoutType )
+{
+	UInt32_t		pixelSize = RenderTargetPool::GetPixelSize( IF_DEPTH24_STENCIL8 );
+	for ( UInt32_t index = 0; index < 4; ++index )
+		pixelSize += RenderTargetPool::GetPixelSize( gbufferFormats[ LayoutType ][ index ] );
+
+	return pixelSize;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Получить трафик кадра для раскладки. Проход геометрии пишет буферы и глубину,
+// каждый полноэкранный проход их читает и смешивает итоговый кадр, в конце кадр выводится
+// ------------------------------------------------------------------------------------ //
+le::UInt64_t le::GBuffer::GetFrameBandwidth( LAYOUT_TYPE LayoutType, const Vector2DInt_t& Size, UInt32_t CountFullscreenPasses )
+{
+	const IMAGE_FORMAT*		formats = gbufferFormats[ LayoutType ];
+	UInt64_t				geometrySize = RenderTargetPool::GetPixelSize( formats[ 0 ] ) + RenderTargetPool::GetPixelSize( formats[ 1 ] ) + RenderTargetPool::GetPixelSize( formats[ 2 ] ) + RenderTargetPool::GetPixelSize( IF_DEPTH24_STENCIL8 );
+	UInt64_t				finalFrameSize = RenderTargetPool::GetPixelSize( formats[ 3 ] );
+	UInt64_t				pixelSize = geometrySize + CountFullscreenPasses * ( geometrySize + finalFrameSize * 2 ) + finalFrameSize;
+
+	return pixelSize * Size.x * Size.y;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Получить код GLSL раскладки. В компактной раскладке нормаль кодируется октаэдрически
+// в два канала RGB10A2, а степень блеска до 255 нормируется в третий
+// ------------------------------------------------------------------------------------ //
+const char* le::GBuffer::GetShaderCode( LAYOUT_TYPE LayoutType )
+{
+	if ( LayoutType == LT_DEFAULT )
+		return "\
+	vec4 GBuffer_EncodeNormal( vec3 Normal, float Shininess ) { return vec4( Normal, Shininess ); }\n\
+	vec4 GBuffer_DecodeNormal( vec4 Value ) { return Value; }\n";
+
+	return "\
+	#define GBUFFER_COMPACT\n\
+	#define GBUFFER_MAX_SHININESS 255.f\n\
+	\n\
+	vec2 GBuffer_OctWrap( vec2 Value )\n\
+	{\n\
+		return ( 1.f - abs( Value.yx ) ) * vec2( Value.x >= 0.f ? 1.f : -1.f, Value.y >= 0.f ? 1.f : -1.f );\n\
+	}\n\
+	\n\
+	vec4 GBuffer_EncodeNormal( vec3 Normal, float Shininess )\n\
+	{\n\
+		Normal /= max( abs( Normal.x ) + abs( Normal.y ) + abs( Normal.z ), 0.00001f );\n\
+		vec2		octahedral = Normal.z >= 0.f ? Normal.xy : GBuffer_OctWrap( Normal.xy );\n\
+		return vec4( octahedral * 0.5f + 0.5f, clamp( Shininess / GBUFFER_MAX_SHININESS, 0.f, 1.f ), 0.f );\n\
+	}\n\
+	\n\
+	vec4 GBuffer_DecodeNormal( vec4 Value )\n\
+	{\n\
+		vec2		octahedral = Value.xy * 2.f - 1.f;\n\
+		vec3		normal = vec3( octahedral, 1.f - abs( octahedral.x ) - abs( octahedral.y ) );\n\
+		if ( normal.z < 0.f )		normal.xy = GBuffer_OctWrap( normal.xy );\n\
+		return vec4( normalize( normal ), Value.z * GBUFFER_MAX_SHININESS );\n\
+	}\n";
+}
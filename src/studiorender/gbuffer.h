@@ -16,10 +16,19 @@
 
 //---------------------------------------------------------------------//
 
+#define GBUFFER_SIZE_STEP			64			// Шаг размера буферов в пикселях
+#define GBUFFER_SHRINK_FRAMES		60			// Через сколько кадров буферы уменьшаются под меньший кадр
+
+//---------------------------------------------------------------------//
+
 namespace le
 {
 	//---------------------------------------------------------------------//
 
+	class RenderTargetPool;
+
+	//---------------------------------------------------------------------//
+
 	class GBuffer
 	{
 	public:
@@ -44,28 +53,62 @@ namespace le
 
 		//---------------------------------------------------------------------//
 
+		// Раскладка буферов. Компактная: RGBA8 альбедо и блик, RGB10A2 октаэдрическая нормаль и
+		// степень блеска, R11G11B10F эмиссия и R11G11B10F итоговый кадр - 20 байт на пиксель вместо 36
+		enum LAYOUT_TYPE
+		{
+			LT_DEFAULT,
+			LT_COMPACT
+		};
+
+		//---------------------------------------------------------------------//
+
 		GBuffer();
 		~GBuffer();
 
-		bool			Initialize( const Vector2DInt_t& WindowSize );
+		bool			Initialize( RenderTargetPool* RenderTargetPool, const Vector2DInt_t& WindowSize, LAYOUT_TYPE LayoutType = LT_DEFAULT );
 		void			Delete();
+
+		// Буферы живут один кадр: Begin берет их из пула под размер вывода, End возвращает.
+		// Кадр рисуется в часть буферов размером RenderSize, при выводе растягивается до OutputSize
+		bool			Begin( const Vector2DInt_t& RenderSize, const Vector2DInt_t& OutputSize );
+		void			End();
 		void			Bind( BIND_TYPE BindType );
 		void			Unbind();
 		void			ShowBuffers();
 		void			ShowFinalFrame();
 
 		bool			IsInitialize() const;
+		inline LAYOUT_TYPE	GetLayoutType() const { return layoutType; }
+		inline const Vector2DInt_t&		GetSize() const { return size; }
+		inline const Vector2DInt_t&		GetOutputSize() const { return outputSize; }
+		inline const Vector2DInt_t&		GetTargetSize() const { return targetSize; }
+
+		// Трафик кадра: проход геометрии, полноэкранные проходы освещения и вывод кадра
+		UInt64_t		GetFrameBandwidth( UInt32_t CountFullscreenPasses ) const;
+
+		static UInt32_t		GetBytesPerPixel( LAYOUT_TYPE LayoutType );
+		static UInt64_t		GetFrameBandwidth( LAYOUT_TYPE LayoutType, const Vector2DInt_t& Size, UInt32_t CountFullscreenPasses );
+
+		// Код GLSL для кодирования нормали в буфер и ее чтения, добавляется во все шейдеры
+		static const char*	GetShaderCode( LAYOUT_TYPE LayoutType );
 
 	private:
-		bool			isInitialize;
-		Vector2DInt_t	windowSize;
-
-		UInt32_t		handle_frameBuffer;
-		Texture			depth;
-		Texture			albedoSpecular;
-		Texture			normalShininess;
-		Texture			emission;
-		Texture 		finalFrame;
+		bool				isInitialize;
+		LAYOUT_TYPE			layoutType;
+		Vector2DInt_t		size;
+		Vector2DInt_t		outputSize;
+		Vector2DInt_t		targetSize;
+		UInt32_t			countShrinkFrames;
+		RenderTargetPool*	renderTargetPool;
+
+		UInt32_t			handle_frameBuffer;
+		Texture*			depth;
+		Texture*			albedoSpecular;
+		Texture*			normalShininess;
+		Texture*			emission;
+		Texture*			finalFrame;
+		bool				isTargetsAcquired;
 	};
 
 	//---------------------------------------------------------------------//
@@ -8,6 +8,7 @@
 //
 //////////////////////////////////////////////////////////////////////////
 
+#include "engine/istatssystem.h"
 #include "global.h"
 
 //---------------------------------------------------------------------//
@@ -19,6 +20,7 @@ namespace le
 	IConsoleSystem*				g_consoleSystem = nullptr;
 	StudioRender*				g_studioRender = nullptr;
 	IEngine*					g_engine = nullptr;
+	Stat						g_statTextureBinds;
 
 	//---------------------------------------------------------------------//
 }
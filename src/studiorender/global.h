@@ -31,6 +31,11 @@ namespace le
 	extern IEngine*							g_engine;
 
 	//---------------------------------------------------------------------//
+
+	class Stat;
+	extern Stat								g_statTextureBinds;
+
+	//---------------------------------------------------------------------//
 }
 
 //---------------------------------------------------------------------//
@@ -0,0 +1,128 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <GL/glew.h>
+
+#include "engine/lifeengine.h"
+#include "gpucounter.h"
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::GPUCounter::GPUCounter() :
+	target( 0 ),
+	isQueryStarted( false ),
+	currentQuery( 0 ),
+	result( 0 ),
+	resultFrameValue( 0.0 ),
+	countResults( 0 )
+{
+	for ( UInt32_t index = 0; index < GPUCOUNTER_COUNT_QUERIES; ++index )
+	{
+		handle_queries[ index ] = 0;
+		isQueryPending[ index ] = false;
+		frameValues[ index ] = 0.0;
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor
+// ------------------------------------------------------------------------------------ //
+le::GPUCounter::~GPUCounter()
+{
+	Delete();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Create queries
+// ------------------------------------------------------------------------------------ //
+bool le::GPUCounter::Create( UInt32_t Target )
+{
+	if ( IsCreated() )		Delete();
+
+	glGenQueries( GPUCOUNTER_COUNT_QUERIES, handle_queries );
+	for ( UInt32_t index = 0; index < GPUCOUNTER_COUNT_QUERIES; ++index )
+		if ( handle_queries[ index ] == 0 )
+		{
+			Delete();
+			return false;
+		}
+
+	target = Target;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Delete queries
+// ------------------------------------------------------------------------------------ //
+void le::GPUCounter::Delete()
+{
+	if ( IsCreated() )		glDeleteQueries( GPUCOUNTER_COUNT_QUERIES, handle_queries );
+
+	for ( UInt32_t index = 0; index < GPUCOUNTER_COUNT_QUERIES; ++index )
+	{
+		handle_queries[ index ] = 0;
+		isQueryPending[ index ] = false;
+	}
+
+	isQueryStarted = false;
+	currentQuery = 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Begin query of frame
+// ------------------------------------------------------------------------------------ //
+void le::GPUCounter::Begin( double FrameValue )
+{
+	// GPU is behind by more frames than there are queries - skip this frame, not wait
+	if ( !IsCreated() || isQueryPending[ currentQuery ] )
+	{
+		isQueryStarted = false;
+		return;
+	}
+
+	glBeginQuery( target, handle_queries[ currentQuery ] );
+	frameValues[ currentQuery ] = FrameValue;
+	isQueryStarted = true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// End query of frame and read ready results from oldest
+// ------------------------------------------------------------------------------------ //
+void le::GPUCounter::End()
+{
+	if ( !IsCreated() )		return;
+
+	if ( isQueryStarted )
+	{
+		glEndQuery( target );
+		isQueryPending[ currentQuery ] = true;
+		isQueryStarted = false;
+		currentQuery = ( currentQuery + 1 ) % GPUCOUNTER_COUNT_QUERIES;
+	}
+
+	for ( UInt32_t index = 0; index < GPUCOUNTER_COUNT_QUERIES; ++index )
+	{
+		UInt32_t		query = ( currentQuery + index ) % GPUCOUNTER_COUNT_QUERIES;
+		if ( !isQueryPending[ query ] )		continue;
+
+		GLint			isAvailable = GL_FALSE;
+		glGetQueryObjectiv( handle_queries[ query ], GL_QUERY_RESULT_AVAILABLE, &isAvailable );
+		if ( !isAvailable )		break;
+
+		GLuint64		value = 0;
+		glGetQueryObjectui64v( handle_queries[ query ], GL_QUERY_RESULT, &value );
+
+		result = value;
+		resultFrameValue = frameValues[ query ];
+		isQueryPending[ query ] = false;
+		++countResults;
+	}
+}
@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef GPUCOUNTER_H
+#define GPUCOUNTER_H
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+#define GPUCOUNTER_COUNT_QUERIES		2			// Queries are double buffered, result of frame is read on next frames
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Ring of GL queries of one target (GL_TIME_ELAPSED, GL_SAMPLES_PASSED). Query is never
+	// waited: if its result isn't ready when slot is needed again, frame is not measured
+	class GPUCounter
+	{
+	public:
+		GPUCounter();
+		~GPUCounter();
+
+		bool					Create( UInt32_t Target );
+		void					Delete();
+
+		// Value of frame (e.g. render area) is kept with query and returned with its result
+		void					Begin( double FrameValue = 0.0 );
+
+		// End query of frame and read results of previous frames
+		void					End();
+
+		inline bool				IsCreated() const
+		{
+			return handle_queries[ 0 ] > 0;
+		}
+
+		// Result of last measured frame
+		inline UInt64_t			GetResult() const
+		{
+			return result;
+		}
+
+		// Value passed to Begin of last measured frame
+		inline double			GetResultFrameValue() const
+		{
+			return resultFrameValue;
+		}
+
+		// Grows with every read result, so user can see that result is new
+		inline UInt32_t			GetCountResults() const
+		{
+			return countResults;
+		}
+
+	private:
+		UInt32_t				target;
+		UInt32_t				handle_queries[ GPUCOUNTER_COUNT_QUERIES ];
+		bool					isQueryPending[ GPUCOUNTER_COUNT_QUERIES ];
+		double					frameValues[ GPUCOUNTER_COUNT_QUERIES ];
+		bool					isQueryStarted;
+		UInt32_t				currentQuery;
+		UInt64_t				result;
+		double					resultFrameValue;
+		UInt32_t				countResults;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !GPUCOUNTER_H
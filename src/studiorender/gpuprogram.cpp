@@ -13,8 +13,11 @@
 #include "engine/lifeengine.h"
 #include "engine/iconsolesystem.h"
 #include "gpuprogram.h"
+#include "studiorender.h"
 #include "global.h"
 
+std::string			le::GPUProgram::commonCode;
+
 // ------------------------------------------------------------------------------------ //
 // Вставить дефайны в код шейдера
 // ------------------------------------------------------------------------------------ //
@@ -38,6 +41,7 @@ inline void InstertDefinesToShaderCode( std::string& CodeShader, const std::stri
 // ------------------------------------------------------------------------------------ //
 bool le::GPUProgram::Compile( const ShaderDescriptor& ShaderDescriptor, UInt32_t CountDefines, const char** Defines )
 {
+	ContextLock				contextLock;
 	std::string				defineCode;
 	std::string				codeShader;
 
@@ -45,6 +49,8 @@ bool le::GPUProgram::Compile( const ShaderDescriptor& ShaderDescriptor, UInt32_t
 		for ( UInt32_t index = 0; index < CountDefines; ++index )
 			defineCode += "#define " + std::string( Defines[ index ] ) + "\n";
 
+	defineCode += commonCode;
+
 	// Если шейдер ранее был создан - удаляем
 	if ( programID > 0 )		Clear();
 
@@ -79,6 +85,13 @@ bool le::GPUProgram::Compile( const ShaderDescriptor& ShaderDescriptor, UInt32_t
 
 		// Линкуем шейдер
 		if ( !Link() )		throw;
+
+		// Привязываем блоки данных сцены и объекта, если шейдер их использует
+		GLuint			blockIndex = glGetUniformBlockIndex( programID, "SceneData" );
+		if ( blockIndex != GL_INVALID_INDEX )		glUniformBlockBinding( programID, blockIndex, GPUPROGRAM_SCENE_UNIFORM_BINDING );
+
+		blockIndex = glGetUniformBlockIndex( programID, "ObjectData" );
+		if ( blockIndex != GL_INVALID_INDEX )		glUniformBlockBinding( programID, blockIndex, GPUPROGRAM_OBJECT_UNIFORM_BINDING );
 	}
 	catch ( ... )
 	{
@@ -112,6 +125,8 @@ void le::GPUProgram::Unbind()
 // ------------------------------------------------------------------------------------ //
 void le::GPUProgram::Clear()
 {
+	ContextLock			contextLock;
+
 	if ( vertexShaderID != 0 )		glDeleteShader( vertexShaderID );
 	if ( geometryShaderID != 0 )	glDeleteShader( geometryShaderID );
 	if ( fragmentShaderID != 0 )	glDeleteShader( fragmentShaderID );
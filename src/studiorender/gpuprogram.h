@@ -19,6 +19,12 @@
 
 //---------------------------------------------------------------------//
 
+// Точки привязки блоков SceneData и ObjectData, данные для них рендер пишет в потоковый буфер
+#define GPUPROGRAM_SCENE_UNIFORM_BINDING		1
+#define GPUPROGRAM_OBJECT_UNIFORM_BINDING		2
+
+//---------------------------------------------------------------------//
+
 namespace le
 {
 	//---------------------------------------------------------------------//
@@ -46,6 +52,17 @@ namespace le
 		GPUProgram();
 		~GPUProgram();
 
+		inline UInt32_t				GetHandle() const
+		{
+			return programID;
+		}
+
+		// Общий код, который вставляется после дефайнов во все шейдеры (функции G-буфера)
+		static inline void			SetCommonCode( const char* Code )
+		{
+			commonCode = Code ? Code : "";
+		}
+
 	private:
 		// GPUProgram
 		bool						Compile_VertexShader( const char* Code );
@@ -61,6 +78,8 @@ namespace le
 		GLuint						programID;
 
 		std::unordered_map< std::string, UInt32_t >		uniforms;
+
+		static std::string								commonCode;
 	};
 
 	//---------------------------------------------------------------------//
@@ -11,6 +11,7 @@
 #ifndef INDEX_BUFFER_OBJECT_H
 #define INDEX_BUFFER_OBJECT_H
 
+#include <utility>
 #include <GL/glew.h>
 
 #include "common/types.h"
@@ -39,6 +40,7 @@ namespace le
 		{
 			if ( handle == 0 ) return;
 			glDeleteBuffers( 1, &handle );
+			handle = 0;
 		}
 
 		inline void					Allocate( const void* Data, UInt32_t Size )
@@ -68,6 +70,12 @@ namespace le
 			glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
 		}
 
+		inline void					Swap( IndexBufferObject& Other )
+		{
+			std::swap( handle, Other.handle );
+			std::swap( typeUsage, Other.typeUsage );
+		}
+
 		inline void					SetTypeUsage( TYPE_USAGE_BUFFER TypeUsage )
 		{
 			typeUsage = TypeUsage;
@@ -0,0 +1,47 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef MATERIAL_BATCH_H
+#define MATERIAL_BATCH_H
+
+#include <vector>
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	class VertexArrayObject;
+	class MaterialTable;
+
+	//---------------------------------------------------------------------//
+
+	struct MaterialBatch
+	{
+		VertexArrayObject*				vertexArrayObject;
+		const MaterialTable*			materialTable;
+		UInt32_t						group;
+		UInt32_t						indexType;
+		UInt32_t						transformation;
+		UInt32_t						uniformOffset;
+		std::vector< Int32_t >			counts;
+		std::vector< void* >			offsets;
+		std::vector< Int32_t >			baseVerteces;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !MATERIAL_BATCH_H
@@ -0,0 +1,348 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <stdint.h>
+#include <GL/glew.h>
+
+#include "common/meshdescriptor.h"
+#include "common/meshsurface.h"
+#include "engine/lifeengine.h"
+#include "engine/imaterial.h"
+#include "engine/iconsolesystem.h"
+#include "studiorender/imesh.h"
+#include "studiorender/ishaderparameter.h"
+#include "studiorender/istudiorendertechnique.h"
+#include "studiorender/studiovertexelement.h"
+
+#include "global.h"
+#include "texture.h"
+#include "studiorendertechnique.h"
+#include "studiorenderpass.h"
+#include "vertexarrayobject.h"
+#include "materialtable.h"
+
+struct MaterialTableImageFormat
+{
+	le::UInt32_t		internalFormat;
+	le::UInt32_t		format;
+	le::UInt32_t		bytesPerPixel;
+};
+
+// ------------------------------------------------------------------------------------ //
+// Get OpenGL format for texture array layer. Only 8-bit formats can be copied
+// ------------------------------------------------------------------------------------ //
+inline bool MaterialTable_GetImageFormat( le::IMAGE_FORMAT ImageFormat, MaterialTableImageFormat& Format )
+{
+	switch ( ImageFormat )
+	{
+	case le::IF_RGBA_8UNORM:	Format = { GL_RGBA8, GL_RGBA, 4 };	return true;
+	case le::IF_RGB_8UNORM:		Format = { GL_RGB8, GL_RGB, 3 };	return true;
+	default:					return false;
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Create texture array and copy first mipmap of textures to layers
+// ------------------------------------------------------------------------------------ //
+inline le::UInt32_t MaterialTable_CreateTextureArray( le::Texture** Textures, le::UInt32_t CountTextures, le::UInt32_t CountLayers, bool IsGenerateMipmaps )
+{
+	LIFEENGINE_ASSERT( Textures && CountTextures > 0 && CountLayers >= CountTextures );
+
+	MaterialTableImageFormat		format;
+	MaterialTable_GetImageFormat( Textures[ 0 ]->GetImageFormat(), format );
+
+	le::UInt32_t					width = Textures[ 0 ]->GetWidth();
+	le::UInt32_t					height = Textures[ 0 ]->GetHeight();
+	le::UInt32_t					handle = 0;
+	std::vector< le::UInt8_t >		buffer( width * height * format.bytesPerPixel, 255 );
+
+	glGenTextures( 1, &handle );
+	glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D_ARRAY, handle );
+	glTexImage3D( GL_TEXTURE_2D_ARRAY, 0, format.internalFormat, width, height, CountLayers, 0, format.format, GL_UNSIGNED_BYTE, nullptr );
+
+	glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+	// Layers without texture stay white
+	for ( le::UInt32_t layer = CountTextures; layer < CountLayers; ++layer )
+		glTexSubImage3D( GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format.format, GL_UNSIGNED_BYTE, buffer.data() );
+
+	for ( le::UInt32_t layer = 0; layer < CountTextures; ++layer )
+	{
+		glBindTexture( GL_TEXTURE_2D, Textures[ layer ]->GetHandle() );
+		glGetTexImage( GL_TEXTURE_2D, 0, format.format, GL_UNSIGNED_BYTE, buffer.data() );
+		glTexSubImage3D( GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format.format, GL_UNSIGNED_BYTE, buffer.data() );
+	}
+
+	glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	if ( IsGenerateMipmaps )
+	{
+		glGenerateMipmap( GL_TEXTURE_2D_ARRAY );
+		glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT );
+		glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT );
+		glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+	}
+	else
+	{
+		glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	}
+
+	glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glBindTexture( GL_TEXTURE_2D_ARRAY, 0 );
+	return handle;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Build material table for mesh
+// ------------------------------------------------------------------------------------ //
+bool le::MaterialTable::Build( const MeshDescriptor& MeshDescriptor, VertexArrayObject& VertexArrayObject )
+{
+	if ( isBuilded )		Delete();
+	if ( !IsSupported( MeshDescriptor ) )		return false;
+
+	// All lightmaps must have one size and format, else they can't be placed to one texture array
+	std::vector< Texture* >			lightmaps;
+	MaterialTableImageFormat		format;
+
+	for ( UInt32_t index = 0; index < MeshDescriptor.countLightmaps; ++index )
+	{
+		Texture*		lightmap = ( Texture* ) MeshDescriptor.lightmaps[ index ];
+		if ( !lightmap || !lightmap->IsCreated() || !MaterialTable_GetImageFormat( lightmap->GetImageFormat(), format ) )
+			return false;
+
+		if ( !lightmaps.empty() && ( lightmap->GetWidth() != lightmaps[ 0 ]->GetWidth() || lightmap->GetHeight() != lightmaps[ 0 ]->GetHeight() || lightmap->GetImageFormat() != lightmaps[ 0 ]->GetImageFormat() ) )
+			return false;
+
+		lightmaps.push_back( lightmap );
+	}
+
+	// Distribute base textures of materials to groups with same size, format and render states
+	for ( UInt32_t index = 0; index < MeshDescriptor.countMaterials; ++index )
+	{
+		MaterialRecord			record = { false, 0, 0 };
+		StudioRenderPass*		pass = GetBatchablePass( MeshDescriptor.materials[ index ] );
+		Texture*				baseTexture = pass ? GetBaseTexture( pass ) : nullptr;
+
+		if ( baseTexture )
+		{
+			UInt32_t			group = 0;
+			for ( UInt32_t countGroups = groups.size(); group < countGroups; ++group )
+			{
+				TextureArrayGroup&			textureArrayGroup = groups[ group ];
+				if ( textureArrayGroup.width == baseTexture->GetWidth() && textureArrayGroup.height == baseTexture->GetHeight() && textureArrayGroup.imageFormat == baseTexture->GetImageFormat() &&
+					 textureArrayGroup.pass->IsCullFace() == pass->IsCullFace() && textureArrayGroup.pass->GetCullFaceType() == pass->GetCullFaceType() && textureArrayGroup.textures.size() < MATERIALTABLE_MAX_LAYERS )
+					break;
+			}
+
+			if ( group == groups.size() )
+				groups.push_back( { 0, baseTexture->GetWidth(), baseTexture->GetHeight(), baseTexture->GetImageFormat(), pass } );
+
+			std::vector< Texture* >&		textures = groups[ group ].textures;
+			UInt32_t						layer = 0;
+			for ( UInt32_t countLayers = textures.size(); layer < countLayers; ++layer )
+				if ( textures[ layer ] == baseTexture )
+					break;
+
+			if ( layer == textures.size() )
+				textures.push_back( baseTexture );
+
+			record = { true, group, layer };
+		}
+
+		records.push_back( record );
+	}
+
+	if ( groups.empty() )
+	{
+		Delete();
+		return false;
+	}
+
+	// Write material and lightmap index to every vertex of batched surfaces
+	UInt32_t			stride = 0;
+	for ( UInt32_t index = 0; index < MeshDescriptor.countVertexElements; ++index )
+		stride += MeshDescriptor.vertexElements[ index ].GetSize();
+
+	UInt32_t					countVerteces = stride > 0 ? MeshDescriptor.sizeVerteces / stride : 0;
+	std::vector< UInt32_t >		materialIndeces( countVerteces * 2, UINT32_MAX );
+
+	for ( UInt32_t indexSurface = 0; indexSurface < MeshDescriptor.countSurfaces; ++indexSurface )
+	{
+		const MeshSurface&		surface = MeshDescriptor.surfaces[ indexSurface ];
+		if ( surface.materialID >= records.size() || !records[ surface.materialID ].isBatched ) continue;
+
+		UInt32_t				lightmapLayer = surface.lightmapID < lightmaps.size() ? surface.lightmapID : lightmaps.size();
+		for ( UInt32_t index = surface.startIndex, count = surface.startIndex + surface.countIndeces; index < count && index < MeshDescriptor.countIndeces; ++index )
+		{
+			UInt32_t			vertex = surface.startVertexIndex + MeshDescriptor.indeces[ index ];
+			if ( vertex >= countVerteces )
+			{
+				Delete();
+				return false;
+			}
+
+			UInt32_t*			materialIndex = &materialIndeces[ vertex * 2 ];
+			if ( materialIndex[ 0 ] != UINT32_MAX && ( materialIndex[ 0 ] != surface.materialID || materialIndex[ 1 ] != lightmapLayer ) )
+			{
+				// Vertex shared between surfaces with different materials, per vertex index is impossible
+				Delete();
+				return false;
+			}
+
+			materialIndex[ 0 ] = surface.materialID;
+			materialIndex[ 1 ] = lightmapLayer;
+		}
+	}
+
+	for ( UInt32_t index = 0, count = materialIndeces.size(); index < count; ++index )
+		if ( materialIndeces[ index ] == UINT32_MAX )
+			materialIndeces[ index ] = 0;
+
+	VertexBufferLayout			vertexBufferLayout;
+	vertexBufferLayout.PushUInt( 2, true );
+
+	materialIndexBuffer.Create();
+	materialIndexBuffer.Bind();
+	materialIndexBuffer.Allocate( materialIndeces.data(), materialIndeces.size() * sizeof( UInt32_t ) );
+	VertexArrayObject.AddBuffer( materialIndexBuffer, vertexBufferLayout, MATERIALTABLE_ATTRIBUTE_LOCATION );
+
+	// Upload per material records, x - layer in texture array of group
+	std::vector< UInt32_t >		uniformData( MeshDescriptor.countMaterials * 4, 0 );
+	for ( UInt32_t index = 0, count = records.size(); index < count; ++index )
+	{
+		uniformData[ index * 4 ] = records[ index ].layer;
+		uniformData[ index * 4 + 1 ] = records[ index ].group;
+	}
+
+	glGenBuffers( 1, &uniformBuffer );
+	glBindBuffer( GL_UNIFORM_BUFFER, uniformBuffer );
+	glBufferData( GL_UNIFORM_BUFFER, uniformData.size() * sizeof( UInt32_t ), uniformData.data(), GL_STATIC_DRAW );
+	glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+
+	// Create texture arrays. Last layer in lightmap array is white for surfaces without lightmap
+	for ( UInt32_t index = 0, count = groups.size(); index < count; ++index )
+		groups[ index ].handle = MaterialTable_CreateTextureArray( groups[ index ].textures.data(), groups[ index ].textures.size(), groups[ index ].textures.size(), true );
+
+	lightmapArray = MaterialTable_CreateTextureArray( lightmaps.data(), lightmaps.size(), lightmaps.size() + 1, false );
+
+	g_consoleSystem->PrintInfo( "Material table builded: %i materials in %i texture arrays, %i lightmaps", ( UInt32_t ) records.size(), ( UInt32_t ) groups.size(), ( UInt32_t ) lightmaps.size() );
+	isBuilded = true;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Can material table be built for mesh
+// ------------------------------------------------------------------------------------ //
+bool le::MaterialTable::IsSupported( const MeshDescriptor& MeshDescriptor )
+{
+	// Batched shader expects vertex format of BSP levels and one material index attribute after it
+	return MeshDescriptor.primitiveType == PT_TRIANGLES && MeshDescriptor.countVertexElements == MATERIALTABLE_ATTRIBUTE_LOCATION &&
+		   MeshDescriptor.countMaterials > 0 && MeshDescriptor.countMaterials <= MATERIALTABLE_MAX_MATERIALS &&
+		   MeshDescriptor.countLightmaps > 0 && MeshDescriptor.countLightmaps < MATERIALTABLE_MAX_LAYERS && MeshDescriptor.indeces;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Delete material table
+// ------------------------------------------------------------------------------------ //
+void le::MaterialTable::Delete()
+{
+	for ( UInt32_t index = 0, count = groups.size(); index < count; ++index )
+		if ( groups[ index ].handle > 0 )
+			glDeleteTextures( 1, &groups[ index ].handle );
+
+	if ( lightmapArray > 0 )		glDeleteTextures( 1, &lightmapArray );
+	if ( uniformBuffer > 0 )		glDeleteBuffers( 1, &uniformBuffer );
+	materialIndexBuffer.Delete();
+
+	lightmapArray = 0;
+	uniformBuffer = 0;
+	records.clear();
+	groups.clear();
+	isBuilded = false;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Bind texture arrays of group and records of materials
+// ------------------------------------------------------------------------------------ //
+void le::MaterialTable::Bind( UInt32_t Group ) const
+{
+	LIFEENGINE_ASSERT( isBuilded && Group < groups.size() );
+
+	glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D_ARRAY, groups[ Group ].handle );
+	glActiveTexture( GL_TEXTURE1 );
+	glBindTexture( GL_TEXTURE_2D_ARRAY, lightmapArray );
+	glBindBufferBase( GL_UNIFORM_BUFFER, MATERIALTABLE_UNIFORM_BINDING, uniformBuffer );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get pass of material, which can be drawn by batched shader
+// ------------------------------------------------------------------------------------ //
+le::StudioRenderPass* le::MaterialTable::GetBatchablePass( IMaterial* Material ) const
+{
+	if ( !Material ) return nullptr;
+
+	IStudioRenderTechnique*		technique = Material->GetTechnique( RT_DEFFERED_SHADING );
+	if ( !technique || technique->GetCountPasses() != 1 ) return nullptr;
+
+	// Batched shader replaces only LightmappedGeneric, other shaders have own parameters
+	StudioRenderPass*			pass = ( StudioRenderPass* ) technique->GetPass( 0 );
+	if ( strcmp( pass->GetNameShader(), "LightmappedGeneric" ) != 0 || !pass->IsDepthTest() || !pass->IsDepthWrite() || pass->IsBlend() )
+		return nullptr;
+
+	return pass;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get base texture of pass
+// ------------------------------------------------------------------------------------ //
+le::Texture* le::MaterialTable::GetBaseTexture( StudioRenderPass* Pass ) const
+{
+	MaterialTableImageFormat		format;
+
+	for ( UInt32_t index = 0, count = Pass->GetCountParameters(); index < count; ++index )
+	{
+		IShaderParameter*		parameter = Pass->GetParameter( index );
+		if ( !parameter->IsDefined() || parameter->GetType() != SPT_TEXTURE || strcmp( parameter->GetName(), "basetexture" ) != 0 )
+			continue;
+
+		Texture*				texture = ( Texture* ) parameter->GetValueTexture();
+		if ( !texture || !texture->IsCreated() || !MaterialTable_GetImageFormat( texture->GetImageFormat(), format ) )
+			return nullptr;
+
+		return texture;
+	}
+
+	return nullptr;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::MaterialTable::MaterialTable() :
+	isBuilded( false ),
+	lightmapArray( 0 ),
+	uniformBuffer( 0 )
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor
+// ------------------------------------------------------------------------------------ //
+le::MaterialTable::~MaterialTable()
+{
+	Delete();
+}
@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef MATERIALTABLE_H
+#define MATERIALTABLE_H
+
+#include <vector>
+
+#include "common/types.h"
+#include "studiorender/itexture.h"
+#include "vertexbufferobject.h"
+
+//---------------------------------------------------------------------//
+
+#define MATERIALTABLE_MAX_MATERIALS			1024
+#define MATERIALTABLE_MAX_LAYERS			256
+#define MATERIALTABLE_ATTRIBUTE_LOCATION	5
+#define MATERIALTABLE_UNIFORM_BINDING		0
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	struct MeshDescriptor;
+	class IMaterial;
+	class Texture;
+	class VertexArrayObject;
+	class StudioRenderPass;
+
+	//---------------------------------------------------------------------//
+
+	class MaterialTable
+	{
+	public:
+		//---------------------------------------------------------------------//
+
+		struct MaterialRecord
+		{
+			bool					isBatched;
+			UInt32_t				group;
+			UInt32_t				layer;
+		};
+
+		//---------------------------------------------------------------------//
+
+		struct TextureArrayGroup
+		{
+			UInt32_t					handle;
+			UInt32_t					width;
+			UInt32_t					height;
+			IMAGE_FORMAT				imageFormat;
+			StudioRenderPass*			pass;
+			std::vector< Texture* >		textures;
+		};
+
+		//---------------------------------------------------------------------//
+
+		MaterialTable();
+		~MaterialTable();
+
+		bool						Build( const MeshDescriptor& MeshDescriptor, VertexArrayObject& VertexArrayObject );
+		void						Delete();
+		void						Bind( UInt32_t Group ) const;
+
+		// Table adds own attribute to VAO of mesh, so such mesh can't share VAO with others
+		static bool					IsSupported( const MeshDescriptor& MeshDescriptor );
+
+		inline bool					IsBuilded() const
+		{
+			return isBuilded;
+		}
+
+		inline bool					IsBatched( UInt32_t MaterialID ) const
+		{
+			return isBuilded && MaterialID < records.size() && records[ MaterialID ].isBatched;
+		}
+
+		inline UInt32_t				GetGroup( UInt32_t MaterialID ) const
+		{
+			return records[ MaterialID ].group;
+		}
+
+		inline StudioRenderPass*	GetPass( UInt32_t Group ) const
+		{
+			return groups[ Group ].pass;
+		}
+
+		inline UInt32_t				GetCountGroups() const
+		{
+			return groups.size();
+		}
+
+	private:
+		StudioRenderPass*			GetBatchablePass( IMaterial* Material ) const;
+		Texture*					GetBaseTexture( StudioRenderPass* Pass ) const;
+
+		bool									isBuilded;
+		UInt32_t								lightmapArray;
+		UInt32_t								uniformBuffer;
+		VertexBufferObject						materialIndexBuffer;
+		std::vector< MaterialRecord >			records;
+		std::vector< TextureArrayGroup >		groups;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !MATERIALTABLE_H
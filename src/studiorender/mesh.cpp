@@ -8,11 +8,16 @@
 //
 //////////////////////////////////////////////////////////////////////////
 
+#include <string.h>
+#include <algorithm>
+
 #include "common/meshsurface.h"
 #include "common/meshdescriptor.h"
 #include "engine/lifeengine.h"
 #include "studiorender/studiovertexelement.h"
 
+#include "global.h"
+#include "studiorender.h"
 #include "mesh.h"
 
 // ------------------------------------------------------------------------------------ //
@@ -24,6 +29,7 @@ void le::Mesh::Create( const MeshDescriptor& MeshDescriptor )
 		( MeshDescriptor.countIndeces > 0 && !MeshDescriptor.indeces ) )
 		return;
 
+	ContextLock			contextLock;
 	if ( isCreated )		Delete();
 
 	// Запоминаем материалы
@@ -38,16 +44,82 @@ void le::Mesh::Create( const MeshDescriptor& MeshDescriptor )
 	for ( UInt32_t index = 0; index < MeshDescriptor.countSurfaces; ++index )
 		surfaces.push_back( MeshDescriptor.surfaces[ index ] );
 
-	// Загружаем информацию о меше в GPU
-	vertexArrayObject.Create();
-	vertexBufferObject.Create();
-	indexBufferObject.Create();
-
-	vertexBufferObject.Bind();
-	vertexBufferObject.Allocate( MeshDescriptor.verteces, MeshDescriptor.sizeVerteces );
-
-	indexBufferObject.Bind();
-	indexBufferObject.Allocate( MeshDescriptor.indeces, MeshDescriptor.countIndeces * sizeof( UInt32_t ) );
+	// Индексы поверхности храним в 16 битах, если ее вершины укладываются в диапазон UInt16_t,
+	// иначе в 32 битах. Меши без поверхностей (примитивы) загружаются как есть
+	std::vector< Byte_t >			indexBuffer;
+	if ( surfaces.empty() )
+		indexBuffer.assign( ( Byte_t* ) MeshDescriptor.indeces, ( Byte_t* ) ( MeshDescriptor.indeces + MeshDescriptor.countIndeces ) );
+	else
+	{
+		// Поверхности обходим по началу диапазона индексов, длинные раньше коротких. Поверхность, лежащая
+		// внутри уже загруженной с той же базовой вершиной (плоскость внутри группы кластера уровня),
+		// ссылается на ее индексы и не копирует их второй раз
+		std::vector< UInt32_t >		surfaceOrder( surfaces.size() );
+		for ( UInt32_t index = 0, count = surfaces.size(); index < count; ++index )
+			surfaceOrder[ index ] = index;
+
+		std::sort( surfaceOrder.begin(), surfaceOrder.end(), [ & ]( UInt32_t Left, UInt32_t Right )
+				   {
+					   if ( surfaces[ Left ].startIndex != surfaces[ Right ].startIndex )
+						   return surfaces[ Left ].startIndex < surfaces[ Right ].startIndex;
+
+					   return surfaces[ Left ].countIndeces > surfaces[ Right ].countIndeces;
+				   } );
+
+		Int32_t						coverSurface = -1;
+		surfaceIndexFormats.resize( surfaces.size() );
+
+		for ( UInt32_t indexOrder = 0, count = surfaceOrder.size(); indexOrder < count; ++indexOrder )
+		{
+			UInt32_t					index = surfaceOrder[ indexOrder ];
+			const MeshSurface&			surface = surfaces[ index ];
+			MeshSurfaceIndexFormat&		indexFormat = surfaceIndexFormats[ index ];
+			const UInt32_t*				indeces = MeshDescriptor.indeces + surface.startIndex;
+			UInt32_t					maxIndex = 0;
+
+			indexFormat.type = GL_UNSIGNED_INT;
+			indexFormat.offset = 0;
+			if ( surface.countIndeces == 0 || surface.startIndex + surface.countIndeces > MeshDescriptor.countIndeces )		continue;
+
+			if ( coverSurface >= 0 )
+			{
+				const MeshSurface&				cover = surfaces[ coverSurface ];
+				const MeshSurfaceIndexFormat&	coverFormat = surfaceIndexFormats[ coverSurface ];
+
+				if ( surface.startVertexIndex == cover.startVertexIndex && surface.startIndex >= cover.startIndex &&
+					 surface.startIndex + surface.countIndeces <= cover.startIndex + cover.countIndeces )
+				{
+					indexFormat.type = coverFormat.type;
+					indexFormat.offset = coverFormat.offset + ( surface.startIndex - cover.startIndex ) * ( coverFormat.type == GL_UNSIGNED_SHORT ? sizeof( UInt16_t ) : sizeof( UInt32_t ) );
+					continue;
+				}
+			}
+
+			if ( coverSurface < 0 || surface.startIndex + surface.countIndeces > surfaces[ coverSurface ].startIndex + surfaces[ coverSurface ].countIndeces )
+				coverSurface = index;
+
+			for ( UInt32_t indexVertex = 0; indexVertex < surface.countIndeces; ++indexVertex )
+				maxIndex = glm::max( maxIndex, indeces[ indexVertex ] );
+
+			if ( maxIndex <= UINT16_MAX )
+			{
+				indexFormat.type = GL_UNSIGNED_SHORT;
+				indexFormat.offset = indexBuffer.size();
+				indexBuffer.resize( indexBuffer.size() + surface.countIndeces * sizeof( UInt16_t ) );
+
+				UInt16_t*		shortIndeces = ( UInt16_t* ) &indexBuffer[ indexFormat.offset ];
+				for ( UInt32_t indexVertex = 0; indexVertex < surface.countIndeces; ++indexVertex )
+					shortIndeces[ indexVertex ] = indeces[ indexVertex ];
+			}
+			else
+			{
+				// Смещение 32-битных индексов должно быть выровнено по 4 байтам
+				indexFormat.offset = ( indexBuffer.size() + 3 ) & ~3;
+				indexBuffer.resize( indexFormat.offset + surface.countIndeces * sizeof( UInt32_t ) );
+				memcpy( &indexBuffer[ indexFormat.offset ], indeces, surface.countIndeces * sizeof( UInt32_t ) );
+			}
+		}
+	}
 
 	VertexBufferLayout				vertexBufferLayout;
 	for ( UInt32_t index = 0; index < MeshDescriptor.countVertexElements; ++index )
@@ -64,8 +136,46 @@ void le::Mesh::Create( const MeshDescriptor& MeshDescriptor )
 		case VET_UNSIGNED_BYTE:
 			vertexBufferLayout.PushUByte( MeshDescriptor.vertexElements[ index ].count );
 			break;
+
+		case VET_HALF_FLOAT:
+			vertexBufferLayout.PushHalfFloat( MeshDescriptor.vertexElements[ index ].count );
+			break;
+
+		case VET_INT_2_10_10_10_REV:
+			vertexBufferLayout.PushInt2_10_10_10_Rev();
+			break;
 		}
-	
+
+	min = MeshDescriptor.min;
+	max = MeshDescriptor.max;
+	primitiveType = MeshDescriptor.primitiveType;
+
+	// Меши с поверхностями кладем в общие буферы арены, тогда меши одного формата вершин рисуются без смены VAO.
+	// Примитивы рисуются по своим смещениям, а таблица материалов добавляет в VAO свой атрибут, поэтому им нужны свои буферы.
+	// Под таблицу материалов попадает меш уровня: он остается вне арены со своим VAO, что стоит одну смену VAO
+	// на проход и отдельные буферы, не участвующие в дефрагментации. В арене атрибут материала пришлось бы
+	// смещать на базовую вершину меша и перестраивать его VAO после каждой дефрагментации
+	if ( !surfaces.empty() && !MaterialTable::IsSupported( MeshDescriptor ) && g_studioRender )
+	{
+		arenaAllocation = g_studioRender->GetBufferArena().Allocate( vertexBufferLayout, MeshDescriptor.verteces, MeshDescriptor.sizeVerteces, indexBuffer.data(), indexBuffer.size() );
+		if ( arenaAllocation )
+		{
+			isCreated = true;
+			return;
+		}
+	}
+
+	// Загружаем информацию о меше в GPU
+	vertexArrayObject.Create();
+	vertexBufferObject.Create();
+	indexBufferObject.Create();
+
+	vertexBufferObject.Bind();
+	vertexBufferObject.Allocate( MeshDescriptor.verteces, MeshDescriptor.sizeVerteces );
+
+	indexBufferObject.Bind();
+	indexBufferObject.Allocate( indexBuffer.data(), indexBuffer.size() );
+
 	vertexArrayObject.Bind();
 	vertexArrayObject.AddBuffer( vertexBufferObject, vertexBufferLayout );
 	vertexArrayObject.AddBuffer( indexBufferObject );
@@ -74,9 +184,8 @@ void le::Mesh::Create( const MeshDescriptor& MeshDescriptor )
 	vertexBufferObject.Unbind();
 	indexBufferObject.Unbind();
 
-	min = MeshDescriptor.min;
-	max = MeshDescriptor.max;
-	primitiveType = MeshDescriptor.primitiveType;
+	// Строим таблицу материалов для объединения отрисовки поверхностей в один вызов
+	materialTable.Build( MeshDescriptor, vertexArrayObject );
 	isCreated = true;
 }
 
@@ -85,13 +194,20 @@ void le::Mesh::Create( const MeshDescriptor& MeshDescriptor )
 // ------------------------------------------------------------------------------------ //
 void le::Mesh::Delete()
 {
+	ContextLock			contextLock;
+
 	vertexArrayObject.Delete();
 	vertexBufferObject.Delete();
 	indexBufferObject.Delete();
+	materialTable.Delete();
+
+	if ( arenaAllocation && g_studioRender )		g_studioRender->GetBufferArena().Free( arenaAllocation );
+	arenaAllocation = nullptr;
 
 	// TODO: Реализовать удаление материалов и карт освещений
 
 	surfaces.clear();
+	surfaceIndexFormats.clear();
 	materials.clear();
 	lightmaps.clear();
 	isCreated = false;
@@ -201,7 +317,8 @@ const le::Vector3D_t& le::Mesh::GetMax() const
 // ------------------------------------------------------------------------------------ //
 le::Mesh::Mesh() :
 	isCreated( false ),
-	primitiveType( PT_TRIANGLES )
+	primitiveType( PT_TRIANGLES ),
+	arenaAllocation( nullptr )
 {}
 
 // ------------------------------------------------------------------------------------ //
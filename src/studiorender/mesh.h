@@ -17,6 +17,8 @@
 #include "vertexarrayobject.h"
 #include "vertexbufferobject.h"
 #include "indexbufferobject.h"
+#include "materialtable.h"
+#include "bufferarena.h"
 
 //---------------------------------------------------------------------//
 
@@ -24,6 +26,14 @@ namespace le
 {
 	//---------------------------------------------------------------------//
 
+	struct MeshSurfaceIndexFormat
+	{
+		UInt32_t			type;
+		UInt32_t			offset;
+	};
+
+	//---------------------------------------------------------------------//
+
 	class Mesh : public IMesh
 	{
 	public:
@@ -49,9 +59,13 @@ namespace le
 		~Mesh();
 
 		inline PRIMITIVE_TYPE					GetPrimitiveType() const		{ return primitiveType; }
-		inline const VertexArrayObject&			GetVertexArrayObject() const	{ return vertexArrayObject; }
+		inline const VertexArrayObject&			GetVertexArrayObject() const	{ return arenaAllocation ? *arenaAllocation->vertexArrayObject : vertexArrayObject; }
+		inline UInt32_t							GetBaseVertex() const			{ return arenaAllocation ? arenaAllocation->vertexOffset / arenaAllocation->stride : 0; }
+		inline UInt32_t							GetBaseIndexOffset() const		{ return arenaAllocation ? arenaAllocation->indexOffset : 0; }
 		inline const VertexBufferObject&		GetVertexBufferObject() const	{ return vertexBufferObject; }
 		inline const IndexBufferObject&			GetIndexBufferObject() const	{ return indexBufferObject; }
+		inline const MaterialTable&				GetMaterialTable() const		{ return materialTable; }
+		inline const MeshSurfaceIndexFormat&	GetSurfaceIndexFormat( UInt32_t Index ) const	{ return surfaceIndexFormats[ Index ]; }
 
 	private:
 		bool							isCreated;
@@ -60,12 +74,15 @@ namespace le
 		VertexArrayObject				vertexArrayObject;
 		VertexBufferObject				vertexBufferObject;
 		IndexBufferObject				indexBufferObject;
+		BufferArenaAllocation*			arenaAllocation;
+		MaterialTable					materialTable;
 		Vector3D_t						min;
 		Vector3D_t						max;
 
 		std::vector< IMaterial* >		materials;
 		std::vector< ITexture* >		lightmaps;
 		std::vector< MeshSurface >		surfaces;
+		std::vector< MeshSurfaceIndexFormat >		surfaceIndexFormats;
 	};
 
 	//---------------------------------------------------------------------//
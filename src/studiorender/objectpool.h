@@ -0,0 +1,139 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <new>
+#include <vector>
+#include <type_traits>
+
+#include "common/types.h"
+#include "engine/lifeengine.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Pool of objects of one type. Objects are placed in slabs with contiguous storage,
+	// freed slots go to free list and are reused without heap allocations
+	template< typename Type, UInt32_t CountInSlab = 256 >
+	class ObjectPool
+	{
+	public:
+		ObjectPool() :
+			freeSlots( nullptr ),
+			countObjects( 0 )
+		{}
+
+		~ObjectPool()
+		{
+			// Objects not returned to pool are destroyed here, live slots are those not in free list
+			if ( countObjects > 0 )
+			{
+				std::vector< bool >		isFreeSlots( slabs.size() * CountInSlab, false );
+				for ( Slot* slot = freeSlots; slot; slot = slot->next )
+					isFreeSlots[ GetSlotIndex( slot ) ] = true;
+
+				for ( UInt32_t index = 0, count = isFreeSlots.size(); index < count; ++index )
+					if ( !isFreeSlots[ index ] )
+						reinterpret_cast< Type* >( &slabs[ index / CountInSlab ][ index % CountInSlab ].storage )->~Type();
+			}
+
+			for ( UInt32_t index = 0, count = slabs.size(); index < count; ++index )
+				delete[] slabs[ index ];
+		}
+
+		inline Type*				Allocate()
+		{
+			if ( !freeSlots )		AddSlab();
+
+			Slot*		slot = freeSlots;
+			freeSlots = slot->next;
+			++countObjects;
+
+			return new( &slot->storage ) Type();
+		}
+
+		inline void					Free( Type* Object )
+		{
+			LIFEENGINE_ASSERT( Object && IsOwner( Object ) );
+			Object->~Type();
+
+			Slot*		slot = reinterpret_cast< Slot* >( Object );
+			slot->next = freeSlots;
+			freeSlots = slot;
+			--countObjects;
+		}
+
+		inline bool					IsOwner( const void* Object ) const
+		{
+			for ( UInt32_t index = 0, count = slabs.size(); index < count; ++index )
+				if ( Object >= slabs[ index ] && Object < slabs[ index ] + CountInSlab )
+					return true;
+
+			return false;
+		}
+
+		inline UInt32_t				GetCountObjects() const
+		{
+			return countObjects;
+		}
+
+		inline UInt32_t				GetCountSlabs() const
+		{
+			return slabs.size();
+		}
+
+		inline UInt32_t				GetCapacity() const
+		{
+			return slabs.size() * CountInSlab;
+		}
+
+	private:
+		union Slot
+		{
+			Slot*														next;
+			typename std::aligned_storage< sizeof( Type ), alignof( Type ) >::type	storage;
+		};
+
+		inline UInt32_t				GetSlotIndex( const Slot* Target ) const
+		{
+			for ( UInt32_t index = 0, count = slabs.size(); index < count; ++index )
+				if ( Target >= slabs[ index ] && Target < slabs[ index ] + CountInSlab )
+					return index * CountInSlab + ( UInt32_t ) ( Target - slabs[ index ] );
+
+			LIFEENGINE_ASSERT( false );
+			return 0;
+		}
+
+		inline void					AddSlab()
+		{
+			Slot*		slab = new Slot[ CountInSlab ];
+			for ( UInt32_t index = 0; index < CountInSlab; ++index )
+				slab[ index ].next = index + 1 < CountInSlab ? &slab[ index + 1 ] : freeSlots;
+
+			freeSlots = slab;
+			slabs.push_back( slab );
+		}
+
+		Slot*						freeSlots;
+		UInt32_t					countObjects;
+		std::vector< Slot* >		slabs;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !OBJECTPOOL_H
@@ -24,6 +24,7 @@ bool					le::OpenGLState::isStencilTest = false;
 
 bool					le::OpenGLState::colorMask[ 4 ] = { true, true, true, true };
 le::CULLFACE_TYPE		le::OpenGLState::cullFaceType = le::CT_BACK;
+le::UInt32_t			le::OpenGLState::depthFuncType = GL_LESS;
 le::UInt32_t			le::OpenGLState::stencilFuncType = GL_ALWAYS;
 le::UInt32_t			le::OpenGLState::stencilFunc_ref = 0;
 le::UInt32_t			le::OpenGLState::stencilFunc_mask = 0;
@@ -120,6 +121,17 @@ void le::OpenGLState::SetColorMask( bool R, bool G, bool B, bool A )
 	glColorMask( R, G, B, A );
 }
 
+// ------------------------------------------------------------------------------------ //
+// Задать функцию теста глубины
+// ------------------------------------------------------------------------------------ //
+void le::OpenGLState::SetDepthFunc( UInt32_t DepthFuncType )
+{
+	if ( depthFuncType == DepthFuncType ) return;
+	depthFuncType = DepthFuncType;
+
+	glDepthFunc( DepthFuncType );
+}
+
 // ------------------------------------------------------------------------------------ //
 // Задать функцию смешивания
 // ------------------------------------------------------------------------------------ //
@@ -187,6 +199,7 @@ void le::OpenGLState::Initialize()
 	}
 
 	glColorMask( colorMask[ 0 ], colorMask[ 1 ], colorMask[ 2 ], colorMask[ 3 ] );
+	glDepthFunc( depthFuncType );
 	glStencilFunc( stencilFuncType, stencilFunc_ref, stencilFunc_mask );
 	glBlendFunc( blendFunc_sFactor, blendFunc_dFactor );
 	glBlendEquation( blendEquation_mode );
@@ -36,6 +36,7 @@ namespace le
 
 		static void				SetCullFaceType( CULLFACE_TYPE CullFaceType );
 		static void				SetColorMask( bool R, bool G, bool B, bool A );
+		static void				SetDepthFunc( UInt32_t DepthFuncType );
 		static void				SetStencilFunc( UInt32_t StencilFuncType, UInt32_t Ref, UInt32_t Mask );
 		static void				SetBlendFunc( UInt32_t SFactor, UInt32_t DFactor );
 		static void				SetBlendEquation( UInt32_t Mode );
@@ -52,6 +53,7 @@ namespace le
 
 		static bool					colorMask[ 4 ];
 		static CULLFACE_TYPE		cullFaceType;
+		static UInt32_t				depthFuncType;
 		static UInt32_t 			stencilFuncType;
 		static UInt32_t				stencilFunc_ref;
 		static UInt32_t				stencilFunc_mask;
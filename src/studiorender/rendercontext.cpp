@@ -60,6 +60,18 @@ void le::RenderContext::MakeCurrent()
 #endif
 }
 
+// ------------------------------------------------------------------------------------ //
+// Отвязать контекст от текущего потока
+// ------------------------------------------------------------------------------------ //
+void le::RenderContext::ReleaseCurrent()
+{
+	if ( !isCreated )	return;
+
+#if defined( PLATFORM_WINDOWS )
+	WinGL_ReleaseCurrentContext();
+#endif
+}
+
 // ------------------------------------------------------------------------------------ //
 // Уничтожить контекст
 // ------------------------------------------------------------------------------------ //
@@ -35,6 +35,7 @@ namespace le
 
 		bool					Create( WindowHandle_t WindowHandle, const SettingsContext& SettingsContext );
 		void					MakeCurrent();	
+		void					ReleaseCurrent();
 		void					Destroy();
 		void					SwapBuffers();
 
@@ -12,6 +12,7 @@
 #define RENDE_ROBJECT_H
 
 #include "common/types.h"
+#include "common/lightsample.h"
 
 //---------------------------------------------------------------------//
 
@@ -22,6 +23,7 @@ namespace le
 	class VertexArrayObject;
 	class IMaterial;
 	class Texture;
+	class MaterialTable;
 
 	//---------------------------------------------------------------------//
 
@@ -30,11 +32,16 @@ namespace le
 		VertexArrayObject*		vertexArrayObject;
 		IMaterial*				material;
 		Texture*				lightmap;
+		const MaterialTable*	materialTable;
+		UInt32_t				materialGroup;
 		UInt32_t				startVertexIndex;
-		UInt32_t				startIndex;
+		UInt32_t				indexType;
+		UInt32_t				indexOffset;
 		UInt32_t				countIndeces;
 		UInt32_t				primitiveType;
-		Matrix4x4_t				transformation;
+		UInt32_t				transformation;		// Index of matrix in pool of frame
+		bool					isLightSample;
+		LightSample				lightSample;
 	};
 
 	//---------------------------------------------------------------------//
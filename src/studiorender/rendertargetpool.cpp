@@ -0,0 +1,135 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "engine/lifeengine.h"
+#include "studiorender/studiorendersampler.h"
+#include "texture.h"
+#include "rendertargetpool.h"
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::RenderTargetPool::RenderTargetPool() :
+	frame( 0 ),
+	memorySize( 0 )
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor
+// ------------------------------------------------------------------------------------ //
+le::RenderTargetPool::~RenderTargetPool()
+{
+	Clear();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Acquire target
+// ------------------------------------------------------------------------------------ //
+le::Texture* le::RenderTargetPool::Acquire( IMAGE_FORMAT Format, UInt32_t Width, UInt32_t Height )
+{
+	RenderTarget*		renderTarget = nullptr;
+	for ( UInt32_t index = 0, count = targets.size(); index < count; ++index )
+	{
+		RenderTarget&		target = targets[ index ];
+		if ( target.isUsed || target.texture->GetImageFormat() != Format || target.texture->GetWidth() != Width || target.texture->GetHeight() != Height )
+			continue;
+
+		if ( !renderTarget || target.lastUsedFrame > renderTarget->lastUsedFrame )
+			renderTarget = &target;
+	}
+
+	if ( !renderTarget )
+	{
+		StudioRenderSampler			sampler;
+		sampler.minFilter = SF_NEAREST;
+		sampler.magFilter = SF_NEAREST;
+
+		Texture*			texture = new Texture();
+		texture->Initialize( TT_2D, Format, Width, Height );
+		texture->Bind();
+		texture->Append( nullptr );
+		texture->SetSampler( sampler );
+
+		targets.push_back( { texture, frame, false } );
+		renderTarget = &targets.back();
+		memorySize += ( UInt64_t ) GetPixelSize( Format ) * Width * Height;
+	}
+
+	renderTarget->isUsed = true;
+	renderTarget->lastUsedFrame = frame;
+	return renderTarget->texture;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Release target
+// ------------------------------------------------------------------------------------ //
+void le::RenderTargetPool::Release( Texture* Texture )
+{
+	if ( !Texture )		return;
+
+	for ( UInt32_t index = 0, count = targets.size(); index < count; ++index )
+		if ( targets[ index ].texture == Texture )
+		{
+			LIFEENGINE_ASSERT( targets[ index ].isUsed );
+			targets[ index ].isUsed = false;
+			targets[ index ].lastUsedFrame = frame;
+			return;
+		}
+}
+
+// ------------------------------------------------------------------------------------ //
+// End frame: delete old free targets
+// ------------------------------------------------------------------------------------ //
+void le::RenderTargetPool::EndFrame()
+{
+	++frame;
+
+	for ( UInt32_t index = 0; index < targets.size(); )
+	{
+		RenderTarget&		target = targets[ index ];
+		if ( target.isUsed || frame - target.lastUsedFrame < RENDERTARGETPOOL_MAX_UNUSED_FRAMES )
+		{
+			++index;
+			continue;
+		}
+
+		memorySize -= ( UInt64_t ) GetPixelSize( target.texture->GetImageFormat() ) * target.texture->GetWidth() * target.texture->GetHeight();
+		delete target.texture;
+
+		target = targets.back();
+		targets.pop_back();
+	}
+}
+
+// ------------------------------------------------------------------------------------ //
+// Delete all targets
+// ------------------------------------------------------------------------------------ //
+void le::RenderTargetPool::Clear()
+{
+	for ( UInt32_t index = 0, count = targets.size(); index < count; ++index )
+		delete targets[ index ].texture;
+
+	targets.clear();
+	memorySize = 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Get size of pixel in bytes
+// ------------------------------------------------------------------------------------ //
+le::UInt32_t le::RenderTargetPool::GetPixelSize( IMAGE_FORMAT Format )
+{
+	switch ( Format )
+	{
+	case IF_RGBA_16FLOAT:		return 8;
+	case IF_RGB_16FLOAT:		return 6;
+	case IF_RGB_8UNORM:			return 3;
+	default:					return 4;
+	}
+}
@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef RENDERTARGETPOOL_H
+#define RENDERTARGETPOOL_H
+
+#include <vector>
+
+#include "common/types.h"
+#include "studiorender/itexture.h"
+
+//---------------------------------------------------------------------//
+
+// Count of frames free target stays in pool. Old size is not deleted at once after resize,
+// so window dragged back and forth or changed resolution scale reuses its targets
+#define RENDERTARGETPOOL_MAX_UNUSED_FRAMES		120
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	class Texture;
+
+	//---------------------------------------------------------------------//
+
+	// Pool of render targets keyed by size and format. Passes acquire transient targets
+	// and release them when their content is not needed, so passes that don't live at
+	// the same time share one target. Pool is used only by thread of render
+	class RenderTargetPool
+	{
+	public:
+		RenderTargetPool();
+		~RenderTargetPool();
+
+		// Target belongs to caller until Release. Target of previous frame is returned
+		// first, so attachments of framebuffers don't change while size is same
+		Texture*				Acquire( IMAGE_FORMAT Format, UInt32_t Width, UInt32_t Height );
+		void					Release( Texture* Texture );
+
+		// Delete targets not used for RENDERTARGETPOOL_MAX_UNUSED_FRAMES
+		void					EndFrame();
+		void					Clear();
+
+		static UInt32_t			GetPixelSize( IMAGE_FORMAT Format );
+
+		inline UInt32_t			GetCountTargets() const
+		{
+			return targets.size();
+		}
+
+		inline UInt64_t			GetMemorySize() const
+		{
+			return memorySize;
+		}
+
+	private:
+		struct RenderTarget
+		{
+			Texture*			texture;
+			UInt32_t			lastUsedFrame;
+			bool				isUsed;
+		};
+
+		std::vector< RenderTarget >		targets;
+		UInt32_t						frame;
+		UInt64_t						memorySize;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !RENDERTARGETPOOL_H
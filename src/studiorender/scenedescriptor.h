@@ -29,13 +29,20 @@ namespace le
 
 	//---------------------------------------------------------------------//
 
+	// Снимок сцены на кадр. Камера и источники света копируются при отправке,
+	// чтобы поток рендера не читал объекты, которые игра меняет для следующего кадра
 	struct SceneDescriptor
 	{
 		ICamera*							camera;
+		Vector3D_t							cameraPosition;
+		Matrix4x4_t							projectionMatrix;
+		Matrix4x4_t							viewMatrix;
+		UInt32_t							uniformOffset;
 		std::vector< RenderObject >			renderObjects;
-		std::vector< PointLight* >			pointLights;
-		std::vector< SpotLight* >			spotLights;
-		std::vector< DirectionalLight* >	directionalLights;
+		std::vector< UInt64_t >				sortKeys;			// Глубина в старших 32 битах, индекс объекта в младших
+		std::vector< PointLight >			pointLights;
+		std::vector< SpotLight >			spotLights;
+		std::vector< DirectionalLight >		directionalLights;
 	};
 
 	//---------------------------------------------------------------------//
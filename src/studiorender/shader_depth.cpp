@@ -40,6 +40,8 @@ bool le::ShaderDepth::Create()
 	ShaderDescriptor		shaderDescriptor = {};
 	shaderDescriptor.vertexShaderSource = "\
     #version 330 core\n\
+    \n\
+    invariant gl_Position;\n\
     \
     layout ( location = 0 )         in vec3 vertex_position;\n\
     \
@@ -50,6 +52,16 @@ bool le::ShaderDepth::Create()
     #elif defined( CONE ) \n\
         uniform float       radius;\n\
         uniform float       height;\n\
+    #elif defined( SCENE ) \n\
+        layout( std140 ) uniform SceneData\n\
+        {\n\
+            mat4        matrix_Projection;\n\
+        };\n\
+        \n\
+        layout( std140 ) uniform ObjectData\n\
+        {\n\
+            mat4        matrix_Transformation;\n\
+        };\n\
     #endif \n\
     \
     void main()\n\
@@ -58,6 +70,8 @@ bool le::ShaderDepth::Create()
 			gl_Position = pvtMatrix * vec4( vertex_position * radius, 1.f ); \n\
 		#elif defined( CONE ) \n\
 			gl_Position = pvtMatrix * vec4( vertex_position.x * radius, vertex_position.y * height, vertex_position.z * radius, 1.f ); \n \
+		#elif defined( SCENE ) \n\
+			gl_Position = matrix_Projection * matrix_Transformation * vec4( vertex_position, 1.f ); \n \
 		#else \n\
 			gl_Position = pvtMatrix * vec4( vertex_position, 1.f ); \n \
 		 #endif \n\
@@ -86,6 +100,14 @@ bool le::ShaderDepth::Create()
 	if ( !gpuProgram_cone->Compile( shaderDescriptor, defines.size(), defines.data() ) )
 		return false;
 
+    // Компилируем шейдер записи в глубину для геометрии сцены (предварительный проход глубины).
+    // Позиция считается тем же выражением, что и в шейдерах материалов, чтобы глубина совпала
+
+    defines = { "SCENE" };
+    GPUProgram*         gpuProgram_scene = new GPUProgram();
+	if ( !gpuProgram_scene->Compile( shaderDescriptor, defines.size(), defines.data() ) )
+		return false;
+
     // Компилируем шейдер записи в глубину для геометрии "Неизвестная геометрия"
 
 	GPUProgram*         gpuProgram_unknown = new GPUProgram();
@@ -97,6 +119,7 @@ bool le::ShaderDepth::Create()
 
     gpuPrograms[ GT_SPHERE ] = gpuProgram_sphere;
     gpuPrograms[ GT_CONE ] = gpuProgram_cone;
+    gpuPrograms[ GT_SCENE ] = gpuProgram_scene;
     gpuPrograms[ GT_UNKNOWN ] = gpuProgram_unknown;
 
 	return true;
@@ -35,7 +35,8 @@ namespace le
         {
             GT_UNKNOWN,
             GT_SPHERE,
-            GT_CONE
+            GT_CONE,
+            GT_SCENE
         };
 
         //---------------------------------------------------------------------//
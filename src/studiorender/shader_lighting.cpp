@@ -22,7 +22,9 @@
 // Конструктор
 // ------------------------------------------------------------------------------------ //
 le::ShaderLighting::ShaderLighting() :
-	gpuProgram( nullptr )
+	gpuProgram( nullptr ),
+	sizeViewport( 0.f ),
+	sizeTargets( 0.f )
 {}
 
 // ------------------------------------------------------------------------------------ //
@@ -49,8 +51,7 @@ bool le::ShaderLighting::Create()
 		uniform struct Camera \n \
 		{ 	\n \
 			mat4		pvMatrix; \n \
-			mat4		invProjectionMatrix;\n \
-			mat4		invViewMatrix;\n \
+			mat4		invPVMatrix;\n \
 			vec3		position; \n \
 		} camera; \n \
 		\n \
@@ -82,7 +83,7 @@ bool le::ShaderLighting::Create()
 			gl_Position = pvtMatrix * vec4( vertex_position * light.radius, 1.f ); \n\
 		#elif defined( SPOT_LIGHT ) \n\
 			gl_Position = pvtMatrix * vec4( vertex_position.x * light.radius, vertex_position.y * light.height, vertex_position.z * light.radius, 1.f ); \n \
-		#elif defined( DIRECTIONAL_LIGHT ) \n\
+		#elif defined( DIRECTIONAL_LIGHT ) || defined( EMISSION ) \n\
 			gl_Position = vec4( vertex_position, 1.f ); \n \
 		 #endif \n\
 	}";
@@ -93,6 +94,7 @@ bool le::ShaderLighting::Create()
 		out vec4				color;\n\
 	\n\
 		uniform vec2			screenSize;\n\
+		uniform vec2			targetScale;\n\
 		uniform sampler2D		albedoSpecular;\n\
 		uniform sampler2D		normalShininess;\n\
 		uniform sampler2D		emission;\n\
@@ -101,8 +103,7 @@ bool le::ShaderLighting::Create()
 		uniform struct Camera \n \
 		{ 	\n \
 			mat4		pvMatrix; \n \
-			mat4		invProjectionMatrix;\n \
-			mat4		invViewMatrix;\n \
+			mat4		invPVMatrix;\n \
 			vec3		position; \n \
 		} camera; \n \
 	\n \
@@ -126,11 +127,11 @@ bool le::ShaderLighting::Create()
 			#endif \n\
 		} light; \n \
 	\n \
-	vec3 ReconstructPosition( vec2 FragCoord ) \n\
+	vec3 ReconstructPosition( vec2 FragCoord, vec2 TexCoord ) \n\
 	{ \n\
-		float 		depth = texture( depth, FragCoord ).r;\n\
+		float 		depth = texture( depth, TexCoord ).r;\n\
 		\
-		vec4 		position = camera.invViewMatrix * camera.invProjectionMatrix * vec4( FragCoord * 2.f - 1.f, depth * 2.f - 1.f, 1.f );\n\
+		vec4 		position = camera.invPVMatrix * vec4( FragCoord * 2.f - 1.f, depth * 2.f - 1.f, 1.f );\n\
 		position /= position.w;\n\
 		return position.xyz;\n\
 		\
@@ -139,10 +140,15 @@ bool le::ShaderLighting::Create()
 	void main()\n\
 	{\n\
 		vec2	fragCoord = gl_FragCoord.xy / screenSize;\n\
+		vec2	texCoord = fragCoord * targetScale;\n\
+		\n\
+		vec4	fragColor = texture( albedoSpecular, texCoord ); \n\
 		\n\
-		vec4	fragColor = texture( albedoSpecular, fragCoord ); \n\
-		vec4	normal = texture( normalShininess, fragCoord ); \n\
-		vec3	posFrag = ReconstructPosition( fragCoord ); \n\
+		#ifdef EMISSION \n\
+			color = vec4( fragColor.rgb * texture( emission, texCoord ).rgb, 1.f ); \n\
+		#else \n\
+		vec4	normal = GBuffer_DecodeNormal( texture( normalShininess, texCoord ) ); \n\
+		vec3	posFrag = ReconstructPosition( fragCoord, texCoord ); \n\
 		vec3	viewDirection = normalize( camera.position - posFrag ); \n\
 		\n\
 		#if defined( POINT_LIGHT ) || defined( SPOT_LIGHT )\n\
@@ -176,6 +182,7 @@ bool le::ShaderLighting::Create()
 		#elif defined( DIRECTIONAL_LIGHT ) \n\
 			color = ( vec4( fragColor.rgb, 1.f ) * light.color * light.intensivity + light.color * specularFactor ) * NdotL; \n\
 		#endif \n\
+		#endif \n\
 	}\n";
 
 	// Компилируем шейдер для точечного освещения
@@ -220,10 +227,25 @@ bool le::ShaderLighting::Create()
 	gpuProgram_directionalLight->SetUniform( "depth", 3 );
 	gpuProgram_directionalLight->Unbind();
 
+	// Компилируем шейдер для запеченного освещения (карты освещения и сетка света уровня)
+
+	defines = { "EMISSION" };
+	GPUProgram*			gpuProgram_emission = new GPUProgram();
+	if ( !gpuProgram_emission->Compile( shaderDescriptor, defines.size(), defines.data() ) )
+		return false;
+
+	gpuProgram_emission->Bind();
+	gpuProgram_emission->SetUniform( "albedoSpecular", 0 );
+	gpuProgram_emission->SetUniform( "normalShininess", 1 );
+	gpuProgram_emission->SetUniform( "emission", 2 );
+	gpuProgram_emission->SetUniform( "depth", 3 );
+	gpuProgram_emission->Unbind();
+
 	gpuProgram = gpuProgram_pointLight;
 	gpuPrograms[ LT_POINT ] = gpuProgram_pointLight;
 	gpuPrograms[ LT_SPOT ] = gpuProgram_spotLight;
 	gpuPrograms[ LT_DIRECTIONAL ] = gpuProgram_directionalLight;
+	gpuPrograms[ LT_EMISSION ] = gpuProgram_emission;
 	
 	return true;
 }
@@ -41,7 +41,8 @@ namespace le
 		{
 			LT_POINT,
 			LT_SPOT,
-			LT_DIRECTIONAL
+			LT_DIRECTIONAL,
+			LT_EMISSION
 		};
 
 		//---------------------------------------------------------------------//
@@ -68,24 +69,32 @@ namespace le
 			gpuProgram = gpuPrograms[ Type ];
 		}
 
-		inline void			SetSizeViewport( const Vector2D_t& SizeViewport )
+		// Размер кадра и буферов задается всем шейдерам сразу. Буферы могут быть больше кадра,
+		// тогда кадр занимает их часть
+		inline void			SetSizeViewport( const Vector2D_t& SizeViewport, const Vector2D_t& SizeTargets )
 		{
-			if ( !gpuProgram ) return;
-			
-			Bind();
-			gpuProgram->SetUniform( "screenSize", SizeViewport );
-			Unbind();
+			if ( SizeViewport == sizeViewport && SizeTargets == sizeTargets ) return;
+			sizeViewport = SizeViewport;
+			sizeTargets = SizeTargets;
+
+			for ( auto it = gpuPrograms.begin(), itEnd = gpuPrograms.end(); it != itEnd; ++it )
+			{
+				it->second->Bind();
+				it->second->SetUniform( "screenSize", SizeViewport );
+				it->second->SetUniform( "targetScale", SizeViewport / SizeTargets );
+				it->second->Unbind();
+			}
 		}
 
-		inline void			SetCamera( ICamera* Camera )
+		inline void			SetCamera( const Vector3D_t& Position, const Matrix4x4_t& ProjectionMatrix, const Matrix4x4_t& ViewMatrix )
 		{
 			if ( !gpuProgram ) return;
-			LIFEENGINE_ASSERT( Camera );
 
 			Bind();
-			gpuProgram->SetUniform( "camera.position", Camera->GetPosition() );			
-			gpuProgram->SetUniform( "camera.invProjectionMatrix", glm::inverse( Camera->GetProjectionMatrix() ) );
-			gpuProgram->SetUniform( "camera.invViewMatrix", glm::inverse( Camera->GetViewMatrix() ) );			
+			gpuProgram->SetUniform( "camera.position", Position );			
+
+			// Обратная матрица считается один раз на кадр, а не для каждого пикселя в шейдере
+			gpuProgram->SetUniform( "camera.invPVMatrix", glm::inverse( ProjectionMatrix * ViewMatrix ) );
 			Unbind();
 		}
 
@@ -145,6 +154,8 @@ namespace le
 	private:
 		GPUProgram*												gpuProgram;
 		std::unordered_map< LIGHTING_TYPE, GPUProgram* >		gpuPrograms;
+		Vector2D_t												sizeViewport;
+		Vector2D_t												sizeTargets;
 	};
 
 	//---------------------------------------------------------------------//
@@ -0,0 +1,137 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <GL/glew.h>
+
+#include "common/shaderdescriptor.h"
+#include "engine/iconsolesystem.h"
+
+#include "global.h"
+#include "materialtable.h"
+#include "shader_materialtable.h"
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::ShaderMaterialTable::ShaderMaterialTable() :
+	gpuProgram( nullptr )
+{}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor
+// ------------------------------------------------------------------------------------ //
+le::ShaderMaterialTable::~ShaderMaterialTable()
+{
+	Delete();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Create shader
+// ------------------------------------------------------------------------------------ //
+bool le::ShaderMaterialTable::Create()
+{
+	// Same output as LightmappedGeneric, but base texture and lightmap are
+	// layers of texture arrays. Index of material record and lightmap layer are taken from vertex
+	ShaderDescriptor		shaderDescriptor = {};
+	shaderDescriptor.vertexShaderSource = "\
+	#version 330 core\n\
+	\n\
+	invariant gl_Position;\n\
+	\n\
+	layout( location = 0 )			in vec3 vertex_position;\n\
+	layout( location = 1 )			in vec2 vertex_texCoords;\n\
+	layout( location = 2 )			in vec2 vertex_lightmapCoords;\n\
+	layout( location = 3 )			in vec3 vertex_normal;\n\
+	layout( location = 4 )			in vec4 vertex_color;\n\
+	layout( location = 5 )			in uvec2 vertex_materialIndex;\n\
+	\n\
+	layout( std140 ) uniform MaterialTable\n\
+	{\n\
+		uvec4				materials[ MAX_MATERIALS ];\n\
+	};\n\
+	\n\
+		out vec3				texCoords;\n\
+		out vec3				lightmapCoords;\n\
+		out vec4				vertexColor;\n\
+		out vec3				normal;\n\
+	\n\
+		layout( std140 ) uniform SceneData\n\
+		{\n\
+			mat4		matrix_Projection;\n\
+		};\n\
+		\n\
+		layout( std140 ) uniform ObjectData\n\
+		{\n\
+			mat4		matrix_Transformation;\n\
+		};\n\
+	\n\
+	void main()\n\
+	{\n\
+		texCoords = vec3( vertex_texCoords, float( materials[ vertex_materialIndex.x ].x ) );\n\
+		lightmapCoords = vec3( vertex_lightmapCoords, float( vertex_materialIndex.y ) );\n\
+		vertexColor = vertex_color;\n\
+		normal = ( matrix_Transformation * vec4( vertex_normal, 0.f ) ).xyz;\n\
+		gl_Position = matrix_Projection * matrix_Transformation * vec4( vertex_position, 1.f );\n\
+	}";
+
+	shaderDescriptor.fragmentShaderSource = "\
+	#version 330 core\n\
+	\n\
+		layout( location = 0 ) out vec4 out_albedoSpecular;\n\
+		layout( location = 1 ) out vec4 out_normalShininess;\n\
+		layout( location = 2 ) out vec4 out_emission;\n\
+	\n\
+		in vec3					texCoords;\n\
+		in vec3					lightmapCoords;\n\
+		in vec4					vertexColor;\n\
+		in vec3					normal;\n\
+	\n\
+		uniform sampler2DArray	basetexture;\n\
+		uniform sampler2DArray	lightmap;\n\
+	\n\
+	void main()\n\
+	{\n\
+		out_albedoSpecular = vec4( texture( basetexture, texCoords ).rgb, 0.f );\n\
+		out_normalShininess = GBuffer_EncodeNormal( normalize( normal ), 1.f );\n\
+		out_emission = texture( lightmap, lightmapCoords ) * vertexColor;\n\
+	}";
+
+	std::string				defineMaxMaterials = "MAX_MATERIALS " + std::to_string( MATERIALTABLE_MAX_MATERIALS );
+	const char*				defines[] = { defineMaxMaterials.c_str() };
+
+	gpuProgram = new GPUProgram();
+	if ( !gpuProgram->Compile( shaderDescriptor, 1, defines ) )
+	{
+		Delete();
+		return false;
+	}
+
+	UInt32_t				handle = gpuProgram->GetHandle();
+	glUniformBlockBinding( handle, glGetUniformBlockIndex( handle, "MaterialTable" ), MATERIALTABLE_UNIFORM_BINDING );
+
+	gpuProgram->Bind();
+	gpuProgram->SetUniform( "basetexture", 0 );
+	gpuProgram->SetUniform( "lightmap", 1 );
+	gpuProgram->Unbind();
+
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Delete shader
+// ------------------------------------------------------------------------------------ //
+void le::ShaderMaterialTable::Delete()
+{
+	if ( !gpuProgram ) return;
+
+	delete gpuProgram;
+	gpuProgram = nullptr;
+}
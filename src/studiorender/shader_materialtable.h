@@ -0,0 +1,53 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef SHADER_MATERIALTABLE_H
+#define SHADER_MATERIALTABLE_H
+
+#include "common/types.h"
+#include "gpuprogram.h"
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	class ShaderMaterialTable
+	{
+	public:
+		ShaderMaterialTable();
+		~ShaderMaterialTable();
+
+		bool				Create();
+		void				Delete();
+
+		inline void			Bind()
+		{
+			if ( !gpuProgram ) return;
+			gpuProgram->Bind();
+		}
+
+		inline void			Unbind()
+		{
+			if ( !gpuProgram ) return;
+			gpuProgram->Unbind();
+		}
+
+	private:
+		GPUProgram*			gpuProgram;
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !SHADER_MATERIALTABLE_H
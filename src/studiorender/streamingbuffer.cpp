@@ -0,0 +1,185 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "engine/lifeengine.h"
+#include "engine/iconsolesystem.h"
+
+#include "global.h"
+#include "streamingbuffer.h"
+
+// ------------------------------------------------------------------------------------ //
+// Constructor
+// ------------------------------------------------------------------------------------ //
+le::StreamingBuffer::StreamingBuffer() :
+	isPersistent( false ),
+	target( 0 ),
+	handle( 0 ),
+	regionSize( 0 ),
+	currentRegion( 0 ),
+	regionOffset( 0 ),
+	head( 0 ),
+	mappedData( nullptr )
+{
+	for ( UInt32_t index = 0; index < STREAMINGBUFFER_COUNT_REGIONS; ++index )
+		fences[ index ] = nullptr;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Destructor
+// ------------------------------------------------------------------------------------ //
+le::StreamingBuffer::~StreamingBuffer()
+{
+	Delete();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Create buffer
+// ------------------------------------------------------------------------------------ //
+bool le::StreamingBuffer::Create( UInt32_t Target, UInt32_t RegionSize )
+{
+	if ( handle > 0 )		Delete();
+	if ( RegionSize == 0 )	return false;
+
+	target = Target;
+	regionSize = RegionSize;
+	isPersistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+
+	glGenBuffers( 1, &handle );
+	glBindBuffer( target, handle );
+
+	if ( isPersistent )
+	{
+		GLbitfield		flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage( target, regionSize * STREAMINGBUFFER_COUNT_REGIONS, nullptr, flags );
+		mappedData = ( Byte_t* ) glMapBufferRange( target, 0, regionSize * STREAMINGBUFFER_COUNT_REGIONS, flags );
+
+		if ( !mappedData )
+		{
+			g_consoleSystem->PrintWarning( "Failed persistent mapping of streaming buffer, used orphaning" );
+			glDeleteBuffers( 1, &handle );
+			glGenBuffers( 1, &handle );
+			glBindBuffer( target, handle );
+			isPersistent = false;
+		}
+	}
+
+	// Without persistent mapping buffer has one region, it is orphaned every frame
+	if ( !isPersistent )
+	{
+		glBufferData( target, regionSize, nullptr, GL_STREAM_DRAW );
+		stagingData.resize( regionSize );
+		mappedData = stagingData.data();
+	}
+
+	glBindBuffer( target, 0 );
+	currentRegion = 0;
+	regionOffset = 0;
+	head = 0;
+	return true;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Delete buffer
+// ------------------------------------------------------------------------------------ //
+void le::StreamingBuffer::Delete()
+{
+	for ( UInt32_t index = 0; index < STREAMINGBUFFER_COUNT_REGIONS; ++index )
+		if ( fences[ index ] )
+		{
+			glDeleteSync( fences[ index ] );
+			fences[ index ] = nullptr;
+		}
+
+	if ( handle > 0 )
+	{
+		if ( isPersistent )
+		{
+			glBindBuffer( target, handle );
+			glUnmapBuffer( target );
+			glBindBuffer( target, 0 );
+		}
+
+		glDeleteBuffers( 1, &handle );
+	}
+
+	stagingData.clear();
+	handle = 0;
+	regionSize = 0;
+	mappedData = nullptr;
+	isPersistent = false;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Begin frame: wait until GPU has finished reading of current region
+// ------------------------------------------------------------------------------------ //
+void le::StreamingBuffer::BeginFrame()
+{
+	GLsync&			fence = fences[ currentRegion ];
+	if ( fence )
+	{
+		GLenum		result = glClientWaitSync( fence, 0, 0 );
+		while ( result == GL_TIMEOUT_EXPIRED )
+			result = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000 );
+
+		glDeleteSync( fence );
+		fence = nullptr;
+	}
+
+	regionOffset = isPersistent ? currentRegion * regionSize : 0;
+	head = 0;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Allocate range in region of frame, returns nullptr if region is full. Can be called from many threads
+// ------------------------------------------------------------------------------------ //
+void* le::StreamingBuffer::Allocate( UInt32_t Size, UInt32_t Alignment, UInt32_t& Offset )
+{
+	LIFEENGINE_ASSERT( Alignment > 0 );
+	if ( !mappedData )		return nullptr;
+
+	UInt32_t		oldHead = head.load( std::memory_order_relaxed );
+	UInt32_t		alignedHead;
+
+	do
+	{
+		alignedHead = ( ( oldHead + Alignment - 1 ) / Alignment ) * Alignment;
+		if ( alignedHead + Size > regionSize )		return nullptr;
+	}
+	while ( !head.compare_exchange_weak( oldHead, alignedHead + Size, std::memory_order_relaxed ) );
+
+	Offset = regionOffset + alignedHead;
+	return isPersistent ? mappedData + Offset : mappedData + alignedHead;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Make written data visible for GPU
+// ------------------------------------------------------------------------------------ //
+void le::StreamingBuffer::Flush()
+{
+	// Coherent mapping needs nothing, data is visible for next commands
+	if ( isPersistent || handle == 0 )		return;
+
+	UInt32_t		size = head.load();
+	glBindBuffer( target, handle );
+	glBufferData( target, regionSize, nullptr, GL_STREAM_DRAW );
+	if ( size > 0 )		glBufferSubData( target, 0, size, stagingData.data() );
+	glBindBuffer( target, 0 );
+}
+
+// ------------------------------------------------------------------------------------ //
+// End frame: fence region and go to next one
+// ------------------------------------------------------------------------------------ //
+void le::StreamingBuffer::EndFrame()
+{
+	if ( !isPersistent )		return;
+
+	fences[ currentRegion ] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	currentRegion = ( currentRegion + 1 ) % STREAMINGBUFFER_COUNT_REGIONS;
+}
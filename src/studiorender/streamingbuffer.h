@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//			        *** lifeEngine ***
+//				Copyright (C) 2018-2020
+//
+// Repository engine:   https://github.com/zombihello/lifeEngine
+// Authors:				Egor Pogulyaka (zombiHello)
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef STREAMINGBUFFER_H
+#define STREAMINGBUFFER_H
+
+#include <atomic>
+#include <vector>
+#include <GL/glew.h>
+
+#include "common/types.h"
+
+//---------------------------------------------------------------------//
+
+// Count of frames in flight, each frame writes to own region of buffer
+#define STREAMINGBUFFER_COUNT_REGIONS		3
+
+//---------------------------------------------------------------------//
+
+namespace le
+{
+	//---------------------------------------------------------------------//
+
+	// Ring buffer for data written every frame. With ARB_buffer_storage it is mapped once
+	// (persistent and coherent) and regions are protected by fences, else data is collected
+	// in memory and uploaded by orphaning of buffer in Flush
+	class StreamingBuffer
+	{
+	public:
+		StreamingBuffer();
+		~StreamingBuffer();
+
+		bool					Create( UInt32_t Target, UInt32_t RegionSize );
+		void					Delete();
+
+		// Frame order: BeginFrame, Allocate..., Flush, draws, EndFrame
+		void					BeginFrame();
+		void*					Allocate( UInt32_t Size, UInt32_t Alignment, UInt32_t& Offset );
+		void					Flush();
+		void					EndFrame();
+
+		inline bool				IsCreated() const
+		{
+			return handle > 0;
+		}
+
+		inline bool				IsPersistent() const
+		{
+			return isPersistent;
+		}
+
+		inline UInt32_t			GetHandle() const
+		{
+			return handle;
+		}
+
+		inline UInt32_t			GetRegionSize() const
+		{
+			return regionSize;
+		}
+
+	private:
+		bool						isPersistent;
+		UInt32_t					target;
+		UInt32_t					handle;
+		UInt32_t					regionSize;
+		UInt32_t					currentRegion;
+		UInt32_t					regionOffset;
+		std::atomic< UInt32_t >		head;
+		Byte_t*						mappedData;
+		std::vector< Byte_t >		stagingData;
+		GLsync						fences[ STREAMINGBUFFER_COUNT_REGIONS ];
+	};
+
+	//---------------------------------------------------------------------//
+}
+
+//---------------------------------------------------------------------//
+
+#endif // !STREAMINGBUFFER_H
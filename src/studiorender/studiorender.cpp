@@ -9,6 +9,7 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <GL/glew.h>
+#include <algorithm>
 
 #include "common/configurations.h"
 #include "engine/lifeengine.h"
@@ -38,11 +39,85 @@
 #include "engine/iconcmd.h"
 #include "engine/icamera.h"
 #include "engine/isprite.h"
+#include "engine/istatssystem.h"
 
 LIFEENGINE_STUDIORENDER_API( le::StudioRender );
 
+// Размер области потокового буфера на один кадр, при нехватке буфер увеличивается
+#define STUDIORENDER_STREAMING_REGION_SIZE		( 256 * 1024 )
+
 le::IConVar*		r_wireframe = nullptr;
 le::IConVar*		r_showgbuffer = nullptr;
+le::IConVar*		r_materialtable = nullptr;
+le::IConVar*		r_multithread = nullptr;
+le::IConVar*		r_dynres = nullptr;
+le::IConVar*		r_target_frametime = nullptr;
+le::IConVar*		r_dynres_minscale = nullptr;
+le::IConVar*		r_dynres_maxscale = nullptr;
+le::IConVar*		r_depthprepass = nullptr;
+le::IConCmd*		r_bufferstats = nullptr;
+le::IConCmd*		r_framestats = nullptr;
+le::IConCmd*		r_poolstats = nullptr;
+
+le::Stat			stat_meshesSubmitted;
+le::Stat			stat_surfacesSubmitted;
+le::Stat			stat_draws;
+le::Stat			stat_triangles;
+le::Stat			stat_vertexArraySwitches;
+le::Stat			stat_materialBatches;
+le::Stat			stat_lightsShaded;
+le::Stat			stat_uploadBytes;
+le::Stat			stat_gbufferBandwidth;
+le::Stat			stat_renderTargetsMemory;
+le::Stat			stat_resolutionScale;
+le::Stat			stat_gpuTime;
+le::Stat			stat_geometrySamples;
+le::Stat			stat_geometryOverdraw;
+
+namespace le
+{
+	// ------------------------------------------------------------------------------------ //
+	// Показать статистику общих буферов мешей
+	// ------------------------------------------------------------------------------------ //
+	void CMD_BufferStats( le::UInt32_t CountArguments, const char** Arguments )
+	{
+		g_studioRender->GetBufferArena().PrintStats();
+		g_consoleSystem->PrintInfo( "VAO switches in last frame: %i", g_studioRender->GetCountVertexArraySwitches() );
+	}
+
+	// ------------------------------------------------------------------------------------ //
+	// Показать статистику пулов объектов фабрики
+	// ------------------------------------------------------------------------------------ //
+	void CMD_PoolStats( le::UInt32_t CountArguments, const char** Arguments )
+	{
+		( ( StudioRenderFactory* ) g_studioRender->GetFactory() )->PrintStats();
+	}
+
+	// ------------------------------------------------------------------------------------ //
+	// Показать статистику временных данных кадров
+	// ------------------------------------------------------------------------------------ //
+	void CMD_FrameStats( le::UInt32_t CountArguments, const char** Arguments )
+	{
+		g_consoleSystem->PrintInfo( "Heap allocations in last frame: %i", g_studioRender->GetCountFrameAllocations() );
+
+		for ( UInt32_t index = 0; index < FRAMEDESCRIPTOR_COUNT_FRAMES; ++index )
+		{
+			const FrameDescriptor&		frame = g_studioRender->GetFrame( index );
+			UInt32_t					countRenderObjects = 0;
+			UInt32_t					capacityRenderObjects = 0;
+
+			for ( UInt32_t indexScene = 0, countScenes = frame.scenes.size(); indexScene < countScenes; ++indexScene )
+			{
+				if ( indexScene < frame.countScenes )		countRenderObjects += frame.scenes[ indexScene ].renderObjects.size();
+				capacityRenderObjects += frame.scenes[ indexScene ].renderObjects.capacity();
+			}
+
+			g_consoleSystem->PrintInfo( "Frame %i: scenes %i/%i, render objects %i/%i, transformations %i/%i", index,
+										frame.countScenes, frame.scenes.size(), countRenderObjects, capacityRenderObjects,
+										frame.transformations.size(), frame.transformations.capacity() );
+		}
+	}
+}
 
 // ------------------------------------------------------------------------------------ //
 // Начать отрисовку сцены
@@ -51,9 +126,23 @@ void le::StudioRender::BeginScene( ICamera* Camera )
 {
 	LIFEENGINE_ASSERT( Camera );
 
-	currentScene = scenes.size();
-	scenes.push_back( SceneDescriptor() );
-	scenes[ currentScene ].camera = Camera;
+	FrameDescriptor&		frame = frames[ currentFrame ];
+	currentScene = frame.countScenes;
+
+	SceneDescriptor&		sceneDescriptor = frame.AllocateScene();
+	sceneDescriptor.camera = Camera;
+	sceneDescriptor.cameraPosition = Camera->GetPosition();
+	sceneDescriptor.projectionMatrix = Camera->GetProjectionMatrix();
+	sceneDescriptor.viewMatrix = Camera->GetViewMatrix();
+	drawDepth = STUDIORENDER_DRAWDEPTH_UNSORTED;
+}
+
+// ------------------------------------------------------------------------------------ //
+// Задать порядок от камеры для следующих мешей сцены
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::SetDrawDepth( UInt32_t Depth )
+{
+	drawDepth = Depth;
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -71,6 +160,22 @@ void le::StudioRender::SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformatio
 // Добавить меш в очередь на отрисовку
 // ------------------------------------------------------------------------------------ //
 void le::StudioRender::SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformation, UInt32_t StartSurface, UInt32_t CountSurface )
+{
+	SubmitSurfaces( Mesh, Transformation, StartSurface, CountSurface, nullptr );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Добавить меш в очередь на отрисовку с освещением из сетки света уровня
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformation, UInt32_t StartSurface, UInt32_t CountSurface, const LightSample& LightSample )
+{
+	SubmitSurfaces( Mesh, Transformation, StartSurface, CountSurface, &LightSample );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Добавить поверхности меша в очередь на отрисовку
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::SubmitSurfaces( IMesh* Mesh, const Matrix4x4_t& Transformation, UInt32_t StartSurface, UInt32_t CountSurface, const LightSample* LightSample )
 {
 	LIFEENGINE_ASSERT( Mesh );
 	if ( !Mesh->IsCreated() )	
@@ -86,9 +191,15 @@ void le::StudioRender::SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformatio
 	//	CountSurface = Mesh->GetCountSurfaces() - StartSurface;
 	}
 
+	FrameDescriptor&		frame = frames[ currentFrame ];
+	SceneDescriptor&		sceneDescriptor = frame.scenes[ currentScene ];
+	const MaterialTable&	materialTable = mesh->GetMaterialTable();
+	UInt32_t				countSubmittedSurfaces = 0;
 	RenderObject		renderObject;
 	renderObject.vertexArrayObject = ( VertexArrayObject* ) &mesh->GetVertexArrayObject();
-	renderObject.transformation = Transformation;
+	renderObject.transformation = frame.AllocateTransformation( Transformation );
+	renderObject.isLightSample = LightSample != nullptr;
+	if ( LightSample )		renderObject.lightSample = *LightSample;
 
 	switch ( mesh->GetPrimitiveType() )
 	{
@@ -109,15 +220,34 @@ void le::StudioRender::SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformatio
 	{
 		surface = &surfaces[ index ];
 
-		renderObject.startVertexIndex = surface->startVertexIndex;
-		renderObject.startIndex = surface->startIndex;
+		// Смещения поверхности переводим в общие буферы арены, они могут измениться после дефрагментации
+		renderObject.startVertexIndex = surface->startVertexIndex + mesh->GetBaseVertex();
+		renderObject.indexType = mesh->GetSurfaceIndexFormat( index ).type;
+		renderObject.indexOffset = mesh->GetSurfaceIndexFormat( index ).offset + mesh->GetBaseIndexOffset();
 		renderObject.countIndeces = surface->countIndeces;
 		renderObject.lightmap = ( Texture* ) mesh->GetLightmap( surface->lightmapID );
 		renderObject.material = mesh->GetMaterial( surface->materialID );
 
+		// Пакеты таблиц материалов рисуются одним шейдером без освещения из сетки света
+		if ( !renderObject.isLightSample && materialTable.IsBatched( surface->materialID ) )
+		{
+			renderObject.materialTable = &materialTable;
+			renderObject.materialGroup = materialTable.GetGroup( surface->materialID );
+		}
+		else
+		{
+			renderObject.materialTable = nullptr;
+			renderObject.materialGroup = 0;
+		}
+
 		if ( !renderObject.material ) continue;
-		scenes[ currentScene ].renderObjects.push_back( renderObject );
+		frame.Push( sceneDescriptor.sortKeys, ( ( UInt64_t ) drawDepth << 32 ) | sceneDescriptor.renderObjects.size() );
+		frame.Push( sceneDescriptor.renderObjects, renderObject );
+		++countSubmittedSurfaces;
 	}
+
+	stat_meshesSubmitted.Add( 1 );
+	stat_surfacesSubmitted.Add( countSubmittedSurfaces );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -126,7 +256,8 @@ void le::StudioRender::SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformatio
 void le::StudioRender::SubmitLight( IPointLight* PointLight )
 {
 	LIFEENGINE_ASSERT( PointLight );
-	scenes[ currentScene ].pointLights.push_back( ( le::PointLight* ) PointLight );
+	FrameDescriptor&		frame = frames[ currentFrame ];
+	frame.Push( frame.scenes[ currentScene ].pointLights, *( le::PointLight* ) PointLight );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -135,7 +266,8 @@ void le::StudioRender::SubmitLight( IPointLight* PointLight )
 void le::StudioRender::SubmitLight( ISpotLight* SpotLight )
 {
 	LIFEENGINE_ASSERT( SpotLight );
-	scenes[ currentScene ].spotLights.push_back( ( le::SpotLight* ) SpotLight );
+	FrameDescriptor&		frame = frames[ currentFrame ];
+	frame.Push( frame.scenes[ currentScene ].spotLights, *( le::SpotLight* ) SpotLight );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -144,14 +276,24 @@ void le::StudioRender::SubmitLight( ISpotLight* SpotLight )
 void le::StudioRender::SubmitLight( IDirectionalLight* DirectionalLight )
 {
 	LIFEENGINE_ASSERT( DirectionalLight );
-	scenes[ currentScene ].directionalLights.push_back( ( le::DirectionalLight* ) DirectionalLight );
+	FrameDescriptor&		frame = frames[ currentFrame ];
+	frame.Push( frame.scenes[ currentScene ].directionalLights, *( le::DirectionalLight* ) DirectionalLight );
 }
 
 // ------------------------------------------------------------------------------------ //
 // Закончить отрисовку сцены
 // ------------------------------------------------------------------------------------ //
 void le::StudioRender::EndScene()
-{}
+{
+	// Сортируем ключи, а не объекты: при равной глубине индекс сохраняет порядок отправки.
+	// Уровень отправляет листья уже спереди назад, поэтому часто ключи отсортированы
+	FrameDescriptor&			frame = frames[ currentFrame ];
+	if ( currentScene >= frame.countScenes )		return;
+
+	std::vector< UInt64_t >&		sortKeys = frame.scenes[ currentScene ].sortKeys;
+	if ( !std::is_sorted( sortKeys.begin(), sortKeys.end() ) )
+		std::sort( sortKeys.begin(), sortKeys.end() );
+}
 
 // ------------------------------------------------------------------------------------ //
 // Инициализировать рендер
@@ -206,17 +348,23 @@ bool le::StudioRender::Initialize( IEngine* Engine )
 	viewport.x = viewport.y = 0;
 	Engine->GetWindow()->GetSize( viewport.width, viewport.height );
 
-	if ( !gbuffer.Initialize( Vector2DInt_t( viewport.width, viewport.height ) ) )
+	// Раскладка G-буфера выбирается при запуске, от нее зависит код всех шейдеров
+	GBuffer::LAYOUT_TYPE		gbufferLayout = configurations.isCompactGBuffer ? GBuffer::LT_COMPACT : GBuffer::LT_DEFAULT;
+	if ( !gbuffer.Initialize( &renderTargetPool, Vector2DInt_t( viewport.width, viewport.height ), gbufferLayout ) )
 	{
 		g_consoleSystem->PrintError( "Failed initialize GBuffer" );
 		return false;
 	}
 
+	GPUProgram::SetCommonCode( GBuffer::GetShaderCode( gbufferLayout ) );
+
 	// Инициализируем консольные команды
 	r_wireframe = ( IConVar* ) g_consoleSystem->GetFactory()->Create( CONVAR_INTERFACE_VERSION );
 	r_wireframe->Initialize( "r_wireframe", "0", CVT_BOOL, "Enable wireframe mode", true, 0, true, 1,
 							 []( le::IConVar* Var )
 							 {
+								 le::ContextLock		contextLock;
+
 								 if ( Var->GetValueBool() )
 									 glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
 								 else
@@ -226,25 +374,91 @@ bool le::StudioRender::Initialize( IEngine* Engine )
 	r_showgbuffer = ( IConVar* ) g_consoleSystem->GetFactory()->Create( CONVAR_INTERFACE_VERSION );
 	r_showgbuffer->Initialize( "r_showgbuffer", "0", CVT_BOOL, "Enable view GBuffer", true, 0, true, 1, nullptr );
 
+	r_materialtable = ( IConVar* ) g_consoleSystem->GetFactory()->Create( CONVAR_INTERFACE_VERSION );
+	r_materialtable->Initialize( "r_materialtable", "0", CVT_BOOL, "Merge draws of static meshes with texture arrays and material table", true, 0, true, 1, nullptr );
+
+	r_multithread = ( IConVar* ) g_consoleSystem->GetFactory()->Create( CONVAR_INTERFACE_VERSION );
+	r_multithread->Initialize( "r_multithread", "0", CVT_BOOL, "Render frame in separate thread while game prepares next frame", true, 0, true, 1, nullptr );
+
+	// Динамическое разрешение: масштаб кадра подбирается по времени GPU под целевое время кадра
+	r_dynres = ( IConVar* ) g_consoleSystem->GetFactory()->Create( CONVAR_INTERFACE_VERSION );
+	r_dynres->Initialize( "r_dynres", "0", CVT_BOOL, "Scale render resolution to hold target frame time", true, 0, true, 1, nullptr );
+
+	r_target_frametime = ( IConVar* ) g_consoleSystem->GetFactory()->Create( CONVAR_INTERFACE_VERSION );
+	r_target_frametime->Initialize( "r_target_frametime", "16.6", CVT_FLOAT, "Target GPU time of frame in ms for dynamic resolution", true, 1, true, 1000, nullptr );
+
+	r_dynres_minscale = ( IConVar* ) g_consoleSystem->GetFactory()->Create( CONVAR_INTERFACE_VERSION );
+	r_dynres_minscale->Initialize( "r_dynres_minscale", "0.5", CVT_FLOAT, "Minimum scale of render resolution", true, 0.25f, true, 1, nullptr );
+
+	r_dynres_maxscale = ( IConVar* ) g_consoleSystem->GetFactory()->Create( CONVAR_INTERFACE_VERSION );
+	r_dynres_maxscale->Initialize( "r_dynres_maxscale", "1", CVT_FLOAT, "Maximum scale of render resolution", true, 0.25f, true, 1, nullptr );
+
+	r_depthprepass = ( IConVar* ) g_consoleSystem->GetFactory()->Create( CONVAR_INTERFACE_VERSION );
+	r_depthprepass->Initialize( "r_depthprepass", "0", CVT_BOOL, "Write depth of opaque geometry before geometry pass, so heavy shaders run once per pixel", true, 0, true, 1, nullptr );
+
 	g_consoleSystem->RegisterVar( r_wireframe );
 	g_consoleSystem->RegisterVar( r_showgbuffer );
+	g_consoleSystem->RegisterVar( r_materialtable );
+	g_consoleSystem->RegisterVar( r_multithread );
+	g_consoleSystem->RegisterVar( r_dynres );
+	g_consoleSystem->RegisterVar( r_target_frametime );
+	g_consoleSystem->RegisterVar( r_dynres_minscale );
+	g_consoleSystem->RegisterVar( r_dynres_maxscale );
+	g_consoleSystem->RegisterVar( r_depthprepass );
+
+	r_bufferstats = ( IConCmd* ) g_consoleSystem->GetFactory()->Create( CONCMD_INTERFACE_VERSION );
+	r_bufferstats->Initialize( "r_bufferstats", "Show stats of shared mesh buffers and VAO switches", CMD_BufferStats );
+	g_consoleSystem->RegisterCommand( r_bufferstats );
+
+	r_framestats = ( IConCmd* ) g_consoleSystem->GetFactory()->Create( CONCMD_INTERFACE_VERSION );
+	r_framestats->Initialize( "r_framestats", "Show heap allocations and pool sizes of frame data", CMD_FrameStats );
+	g_consoleSystem->RegisterCommand( r_framestats );
+
+	r_poolstats = ( IConCmd* ) g_consoleSystem->GetFactory()->Create( CONCMD_INTERFACE_VERSION );
+	r_poolstats->Initialize( "r_poolstats", "Show object pools of studiorender factory", CMD_PoolStats );
+	g_consoleSystem->RegisterCommand( r_poolstats );
 	g_engine = Engine;
 
+	// Статистику кадра публикуем в реестр движка. При r_multithread проходы рисуются
+	// в потоке рендера, поэтому их значения попадают в статистику следующего кадра
+	IStatsSystem*		statsSystem = Engine->GetStatsSystem();
+	stat_meshesSubmitted.Register( statsSystem, "render.meshes_submitted", ST_COUNTER );
+	stat_surfacesSubmitted.Register( statsSystem, "render.surfaces_submitted", ST_COUNTER );
+	stat_draws.Register( statsSystem, "render.draws", ST_COUNTER );
+	stat_triangles.Register( statsSystem, "render.triangles", ST_COUNTER );
+	stat_vertexArraySwitches.Register( statsSystem, "render.vao_switches", ST_COUNTER );
+	stat_materialBatches.Register( statsSystem, "render.material_batches", ST_COUNTER );
+	stat_lightsShaded.Register( statsSystem, "render.lights_shaded", ST_COUNTER );
+	stat_uploadBytes.Register( statsSystem, "render.upload_bytes", ST_COUNTER );
+	stat_gbufferBandwidth.Register( statsSystem, "render.gbuffer_bytes", ST_COUNTER );
+	stat_renderTargetsMemory.Register( statsSystem, "render.rendertargets_memory", ST_GAUGE );
+	stat_resolutionScale.Register( statsSystem, "render.resolution_scale", ST_GAUGE );
+	stat_gpuTime.Register( statsSystem, "render.gpu_time_us", ST_GAUGE );
+	stat_geometrySamples.Register( statsSystem, "render.geometry_samples", ST_GAUGE );
+	stat_geometryOverdraw.Register( statsSystem, "render.geometry_overdraw", ST_GAUGE );
+	g_statTextureBinds.Register( statsSystem, "render.texture_binds", ST_COUNTER );
+
 	quad.Create();
 	sphere.Create();
 	cone.Create();
 
-	if ( !shaderDepth.Create() || !shaderLighting.Create() )
+	if ( !shaderDepth.Create() || !shaderLighting.Create() || !shaderMaterialTable.Create() )
 		return false;
 
-	shaderLighting.SetType( ShaderLighting::LT_POINT );
-	shaderLighting.SetSizeViewport( Vector2D_t( viewport.width, viewport.height ) );
+	GLint		alignment = 0;
+	glGetIntegerv( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment );
+	uniformAlignment = alignment > 0 ? alignment : 256;
 
-	shaderLighting.SetType( ShaderLighting::LT_SPOT );
-	shaderLighting.SetSizeViewport( Vector2D_t( viewport.width, viewport.height ) );
+	if ( !streamingBuffer.Create( GL_UNIFORM_BUFFER, STUDIORENDER_STREAMING_REGION_SIZE ) )
+		return false;
 
-	shaderLighting.SetType( ShaderLighting::LT_DIRECTIONAL );
-	shaderLighting.SetSizeViewport( Vector2D_t( viewport.width, viewport.height ) );
+	g_consoleSystem->PrintInfo( "Streaming buffer: %s", streamingBuffer.IsPersistent() ? "persistent mapping" : "orphaning" );
+
+	// Без запросов таймера время GPU не измерить, кадр всегда рисуется в полном разрешении
+	if ( !dynamicResolution.Create() )
+		g_consoleSystem->PrintWarning( "Timer queries not supported, dynamic resolution disabled" );
+
+	geometrySamples.Create( GL_SAMPLES_PASSED );
 
 	return true;
 }
@@ -255,10 +469,24 @@ bool le::StudioRender::Initialize( IEngine* Engine )
 void le::StudioRender::Begin()
 {
 	LIFEENGINE_ASSERT( renderContext.IsCreated() );
-	glViewport( viewport.x, viewport.y, viewport.width, viewport.height );
 
+	// Режим рендера переключаем между кадрами, когда поток рендера не занят
+	if ( r_multithread->GetValueBool() != isMultithread )
+	{
+		if ( isMultithread )	StopRenderThread();
+		else					StartRenderThread();
+	}
+
+	// Сцены и пулы кадра переиспользуются, память под них выделяется только при росте
 	currentScene = 0;
-	scenes.clear();
+	frames[ currentFrame ].Reset();
+
+	// Дефрагментация двигает меши в общих буферах, поэтому делается до отправки мешей на отрисовку
+	if ( bufferArena.IsNeedDefragment() )
+	{
+		ContextLock			contextLock;
+		bufferArena.Defragment();
+	}
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -276,12 +504,61 @@ void le::StudioRender::Present()
 {
 	LIFEENGINE_ASSERT( renderContext.IsCreated() );
 
-	for ( UInt32_t indexScene = 0, countScenes = scenes.size(); indexScene < countScenes; ++indexScene )
+	if ( !isMultithread )
+	{
+		RenderFrame( frames[ currentFrame ], viewport );
+		return;
+	}
+
+	// Очередь на один кадр: ждем, пока поток рендера закончит предыдущий снимок, и отдаем ему новый
+	std::unique_lock< std::mutex >		lock( renderMutex );
+	conditionDone.wait( lock, [ this ]() { return !isFramePending; } );
+
+	renderFrame = currentFrame;
+	currentFrame = ( currentFrame + 1 ) % FRAMEDESCRIPTOR_COUNT_FRAMES;
+	renderViewport = viewport;
+	isFramePending = true;
+	conditionRender.notify_all();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Нарисовать снимок кадра
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::RenderFrame( FrameDescriptor& Frame, const StudioRenderViewport& Viewport )
+{
+	countVertexArraySwitches = 0;
+
+	// Масштаб кадра считается по времени GPU прошлых кадров. Проходы рисуются в уменьшенную
+	// часть буферов, финальный кадр растягивается на все окно
+	if ( r_dynres->GetValueBool() )
+		dynamicResolution.Update( r_target_frametime->GetValueFloat(), r_dynres_minscale->GetValueFloat(), r_dynres_maxscale->GetValueFloat() );
+	else
+		dynamicResolution.Reset();
+
+	Vector2DInt_t		outputSize( Viewport.width, Viewport.height );
+	Vector2DInt_t		renderSize = glm::max( Vector2DInt_t( Vector2D_t( outputSize ) * dynamicResolution.GetScale() ), Vector2DInt_t( 1, 1 ) );
+	glViewport( Viewport.x, Viewport.y, renderSize.x, renderSize.y );
+
+	// Буферы кадра берутся из пула под текущий размер окна, после изменения размера пул выделит новые
+	if ( !gbuffer.Begin( renderSize, outputSize ) )
+	{
+		renderContext.SwapBuffers();
+		return;
+	}
+
+	dynamicResolution.BeginFrame();
+
+	shaderLighting.SetSizeViewport( Vector2D_t( gbuffer.GetSize() ), Vector2D_t( gbuffer.GetTargetSize() ) );
+
+	// Данные кадра пишем в потоковый буфер до первой отрисовки
+	UploadSceneData( Frame );
+
+	for ( UInt32_t indexScene = 0; indexScene < Frame.countScenes; ++indexScene )
 	{
-		SceneDescriptor&			sceneDescriptor = scenes[ indexScene ];
+		SceneDescriptor&			sceneDescriptor = Frame.scenes[ indexScene ];
 
-		// Геометрический проход Deffered Shading'a
-		Render_GeometryPass( sceneDescriptor );
+		// Геометрический проход Deffered Shading'a. Перерисовку считаем по первой сцене кадра
+		Render_GeometryPass( Frame, sceneDescriptor, indexScene == 0 );
 
 		// Проход освещения
 		Render_LightPass( sceneDescriptor );
@@ -290,21 +567,219 @@ void le::StudioRender::Present()
 		Render_FinalPass( sceneDescriptor );
 	}
 
+	streamingBuffer.EndFrame();
+	countFrameAllocations = Frame.countAllocations;
+
 	if ( r_showgbuffer->GetValueBool() )		gbuffer.ShowBuffers();
+	gbuffer.End();
+	renderTargetPool.EndFrame();
+	dynamicResolution.EndFrame();
+
+	stat_renderTargetsMemory.Set( renderTargetPool.GetMemorySize() );
+	stat_resolutionScale.Set( ( Int64_t ) ( dynamicResolution.GetScale() * 100.f + 0.5f ) );
+	stat_gpuTime.Set( ( Int64_t ) ( dynamicResolution.GetGPUTime() * 1000.f ) );
+	// Результат запроса приходит с опозданием на кадры, поэтому делим на площадь того кадра, а не текущего
+	stat_geometrySamples.Set( geometrySamples.GetResult() );
+	if ( geometrySamples.GetResultFrameValue() > 0.0 )
+		stat_geometryOverdraw.Set( ( Int64_t ) ( geometrySamples.GetResult() * 100.0 / geometrySamples.GetResultFrameValue() ) );
+
 	renderContext.SwapBuffers();
 }
 
+// ------------------------------------------------------------------------------------ //
+// Запустить поток рендера, контекст OpenGL переходит к нему
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::StartRenderThread()
+{
+	if ( isMultithread )		return;
+
+	isStopRenderThread = false;
+	isFramePending = false;
+	isContextRequested = false;
+	isContextReleased = false;
+	countContextLocks = 0;
+	gameThread = std::this_thread::get_id();
+
+	renderContext.ReleaseCurrent();
+	renderThread = std::thread( &StudioRender::RenderThread, this );
+	isMultithread = true;
+
+	g_consoleSystem->PrintInfo( "Render thread started" );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Остановить поток рендера, контекст OpenGL возвращается потоку игры
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::StopRenderThread()
+{
+	if ( !isMultithread )		return;
+
+	{
+		std::lock_guard< std::mutex >		lock( renderMutex );
+		isStopRenderThread = true;
+	}
+
+	conditionRender.notify_all();
+	renderThread.join();
+
+	isMultithread = false;
+	renderContext.MakeCurrent();
+
+	g_consoleSystem->PrintInfo( "Render thread stopped" );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Поток рендера
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::RenderThread()
+{
+	renderContext.MakeCurrent();
+	std::unique_lock< std::mutex >		lock( renderMutex );
+
+	while ( true )
+	{
+		conditionRender.wait( lock, [ this ]() { return isStopRenderThread || isFramePending || isContextRequested; } );
+
+		// Кадр в очереди рисуем первым: ресурсы из его снимка могут быть удалены, как только контекст уйдет игре
+		if ( isFramePending )
+		{
+			lock.unlock();
+			RenderFrame( frames[ renderFrame ], renderViewport );
+			lock.lock();
+
+			isFramePending = false;
+			conditionDone.notify_all();
+			continue;
+		}
+
+		if ( isContextRequested )
+		{
+			renderContext.ReleaseCurrent();
+			isContextReleased = true;
+			conditionDone.notify_all();
+
+			conditionRender.wait( lock, [ this ]() { return !isContextRequested; } );
+			renderContext.MakeCurrent();
+			continue;
+		}
+
+		if ( isStopRenderThread )		break;
+	}
+
+	renderContext.ReleaseCurrent();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Захватить контекст OpenGL в потоке игры. Счетчик вложенных захватов не атомарный,
+// поэтому захват допустим только из потока игры, запустившего поток рендера
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::LockContext()
+{
+	if ( !isMultithread || std::this_thread::get_id() == renderThread.get_id() )		return;
+	LIFEENGINE_ASSERT( std::this_thread::get_id() == gameThread );
+	if ( countContextLocks++ > 0 )		return;
+
+	std::unique_lock< std::mutex >		lock( renderMutex );
+	isContextRequested = true;
+	conditionRender.notify_all();
+	conditionDone.wait( lock, [ this ]() { return isContextReleased; } );
+
+	renderContext.MakeCurrent();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Вернуть контекст OpenGL потоку рендера
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::UnlockContext()
+{
+	if ( !isMultithread || std::this_thread::get_id() == renderThread.get_id() )		return;
+	LIFEENGINE_ASSERT( std::this_thread::get_id() == gameThread && countContextLocks > 0 );
+	if ( --countContextLocks > 0 )		return;
+
+	renderContext.ReleaseCurrent();
+
+	{
+		std::lock_guard< std::mutex >		lock( renderMutex );
+		isContextRequested = false;
+		isContextReleased = false;
+	}
+
+	conditionRender.notify_all();
+}
+
+// ------------------------------------------------------------------------------------ //
+// Записать матрицы сцен и объектов в потоковый буфер
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::UploadSceneData( FrameDescriptor& Frame )
+{
+	UInt32_t		blockSize = ( ( sizeof( Matrix4x4_t ) + uniformAlignment - 1 ) / uniformAlignment ) * uniformAlignment;
+	UInt32_t		countBlocks = Frame.countScenes + Frame.transformations.size();
+
+	// Если данные кадра не помещаются в область - пересоздаем буфер с запасом
+	if ( countBlocks * blockSize > streamingBuffer.GetRegionSize() )
+		streamingBuffer.Create( GL_UNIFORM_BUFFER, glm::max( streamingBuffer.GetRegionSize() * 2, countBlocks * blockSize ) );
+
+	streamingBuffer.BeginFrame();
+
+	for ( UInt32_t indexScene = 0; indexScene < Frame.countScenes; ++indexScene )
+	{
+		SceneDescriptor&		sceneDescriptor = Frame.scenes[ indexScene ];
+		Matrix4x4_t*			data = ( Matrix4x4_t* ) streamingBuffer.Allocate( sizeof( Matrix4x4_t ), uniformAlignment, sceneDescriptor.uniformOffset );
+		*data = sceneDescriptor.projectionMatrix * sceneDescriptor.viewMatrix;
+	}
+
+	// Каждая матрица пула пишется один раз, объекты ссылаются на нее по индексу
+	for ( UInt32_t index = 0, count = Frame.transformations.size(); index < count; ++index )
+	{
+		UInt32_t				offset = 0;
+		Matrix4x4_t*			data = ( Matrix4x4_t* ) streamingBuffer.Allocate( sizeof( Matrix4x4_t ), uniformAlignment, offset );
+		*data = Frame.transformations[ index ];
+		Frame.Push( Frame.transformOffsets, offset );
+	}
+
+	streamingBuffer.Flush();
+	stat_uploadBytes.Add( countBlocks * blockSize );
+}
+
 // ------------------------------------------------------------------------------------ //
 // Геометрический проход Deffered Shading'a
 // ------------------------------------------------------------------------------------ //
-void le::StudioRender::Render_GeometryPass( const SceneDescriptor& SceneDescriptor ) 
+void le::StudioRender::Render_GeometryPass( const FrameDescriptor& Frame, const SceneDescriptor& SceneDescriptor, bool IsCountSamples ) 
 {
 	gbuffer.Bind( GBuffer::BT_GEOMETRY );
 	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+	glBindBufferRange( GL_UNIFORM_BUFFER, GPUPROGRAM_SCENE_UNIFORM_BINDING, streamingBuffer.GetHandle(), SceneDescriptor.uniformOffset, sizeof( Matrix4x4_t ) );
+
+	// После прохода глубины шейдеры материалов выполняются только для видимых пикселей
+	bool						isDepthPrePass = r_depthprepass->GetValueBool();
+	UInt32_t					countSwitches = countVertexArraySwitches;
+	if ( isDepthPrePass )
+	{
+		Render_DepthPrePass( Frame, SceneDescriptor );
+		OpenGLState::SetDepthFunc( GL_LEQUAL );
+	}
+
+	// Выборки считаем после прохода глубины, чтобы в них были только затененные пиксели:
+	// число выборок, прошедших тест глубины, к площади кадра
+	if ( IsCountSamples )		geometrySamples.Begin( ( double ) gbuffer.GetSize().x * gbuffer.GetSize().y );
 
-	for ( UInt32_t indexObject = 0, countObjects = SceneDescriptor.renderObjects.size(); indexObject < countObjects; ++indexObject )
+	bool						isMaterialTable = r_materialtable->GetValueBool();
+	const VertexArrayObject*	currentVertexArrayObject = nullptr;
+	UInt32_t					currentUniformOffset = UINT32_MAX;
+	UInt32_t					countDraws = 0;
+	UInt32_t					countTriangles = 0;
+	countMaterialBatches = 0;
+
+	// Объекты идут по ключам сортировки, непрозрачная геометрия уровня - спереди назад
+	for ( UInt32_t indexObject = 0, countObjects = SceneDescriptor.sortKeys.size(); indexObject < countObjects; ++indexObject )
 	{
-		const RenderObject&		renderObject = SceneDescriptor.renderObjects[ indexObject ];
+		const RenderObject&		renderObject = SceneDescriptor.renderObjects[ ( UInt32_t ) SceneDescriptor.sortKeys[ indexObject ] ];
+		if ( isMaterialTable && renderObject.materialTable )
+		{
+			AddToMaterialBatch( Frame, renderObject );
+			continue;
+		}
+
 		StudioRenderTechnique*	technique = ( StudioRenderTechnique* ) renderObject.material->GetTechnique( RT_DEFFERED_SHADING );
 		if ( !technique ) continue;
 
@@ -312,47 +787,209 @@ void le::StudioRender::Render_GeometryPass( const SceneDescriptor& SceneDescript
 		{
 			StudioRenderPass*		pass = ( StudioRenderPass* ) technique->GetPass( indexPass );
 
-			pass->Apply( renderObject.transformation, SceneDescriptor.camera, renderObject.lightmap );
+			pass->Apply( Frame.transformations[ renderObject.transformation ], SceneDescriptor.camera, renderObject.lightmap, renderObject.isLightSample ? &renderObject.lightSample : nullptr );
+			if ( Frame.transformOffsets[ renderObject.transformation ] != currentUniformOffset )
+			{
+				currentUniformOffset = Frame.transformOffsets[ renderObject.transformation ];
+				glBindBufferRange( GL_UNIFORM_BUFFER, GPUPROGRAM_OBJECT_UNIFORM_BINDING, streamingBuffer.GetHandle(), currentUniformOffset, sizeof( Matrix4x4_t ) );
+			}
+
+			if ( renderObject.vertexArrayObject != currentVertexArrayObject )
+			{
+				renderObject.vertexArrayObject->Bind();
+				currentVertexArrayObject = renderObject.vertexArrayObject;
+				++countVertexArraySwitches;
+			}
+
+			glDrawElementsBaseVertex( renderObject.primitiveType, renderObject.countIndeces, renderObject.indexType, ( void* ) ( size_t ) renderObject.indexOffset, renderObject.startVertexIndex );
+			++countDraws;
+			countTriangles += renderObject.countIndeces / 3;
+		}
+	}
+
+	if ( countMaterialBatches > 0 )
+	{
+		// Пакет рисуется одним вызовом, треугольники считаем по всем его поверхностям
+		for ( UInt32_t indexBatch = 0; indexBatch < countMaterialBatches; ++indexBatch )
+			for ( UInt32_t index = 0, count = materialBatches[ indexBatch ].counts.size(); index < count; ++index )
+				countTriangles += materialBatches[ indexBatch ].counts[ index ] / 3;
+
+		countDraws += countMaterialBatches;
+		Render_MaterialBatches( SceneDescriptor );
+	}
+
+	if ( IsCountSamples )		geometrySamples.End();
+	if ( isDepthPrePass )		OpenGLState::SetDepthFunc( GL_LESS );
+
+	stat_draws.Add( countDraws );
+	stat_triangles.Add( countTriangles );
+	stat_vertexArraySwitches.Add( countVertexArraySwitches - countSwitches );
+	stat_materialBatches.Add( countMaterialBatches );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Предварительный проход глубины: непрозрачная геометрия пишет только глубину
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::Render_DepthPrePass( const FrameDescriptor& Frame, const SceneDescriptor& SceneDescriptor )
+{
+	const VertexArrayObject*	currentVertexArrayObject = nullptr;
+	UInt32_t					currentUniformOffset = UINT32_MAX;
+	UInt32_t					countDraws = 0;
+
+	OpenGLState::SetColorMask( false, false, false, false );
+	OpenGLState::EnableBlend( false );
+	OpenGLState::EnableDepthTest( true );
+	OpenGLState::EnableDepthWrite( true );
+
+	shaderDepth.SetType( ShaderDepth::GT_SCENE );
+	shaderDepth.Bind();
+
+	for ( UInt32_t indexObject = 0, countObjects = SceneDescriptor.sortKeys.size(); indexObject < countObjects; ++indexObject )
+	{
+		const RenderObject&		renderObject = SceneDescriptor.renderObjects[ ( UInt32_t ) SceneDescriptor.sortKeys[ indexObject ] ];
+		StudioRenderTechnique*	technique = ( StudioRenderTechnique* ) renderObject.material->GetTechnique( RT_DEFFERED_SHADING );
+		if ( !technique || technique->GetCountPasses() == 0 ) continue;
+
+		// Прозрачные проходы и проходы без записи глубины в предварительный проход не попадают
+		StudioRenderPass*		pass = ( StudioRenderPass* ) technique->GetPass( 0 );
+		if ( pass->IsBlend() || !pass->IsDepthTest() || !pass->IsDepthWrite() ) continue;
+
+		OpenGLState::EnableCullFace( pass->IsCullFace() );
+		OpenGLState::SetCullFaceType( pass->GetCullFaceType() );
+
+		if ( Frame.transformOffsets[ renderObject.transformation ] != currentUniformOffset )
+		{
+			currentUniformOffset = Frame.transformOffsets[ renderObject.transformation ];
+			glBindBufferRange( GL_UNIFORM_BUFFER, GPUPROGRAM_OBJECT_UNIFORM_BINDING, streamingBuffer.GetHandle(), currentUniformOffset, sizeof( Matrix4x4_t ) );
+		}
+
+		if ( renderObject.vertexArrayObject != currentVertexArrayObject )
+		{
 			renderObject.vertexArrayObject->Bind();
-			glDrawRangeElementsBaseVertex( renderObject.primitiveType, 0, renderObject.countIndeces, renderObject.countIndeces, GL_UNSIGNED_INT, ( void* ) ( renderObject.startIndex * sizeof( UInt32_t ) ), renderObject.startVertexIndex );
+			currentVertexArrayObject = renderObject.vertexArrayObject;
+			++countVertexArraySwitches;
 		}
+
+		glDrawElementsBaseVertex( renderObject.primitiveType, renderObject.countIndeces, renderObject.indexType, ( void* ) ( size_t ) renderObject.indexOffset, renderObject.startVertexIndex );
+		++countDraws;
 	}
+
+	shaderDepth.Unbind();
+	OpenGLState::SetColorMask( true, true, true, true );
+	stat_draws.Add( countDraws );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Добавить объект в пакет отрисовки через таблицу материалов
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::AddToMaterialBatch( const FrameDescriptor& Frame, const RenderObject& RenderObject )
+{
+	MaterialBatch*		materialBatch = nullptr;
+
+	for ( UInt32_t index = 0; index < countMaterialBatches; ++index )
+	{
+		MaterialBatch&		batch = materialBatches[ index ];
+		if ( batch.materialTable == RenderObject.materialTable && batch.group == RenderObject.materialGroup && batch.indexType == RenderObject.indexType &&
+			 batch.vertexArrayObject == RenderObject.vertexArrayObject && batch.transformation == RenderObject.transformation )
+		{
+			materialBatch = &batch;
+			break;
+		}
+	}
+
+	// Пакеты не удаляются между кадрами, чтобы не перевыделять память под массивы
+	if ( !materialBatch )
+	{
+		if ( countMaterialBatches == materialBatches.size() )
+			materialBatches.push_back( MaterialBatch() );
+
+		materialBatch = &materialBatches[ countMaterialBatches ];
+		++countMaterialBatches;
+
+		materialBatch->vertexArrayObject = RenderObject.vertexArrayObject;
+		materialBatch->materialTable = RenderObject.materialTable;
+		materialBatch->group = RenderObject.materialGroup;
+		materialBatch->indexType = RenderObject.indexType;
+		materialBatch->transformation = RenderObject.transformation;
+		materialBatch->uniformOffset = Frame.transformOffsets[ RenderObject.transformation ];
+		materialBatch->counts.clear();
+		materialBatch->offsets.clear();
+		materialBatch->baseVerteces.clear();
+	}
+
+	materialBatch->counts.push_back( RenderObject.countIndeces );
+	materialBatch->offsets.push_back( ( void* ) ( size_t ) RenderObject.indexOffset );
+	materialBatch->baseVerteces.push_back( RenderObject.startVertexIndex );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Отрисовать пакеты таблиц материалов
+// ------------------------------------------------------------------------------------ //
+void le::StudioRender::Render_MaterialBatches( const SceneDescriptor& SceneDescriptor )
+{
+	shaderMaterialTable.Bind();
+
+	for ( UInt32_t index = 0; index < countMaterialBatches; ++index )
+	{
+		MaterialBatch&		materialBatch = materialBatches[ index ];
+
+		materialBatch.materialTable->GetPass( materialBatch.group )->InitStates();
+		materialBatch.materialTable->Bind( materialBatch.group );
+		glBindBufferRange( GL_UNIFORM_BUFFER, GPUPROGRAM_OBJECT_UNIFORM_BINDING, streamingBuffer.GetHandle(), materialBatch.uniformOffset, sizeof( Matrix4x4_t ) );
+
+		materialBatch.vertexArrayObject->Bind();
+		++countVertexArraySwitches;
+		glMultiDrawElementsBaseVertex( GL_TRIANGLES, materialBatch.counts.data(), materialBatch.indexType, materialBatch.offsets.data(), materialBatch.counts.size(), materialBatch.baseVerteces.data() );
+	}
+
+	shaderMaterialTable.Unbind();
 }
 
 // ------------------------------------------------------------------------------------ //
 // Световой проход Deffered Shading'a
 // ------------------------------------------------------------------------------------ //
-void le::StudioRender::Render_LightPass( const SceneDescriptor& SceneDescriptor ) 
+void le::StudioRender::Render_LightPass( SceneDescriptor& SceneDescriptor ) 
 {
 	gbuffer.Bind( GBuffer::BT_LIGHT ); 
 	glClear( GL_COLOR_BUFFER_BIT );
 
+	// Запеченное освещение (карты освещения и сетка света) пишется первым, источники света складываются поверх
+	shaderLighting.SetType( ShaderLighting::LT_EMISSION );
+	shaderLighting.Bind();
+	quad.Bind();
+
+	OpenGLState::EnableDepthTest( false );
+	OpenGLState::SetCullFaceType( CT_BACK );
+	glDrawElements( GL_TRIANGLES, quad.GetCountIndeces(), GL_UNSIGNED_INT, ( void* ) ( quad.GetStartIndex() * sizeof( UInt32_t ) ) );
+
 	OpenGLState::EnableStencilTest( true );
 	OpenGLState::EnableDepthWrite( false );
 	OpenGLState::SetCullFaceType( CT_FRONT );
 	OpenGLState::SetStencilOpSeparate( GL_FRONT, GL_KEEP, GL_INCR_WRAP, GL_KEEP );
 	OpenGLState::SetStencilOpSeparate( GL_BACK, GL_KEEP, GL_DECR_WRAP_EXT, GL_KEEP );
 
+	Matrix4x4_t			projectionView = SceneDescriptor.projectionMatrix * SceneDescriptor.viewMatrix;
+
 	shaderDepth.SetType( ShaderDepth::GT_SPHERE );
 	shaderLighting.SetType( ShaderLighting::LT_POINT );
-	shaderLighting.SetCamera( SceneDescriptor.camera );
+	shaderLighting.SetCamera( SceneDescriptor.cameraPosition, SceneDescriptor.projectionMatrix, SceneDescriptor.viewMatrix );
 	sphere.Bind();
 
 	for ( UInt32_t indexLight = 0, countLights = SceneDescriptor.pointLights.size(); indexLight < countLights; ++indexLight )
 	{
-		auto*			light = SceneDescriptor.pointLights[ indexLight ];
+		auto*			light = &SceneDescriptor.pointLights[ indexLight ];
 
 		OpenGLState::SetColorMask( false, false, false, false );
 		OpenGLState::EnableDepthTest( true );
 		glClear( GL_STENCIL_BUFFER_BIT );
 		OpenGLState::SetStencilFunc( GL_ALWAYS, 0, 0 );
 
-		shaderDepth.SetPVTMatrix( SceneDescriptor.camera->GetProjectionMatrix() * SceneDescriptor.camera->GetViewMatrix() * light->GetTransformation() );
+		shaderDepth.SetPVTMatrix( projectionView * light->GetTransformation() );
 		shaderDepth.SetRadius( light->GetRadius() );
 		shaderDepth.Bind();
 		glDrawElements( GL_TRIANGLES, sphere.GetCountIndeces(), GL_UNSIGNED_INT, ( void* ) ( sphere.GetStartIndex() * sizeof( UInt32_t ) ) );
 	
-		shaderLighting.SetPVTMatrix( SceneDescriptor.camera->GetProjectionMatrix() * SceneDescriptor.camera->GetViewMatrix() * light->GetTransformation() );
+		shaderLighting.SetPVTMatrix( projectionView * light->GetTransformation() );
 		shaderLighting.SetLight( light );
 		shaderLighting.Bind();	
 		
@@ -367,25 +1004,25 @@ void le::StudioRender::Render_LightPass( const SceneDescriptor& SceneDescriptor
 
 	shaderDepth.SetType( ShaderDepth::GT_CONE );
 	shaderLighting.SetType( ShaderLighting::LT_SPOT );
-	shaderLighting.SetCamera( SceneDescriptor.camera );
+	shaderLighting.SetCamera( SceneDescriptor.cameraPosition, SceneDescriptor.projectionMatrix, SceneDescriptor.viewMatrix );
 	cone.Bind();
 
 	for ( UInt32_t indexLight = 0, countLights = SceneDescriptor.spotLights.size(); indexLight < countLights; ++indexLight )
 	{
-		auto*			light = SceneDescriptor.spotLights[ indexLight ];
+		auto*			light = &SceneDescriptor.spotLights[ indexLight ];
 
 		OpenGLState::SetColorMask( false, false, false, false );
 		OpenGLState::EnableDepthTest( true );
 		glClear( GL_STENCIL_BUFFER_BIT );
 		OpenGLState::SetStencilFunc( GL_ALWAYS, 0, 0 );
 	
-		shaderDepth.SetPVTMatrix( SceneDescriptor.camera->GetProjectionMatrix() * SceneDescriptor.camera->GetViewMatrix() * light->GetTransformation() );
+		shaderDepth.SetPVTMatrix( projectionView * light->GetTransformation() );
 		shaderDepth.SetRadius( light->GetRadius() );
 		shaderDepth.SetHeight( light->GetHeight() );
 		shaderDepth.Bind();
 		glDrawElements( GL_TRIANGLES, cone.GetCountIndeces(), GL_UNSIGNED_INT, ( void* ) ( cone.GetStartIndex() * sizeof( UInt32_t ) ) );
 	
-		shaderLighting.SetPVTMatrix( SceneDescriptor.camera->GetProjectionMatrix() * SceneDescriptor.camera->GetViewMatrix() * light->GetTransformation() );
+		shaderLighting.SetPVTMatrix( projectionView * light->GetTransformation() );
 		shaderLighting.SetLight( light );
 		shaderLighting.Bind();	
 		
@@ -399,7 +1036,7 @@ void le::StudioRender::Render_LightPass( const SceneDescriptor& SceneDescriptor
 	}
 
 	shaderLighting.SetType( ShaderLighting::LT_DIRECTIONAL );
-	shaderLighting.SetCamera( SceneDescriptor.camera );
+	shaderLighting.SetCamera( SceneDescriptor.cameraPosition, SceneDescriptor.projectionMatrix, SceneDescriptor.viewMatrix );
 	quad.Bind();
 
 	OpenGLState::EnableStencilTest( false );
@@ -408,7 +1045,7 @@ void le::StudioRender::Render_LightPass( const SceneDescriptor& SceneDescriptor
 
 	for ( UInt32_t indexLight = 0, countLights = SceneDescriptor.directionalLights.size(); indexLight < countLights; ++indexLight )
 	{
-		auto*			light = SceneDescriptor.directionalLights[ indexLight ];
+		auto*			light = &SceneDescriptor.directionalLights[ indexLight ];
 		
 		shaderLighting.SetLight( light );
 		shaderLighting.Bind();	
@@ -419,6 +1056,14 @@ void le::StudioRender::Render_LightPass( const SceneDescriptor& SceneDescriptor
 	OpenGLState::EnableStencilTest( false );
 	OpenGLState::EnableDepthTest( true );
 	OpenGLState::EnableDepthWrite( true );
+
+	// Точечный и прожекторный свет рисуются двумя вызовами: трафарет и освещение
+	UInt32_t		countVolumeLights = SceneDescriptor.pointLights.size() + SceneDescriptor.spotLights.size();
+	stat_lightsShaded.Add( countVolumeLights + SceneDescriptor.directionalLights.size() );
+	stat_draws.Add( 1 + countVolumeLights * 2 + SceneDescriptor.directionalLights.size() );
+
+	// Полноэкранные проходы: запеченное освещение и направленные источники
+	stat_gbufferBandwidth.Add( gbuffer.GetFrameBandwidth( 1 + SceneDescriptor.directionalLights.size() ) );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -435,6 +1080,8 @@ void le::StudioRender::Render_FinalPass( const SceneDescriptor& SceneDescriptor
 void le::StudioRender::SetVerticalSyncEnabled( bool IsEnabled )
 {
 	LIFEENGINE_ASSERT( renderContext.IsCreated() );
+
+	ContextLock			contextLock;
 	renderContext.SetVerticalSync( IsEnabled );
 }
 
@@ -475,7 +1122,20 @@ const le::StudioRenderViewport& le::StudioRender::GetViewport() const
 // ------------------------------------------------------------------------------------ //
 le::StudioRender::StudioRender() :
 	isInitialize( false ),
-	currentScene( 0 )
+	currentScene( 0 ),
+	drawDepth( STUDIORENDER_DRAWDEPTH_UNSORTED ),
+	currentFrame( 0 ),
+	renderFrame( 0 ),
+	countFrameAllocations( 0 ),
+	countMaterialBatches( 0 ),
+	countVertexArraySwitches( 0 ),
+	uniformAlignment( 256 ),
+	isMultithread( false ),
+	isStopRenderThread( false ),
+	isFramePending( false ),
+	isContextRequested( false ),
+	isContextReleased( false ),
+	countContextLocks( 0 )
 {
 	LIFEENGINE_ASSERT( !g_studioRender );
 	g_studioRender = this;
@@ -486,5 +1146,15 @@ le::StudioRender::StudioRender() :
 // ------------------------------------------------------------------------------------ //
 le::StudioRender::~StudioRender()
 {
+	StopRenderThread();
+
+	// Буферы удаляются, пока контекст еще жив
+	gbuffer.Delete();
+	renderTargetPool.Clear();
+	dynamicResolution.Delete();
+	geometrySamples.Delete();
 	if ( renderContext.IsCreated() )		renderContext.Destroy();
+
+	// Меши, удаленные после рендера, не должны обращаться к его арене
+	g_studioRender = nullptr;
 }
@@ -12,14 +12,20 @@
 #define STUDIORENDER_H
 
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "studiorender/istudiorenderinternal.h"
 #include "studiorender/studiorenderviewport.h"
 #include "studiorender/rendercontext.h"
 #include "studiorender/studiorenderfactory.h"
 #include "studiorender/scenedescriptor.h"
+#include "studiorender/framedescriptor.h"
+#include "studiorender/materialbatch.h"
 #include "studiorender/shadermanager.h"
 #include "studiorender/gbuffer.h"
+#include "studiorender/rendertargetpool.h"
 #include "studiorender/mesh.h"
 #include "studiorender/gpuprogram.h"
 #include "studiorender/quad.h"
@@ -28,6 +34,10 @@
 
 #include "shader_lighting.h"
 #include "shader_depth.h"
+#include "shader_materialtable.h"
+#include "streamingbuffer.h"
+#include "dynamicresolution.h"
+#include "global.h"
 
 //---------------------------------------------------------------------//
 
@@ -48,6 +58,8 @@ namespace le
 		virtual void							BeginScene( ICamera* Camera );
 		virtual void							SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformation );
 		virtual void							SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformation, UInt32_t StartSurface, UInt32_t CountSurface );
+		virtual void							SubmitMesh( IMesh* Mesh, const Matrix4x4_t& Transformation, UInt32_t StartSurface, UInt32_t CountSurface, const LightSample& LightSample );
+		virtual void							SetDrawDepth( UInt32_t Depth );
 		virtual void							SubmitLight( IPointLight* PointLight );
 		virtual void							SubmitLight( ISpotLight* SpotLight );
 		virtual void							SubmitLight( IDirectionalLight* DirectionalLight );
@@ -64,10 +76,28 @@ namespace le
 		StudioRender();
 		~StudioRender();
 
+		void								LockContext();
+		void								UnlockContext();
+
+		inline BufferArena&					GetBufferArena()				{ return bufferArena; }
+		inline UInt32_t						GetCountVertexArraySwitches() const	{ return countVertexArraySwitches; }
+		inline UInt32_t						GetCountFrameAllocations() const	{ return countFrameAllocations; }
+		inline const FrameDescriptor&		GetFrame( UInt32_t Index ) const	{ return frames[ Index ]; }
+		inline bool							IsMultithread() const			{ return isMultithread; }
+
 	private:
-		void								Render_GeometryPass( const SceneDescriptor& SceneDescriptor );
-		void								Render_LightPass( const SceneDescriptor& SceneDescriptor );
+		void								StartRenderThread();
+		void								StopRenderThread();
+		void								RenderThread();
+		void								RenderFrame( FrameDescriptor& Frame, const StudioRenderViewport& Viewport );
+		void								UploadSceneData( FrameDescriptor& Frame );
+		void								SubmitSurfaces( IMesh* Mesh, const Matrix4x4_t& Transformation, UInt32_t StartSurface, UInt32_t CountSurface, const LightSample* LightSample );
+		void								Render_DepthPrePass( const FrameDescriptor& Frame, const SceneDescriptor& SceneDescriptor );
+		void								Render_GeometryPass( const FrameDescriptor& Frame, const SceneDescriptor& SceneDescriptor, bool IsCountSamples );
+		void								Render_LightPass( SceneDescriptor& SceneDescriptor );
 		void								Render_FinalPass( const SceneDescriptor& SceneDescriptor );
+		void								Render_MaterialBatches( const SceneDescriptor& SceneDescriptor );
+		void								AddToMaterialBatch( const FrameDescriptor& Frame, const RenderObject& RenderObject );
 
 		bool								isInitialize;
 
@@ -75,15 +105,60 @@ namespace le
 		StudioRenderFactory					studioRenderFactory;
 		StudioRenderViewport				viewport;
 		ShaderManager						shaderManager;
+		RenderTargetPool					renderTargetPool;
 		GBuffer								gbuffer;
 		Quad								quad;
 		Sphere								sphere;
 		Cone								cone;
 		ShaderDepth							shaderDepth;
 		ShaderLighting						shaderLighting;
+		ShaderMaterialTable					shaderMaterialTable;
+		BufferArena							bufferArena;
+		StreamingBuffer						streamingBuffer;
+		DynamicResolution					dynamicResolution;
+		GPUCounter							geometrySamples;
 
 		UInt32_t							currentScene;
-		std::vector< SceneDescriptor >		scenes;
+		UInt32_t							drawDepth;
+		UInt32_t							currentFrame;
+		UInt32_t							renderFrame;
+		UInt32_t							countFrameAllocations;
+		FrameDescriptor						frames[ FRAMEDESCRIPTOR_COUNT_FRAMES ];
+		UInt32_t							countMaterialBatches;
+		std::vector< MaterialBatch >		materialBatches;
+		UInt32_t							countVertexArraySwitches;
+		UInt32_t							uniformAlignment;
+
+		// Конвейерный режим: игра готовит кадр N+1, пока поток рендера рисует снимок кадра N
+		bool								isMultithread;
+		bool								isStopRenderThread;
+		bool								isFramePending;
+		bool								isContextRequested;
+		bool								isContextReleased;
+		UInt32_t							countContextLocks;
+		std::thread::id						gameThread;
+		StudioRenderViewport				renderViewport;
+		std::thread							renderThread;
+		std::mutex							renderMutex;
+		std::condition_variable				conditionRender;
+		std::condition_variable				conditionDone;
+	};
+
+	//---------------------------------------------------------------------//
+
+	// Захват контекста OpenGL потоком игры на время вызова, в потоке рендера ничего не делает
+	class ContextLock
+	{
+	public:
+		ContextLock()
+		{
+			if ( g_studioRender )		g_studioRender->LockContext();
+		}
+
+		~ContextLock()
+		{
+			if ( g_studioRender )		g_studioRender->UnlockContext();
+		}
 	};
 
 	//---------------------------------------------------------------------//
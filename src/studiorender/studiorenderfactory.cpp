@@ -10,7 +10,10 @@
 
 #include <string.h>
 
+#include "engine/iconsolesystem.h"
+#include "global.h"
 #include "studiorenderfactory.h"
+#include "studiorender.h"
 #include "gpuprogram.h"
 #include "texture.h"
 #include "mesh.h"
@@ -26,17 +29,30 @@
 // ------------------------------------------------------------------------------------ //
 void* le::StudioRenderFactory::Create( const char* NameInterface )
 {
-	if ( strcmp( NameInterface, GPUPROGRAM_INTERFACE_VERSION ) == 0 )					return new GPUProgram();
-	else if ( strcmp( NameInterface, TEXTURE_INTERFACE_VERSION ) == 0 )					return new Texture();
-	else if ( strcmp( NameInterface, MESH_INTERFACE_VERSION ) == 0 )					return new Mesh();
-	else if ( strcmp( NameInterface, TECHNIQUE_INTERFACE_VERSION ) == 0 )				return new StudioRenderTechnique();
-	else if ( strcmp( NameInterface, PASS_INTERFACE_VERSION ) == 0 )					return new StudioRenderPass();
-	else if ( strcmp( NameInterface, SHADERPARAMETER_INTERFACE_VERSION ) == 0 )			return new ShaderParameter();
-	else if ( strcmp( NameInterface, POINTLIGHT_INTERFACE_VERSION ) == 0 )				return new PointLight();
-	else if ( strcmp( NameInterface, SPOTLIGHT_INTERFACE_VERSION ) == 0 )				return new SpotLight();
-	else if ( strcmp( NameInterface, DIRECTIONALLIGHT_INTERFACE_VERSION ) == 0 )		return new DirectionalLight();
-
-	return nullptr;
+	return Create( HashInterface( NameInterface ) );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Создать объект по хешу названия интерфейса
+// ------------------------------------------------------------------------------------ //
+void* le::StudioRenderFactory::Create( UInt32_t InterfaceID )
+{
+	// Программы шейдеров создаются и из потока рендера
+	std::lock_guard< std::recursive_mutex >		lock( mutex );
+
+	switch ( InterfaceID )
+	{
+	case HashInterface( GPUPROGRAM_INTERFACE_VERSION ):			return poolGPUPrograms.Allocate();
+	case HashInterface( TEXTURE_INTERFACE_VERSION ):			return poolTextures.Allocate();
+	case HashInterface( MESH_INTERFACE_VERSION ):				return poolMeshes.Allocate();
+	case HashInterface( TECHNIQUE_INTERFACE_VERSION ):			return poolTechniques.Allocate();
+	case HashInterface( PASS_INTERFACE_VERSION ):				return poolPasses.Allocate();
+	case HashInterface( SHADERPARAMETER_INTERFACE_VERSION ):	return poolShaderParameters.Allocate();
+	case HashInterface( POINTLIGHT_INTERFACE_VERSION ):			return poolPointLights.Allocate();
+	case HashInterface( SPOTLIGHT_INTERFACE_VERSION ):			return poolSpotLights.Allocate();
+	case HashInterface( DIRECTIONALLIGHT_INTERFACE_VERSION ):	return poolDirectionalLights.Allocate();
+	default:													return nullptr;
+	}
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -45,5 +61,39 @@ void* le::StudioRenderFactory::Create( const char* NameInterface )
 void le::StudioRenderFactory::Delete( void* Object )
 {
 	if ( !Object ) return;
-	delete Object;
+
+	// Объект может быть в снимке кадра, который рисует поток рендера
+	ContextLock									contextLock;
+	std::lock_guard< std::recursive_mutex >		lock( mutex );
+
+	// Тип объекта определяем по слабу, в котором он лежит
+	if ( poolShaderParameters.IsOwner( Object ) )			poolShaderParameters.Free( ( ShaderParameter* ) Object );
+	else if ( poolPasses.IsOwner( Object ) )				poolPasses.Free( ( StudioRenderPass* ) Object );
+	else if ( poolTechniques.IsOwner( Object ) )			poolTechniques.Free( ( StudioRenderTechnique* ) Object );
+	else if ( poolTextures.IsOwner( Object ) )				poolTextures.Free( ( Texture* ) Object );
+	else if ( poolMeshes.IsOwner( Object ) )				poolMeshes.Free( ( Mesh* ) Object );
+	else if ( poolGPUPrograms.IsOwner( Object ) )			poolGPUPrograms.Free( ( GPUProgram* ) Object );
+	else if ( poolPointLights.IsOwner( Object ) )			poolPointLights.Free( ( PointLight* ) Object );
+	else if ( poolSpotLights.IsOwner( Object ) )			poolSpotLights.Free( ( SpotLight* ) Object );
+	else if ( poolDirectionalLights.IsOwner( Object ) )		poolDirectionalLights.Free( ( DirectionalLight* ) Object );
+	else													LIFEENGINE_ASSERT( false );
+}
+
+// ------------------------------------------------------------------------------------ //
+// Вывести статистику пулов объектов
+// ------------------------------------------------------------------------------------ //
+void le::StudioRenderFactory::PrintStats()
+{
+	std::lock_guard< std::recursive_mutex >		lock( mutex );
+
+	g_consoleSystem->PrintInfo( "Pool: objects / capacity / slabs" );
+	g_consoleSystem->PrintInfo( "GPUProgram: %i / %i / %i", poolGPUPrograms.GetCountObjects(), poolGPUPrograms.GetCapacity(), poolGPUPrograms.GetCountSlabs() );
+	g_consoleSystem->PrintInfo( "Texture: %i / %i / %i", poolTextures.GetCountObjects(), poolTextures.GetCapacity(), poolTextures.GetCountSlabs() );
+	g_consoleSystem->PrintInfo( "Mesh: %i / %i / %i", poolMeshes.GetCountObjects(), poolMeshes.GetCapacity(), poolMeshes.GetCountSlabs() );
+	g_consoleSystem->PrintInfo( "StudioRenderTechnique: %i / %i / %i", poolTechniques.GetCountObjects(), poolTechniques.GetCapacity(), poolTechniques.GetCountSlabs() );
+	g_consoleSystem->PrintInfo( "StudioRenderPass: %i / %i / %i", poolPasses.GetCountObjects(), poolPasses.GetCapacity(), poolPasses.GetCountSlabs() );
+	g_consoleSystem->PrintInfo( "ShaderParameter: %i / %i / %i", poolShaderParameters.GetCountObjects(), poolShaderParameters.GetCapacity(), poolShaderParameters.GetCountSlabs() );
+	g_consoleSystem->PrintInfo( "PointLight: %i / %i / %i", poolPointLights.GetCountObjects(), poolPointLights.GetCapacity(), poolPointLights.GetCountSlabs() );
+	g_consoleSystem->PrintInfo( "SpotLight: %i / %i / %i", poolSpotLights.GetCountObjects(), poolSpotLights.GetCapacity(), poolSpotLights.GetCountSlabs() );
+	g_consoleSystem->PrintInfo( "DirectionalLight: %i / %i / %i", poolDirectionalLights.GetCountObjects(), poolDirectionalLights.GetCapacity(), poolDirectionalLights.GetCountSlabs() );
 }
\ No newline at end of file
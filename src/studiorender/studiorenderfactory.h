@@ -11,7 +11,19 @@
 #ifndef STUDIORENDER_FACTORY_H
 #define STUDIORENDER_FACTORY_H
 
+#include <mutex>
+
 #include "engine/ifactory.h"
+#include "objectpool.h"
+#include "gpuprogram.h"
+#include "texture.h"
+#include "mesh.h"
+#include "studiorendertechnique.h"
+#include "studiorenderpass.h"
+#include "shaderparameter.h"
+#include "pointlight.h"
+#include "spotlight.h"
+#include "directionallight.h"
 
 namespace le
 {
@@ -22,7 +34,23 @@ namespace le
 	public:
 		// IFactory
 		virtual void*			Create( const char* NameInterface );
+		virtual void*			Create( UInt32_t InterfaceID );
 		virtual void			Delete( void* Object );
+
+		// StudioRenderFactory
+		void					PrintStats();
+
+	private:
+		std::recursive_mutex					mutex;
+		ObjectPool< GPUProgram >				poolGPUPrograms;
+		ObjectPool< Texture >					poolTextures;
+		ObjectPool< Mesh >						poolMeshes;
+		ObjectPool< StudioRenderTechnique >		poolTechniques;
+		ObjectPool< StudioRenderPass >			poolPasses;
+		ObjectPool< ShaderParameter >			poolShaderParameters;
+		ObjectPool< PointLight >				poolPointLights;
+		ObjectPool< SpotLight >					poolSpotLights;
+		ObjectPool< DirectionalLight >			poolDirectionalLights;
 	};
 
 	//---------------------------------------------------------------------//
@@ -36,7 +36,7 @@ void le::StudioRenderPass::RemoveParameter( UInt32_t Index )
 {
 	LIFEENGINE_ASSERT( Index < parameters.size() );
 
-	delete parameters[ Index ];
+	g_studioRender->GetFactory()->Delete( parameters[ Index ] );
 	parameters.erase( parameters.begin() + Index );
 	isNeadRefrash = true;
 }
@@ -47,7 +47,7 @@ void le::StudioRenderPass::RemoveParameter( UInt32_t Index )
 void le::StudioRenderPass::Clear()
 {
 	for ( UInt32_t index = 0, count = parameters.size(); index < count; ++index )
-		delete parameters[ index ];
+		g_studioRender->GetFactory()->Delete( parameters[ index ] );
 
 	shader = nullptr;
 	parameters.clear();
@@ -56,12 +56,12 @@ void le::StudioRenderPass::Clear()
 // ------------------------------------------------------------------------------------ //
 // Применить настройки прохода к рендеру
 // ------------------------------------------------------------------------------------ //
-void le::StudioRenderPass::Apply( const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap )
+void le::StudioRenderPass::Apply( const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap, const LightSample* LightSample )
 {
 	InitStates();
 
 	if ( shader && ( !isNeadRefrash || Refrash() ) )
-		shader->OnDrawMesh( parameters.size(), ( IShaderParameter** ) parameters.data(), Transformation, Camera, Lightmap );
+		shader->OnDrawMesh( parameters.size(), ( IShaderParameter** ) parameters.data(), Transformation, Camera, Lightmap, LightSample );
 }
 
 // ------------------------------------------------------------------------------------ //
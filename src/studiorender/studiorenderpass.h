@@ -23,6 +23,7 @@ namespace le
 	//---------------------------------------------------------------------//
 
 	class ICamera;
+	struct LightSample;
 
 	//---------------------------------------------------------------------//
 
@@ -55,7 +56,7 @@ namespace le
 		StudioRenderPass();
 		~StudioRenderPass();
 
-		void						Apply( const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap = nullptr );
+		void						Apply( const Matrix4x4_t& Transformation, ICamera* Camera, ITexture* Lightmap = nullptr, const LightSample* LightSample = nullptr );
 		void						InitStates();
 		bool						Refrash();
 		inline void					NeadRefrash()
@@ -9,6 +9,8 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "engine/lifeengine.h"
+#include "global.h"
+#include "studiorender.h"
 #include "studiorendertechnique.h"
 
 // ------------------------------------------------------------------------------------ //
@@ -27,7 +29,7 @@ void le::StudioRenderTechnique::RemovePass( UInt32_t Index )
 {
 	LIFEENGINE_ASSERT( Index < passes.size() );
 	
-	delete passes[ Index ];
+	g_studioRender->GetFactory()->Delete( passes[ Index ] );
 	passes.erase( passes.begin() + Index );
 }
 
@@ -37,7 +39,7 @@ void le::StudioRenderTechnique::RemovePass( UInt32_t Index )
 void le::StudioRenderTechnique::Clear()
 {
 	for ( UInt32_t index = 0, count = passes.size(); index < count; ++index )
-		delete passes[ index ];
+		g_studioRender->GetFactory()->Delete( passes[ index ] );
 
 	passes.clear();
 }
@@ -11,8 +11,10 @@
 #include <GL/glew.h>
 
 #include "engine/lifeengine.h"
+#include "engine/istatssystem.h"
 #include "studiorender/studiorendersampler.h"
 #include "global.h"
+#include "studiorender.h"
 #include "texture.h"
 
 struct OpenGLImageFormat
@@ -34,6 +36,8 @@ inline OpenGLImageFormat TextureImageFormat_EnumToOpenGLFormat( le::IMAGE_FORMAT
 	case le::IF_RGBA_16FLOAT:		return { GL_RGBA16F, GL_RGBA, GL_FLOAT };
 	case le::IF_RGB_16FLOAT:		return { GL_RGB16F, GL_RGB, GL_FLOAT };
 	case le::IF_DEPTH24_STENCIL8:	return { GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8 };
+	case le::IF_RGB10_A2_UNORM:		return { GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV };
+	case le::IF_R11G11B10_FLOAT:	return { GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT };
 	}
 }
 
@@ -74,6 +78,7 @@ inline le::UInt32_t ConvertEngineSamplerAddressMode_To_OpenGLTextureAddressMode(
 // ------------------------------------------------------------------------------------ //
 void le::Texture::Initialize( TEXTURE_TYPE TextureType, IMAGE_FORMAT ImageFormat, UInt32_t Width, UInt32_t Height, UInt32_t CountMipmap )
 {
+	ContextLock			contextLock;
 	if ( handle ) Delete();
 
 	glGenTextures( 1, &handle );
@@ -93,6 +98,7 @@ void le::Texture::Delete()
 {
 	LIFEENGINE_ASSERT( handle );
 
+	ContextLock			contextLock;
 	glDeleteTextures( 1, &handle );
 
 	width = 0;
@@ -109,9 +115,11 @@ void le::Texture::Bind( UInt32_t Layer )
 {
 	LIFEENGINE_ASSERT( handle );
 	
+	ContextLock			contextLock;
 	glActiveTexture( GL_TEXTURE0 + Layer );
 	glBindTexture( GL_TEXTURE_2D, handle );	
 	layer = Layer;
+	g_statTextureBinds.Add( 1 );
 }
 
 // ------------------------------------------------------------------------------------ //
@@ -121,6 +129,7 @@ void le::Texture::Unbind()
 {
 	LIFEENGINE_ASSERT( handle );
 
+	ContextLock			contextLock;
 	glActiveTexture( GL_TEXTURE0 + layer );
 	glBindTexture( GL_TEXTURE_2D, 0 );
 	layer = 0;
@@ -133,6 +142,7 @@ void le::Texture::GenerateMipmaps()
 {
 	LIFEENGINE_ASSERT( handle && layer );
 
+	ContextLock			contextLock;
 	glGenerateMipmap( GL_TEXTURE_2D );
 	countMipmaps = floor( log2( glm::max( width, height ) ) );
 }
@@ -148,6 +158,7 @@ void le::Texture::Append( const UInt8_t* Data, UInt32_t MipmapLevel )
 	UInt32_t				width = GetWidth( MipmapLevel );
 	UInt32_t				height = GetHeight( MipmapLevel );
 	
+	ContextLock				contextLock;
 	glTexImage2D( GL_TEXTURE_2D, MipmapLevel, openglImageFormat.internalFormat, width, height, 0, openglImageFormat.format, openglImageFormat.type, Data );
 }
 
@@ -158,6 +169,7 @@ void le::Texture::Update( UInt32_t X, UInt32_t Y, UInt32_t Width, UInt32_t Heigh
 {
 	LIFEENGINE_ASSERT( MipmapLevel >= 0 && MipmapLevel < countMipmaps && Width <= GetWidth( MipmapLevel ) && Height <= GetHeight( MipmapLevel ) && handle && layer );
 
+	ContextLock			contextLock;
 	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );	
 	glTexSubImage2D( GL_TEXTURE_2D, MipmapLevel, X, Y, Width, Height, TextureImageFormat_EnumToOpenGLFormat( imageFormat ).format, GL_UNSIGNED_BYTE, Data );
 	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
@@ -170,6 +182,7 @@ void le::Texture::SetSampler( const StudioRenderSampler& Sampler )
 {
 	LIFEENGINE_ASSERT( handle && layer );
 
+	ContextLock			contextLock;
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, ConvertEngineSamplerAddressMode_To_OpenGLTextureAddressMode( Sampler.addressU ) );
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, ConvertEngineSamplerAddressMode_To_OpenGLTextureAddressMode( Sampler.addressV ) );
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, ConvertEngineSamplerAddressMode_To_OpenGLTextureAddressMode( Sampler.addressW ) );
@@ -243,5 +256,5 @@ le::Texture::Texture() :
 // ------------------------------------------------------------------------------------ //
 le::Texture::~Texture()
 {
-	Delete();
+	if ( handle )		Delete();
 }
@@ -48,6 +48,11 @@ namespace le
 			return handle;
 		}
 
+		inline IMAGE_FORMAT			GetImageFormat() const
+		{
+			return imageFormat;
+		}
+
 	private:
 		bool				isCreated;
 
@@ -28,7 +28,7 @@ le::VertexArrayObject::~VertexArrayObject()
 // ------------------------------------------------------------------------------------ //
 // Добавить буфер
 // ------------------------------------------------------------------------------------ //
-void le::VertexArrayObject::AddBuffer( VertexBufferObject& VertexBufferObject, VertexBufferLayout& VertexBufferLayout )
+void le::VertexArrayObject::AddBuffer( VertexBufferObject& VertexBufferObject, VertexBufferLayout& VertexBufferLayout, UInt32_t StartLocation )
 {
 	if ( handle == 0 ) return;
 
@@ -42,9 +42,13 @@ void le::VertexArrayObject::AddBuffer( VertexBufferObject& VertexBufferObject, V
 	{
 		VertexBufferElement			element = elements[ index ];
 		
-		glEnableVertexAttribArray( index );
-		glVertexAttribPointer( index, element.count, element.type, element.normalized, VertexBufferLayout.GetStride(), (void*) offset );
-		offset += element.count * VertexBufferElement::GetSizeOfType( element.type );
+		glEnableVertexAttribArray( StartLocation + index );
+		if ( element.isInteger )
+			glVertexAttribIPointer( StartLocation + index, element.count, element.type, VertexBufferLayout.GetStride(), (void*) offset );
+		else
+			glVertexAttribPointer( StartLocation + index, element.count, element.type, element.normalized, VertexBufferLayout.GetStride(), (void*) offset );
+
+		offset += element.GetSize();
 	}
 
 	Unbind();
@@ -40,9 +40,10 @@ namespace le
 		{
 			if ( handle == 0 ) return;
 			glDeleteVertexArrays( 1, &handle );
+			handle = 0;
 		}
 
-		void						AddBuffer( VertexBufferObject& VertexBufferObject, VertexBufferLayout& VertexBufferLayout );
+		void						AddBuffer( VertexBufferObject& VertexBufferObject, VertexBufferLayout& VertexBufferLayout, UInt32_t StartLocation = 0 );
 		void						AddBuffer( IndexBufferObject& IndexBufferObject );
 
 		inline void					Bind() const
@@ -28,6 +28,7 @@ le::UInt32_t le::VertexBufferElement::GetSizeOfType( UInt32_t Type )
 		case GL_FLOAT: 
 		case GL_UNSIGNED_INT:	return 4;
 		case GL_UNSIGNED_BYTE:	return 1;
+		case GL_HALF_FLOAT:		return 2;
 	}
 
 	LIFEENGINE_ASSERT( false );
@@ -26,9 +26,17 @@ namespace le
 	{
 		static UInt32_t			GetSizeOfType( UInt32_t Type );
 
+		inline UInt32_t			GetSize() const
+		{
+			// Packed type holds all components in one 32 bit value
+			if ( type == GL_INT_2_10_10_10_REV )		return 4;
+			return count * GetSizeOfType( type );
+		}
+
 		UInt32_t			type;	
 		UInt32_t			count;	
 		UInt8_t				normalized;
+		bool				isInteger;
 	};
 
 	class VertexBufferLayout
@@ -38,22 +46,34 @@ namespace le
 
 		inline void				PushFloat( UInt32_t Count )
 		{
-			elements.push_back( { GL_FLOAT, Count, GL_FALSE } );
-			stride += Count * VertexBufferElement::GetSizeOfType( GL_FLOAT );
+			elements.push_back( { GL_FLOAT, Count, GL_FALSE, false } );
+			stride += elements.back().GetSize();
 		}	
 
-		inline void				PushUInt( UInt32_t Count )
+		inline void				PushUInt( UInt32_t Count, bool IsInteger = false )
 		{
-			elements.push_back( { GL_UNSIGNED_INT, Count, GL_FALSE } );
-			stride += Count * VertexBufferElement::GetSizeOfType( GL_UNSIGNED_INT );
+			elements.push_back( { GL_UNSIGNED_INT, Count, GL_FALSE, IsInteger } );
+			stride += elements.back().GetSize();
 		}
 
 		inline void				PushUByte( UInt32_t Count )
 		{
-			elements.push_back( { GL_UNSIGNED_BYTE, Count, GL_TRUE } );
-			stride += Count * VertexBufferElement::GetSizeOfType( GL_UNSIGNED_BYTE );
+			elements.push_back( { GL_UNSIGNED_BYTE, Count, GL_TRUE, false } );
+			stride += elements.back().GetSize();
 		}	
 
+		inline void				PushHalfFloat( UInt32_t Count )
+		{
+			elements.push_back( { GL_HALF_FLOAT, Count, GL_FALSE, false } );
+			stride += elements.back().GetSize();
+		}
+
+		inline void				PushInt2_10_10_10_Rev()
+		{
+			elements.push_back( { GL_INT_2_10_10_10_REV, 4, GL_TRUE, false } );
+			stride += elements.back().GetSize();
+		}
+
 		inline void				Clear()
 		{
 			elements.clear();
@@ -40,7 +40,8 @@ namespace le
 	//---------------------------------------------------------------------//
 }
 
-static le::ContextDescriptor*				currentContext = nullptr;
+// Контекст текущий для каждого потока свой, рендер может работать в отдельном потоке
+static thread_local le::ContextDescriptor*	currentContext = nullptr;
 
 // ------------------------------------------------------------------------------------ //
 // Создать контекст
@@ -230,6 +231,17 @@ bool le::WinGL_MakeCurrentContext( const ContextDescriptor_t& ContextDescriptor
 	return true;
 }
 
+// ------------------------------------------------------------------------------------ //
+// Отвязать текущий контекст от потока
+// ------------------------------------------------------------------------------------ //
+void le::WinGL_ReleaseCurrentContext()
+{
+	if ( !currentContext ) return;
+
+	wglMakeCurrent( nullptr, nullptr );
+	currentContext = nullptr;
+}
+
 // ------------------------------------------------------------------------------------ //
 // Удалить контекст
 // ------------------------------------------------------------------------------------ //
@@ -21,6 +21,7 @@ namespace le
 
 	bool					WinGL_CreateContext( WindowHandle_t WindowHandle, const SettingsContext& SettingsContext, ContextDescriptor_t& ContextDescriptor, ContextDescriptor_t* ShareContext = nullptr );
 	bool					WinGL_MakeCurrentContext( const ContextDescriptor_t& ContextDescriptor );
+	void					WinGL_ReleaseCurrentContext();
 	void					WinGL_DeleteContext( ContextDescriptor_t& ContextDescriptor );
 	void					WinGL_SwapBuffers( const ContextDescriptor_t& ContextDescriptor );
 	void					WinGL_SetVerticalSync( bool IsEnable = true );